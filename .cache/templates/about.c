@@ -0,0 +1,41 @@
+#include ".cache/templates/about.h"
+#include "Trace.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char about_lit_0[] =
+    "<h1>Welcome!</h1>\n"
+    "<p>Page visits: ";
+
+static const char about_lit_1[] =
+    "</p>\n"
+    "\n";
+
+bool template_about(const Template_about *p, TemplateOutput *out) {
+    (void)p;
+    if (!template_output_append(out, about_lit_0, sizeof(about_lit_0) - 1)) return false;
+    if (!template_output_escape_str(out, p->visits, ESCAPE_TEXT)) return false;
+    if (!template_output_append(out, about_lit_1, sizeof(about_lit_1) - 1)) return false;
+    return true;
+}
+
+#define about_path    "about.html"
+
+void render_template_about(HTTPRequest *request, const Template_about *p) {
+    TemplateOutput out;
+    template_output_init(&out);
+    int64_t started = HTTPRequest_begin_phase(request, HTTP_PHASE_RENDER);
+    TRACE_PROBE1(render_start, about_path);
+    bool ok = template_about(p, &out);
+    TRACE_PROBE2(render_end, about_path, ok);
+    HTTPRequest_add_phase(request, HTTP_PHASE_RENDER, started);
+    template_output_send(request, &out, ok);
+}
+
+char *process_template_about(const Template_about *p) {
+    TemplateOutput out;
+    template_output_init(&out);
+    char *html = template_about(p, &out) ? template_output_join(&out) : NULL;
+    template_output_free(&out);
+    return html ? html : strdup("");
+}
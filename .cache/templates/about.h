@@ -0,0 +1,11 @@
+#pragma once
+#include "../../.engine/HTMLTemplating/HTMLTemplating.h"
+
+// Generated from templates/about.html
+typedef struct {
+    const char *visits;
+} Template_about;
+
+bool template_about(const Template_about *p, TemplateOutput *out);
+void render_template_about(HTTPRequest *request, const Template_about *p);
+char *process_template_about(const Template_about *p);
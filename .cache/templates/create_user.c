@@ -0,0 +1,156 @@
+#include ".cache/templates/create_user.h"
+#include "Trace.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char create_user_lit_0[] =
+    "<!DOCTYPE html>\n"
+    "<html lang=\"en\">\n"
+    "<head>\n"
+    "    <meta charset=\"UTF-8\">\n"
+    "    <title>User Created</title>\n"
+    "    <style>\n"
+    "        body {\n"
+    "            background: #1e1e1e;\n"
+    "            color: #eaeaea;\n"
+    "            font-family: Arial, sans-serif;\n"
+    "            margin: 0;\n"
+    "            padding: 0;\n"
+    "            height: 100vh;\n"
+    "            display: flex;\n"
+    "            justify-content: center;\n"
+    "            align-items: center;\n"
+    "        }\n"
+    "\n"
+    "        .card {\n"
+    "            background: #2a2a2a;\n"
+    "            padding: 24px 32px;\n"
+    "            border-radius: 12px;\n"
+    "            width: 320px;\n"
+    "            box-shadow: 0 0 40px rgba(0,0,0,0.5);\n"
+    "        }\n"
+    "\n"
+    "        h1 {\n"
+    "            margin-top: 0;\n"
+    "            text-align: center;\n"
+    "            font-size: 22px;\n"
+    "        }\n"
+    "\n"
+    "        .result {\n"
+    "            text-align: center;\n"
+    "            margin-bottom: 16px;\n"
+    "            font-weight: bold;\n"
+    "            color: #9be29b;\n"
+    "        }\n"
+    "\n"
+    "        .field {\n"
+    "            margin: 8px 0;\n"
+    "            display: flex;\n"
+    "            justify-content: space-between;\n"
+    "            border-bottom: 1px solid #3a3a3a;\n"
+    "            padding-bottom: 4px;\n"
+    "        }\n"
+    "\n"
+    "        .label {\n"
+    "            color: #bbbbbb;\n"
+    "        }\n"
+    "\n"
+    "        .value {\n"
+    "            font-weight: bold;\n"
+    "        }\n"
+    "    </style>\n"
+    "</head>\n"
+    "<body>\n"
+    "\n"
+    "<div class=\"card\">\n"
+    "    <h1>User Created</h1>\n"
+    "\n"
+    "    <div class=\"result\">\n"
+    "        ";
+
+static const char create_user_lit_1[] =
+    "\n"
+    "    </div>\n"
+    "\n"
+    "    <div class=\"field\">\n"
+    "        <span class=\"label\">Name</span>\n"
+    "        <span class=\"value\">";
+
+static const char create_user_lit_2[] =
+    "</span>\n"
+    "    </div>\n"
+    "\n"
+    "    <div class=\"field\">\n"
+    "        <span class=\"label\">DNI</span>\n"
+    "        <span class=\"value\">";
+
+static const char create_user_lit_3[] =
+    "</span>\n"
+    "    </div>\n"
+    "\n"
+    "    <div class=\"field\">\n"
+    "        <span class=\"label\">Age</span>\n"
+    "        <span class=\"value\">";
+
+static const char create_user_lit_4[] =
+    "</span>\n"
+    "    </div>\n"
+    "\n"
+    "    <div class=\"field\">\n"
+    "        <span class=\"label\">Email</span>\n"
+    "        <span class=\"value\">";
+
+static const char create_user_lit_5[] =
+    "</span>\n"
+    "    </div>\n"
+    "\n"
+    "    <div class=\"field\">\n"
+    "        <span class=\"label\">Group ID</span>\n"
+    "        <span class=\"value\">";
+
+static const char create_user_lit_6[] =
+    "</span>\n"
+    "    </div>\n"
+    "</div>\n"
+    "\n"
+    "</body>\n"
+    "</html>\n";
+
+bool template_create_user(const Template_create_user *p, TemplateOutput *out) {
+    (void)p;
+    if (!template_output_append(out, create_user_lit_0, sizeof(create_user_lit_0) - 1)) return false;
+    if (!template_output_escape_str(out, p->result, ESCAPE_TEXT)) return false;
+    if (!template_output_append(out, create_user_lit_1, sizeof(create_user_lit_1) - 1)) return false;
+    if (!template_output_escape_str(out, p->name, ESCAPE_TEXT)) return false;
+    if (!template_output_append(out, create_user_lit_2, sizeof(create_user_lit_2) - 1)) return false;
+    if (!template_output_escape_str(out, p->DNI, ESCAPE_TEXT)) return false;
+    if (!template_output_append(out, create_user_lit_3, sizeof(create_user_lit_3) - 1)) return false;
+    if (!write_int(out, &p->age)) return false;
+    if (!template_output_append(out, create_user_lit_4, sizeof(create_user_lit_4) - 1)) return false;
+    if (!template_output_escape_str(out, p->email, ESCAPE_TEXT)) return false;
+    if (!template_output_append(out, create_user_lit_5, sizeof(create_user_lit_5) - 1)) return false;
+    if (!write_int(out, &p->group_id)) return false;
+    if (!template_output_append(out, create_user_lit_6, sizeof(create_user_lit_6) - 1)) return false;
+    return true;
+}
+
+#define create_user_path    "create_user.html"
+
+void render_template_create_user(HTTPRequest *request, const Template_create_user *p) {
+    TemplateOutput out;
+    template_output_init(&out);
+    int64_t started = HTTPRequest_begin_phase(request, HTTP_PHASE_RENDER);
+    TRACE_PROBE1(render_start, create_user_path);
+    bool ok = template_create_user(p, &out);
+    TRACE_PROBE2(render_end, create_user_path, ok);
+    HTTPRequest_add_phase(request, HTTP_PHASE_RENDER, started);
+    template_output_send(request, &out, ok);
+}
+
+char *process_template_create_user(const Template_create_user *p) {
+    TemplateOutput out;
+    template_output_init(&out);
+    char *html = template_create_user(p, &out) ? template_output_join(&out) : NULL;
+    template_output_free(&out);
+    return html ? html : strdup("");
+}
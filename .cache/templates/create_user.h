@@ -0,0 +1,16 @@
+#pragma once
+#include "../../.engine/HTMLTemplating/HTMLTemplating.h"
+
+// Generated from templates/create_user.html
+typedef struct {
+    const char *result;
+    const char *name;
+    const char *DNI;
+    int age;
+    const char *email;
+    int group_id;
+} Template_create_user;
+
+bool template_create_user(const Template_create_user *p, TemplateOutput *out);
+void render_template_create_user(HTTPRequest *request, const Template_create_user *p);
+char *process_template_create_user(const Template_create_user *p);
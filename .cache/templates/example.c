@@ -0,0 +1,362 @@
+#include ".cache/templates/example.h"
+#include "Trace.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char example_lit_0[] =
+    "<!DOCTYPE html>\n"
+    "<html lang=\"en\">\n"
+    "<head>\n"
+    "    <meta charset=\"UTF-8\">\n"
+    "    <meta name=\"viewport\" content=\"width=device-width, initial-scale=1.0\">\n"
+    "    <meta http-equiv=\"X-UA-Compatible\" content=\"ie=edge\">\n"
+    "    <title>";
+
+static const char example_lit_1[] =
+    " - Personal Website</title>\n"
+    "    <link href=\"https://fonts.googleapis.com/css2\?family=Poppins:wght@300;400;600&display=swap\" rel="
+    "\"stylesheet\">\n"
+    "    <style>\n"
+    "        body {\n"
+    "            font-family: 'Poppins', sans-serif;\n"
+    "            margin: 0;\n"
+    "            padding: 0;\n"
+    "            background-color: #f4f7fa;\n"
+    "            color: #333;\n"
+    "        }\n"
+    "        header {\n"
+    "            background-color: #343a40;\n"
+    "            color: #fff;\n"
+    "            padding: 1.5rem;\n"
+    "            text-align: center;\n"
+    "        }\n"
+    "        header h1 {\n"
+    "            margin: 0;\n"
+    "            font-size: 2.5rem;\n"
+    "            letter-spacing: 1px;\n"
+    "        }\n"
+    "        header p {\n"
+    "            margin: 0.5rem;\n"
+    "            font-weight: 300;\n"
+    "        }\n"
+    "        .container {\n"
+    "            width: 80%;\n"
+    "            margin: 0 auto;\n"
+    "            padding: 2rem 0;\n"
+    "        }\n"
+    "        .profile {\n"
+    "            display: flex;\n"
+    "            justify-content: space-between;\n"
+    "            align-items: center;\n"
+    "            margin-bottom: 2rem;\n"
+    "        }\n"
+    "        .profile img {\n"
+    "            width: 150px;\n"
+    "            height: 150px;\n"
+    "            border-radius: 50%;\n"
+    "            object-fit: cover;\n"
+    "            border: 4px solid #343a40;\n"
+    "        }\n"
+    "        .profile .info {\n"
+    "            flex: 1;\n"
+    "            margin-left: 2rem;\n"
+    "        }\n"
+    "        .profile .info h2 {\n"
+    "            margin: 0;\n"
+    "            font-size: 2rem;\n"
+    "            color: #343a40;\n"
+    "        }\n"
+    "        .profile .info p {\n"
+    "            color: #666;\n"
+    "            line-height: 1.6;\n"
+    "        }\n"
+    "        .about, .projects, .experience {\n"
+    "            margin-bottom: 2rem;\n"
+    "        }\n"
+    "        .section-title {\n"
+    "            font-size: 1.8rem;\n"
+    "            margin-bottom: 1rem;\n"
+    "            color: #343a40;\n"
+    "        }\n"
+    "        .section-content {\n"
+    "            background-color: #fff;\n"
+    "            padding: 1.5rem;\n"
+    "            border-radius: 8px;\n"
+    "            box-shadow: 0 4px 8px rgba(0, 0, 0, 0.1);\n"
+    "        }\n"
+    "        .project, .job {\n"
+    "            display: flex;\n"
+    "            justify-content: space-between;\n"
+    "            margin-bottom: 1rem;\n"
+    "        }\n"
+    "        .project h3, .job h3 {\n"
+    "            margin: 0;\n"
+    "            color: #343a40;\n"
+    "        }\n"
+    "        .project p, .job p {\n"
+    "            color: #666;\n"
+    "            flex: 1;\n"
+    "        }\n"
+    "        .button {\n"
+    "            background-color: #007bff;\n"
+    "            color: #fff;\n"
+    "            padding: 0.5rem 1.5rem;\n"
+    "            text-decoration: none;\n"
+    "            border-radius: 5px;\n"
+    "            transition: background-color 0.3s ease;\n"
+    "        }\n"
+    "        .button:hover {\n"
+    "            background-color: #0056b3;\n"
+    "        }\n"
+    "        footer {\n"
+    "            background-color: #343a40;\n"
+    "            color: #fff;\n"
+    "            text-align: center;\n"
+    "            padding: 1rem 0;\n"
+    "            position: relative;\n"
+    "            bottom: 0;\n"
+    "            width: 100%;\n"
+    "        }\n"
+    "        .footer-links {\n"
+    "            list-style: none;\n"
+    "            padding: 0;\n"
+    "            margin: 1rem 0;\n"
+    "        }\n"
+    "        .footer-links li {\n"
+    "            display: inline;\n"
+    "            margin: 0 10px;\n"
+    "        }\n"
+    "        .footer-links a {\n"
+    "            color: #fff;\n"
+    "            text-decoration: none;\n"
+    "            font-size: 1.2rem;\n"
+    "        }\n"
+    "        .footer-links a:hover {\n"
+    "            text-decoration: underline;\n"
+    "        }\n"
+    "        @media (max-width: 768px) {\n"
+    "            .profile {\n"
+    "                flex-direction: column;\n"
+    "                text-align: center;\n"
+    "            }\n"
+    "            .profile img {\n"
+    "                margin-bottom: 1rem;\n"
+    "            }\n"
+    "            .profile .info {\n"
+    "                margin-left: 0;\n"
+    "            }\n"
+    "            .container {\n"
+    "                width: 90%;\n"
+    "            }\n"
+    "        }\n"
+    "    </style>\n"
+    "</head>\n"
+    "<body>\n"
+    "\n"
+    "    <header>\n"
+    "        <h1>";
+
+static const char example_lit_2[] =
+    "</h1>\n"
+    "        <p>";
+
+static const char example_lit_3[] =
+    "</p>\n"
+    "    </header>\n"
+    "    \n"
+    "    <div class=\"container\">\n"
+    "        <section class=\"profile\">\n"
+    "            <img src=\"";
+
+static const char example_lit_4[] =
+    "\" alt=\"";
+
+static const char example_lit_5[] =
+    "\">\n"
+    "            <div class=\"info\">\n"
+    "                <h2>About Me</h2>\n"
+    "                <p>";
+
+static const char example_lit_6[] =
+    "</p>\n"
+    "            </div>\n"
+    "        </section>\n"
+    "    \n"
+    "        <section class=\"projects\">\n"
+    "            <h2 class=\"section-title\">Projects</h2>\n"
+    "            <div class=\"section-content\">\n"
+    "                ";
+
+static const char example_lit_7[] =
+    "\n"
+    "                <div class=\"project\">\n"
+    "                    <div>\n"
+    "                        <h3>";
+
+static const char example_lit_8[] =
+    "</h3>\n"
+    "                        <p>";
+
+static const char example_lit_9[] =
+    "</p>\n"
+    "                    </div>\n"
+    "                    <a href=\"#\" class=\"button\">View</a>\n"
+    "                </div>\n"
+    "                ";
+
+static const char example_lit_10[] =
+    "\n"
+    "            </div>\n"
+    "        </section>\n"
+    "    \n"
+    "        <section class=\"experience\">\n"
+    "            <h2 class=\"section-title\">Experience</h2>\n"
+    "            <div class=\"section-content\">\n"
+    "                ";
+
+static const char example_lit_11[] =
+    "\n"
+    "                ";
+
+static const char example_lit_12[] =
+    "\n"
+    "                ";
+
+static const char example_lit_13[] =
+    "<div class=\"project\">\n"
+    "    <div>\n"
+    "        <h3>";
+
+static const char example_lit_14[] =
+    "</h3>\n"
+    "        <p>";
+
+static const char example_lit_15[] =
+    "</p>\n"
+    "    </div>\n"
+    "    <a href=\"#\" class=\"button\">View</a>\n"
+    "</div>\n";
+
+static const char example_lit_16[] =
+    "\n"
+    "                ";
+
+static const char example_lit_17[] =
+    "\n"
+    "                ";
+
+static const char example_lit_18[] =
+    "\n"
+    "                <p>No experience yet.</p>\n"
+    "                ";
+
+static const char example_lit_19[] =
+    "\n"
+    "            </div>\n"
+    "        </section>\n"
+    "    </div>\n"
+    "    \n"
+    "    <footer>\n"
+    "        <p>&copy; ";
+
+static const char example_lit_20[] =
+    " ";
+
+static const char example_lit_21[] =
+    "</p>\n"
+    "        <ul class=\"footer-links\">\n"
+    "            <li><a href=\"#\">LinkedIn</a></li>\n"
+    "            <li><a href=\"#\">GitHub</a></li>\n"
+    "            <li><a href=\"#\">Twitter</a></li>\n"
+    "        </ul>\n"
+    "    </footer>\n"
+    "    \n"
+    "</body>\n"
+    "</html>\n";
+
+bool template_example(const Template_example *p, TemplateOutput *out) {
+    (void)p;
+    if (!template_output_append(out, example_lit_0, sizeof(example_lit_0) - 1)) return false;
+    if (!template_output_escape_str(out, p->name, ESCAPE_TEXT)) return false;
+    if (!template_output_append(out, example_lit_1, sizeof(example_lit_1) - 1)) return false;
+    if (!template_output_escape_str(out, p->name, ESCAPE_TEXT)) return false;
+    if (!template_output_append(out, example_lit_2, sizeof(example_lit_2) - 1)) return false;
+    if (!template_output_escape_str(out, p->title, ESCAPE_TEXT)) return false;
+    if (!template_output_append(out, example_lit_3, sizeof(example_lit_3) - 1)) return false;
+    if (!template_output_escape_str(out, p->image_url, ESCAPE_ATTR)) return false;
+    if (!template_output_append(out, example_lit_4, sizeof(example_lit_4) - 1)) return false;
+    if (!template_output_escape_str(out, p->name, ESCAPE_ATTR)) return false;
+    if (!template_output_append(out, example_lit_5, sizeof(example_lit_5) - 1)) return false;
+    if (!template_output_escape_str(out, p->about, ESCAPE_TEXT)) return false;
+    if (!template_output_append(out, example_lit_6, sizeof(example_lit_6) - 1)) return false;
+    if (p->projects) {
+        int f0_title = template_list_field(p->projects, "title");
+        int f0_description = template_list_field(p->projects, "description");
+        for (size_t i0 = 0; i0 < p->projects->count; i0++) {
+            const void *item0 = template_list_item(p->projects, i0);
+            (void)item0;
+            if (!template_output_append(out, example_lit_7, sizeof(example_lit_7) - 1)) return false;
+            if (!template_output_field(out, p->projects, item0, f0_title, ESCAPE_TEXT)) return false;
+            if (!template_output_append(out, example_lit_8, sizeof(example_lit_8) - 1)) return false;
+            if (!template_output_field(out, p->projects, item0, f0_description, ESCAPE_TEXT)) return false;
+            if (!template_output_append(out, example_lit_9, sizeof(example_lit_9) - 1)) return false;
+        }
+    }
+    if (!template_output_append(out, example_lit_10, sizeof(example_lit_10) - 1)) return false;
+    if ((p->jobs && p->jobs->count > 0)) {
+        if (!template_output_append(out, example_lit_11, sizeof(example_lit_11) - 1)) return false;
+        if (p->jobs) {
+            int f1_title = template_list_field(p->jobs, "title");
+            int f1_description = template_list_field(p->jobs, "description");
+            for (size_t i1 = 0; i1 < p->jobs->count; i1++) {
+                const void *item1 = template_list_item(p->jobs, i1);
+                (void)item1;
+                if (!template_output_append(out, example_lit_12, sizeof(example_lit_12) - 1)) return false;
+                if (!template_output_append(out, example_lit_13, sizeof(example_lit_13) - 1)) return false;
+                if (f1_title >= 0) {
+                    if (!template_output_field(out, p->jobs, item1, f1_title, ESCAPE_TEXT)) return false;
+                } else {
+                    if (!template_output_escape_str(out, p->title, ESCAPE_TEXT)) return false;
+                }
+                if (!template_output_append(out, example_lit_14, sizeof(example_lit_14) - 1)) return false;
+                if (f1_description >= 0) {
+                    if (!template_output_field(out, p->jobs, item1, f1_description, ESCAPE_TEXT)) return false;
+                } else {
+                    if (!template_output_escape_str(out, p->description, ESCAPE_TEXT)) return false;
+                }
+                if (!template_output_append(out, example_lit_15, sizeof(example_lit_15) - 1)) return false;
+                if (!template_output_append(out, example_lit_16, sizeof(example_lit_16) - 1)) return false;
+            }
+        }
+        if (!template_output_append(out, example_lit_17, sizeof(example_lit_17) - 1)) return false;
+    } else {
+        if (!template_output_append(out, example_lit_18, sizeof(example_lit_18) - 1)) return false;
+    }
+    if (!template_output_append(out, example_lit_19, sizeof(example_lit_19) - 1)) return false;
+    if (!template_output_escape_str(out, p->year, ESCAPE_TEXT)) return false;
+    if (!template_output_append(out, example_lit_20, sizeof(example_lit_20) - 1)) return false;
+    if (!template_output_escape_str(out, p->name, ESCAPE_TEXT)) return false;
+    if (!template_output_append(out, example_lit_21, sizeof(example_lit_21) - 1)) return false;
+    return true;
+}
+
+#define example_path    "example.html"
+
+void render_template_example(HTTPRequest *request, const Template_example *p) {
+    TemplateOutput out;
+    template_output_init(&out);
+    int64_t started = HTTPRequest_begin_phase(request, HTTP_PHASE_RENDER);
+    TRACE_PROBE1(render_start, example_path);
+    bool ok = template_example(p, &out);
+    TRACE_PROBE2(render_end, example_path, ok);
+    HTTPRequest_add_phase(request, HTTP_PHASE_RENDER, started);
+    template_output_send(request, &out, ok);
+}
+
+char *process_template_example(const Template_example *p) {
+    TemplateOutput out;
+    template_output_init(&out);
+    char *html = template_example(p, &out) ? template_output_join(&out) : NULL;
+    template_output_free(&out);
+    return html ? html : strdup("");
+}
@@ -0,0 +1,18 @@
+#pragma once
+#include "../../.engine/HTMLTemplating/HTMLTemplating.h"
+
+// Generated from templates/example.html
+typedef struct {
+    const char *name;
+    const char *title;
+    const char *image_url;
+    const char *about;
+    const TemplateList *projects;
+    const TemplateList *jobs;
+    const char *description;
+    const char *year;
+} Template_example;
+
+bool template_example(const Template_example *p, TemplateOutput *out);
+void render_template_example(HTTPRequest *request, const Template_example *p);
+char *process_template_example(const Template_example *p);
@@ -0,0 +1,203 @@
+#include ".cache/templates/home.h"
+#include "Trace.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char home_lit_0[] =
+    "<!DOCTYPE html>\r\n"
+    "<html lang=\"en\">\r\n"
+    "<head>\r\n"
+    "    <meta charset=\"UTF-8\" />\r\n"
+    "    <meta name=\"viewport\" content=\"width=device-width, initial-scale=1.0\" />\r\n"
+    "    <title>Your C Web Project</title>\r\n"
+    "    <style>\r\n"
+    "        body {\r\n"
+    "            margin: 0;\r\n"
+    "            padding: 0;\r\n"
+    "            font-family: \"Segoe UI\", Roboto, Arial, sans-serif;\r\n"
+    "            background-color: #1e1e1e; /* deep grey, not full black */\r\n"
+    "            color: #dedede;\r\n"
+    "            height: 100vh;\r\n"
+    "            display: flex;\r\n"
+    "            align-items: center;      /* vertical center */\r\n"
+    "            justify-content: center;  /* horizontal center */\r\n"
+    "        }\r\n"
+    "\r\n"
+    "        .card {\r\n"
+    "            background-color: #2a2a2a;\r\n"
+    "            padding: 40px 50px;\r\n"
+    "            border-radius: 14px;\r\n"
+    "            text-align: center;\r\n"
+    "            max-width: 600px;\r\n"
+    "            box-shadow: 0 0 25px rgba(0, 0, 0, 0.35);\r\n"
+    "        }\r\n"
+    "\r\n"
+    "        h1 {\r\n"
+    "            margin: 0 0 15px 0;\r\n"
+    "            font-size: 2rem;\r\n"
+    "            font-weight: 600;\r\n"
+    "        }\r\n"
+    "\r\n"
+    "        p {\r\n"
+    "            font-size: 1.1rem;\r\n"
+    "            line-height: 1.6;\r\n"
+    "            color: #c7c7c7;\r\n"
+    "        }\r\n"
+    "\r\n"
+    "        .hint {\r\n"
+    "            margin-top: 25px;\r\n"
+    "            font-size: 0.95rem;\r\n"
+    "            opacity: 0.85;\r\n"
+    "        }\r\n"
+    "    </style>\r\n"
+    "</head>\r\n"
+    "<body>\r\n"
+    "    <div class=\"card\">\r\n"
+    "        <h1>Your Project Is Running \360\237\216\211</h1>\r\n"
+    "        <p>\r\n"
+    "            This is your new project\342\200\231s home page.<br>\r\n"
+    "            Everything is set up correctly and ready to build on.\r\n"
+    "        </p>\r\n"
+    "        <p class=\"hint\">\r\n"
+    "            You can customize this page by editing <strong>templates/home.html</strong>,<br>\r\n"
+    "            or update your routes inside <strong>routes.c</strong> to add new pages.\r\n"
+    "        </p>\r\n"
+    "    </div>\r\n"
+    "</body>\r\n"
+    "</html>\r\n"
+    "\r\n";
+
+bool template_home(const Template_home *p, TemplateOutput *out) {
+    (void)p;
+    if (!template_output_append(out, home_lit_0, sizeof(home_lit_0) - 1)) return false;
+    return true;
+}
+
+static const unsigned char home_gzip[769] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x75, 0x55, 0xcd, 0x8e, 0xd3, 0x30,
+    0x10, 0xbe, 0xaf, 0xb4, 0xef, 0x30, 0x84, 0x0b, 0xa0, 0x26, 0x69, 0x96, 0xed, 0x02, 0x6d, 0x5a,
+    0x09, 0xc1, 0x22, 0x71, 0x02, 0x2d, 0x8b, 0x10, 0x47, 0x27, 0x9e, 0x26, 0x06, 0xc7, 0x8e, 0x6c,
+    0xf7, 0x27, 0x8b, 0x90, 0xb8, 0x72, 0xe1, 0xce, 0x89, 0x77, 0xe3, 0x09, 0x78, 0x04, 0xc6, 0x4d,
+    0xdb, 0x6d, 0xd3, 0xd6, 0x8e, 0x62, 0x39, 0xe3, 0x99, 0xf9, 0xe6, 0xc7, 0x5f, 0xd2, 0x07, 0xaf,
+    0xdf, 0xbd, 0xba, 0xfd, 0xfc, 0xfe, 0x1a, 0x4a, 0x57, 0xc9, 0xc9, 0xf9, 0x59, 0xea, 0x57, 0x90,
+    0x4c, 0x15, 0xe3, 0x00, 0x55, 0xb0, 0xfa, 0x82, 0x8c, 0xd3, 0x0a, 0x34, 0xd2, 0x0a, 0x1d, 0x83,
+    0xbc, 0x64, 0xc6, 0xa2, 0x1b, 0x07, 0x1f, 0x6f, 0xdf, 0x84, 0xcf, 0x03, 0x88, 0xf7, 0xa4, 0x8a,
+    0x55, 0x38, 0x0e, 0xe6, 0x02, 0x17, 0xb5, 0x36, 0x2e, 0x80, 0x5c, 0x2b, 0x87, 0x8a, 0x4e, 0x2f,
+    0x04, 0x77, 0xe5, 0x98, 0xe3, 0x5c, 0xe4, 0x18, 0xae, 0x36, 0x3d, 0x10, 0x4a, 0x38, 0xc1, 0x64,
+    0x68, 0x73, 0x26, 0x71, 0x9c, 0x44, 0xfd, 0x1d, 0x6b, 0x4e, 0x38, 0x89, 0x93, 0xcf, 0x7a, 0x66,
+    0xe0, 0x15, 0x7c, 0xc2, 0x0c, 0xde, 0x1b, 0xfd, 0x05, 0x73, 0x97, 0xc6, 0xad, 0x64, 0x7d, 0xcc,
+    0xba, 0x66, 0xbb, 0xf1, 0x23, 0xd3, 0xbc, 0x81, 0x6f, 0xf7, 0x7b, 0x3f, 0x2a, 0x66, 0x0a, 0xa1,
+    0x86, 0xd0, 0x1f, 0xed, 0x7f, 0xaf, 0x19, 0xe7, 0x42, 0x15, 0x87, 0x82, 0x29, 0x81, 0x0e, 0xa7,
+    0xac, 0x12, 0xb2, 0x19, 0x42, 0xf0, 0x01, 0x0b, 0x8d, 0xf0, 0xf1, 0x6d, 0xd0, 0x83, 0x1b, 0x9d,
+    0x69, 0xa7, 0x7b, 0xf0, 0xd2, 0x10, 0xec, 0x1e, 0x58, 0xa6, 0x6c, 0x68, 0xd1, 0x88, 0x69, 0xc7,
+    0x40, 0xc6, 0xf2, 0xaf, 0x85, 0xd1, 0x33, 0xc5, 0xc3, 0x5c, 0x4b, 0x6d, 0x86, 0xf0, 0x30, 0x41,
+    0x3f, 0x47, 0x10, 0x3f, 0x01, 0x8e, 0x58, 0x43, 0x61, 0xb0, 0xe9, 0x81, 0xd2, 0x0e, 0xa6, 0x33,
+    0x29, 0x21, 0x93, 0xa4, 0x02, 0x4f, 0xe2, 0x7d, 0x3b, 0x1b, 0x65, 0x8e, 0x7e, 0x76, 0x9c, 0x94,
+    0x28, 0x8a, 0xd2, 0x0d, 0x21, 0xe9, 0xf7, 0xe7, 0x65, 0x47, 0xc6, 0x85, 0xad, 0x25, 0x23, 0xf4,
+    0x53, 0x89, 0xcb, 0x8e, 0x8c, 0x49, 0x51, 0xa8, 0x50, 0x38, 0xac, 0xec, 0x10, 0x72, 0x2a, 0x0e,
+    0x9a, 0x51, 0x2b, 0x21, 0x6c, 0x73, 0x34, 0x4e, 0x50, 0x39, 0xd6, 0x82, 0x03, 0x44, 0x5f, 0x66,
+    0xd6, 0x89, 0x69, 0x13, 0xae, 0xeb, 0xba, 0x63, 0x80, 0x94, 0x4b, 0x6d, 0xc4, 0x1d, 0x09, 0x8e,
+    0xab, 0x7f, 0x3f, 0x3f, 0xbb, 0xdf, 0x44, 0x39, 0x33, 0xbc, 0x5b, 0xa8, 0x23, 0x69, 0xbb, 0x60,
+    0x7e, 0x9e, 0x2a, 0xdc, 0x65, 0xbf, 0x5e, 0xc2, 0x80, 0x5e, 0xdd, 0xfc, 0x6b, 0xc3, 0xd1, 0x84,
+    0x86, 0x71, 0x31, 0xa3, 0x20, 0x93, 0xcb, 0x83, 0x13, 0x0e, 0x97, 0x2e, 0x5c, 0x65, 0x62, 0x1b,
+    0x42, 0xb7, 0x69, 0x96, 0x6d, 0x9b, 0x0e, 0xe1, 0xaa, 0x7f, 0xcc, 0xc3, 0x32, 0xb4, 0x25, 0xe3,
+    0x7a, 0x41, 0xed, 0x43, 0xf3, 0x62, 0x40, 0x48, 0x4c, 0x91, 0xb1, 0x47, 0xfd, 0x1e, 0xac, 0x9f,
+    0xe8, 0xe9, 0xe0, 0xf1, 0xe8, 0x44, 0xfc, 0x65, 0x72, 0xb2, 0x4b, 0x69, 0x26, 0xde, 0xda, 0xd1,
+    0xae, 0xb4, 0xe2, 0x0e, 0x87, 0x70, 0x61, 0xb0, 0x3a, 0x26, 0x5d, 0xac, 0x5b, 0x82, 0x10, 0x9f,
+    0x72, 0x5c, 0x77, 0xfd, 0xee, 0x98, 0x4d, 0xa2, 0xe4, 0xd0, 0xb0, 0x14, 0x0a, 0xc3, 0x6d, 0xaf,
+    0x45, 0x57, 0xa3, 0xe3, 0x2d, 0x9a, 0x3f, 0xf3, 0xf3, 0x94, 0xd7, 0xa8, 0x14, 0xca, 0x1d, 0x8f,
+    0x38, 0x74, 0xba, 0x1e, 0xae, 0xf2, 0x77, 0x3a, 0xde, 0x7e, 0xf4, 0x62, 0x70, 0x88, 0x4c, 0xd7,
+    0x2c, 0x17, 0xae, 0xf1, 0xe2, 0xe7, 0x83, 0x7d, 0xcf, 0x7e, 0x49, 0xe3, 0x0d, 0x39, 0xa4, 0xf1,
+    0x9a, 0xc5, 0x52, 0x4f, 0x0f, 0x1b, 0xea, 0xe0, 0x62, 0x0e, 0xb9, 0x64, 0xd6, 0x8e, 0x03, 0xdf,
+    0x8c, 0xc1, 0x0e, 0x8b, 0xa4, 0x65, 0xd2, 0x52, 0xcf, 0x9a, 0x74, 0xe0, 0xad, 0x85, 0x9b, 0x99,
+    0x52, 0xd4, 0x74, 0xf0, 0xef, 0xcf, 0xaf, 0x9f, 0x64, 0x30, 0xd9, 0x3d, 0x5e, 0x4f, 0xf6, 0x91,
+    0xdd, 0x96, 0xc2, 0x02, 0x3d, 0x8d, 0xb7, 0xa1, 0x70, 0x01, 0x75, 0x6b, 0xe7, 0xef, 0x8f, 0xdf,
+    0x96, 0x6e, 0x49, 0x85, 0xd4, 0xc2, 0x05, 0x46, 0x69, 0x66, 0x3a, 0x8a, 0xd7, 0x74, 0xff, 0x1a,
+    0x57, 0x7a, 0x3f, 0xa4, 0x4e, 0x34, 0x0b, 0xb3, 0x9a, 0x52, 0x6c, 0x0c, 0x29, 0xcb, 0x06, 0x98,
+    0xe2, 0x60, 0x28, 0x94, 0x06, 0x9c, 0x86, 0x6c, 0x26, 0x24, 0x07, 0xad, 0xa2, 0x1d, 0x20, 0x71,
+    0xbd, 0x07, 0x6b, 0x13, 0x9f, 0xcf, 0x7e, 0xd0, 0x71, 0x45, 0xf1, 0x41, 0xce, 0x14, 0xe4, 0x74,
+    0xa3, 0x75, 0x45, 0x69, 0x06, 0xe7, 0x51, 0x7b, 0x60, 0x90, 0x35, 0x80, 0x9c, 0xb8, 0x99, 0x60,
+    0x10, 0xc3, 0x1a, 0xad, 0x8a, 0x09, 0xd1, 0x05, 0x31, 0x8a, 0x43, 0x1b, 0x7b, 0xfc, 0x91, 0xff,
+    0x51, 0xf8, 0x04, 0xaf, 0x64, 0xbd, 0xc3, 0x40, 0xb4, 0x21, 0xe4, 0x9c, 0xce, 0xb7, 0x39, 0xa0,
+    0x4b, 0x4d, 0xaa, 0x44, 0xf8, 0x56, 0x70, 0xdc, 0xda, 0x6c, 0xbf, 0x46, 0xf9, 0xd6, 0x90, 0x0f,
+    0x8b, 0xee, 0x76, 0x9b, 0x32, 0x02, 0x62, 0x8f, 0xc6, 0x96, 0xc6, 0x54, 0xba, 0x55, 0x59, 0xd7,
+    0xe5, 0xa4, 0x72, 0xb4, 0xff, 0xaf, 0xf3, 0xb3, 0xff, 0xdd, 0x09, 0x0e, 0xe7, 0xd3, 0x06, 0x00,
+    0x00,
+};
+static const unsigned char home_deflate[757] = {
+    0x78, 0x9c, 0x75, 0x55, 0xcd, 0x8e, 0xd3, 0x30, 0x10, 0xbe, 0xaf, 0xb4, 0xef, 0x30, 0x84, 0x0b,
+    0xa0, 0x26, 0x69, 0x96, 0xed, 0x02, 0x6d, 0x5a, 0x09, 0xc1, 0x22, 0x71, 0x02, 0x2d, 0x8b, 0x10,
+    0x47, 0x27, 0x9e, 0x26, 0x06, 0xc7, 0x8e, 0x6c, 0xf7, 0x27, 0x8b, 0x90, 0xb8, 0x72, 0xe1, 0xce,
+    0x89, 0x77, 0xe3, 0x09, 0x78, 0x04, 0xc6, 0x4d, 0xdb, 0x6d, 0xd3, 0xd6, 0x8e, 0x62, 0x39, 0xe3,
+    0x99, 0xf9, 0xe6, 0xc7, 0x5f, 0xd2, 0x07, 0xaf, 0xdf, 0xbd, 0xba, 0xfd, 0xfc, 0xfe, 0x1a, 0x4a,
+    0x57, 0xc9, 0xc9, 0xf9, 0x59, 0xea, 0x57, 0x90, 0x4c, 0x15, 0xe3, 0x00, 0x55, 0xb0, 0xfa, 0x82,
+    0x8c, 0xd3, 0x0a, 0x34, 0xd2, 0x0a, 0x1d, 0x83, 0xbc, 0x64, 0xc6, 0xa2, 0x1b, 0x07, 0x1f, 0x6f,
+    0xdf, 0x84, 0xcf, 0x03, 0x88, 0xf7, 0xa4, 0x8a, 0x55, 0x38, 0x0e, 0xe6, 0x02, 0x17, 0xb5, 0x36,
+    0x2e, 0x80, 0x5c, 0x2b, 0x87, 0x8a, 0x4e, 0x2f, 0x04, 0x77, 0xe5, 0x98, 0xe3, 0x5c, 0xe4, 0x18,
+    0xae, 0x36, 0x3d, 0x10, 0x4a, 0x38, 0xc1, 0x64, 0x68, 0x73, 0x26, 0x71, 0x9c, 0x44, 0xfd, 0x1d,
+    0x6b, 0x4e, 0x38, 0x89, 0x93, 0xcf, 0x7a, 0x66, 0xe0, 0x15, 0x7c, 0xc2, 0x0c, 0xde, 0x1b, 0xfd,
+    0x05, 0x73, 0x97, 0xc6, 0xad, 0x64, 0x7d, 0xcc, 0xba, 0x66, 0xbb, 0xf1, 0x23, 0xd3, 0xbc, 0x81,
+    0x6f, 0xf7, 0x7b, 0x3f, 0x2a, 0x66, 0x0a, 0xa1, 0x86, 0xd0, 0x1f, 0xed, 0x7f, 0xaf, 0x19, 0xe7,
+    0x42, 0x15, 0x87, 0x82, 0x29, 0x81, 0x0e, 0xa7, 0xac, 0x12, 0xb2, 0x19, 0x42, 0xf0, 0x01, 0x0b,
+    0x8d, 0xf0, 0xf1, 0x6d, 0xd0, 0x83, 0x1b, 0x9d, 0x69, 0xa7, 0x7b, 0xf0, 0xd2, 0x10, 0xec, 0x1e,
+    0x58, 0xa6, 0x6c, 0x68, 0xd1, 0x88, 0x69, 0xc7, 0x40, 0xc6, 0xf2, 0xaf, 0x85, 0xd1, 0x33, 0xc5,
+    0xc3, 0x5c, 0x4b, 0x6d, 0x86, 0xf0, 0x30, 0x41, 0x3f, 0x47, 0x10, 0x3f, 0x01, 0x8e, 0x58, 0x43,
+    0x61, 0xb0, 0xe9, 0x81, 0xd2, 0x0e, 0xa6, 0x33, 0x29, 0x21, 0x93, 0xa4, 0x02, 0x4f, 0xe2, 0x7d,
+    0x3b, 0x1b, 0x65, 0x8e, 0x7e, 0x76, 0x9c, 0x94, 0x28, 0x8a, 0xd2, 0x0d, 0x21, 0xe9, 0xf7, 0xe7,
+    0x65, 0x47, 0xc6, 0x85, 0xad, 0x25, 0x23, 0xf4, 0x53, 0x89, 0xcb, 0x8e, 0x8c, 0x49, 0x51, 0xa8,
+    0x50, 0x38, 0xac, 0xec, 0x10, 0x72, 0x2a, 0x0e, 0x9a, 0x51, 0x2b, 0x21, 0x6c, 0x73, 0x34, 0x4e,
+    0x50, 0x39, 0xd6, 0x82, 0x03, 0x44, 0x5f, 0x66, 0xd6, 0x89, 0x69, 0x13, 0xae, 0xeb, 0xba, 0x63,
+    0x80, 0x94, 0x4b, 0x6d, 0xc4, 0x1d, 0x09, 0x8e, 0xab, 0x7f, 0x3f, 0x3f, 0xbb, 0xdf, 0x44, 0x39,
+    0x33, 0xbc, 0x5b, 0xa8, 0x23, 0x69, 0xbb, 0x60, 0x7e, 0x9e, 0x2a, 0xdc, 0x65, 0xbf, 0x5e, 0xc2,
+    0x80, 0x5e, 0xdd, 0xfc, 0x6b, 0xc3, 0xd1, 0x84, 0x86, 0x71, 0x31, 0xa3, 0x20, 0x93, 0xcb, 0x83,
+    0x13, 0x0e, 0x97, 0x2e, 0x5c, 0x65, 0x62, 0x1b, 0x42, 0xb7, 0x69, 0x96, 0x6d, 0x9b, 0x0e, 0xe1,
+    0xaa, 0x7f, 0xcc, 0xc3, 0x32, 0xb4, 0x25, 0xe3, 0x7a, 0x41, 0xed, 0x43, 0xf3, 0x62, 0x40, 0x48,
+    0x4c, 0x91, 0xb1, 0x47, 0xfd, 0x1e, 0xac, 0x9f, 0xe8, 0xe9, 0xe0, 0xf1, 0xe8, 0x44, 0xfc, 0x65,
+    0x72, 0xb2, 0x4b, 0x69, 0x26, 0xde, 0xda, 0xd1, 0xae, 0xb4, 0xe2, 0x0e, 0x87, 0x70, 0x61, 0xb0,
+    0x3a, 0x26, 0x5d, 0xac, 0x5b, 0x82, 0x10, 0x9f, 0x72, 0x5c, 0x77, 0xfd, 0xee, 0x98, 0x4d, 0xa2,
+    0xe4, 0xd0, 0xb0, 0x14, 0x0a, 0xc3, 0x6d, 0xaf, 0x45, 0x57, 0xa3, 0xe3, 0x2d, 0x9a, 0x3f, 0xf3,
+    0xf3, 0x94, 0xd7, 0xa8, 0x14, 0xca, 0x1d, 0x8f, 0x38, 0x74, 0xba, 0x1e, 0xae, 0xf2, 0x77, 0x3a,
+    0xde, 0x7e, 0xf4, 0x62, 0x70, 0x88, 0x4c, 0xd7, 0x2c, 0x17, 0xae, 0xf1, 0xe2, 0xe7, 0x83, 0x7d,
+    0xcf, 0x7e, 0x49, 0xe3, 0x0d, 0x39, 0xa4, 0xf1, 0x9a, 0xc5, 0x52, 0x4f, 0x0f, 0x1b, 0xea, 0xe0,
+    0x62, 0x0e, 0xb9, 0x64, 0xd6, 0x8e, 0x03, 0xdf, 0x8c, 0xc1, 0x0e, 0x8b, 0xa4, 0x65, 0xd2, 0x52,
+    0xcf, 0x9a, 0x74, 0xe0, 0xad, 0x85, 0x9b, 0x99, 0x52, 0xd4, 0x74, 0xf0, 0xef, 0xcf, 0xaf, 0x9f,
+    0x64, 0x30, 0xd9, 0x3d, 0x5e, 0x4f, 0xf6, 0x91, 0xdd, 0x96, 0xc2, 0x02, 0x3d, 0x8d, 0xb7, 0xa1,
+    0x70, 0x01, 0x75, 0x6b, 0xe7, 0xef, 0x8f, 0xdf, 0x96, 0x6e, 0x49, 0x85, 0xd4, 0xc2, 0x05, 0x46,
+    0x69, 0x66, 0x3a, 0x8a, 0xd7, 0x74, 0xff, 0x1a, 0x57, 0x7a, 0x3f, 0xa4, 0x4e, 0x34, 0x0b, 0xb3,
+    0x9a, 0x52, 0x6c, 0x0c, 0x29, 0xcb, 0x06, 0x98, 0xe2, 0x60, 0x28, 0x94, 0x06, 0x9c, 0x86, 0x6c,
+    0x26, 0x24, 0x07, 0xad, 0xa2, 0x1d, 0x20, 0x71, 0xbd, 0x07, 0x6b, 0x13, 0x9f, 0xcf, 0x7e, 0xd0,
+    0x71, 0x45, 0xf1, 0x41, 0xce, 0x14, 0xe4, 0x74, 0xa3, 0x75, 0x45, 0x69, 0x06, 0xe7, 0x51, 0x7b,
+    0x60, 0x90, 0x35, 0x80, 0x9c, 0xb8, 0x99, 0x60, 0x10, 0xc3, 0x1a, 0xad, 0x8a, 0x09, 0xd1, 0x05,
+    0x31, 0x8a, 0x43, 0x1b, 0x7b, 0xfc, 0x91, 0xff, 0x51, 0xf8, 0x04, 0xaf, 0x64, 0xbd, 0xc3, 0x40,
+    0xb4, 0x21, 0xe4, 0x9c, 0xce, 0xb7, 0x39, 0xa0, 0x4b, 0x4d, 0xaa, 0x44, 0xf8, 0x56, 0x70, 0xdc,
+    0xda, 0x6c, 0xbf, 0x46, 0xf9, 0xd6, 0x90, 0x0f, 0x8b, 0xee, 0x76, 0x9b, 0x32, 0x02, 0x62, 0x8f,
+    0xc6, 0x96, 0xc6, 0x54, 0xba, 0x55, 0x59, 0xd7, 0xe5, 0xa4, 0x72, 0xb4, 0xff, 0xaf, 0xf3, 0xb3,
+    0xff, 0x3c, 0x43, 0xc7, 0xf5,
+};
+static const EncodedBody home_encoded[ENCODING_COUNT] = {
+    { NULL, 0 },
+    { (const char *)home_gzip, sizeof(home_gzip) },
+    { (const char *)home_deflate, sizeof(home_deflate) },
+};
+
+#define home_path    "home.html"
+
+void render_template_home(HTTPRequest *request, const Template_home *p) {
+    TemplateOutput out;
+    template_output_init(&out);
+    if (template_send_static(request, "\"73507f50c6e99e12\"", home_encoded)) return;
+    int64_t started = HTTPRequest_begin_phase(request, HTTP_PHASE_RENDER);
+    TRACE_PROBE1(render_start, home_path);
+    bool ok = template_home(p, &out);
+    TRACE_PROBE2(render_end, home_path, ok);
+    HTTPRequest_add_phase(request, HTTP_PHASE_RENDER, started);
+    template_output_send_etag(request, &out, ok, "\"73507f50c6e99e12\"");
+}
+
+char *process_template_home(const Template_home *p) {
+    TemplateOutput out;
+    template_output_init(&out);
+    char *html = template_home(p, &out) ? template_output_join(&out) : NULL;
+    template_output_free(&out);
+    return html ? html : strdup("");
+}
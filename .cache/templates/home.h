@@ -0,0 +1,11 @@
+#pragma once
+#include "../../.engine/HTMLTemplating/HTMLTemplating.h"
+
+// Generated from templates/home.html
+typedef struct {
+    char unused;
+} Template_home;
+
+bool template_home(const Template_home *p, TemplateOutput *out);
+void render_template_home(HTTPRequest *request, const Template_home *p);
+char *process_template_home(const Template_home *p);
@@ -0,0 +1,50 @@
+#include ".cache/templates/label_content.h"
+#include "Trace.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char label_content_lit_0[] =
+    "<div class=\"project\">\n"
+    "    <div>\n"
+    "        <h3>";
+
+static const char label_content_lit_1[] =
+    "</h3>\n"
+    "        <p>";
+
+static const char label_content_lit_2[] =
+    "</p>\n"
+    "    </div>\n"
+    "    <a href=\"#\" class=\"button\">View</a>\n"
+    "</div>\n";
+
+bool template_label_content(const Template_label_content *p, TemplateOutput *out) {
+    (void)p;
+    if (!template_output_append(out, label_content_lit_0, sizeof(label_content_lit_0) - 1)) return false;
+    if (!template_output_escape_str(out, p->title, ESCAPE_TEXT)) return false;
+    if (!template_output_append(out, label_content_lit_1, sizeof(label_content_lit_1) - 1)) return false;
+    if (!template_output_escape_str(out, p->description, ESCAPE_TEXT)) return false;
+    if (!template_output_append(out, label_content_lit_2, sizeof(label_content_lit_2) - 1)) return false;
+    return true;
+}
+
+#define label_content_path    "label_content.html"
+
+void render_template_label_content(HTTPRequest *request, const Template_label_content *p) {
+    TemplateOutput out;
+    template_output_init(&out);
+    int64_t started = HTTPRequest_begin_phase(request, HTTP_PHASE_RENDER);
+    TRACE_PROBE1(render_start, label_content_path);
+    bool ok = template_label_content(p, &out);
+    TRACE_PROBE2(render_end, label_content_path, ok);
+    HTTPRequest_add_phase(request, HTTP_PHASE_RENDER, started);
+    template_output_send(request, &out, ok);
+}
+
+char *process_template_label_content(const Template_label_content *p) {
+    TemplateOutput out;
+    template_output_init(&out);
+    char *html = template_label_content(p, &out) ? template_output_join(&out) : NULL;
+    template_output_free(&out);
+    return html ? html : strdup("");
+}
@@ -0,0 +1,12 @@
+#pragma once
+#include "../../.engine/HTMLTemplating/HTMLTemplating.h"
+
+// Generated from templates/label_content.html
+typedef struct {
+    const char *title;
+    const char *description;
+} Template_label_content;
+
+bool template_label_content(const Template_label_content *p, TemplateOutput *out);
+void render_template_label_content(HTTPRequest *request, const Template_label_content *p);
+char *process_template_label_content(const Template_label_content *p);
@@ -0,0 +1,41 @@
+#include ".cache/templates/subfolder_about.h"
+#include "Trace.h"
+#include <stdlib.h>
+#include <string.h>
+
+static const char subfolder_about_lit_0[] =
+    "<h1>About Page</h1>\n";
+
+bool template_subfolder_about(const Template_subfolder_about *p, TemplateOutput *out) {
+    (void)p;
+    if (!template_output_append(out, subfolder_about_lit_0, sizeof(subfolder_about_lit_0) - 1)) return false;
+    return true;
+}
+
+static const EncodedBody subfolder_about_encoded[ENCODING_COUNT] = {
+    { NULL, 0 },
+    { NULL, 0 },
+    { NULL, 0 },
+};
+
+#define subfolder_about_path    "subfolder/about.html"
+
+void render_template_subfolder_about(HTTPRequest *request, const Template_subfolder_about *p) {
+    TemplateOutput out;
+    template_output_init(&out);
+    if (template_send_static(request, "\"04726f6ed22836a7\"", subfolder_about_encoded)) return;
+    int64_t started = HTTPRequest_begin_phase(request, HTTP_PHASE_RENDER);
+    TRACE_PROBE1(render_start, subfolder_about_path);
+    bool ok = template_subfolder_about(p, &out);
+    TRACE_PROBE2(render_end, subfolder_about_path, ok);
+    HTTPRequest_add_phase(request, HTTP_PHASE_RENDER, started);
+    template_output_send_etag(request, &out, ok, "\"04726f6ed22836a7\"");
+}
+
+char *process_template_subfolder_about(const Template_subfolder_about *p) {
+    TemplateOutput out;
+    template_output_init(&out);
+    char *html = template_subfolder_about(p, &out) ? template_output_join(&out) : NULL;
+    template_output_free(&out);
+    return html ? html : strdup("");
+}
@@ -0,0 +1,11 @@
+#pragma once
+#include "../../.engine/HTMLTemplating/HTMLTemplating.h"
+
+// Generated from templates/subfolder/about.html
+typedef struct {
+    char unused;
+} Template_subfolder_about;
+
+bool template_subfolder_about(const Template_subfolder_about *p, TemplateOutput *out);
+void render_template_subfolder_about(HTTPRequest *request, const Template_subfolder_about *p);
+char *process_template_subfolder_about(const Template_subfolder_about *p);
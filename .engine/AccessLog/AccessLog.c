@@ -0,0 +1,273 @@
+#include "AccessLog.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+// Records per thread, a power of two
+#define ACCESS_LOG_RING_SIZE 1024
+// Producer threads with a ring, per process
+#define ACCESS_LOG_MAX_THREADS 128
+// How often the writer drains the rings: a ring absorbs RING_SIZE
+// requests per interval, about 50k/s per thread
+#define ACCESS_LOG_FLUSH_MS 20
+
+#define ACCESS_LOG_PATH_SIZE 160
+#define ACCESS_LOG_DETAIL_SIZE 512
+
+typedef struct {
+    int64_t time_ns;        // wall clock when the response was done
+    int64_t duration_ns;
+    int64_t phase_ns[HTTP_PHASE_COUNT];   // slow requests only
+    int status;
+    bool slow;
+    size_t bytes;
+    char method[8];
+    char path[ACCESS_LOG_PATH_SIZE];
+    char detail[ACCESS_LOG_DETAIL_SIZE];  // query and headers, verbose only
+} AccessLogRecord;
+
+// head is only written by the owning thread and tail only by the writer,
+// each on its own cache line
+typedef struct {
+    uint64_t head __attribute__((aligned(64)));
+    uint64_t tail __attribute__((aligned(64)));
+    uint64_t dropped;
+    int id;
+    AccessLogRecord records[ACCESS_LOG_RING_SIZE];
+} AccessLogRing;
+
+static AccessLogRing *rings[ACCESS_LOG_MAX_THREADS];
+static int ring_count = 0;
+static pthread_mutex_t register_lock = PTHREAD_MUTEX_INITIALIZER;
+static __thread AccessLogRing *thread_ring = NULL;
+static __thread unsigned sample_counter = 0;
+
+static int log_level = ACCESS_LOG_OFF;
+static int log_sample = 1;
+static int64_t slow_ns = 0;
+static bool accepting = false;
+static int log_fd = -1;
+static bool running = false;
+static bool stop_requested = false;
+static pthread_t writer;
+
+// First record of a thread: the ring lives as long as the process, so the
+// writer never races with a thread that exits
+static AccessLogRing *register_thread(void) {
+    pthread_mutex_lock(&register_lock);
+    if (ring_count < ACCESS_LOG_MAX_THREADS) {
+        AccessLogRing *ring = calloc(1, sizeof(AccessLogRing));
+        if (ring) {
+            ring->id = ring_count;
+            __atomic_store_n(&rings[ring_count], ring, __ATOMIC_RELEASE);
+            __atomic_store_n(&ring_count, ring_count + 1, __ATOMIC_RELEASE);
+            thread_ring = ring;
+        }
+    }
+    pthread_mutex_unlock(&register_lock);
+    return thread_ring;
+}
+
+// "Name: value, Name: value" after the query string, cut at the buffer size
+static void format_detail(const HTTPRequest *request, char *out, size_t size) {
+    int n = snprintf(out, size, "%s%s", request->query ? "?" : "", request->query ? request->query : "");
+    size_t used = (n >= 0 && (size_t)n < size) ? (size_t)n : size - 1;
+    for (size_t i = 0; i < request->header_count && used < size - 1; i++) {
+        const HTTPHeader *h = &request->header_list[i];
+        n = snprintf(out + used, size - used, "%s%s: %s", i > 0 ? ", " : (used ? " {" : "{"),
+                     h->key ? h->key : "", h->value ? h->value : "");
+        used += (n >= 0 && (size_t)n < size - used) ? (size_t)n : size - 1 - used;
+    }
+    if (request->header_count > 0 && used < size - 1) {
+        out[used++] = '}';
+        out[used] = '\0';
+    }
+}
+
+void AccessLog_request(const HTTPRequest *request) {
+    if (!__atomic_load_n(&accepting, __ATOMIC_ACQUIRE)) return;
+
+    int64_t duration = request->received_ns ? HTTPServer_now_ns() - request->received_ns : 0;
+    bool slow = slow_ns > 0 && duration >= slow_ns;
+    if (!slow) {
+        if (log_level == ACCESS_LOG_OFF) return;
+        if (request->status_code < 400) {
+            if (log_level == ACCESS_LOG_ERRORS) return;
+            if (log_sample > 1 && ++sample_counter % log_sample != 0) return;
+        }
+    }
+
+    AccessLogRing *ring = thread_ring ? thread_ring : register_thread();
+    if (!ring) return;
+
+    uint64_t head = ring->head;
+    if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) >= ACCESS_LOG_RING_SIZE) {
+        __atomic_add_fetch(&ring->dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    AccessLogRecord *r = &ring->records[head & (ACCESS_LOG_RING_SIZE - 1)];
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    r->time_ns = (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+    r->duration_ns = duration;
+    r->status = request->status_code;
+    r->slow = slow;
+    if (slow) memcpy(r->phase_ns, request->phase_ns, sizeof(r->phase_ns));
+    r->bytes = request->response_bytes;
+    snprintf(r->method, sizeof(r->method), "%s", request->method);
+    snprintf(r->path, sizeof(r->path), "%s", request->path ? request->path : "-");
+    r->detail[0] = '\0';
+    if (log_level == ACCESS_LOG_VERBOSE) format_detail(request, r->detail, sizeof(r->detail));
+
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+// Batches are at most PIPE_BUF bytes and end on a line, so the lines of
+// several worker processes sharing a pipe never interleave
+typedef struct {
+    char data[PIPE_BUF];
+    size_t len;
+} Batch;
+
+static void flush_batch(Batch *batch) {
+    size_t written = 0;
+    while (written < batch->len) {
+        ssize_t n = write(log_fd, batch->data + written, batch->len - written);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        written += n;
+    }
+    batch->len = 0;
+}
+
+static void append_line(Batch *batch, const char *line, size_t len) {
+    if (batch->len + len > sizeof(batch->data)) flush_batch(batch);
+    if (len > sizeof(batch->data)) len = sizeof(batch->data);
+    memcpy(batch->data + batch->len, line, len);
+    batch->len += len;
+}
+
+static void format_record(Batch *batch, int thread_id, const AccessLogRecord *r) {
+    time_t seconds = r->time_ns / 1000000000;
+    struct tm tm;
+    gmtime_r(&seconds, &tm);
+    char timestamp[32];
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%S", &tm);
+
+    char status[12];
+    // 0 when the connection was handed to a coalesced request's leader
+    if (r->status > 0) snprintf(status, sizeof(status), "%d", r->status);
+    else strcpy(status, "-");
+
+    char phases[HTTP_PHASE_COUNT * 32] = "";
+    if (r->slow) {
+        size_t used = snprintf(phases, sizeof(phases), " slow");
+        for (int p = 0; p < HTTP_PHASE_COUNT; p++) {
+            used += snprintf(phases + used, sizeof(phases) - used, " %s=%.3fms",
+                             HTTPServer_phase_name(p), r->phase_ns[p] / 1e6);
+        }
+    }
+
+    char line[ACCESS_LOG_PATH_SIZE + ACCESS_LOG_DETAIL_SIZE + sizeof(phases) + 128];
+    int len = snprintf(line, sizeof(line), "%s.%03dZ t%d %s %s %s %zu %.3fms%s%s%s\n",
+                       timestamp, (int)(r->time_ns / 1000000 % 1000), thread_id, r->method, r->path,
+                       status, r->bytes, r->duration_ns / 1e6, phases, r->detail[0] ? " " : "", r->detail);
+    if (len >= (int)sizeof(line)) {
+        len = sizeof(line) - 1;
+        line[len - 1] = '\n';
+    }
+    append_line(batch, line, len);
+}
+
+// Drains every ring into the batch
+static void drain(Batch *batch) {
+    int count = __atomic_load_n(&ring_count, __ATOMIC_ACQUIRE);
+    for (int i = 0; i < count; i++) {
+        AccessLogRing *ring = __atomic_load_n(&rings[i], __ATOMIC_ACQUIRE);
+        uint64_t tail = ring->tail;
+        uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        for (; tail != head; tail++) {
+            format_record(batch, ring->id, &ring->records[tail & (ACCESS_LOG_RING_SIZE - 1)]);
+        }
+        __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+    }
+}
+
+static void *writer_thread(void *arg) {
+    (void)arg;
+    static Batch batch;
+    uint64_t reported_drops = 0;
+    bool stopping = false;
+    while (!stopping) {
+        stopping = __atomic_load_n(&stop_requested, __ATOMIC_ACQUIRE);
+        drain(&batch);
+
+        uint64_t drops = AccessLog_dropped();
+        if (drops != reported_drops) {
+            char line[96];
+            int len = snprintf(line, sizeof(line), "access log: %llu records dropped, rings full\n",
+                               (unsigned long long)(drops - reported_drops));
+            append_line(&batch, line, len);
+            reported_drops = drops;
+        }
+        flush_batch(&batch);
+
+        if (!stopping) {
+            struct timespec pause = { 0, ACCESS_LOG_FLUSH_MS * 1000000 };
+            nanosleep(&pause, NULL);
+        }
+    }
+    return NULL;
+}
+
+bool AccessLog_start(int level, int sample, int slow_ms, const char *path) {
+    if (running || (level <= ACCESS_LOG_OFF && slow_ms <= 0)) return true;
+
+    log_fd = STDOUT_FILENO;
+    if (path && *path) {
+        log_fd = open(path, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+        if (log_fd < 0) {
+            perror("Failed to open access log");
+            return false;
+        }
+    }
+    log_level = level > ACCESS_LOG_OFF ? level : ACCESS_LOG_OFF;
+    log_sample = sample > 0 ? sample : 1;
+    slow_ns = slow_ms > 0 ? (int64_t)slow_ms * 1000000 : 0;
+    __atomic_store_n(&stop_requested, false, __ATOMIC_RELEASE);
+    if (pthread_create(&writer, NULL, writer_thread, NULL) != 0) {
+        perror("Failed to start access log writer");
+        if (log_fd != STDOUT_FILENO) close(log_fd);
+        return false;
+    }
+    running = true;
+    __atomic_store_n(&accepting, true, __ATOMIC_RELEASE);
+    return true;
+}
+
+void AccessLog_stop(void) {
+    if (!running) return;
+    __atomic_store_n(&accepting, false, __ATOMIC_RELEASE);
+    __atomic_store_n(&stop_requested, true, __ATOMIC_RELEASE);
+    pthread_join(writer, NULL);
+    if (log_fd != STDOUT_FILENO) close(log_fd);
+    log_fd = -1;
+    running = false;
+}
+
+uint64_t AccessLog_dropped(void) {
+    uint64_t total = 0;
+    int count = __atomic_load_n(&ring_count, __ATOMIC_ACQUIRE);
+    for (int i = 0; i < count; i++) {
+        AccessLogRing *ring = __atomic_load_n(&rings[i], __ATOMIC_ACQUIRE);
+        total += __atomic_load_n(&ring->dropped, __ATOMIC_RELAXED);
+    }
+    return total;
+}
@@ -0,0 +1,145 @@
+#include "Compression.h"
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <zlib.h>
+
+// One stream per coding per worker, deflateInit2 only runs once per thread.
+// Workers live as long as the process, so the state is never torn down.
+static __thread z_stream *streams[ENCODING_COUNT];
+static __thread char *output;
+static __thread size_t output_size;
+
+static const char *names[ENCODING_COUNT] = { NULL, "gzip", "deflate" };
+
+// Parses the q-value of one Accept-Encoding element, 1 when absent
+static double parse_quality(const char *params, const char *end) {
+    const char *q = params;
+    while (q < end) {
+        while (q < end && (*q == ';' || *q == ' ')) q++;
+        if (end - q >= 2 && (q[0] == 'q' || q[0] == 'Q') && q[1] == '=') {
+            return strtod(q + 2, NULL);
+        }
+        while (q < end && *q != ';') q++;
+    }
+    return 1.0;
+}
+
+ContentEncoding Compression_negotiate(const char *accept_encoding) {
+    if (!accept_encoding) return ENCODING_IDENTITY;
+
+    double quality[ENCODING_COUNT] = { 0 };
+    bool listed[ENCODING_COUNT] = { false };
+    double wildcard = 0;
+    bool has_wildcard = false;
+
+    const char *p = accept_encoding;
+    while (*p) {
+        while (*p == ' ' || *p == ',') p++;
+        if (!*p) break;
+
+        const char *end = strchr(p, ',');
+        if (!end) end = p + strlen(p);
+        size_t token_len = strcspn(p, ";, ");
+        if (p + token_len > end) token_len = end - p;
+        double q = parse_quality(p + token_len, end);
+
+        if (token_len == 1 && *p == '*') {
+            wildcard = q;
+            has_wildcard = true;
+        }
+        for (int i = ENCODING_GZIP; i < ENCODING_COUNT; i++) {
+            if (strlen(names[i]) == token_len && strncasecmp(p, names[i], token_len) == 0) {
+                quality[i] = q;
+                listed[i] = true;
+            }
+        }
+        // x-gzip is the same coding under its old name
+        if (token_len == 6 && strncasecmp(p, "x-gzip", 6) == 0 && !listed[ENCODING_GZIP]) {
+            quality[ENCODING_GZIP] = q;
+            listed[ENCODING_GZIP] = true;
+        }
+        p = end;
+    }
+
+    ContentEncoding best = ENCODING_IDENTITY;
+    double best_quality = 0;
+    for (int i = ENCODING_GZIP; i < ENCODING_COUNT; i++) {
+        double q = listed[i] ? quality[i] : (has_wildcard ? wildcard : 0);
+        if (q > best_quality) {
+            best = i;
+            best_quality = q;
+        }
+    }
+    return best;
+}
+
+const char *Compression_name(ContentEncoding encoding) {
+    return (encoding > ENCODING_IDENTITY && encoding < ENCODING_COUNT) ? names[encoding] : NULL;
+}
+
+bool Compression_compressible(const char *content_type) {
+    if (!content_type || !*content_type) return true;  // the server default is text/html
+    return strncasecmp(content_type, "text/", 5) == 0 ||
+           strncasecmp(content_type, "application/json", 16) == 0 ||
+           strncasecmp(content_type, "application/javascript", 22) == 0 ||
+           strncasecmp(content_type, "application/xml", 15) == 0 ||
+           strncasecmp(content_type, "image/svg+xml", 13) == 0;
+}
+
+static z_stream *thread_stream(ContentEncoding encoding) {
+    if (streams[encoding]) {
+        deflateReset(streams[encoding]);
+        return streams[encoding];
+    }
+
+    z_stream *stream = calloc(1, sizeof(z_stream));
+    if (!stream) return NULL;
+
+    // windowBits 15 is the zlib format "deflate" names, +16 wraps it as gzip
+    int window_bits = (encoding == ENCODING_GZIP) ? 15 + 16 : 15;
+    if (deflateInit2(stream, COMPRESSION_LEVEL, Z_DEFLATED, window_bits, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        fprintf(stderr, "deflateInit2 failed\n");
+        free(stream);
+        return NULL;
+    }
+    streams[encoding] = stream;
+    return stream;
+}
+
+bool Compression_compress(ContentEncoding encoding, const struct iovec *iov, int iov_count,
+                          const char **out, size_t *out_len) {
+    if (encoding <= ENCODING_IDENTITY || encoding >= ENCODING_COUNT) return false;
+
+    z_stream *stream = thread_stream(encoding);
+    if (!stream) return false;
+
+    size_t total = 0;
+    for (int i = 0; i < iov_count; i++) {
+        total += iov[i].iov_len;
+    }
+
+    // deflateBound is enough for the whole body in one pass
+    size_t bound = deflateBound(stream, total);
+    if (bound > output_size) {
+        char *grown = realloc(output, bound);
+        if (!grown) return false;
+        output = grown;
+        output_size = bound;
+    }
+
+    stream->next_out = (Bytef *)output;
+    stream->avail_out = output_size;
+    for (int i = 0; i < iov_count; i++) {
+        stream->next_in = iov[i].iov_base;
+        stream->avail_in = iov[i].iov_len;
+        if (deflate(stream, Z_NO_FLUSH) == Z_STREAM_ERROR || stream->avail_in != 0) return false;
+    }
+    if (deflate(stream, Z_FINISH) != Z_STREAM_END) return false;
+
+    *out = output;
+    *out_len = output_size - stream->avail_out;
+    return true;
+}
@@ -0,0 +1,717 @@
+#include "HTMLTemplating.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+// Compiles every file under TEMPLATE_DIR into a C render function:
+// literal bytes become static data, every {{ key }} becomes a typed
+// field of a generated params struct. Passing a key the template does
+// not use is then a compile-time error in the view. {% if %} and
+// {% for %} become plain C control flow and includes are inlined.
+
+typedef enum {
+    PARAM_STRING,
+    PARAM_INT,
+    PARAM_FLOAT,
+    PARAM_BOOL,
+    PARAM_LIST
+} CompiledParamType;
+
+typedef struct {
+    char name[128];
+    CompiledParamType type;
+    bool explicit_type;
+} CompiledParam;
+
+// A {% for %} being compiled. Includes "with" a loop variable push a copy
+// whose fields are recorded on the owning loop.
+typedef struct {
+    char var[64];
+    char list[128];
+    int id;
+    int owner;
+    bool unqualified;
+    char fields[32][64];
+    int field_count;
+} CompileScope;
+
+typedef struct {
+    const char *ident;
+    const char *path;
+    bool emitting;          // pass 1 only collects params, pass 2 writes code
+    FILE *fc;               // literals go straight to the C file
+    FILE *body;             // function body being written
+    int indent;
+    CompiledParam params[128];
+    int param_count;
+    CompileScope scopes[TEMPLATE_MAX_DEPTH];
+    int scope_count;
+    int literal_count;
+    int loop_count;
+    int include_depth;
+    bool ok;
+} CompileContext;
+
+static void init_generated_templates_header() {
+    const char *path = "GeneratedTemplates.h";
+    FILE *f = fopen(path, "w"); // "w" truncates the file, starting fresh
+    if (!f) return;
+    fprintf(f, "#pragma once\n\n");
+    fclose(f);
+}
+
+static void append_to_generated_templates_header(const char *ident) {
+    const char *path = "GeneratedTemplates.h";
+    FILE *f = fopen(path, "a");
+    if (!f) return;
+    fprintf(f, "#include \".cache/templates/%s.h\"\n", ident);
+    fclose(f);
+}
+
+// "subfolder/about.html" -> "subfolder_about"
+static void template_identifier(const char *path, char *out, size_t size) {
+    size_t n = 0;
+    const char *ext = strrchr(path, '.');
+    for (const char *p = path; *p && p != ext && n + 1 < size; p++) {
+        out[n++] = isalnum((unsigned char)*p) ? *p : '_';
+    }
+    out[n] = '\0';
+}
+
+static void compile_error(CompileContext *ctx, const TemplateSegment *seg, const char *message) {
+    if (!ctx->ok) return;
+    fprintf(stderr, "%s: %s in %.*s\n", ctx->path, message, (int)seg->len, seg->text);
+    ctx->ok = false;
+}
+
+static bool parse_param_type(const TemplateSegment *seg, CompiledParamType *type) {
+    if (!seg->hint || seg->hint_len == 0) {
+        *type = PARAM_STRING;
+        return true;
+    }
+
+    static const struct { const char *name; CompiledParamType type; } types[] = {
+        {"string", PARAM_STRING},
+        {"int",    PARAM_INT},
+        {"float",  PARAM_FLOAT},
+        {"bool",   PARAM_BOOL},
+    };
+    for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+        if (strlen(types[i].name) == seg->hint_len && strncmp(types[i].name, seg->hint, seg->hint_len) == 0) {
+            *type = types[i].type;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool copy_identifier(const char *src, size_t len, char *out, size_t size) {
+    if (len == 0 || len >= size) return false;
+    if (!isalpha((unsigned char)src[0]) && src[0] != '_') return false;
+    for (size_t i = 0; i < len; i++) {
+        if (!isalnum((unsigned char)src[i]) && src[i] != '_') return false;
+    }
+    memcpy(out, src, len);
+    out[len] = '\0';
+    return true;
+}
+
+// Registers a top-level param (pass 1) or looks it up (pass 2)
+static CompiledParam *use_param(CompileContext *ctx, const TemplateSegment *seg, const char *name,
+                                CompiledParamType type, bool explicit_type) {
+    for (int i = 0; i < ctx->param_count; i++) {
+        CompiledParam *param = &ctx->params[i];
+        if (strcmp(param->name, name) != 0) continue;
+        if (ctx->emitting || !explicit_type) return param;
+
+        if (param->explicit_type && param->type != type) {
+            compile_error(ctx, seg, "conflicting types");
+        }
+        param->type = type;
+        param->explicit_type = true;
+        return param;
+    }
+
+    if (ctx->emitting || ctx->param_count == (int)(sizeof(ctx->params) / sizeof(ctx->params[0]))) {
+        compile_error(ctx, seg, "too many params");
+        return NULL;
+    }
+    CompiledParam *param = &ctx->params[ctx->param_count++];
+    strcpy(param->name, name);
+    param->type = type;
+    param->explicit_type = explicit_type;
+    return param;
+}
+
+static void emit(CompileContext *ctx, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+static void emit(CompileContext *ctx, const char *fmt, ...) {
+    if (!ctx->emitting) return;
+    fprintf(ctx->body, "%*s", 4 * ctx->indent, "");
+    va_list args;
+    va_start(args, fmt);
+    vfprintf(ctx->body, fmt, args);
+    va_end(args);
+}
+
+static void write_c_literal(FILE *fc, const char *data, size_t len) {
+    fprintf(fc, "    \"");
+    size_t column = 0;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = data[i];
+        switch (c) {
+            case '\n': fprintf(fc, "\\n"); break;
+            case '\t': fprintf(fc, "\\t"); break;
+            case '\r': fprintf(fc, "\\r"); break;
+            case '"':  fprintf(fc, "\\\""); break;
+            case '\\': fprintf(fc, "\\\\"); break;
+            case '?':  fprintf(fc, "\\?"); break; // avoid trigraphs
+            default:
+                if (isprint(c)) fputc(c, fc);
+                else fprintf(fc, "\\%03o", c);
+        }
+        column++;
+        if ((c == '\n' || column >= 100) && i + 1 < len) {
+            fprintf(fc, "\"\n    \"");
+            column = 0;
+        }
+    }
+    fprintf(fc, "\"");
+}
+
+static CompileScope *find_scope(CompileContext *ctx, const char *var, size_t var_len) {
+    for (int i = ctx->scope_count - 1; i >= 0; i--) {
+        if (strlen(ctx->scopes[i].var) == var_len && strncmp(ctx->scopes[i].var, var, var_len) == 0) {
+            return &ctx->scopes[i];
+        }
+    }
+    return NULL;
+}
+
+static CompileScope *innermost_with(CompileContext *ctx) {
+    for (int i = ctx->scope_count - 1; i >= 0; i--) {
+        if (ctx->scopes[i].unqualified) return &ctx->scopes[i];
+    }
+    return NULL;
+}
+
+// Records a field read inside a loop, the index is looked up once before the loop
+static bool use_field(CompileContext *ctx, CompileScope *scope, const char *field, size_t field_len, char *name) {
+    if (!copy_identifier(field, field_len, name, 64)) return false;
+    CompileScope *owner = &ctx->scopes[scope->owner];
+    for (int i = 0; i < owner->field_count; i++) {
+        if (strcmp(owner->fields[i], name) == 0) return true;
+    }
+    if (owner->field_count == 32) return false;
+    strcpy(owner->fields[owner->field_count++], name);
+    return true;
+}
+
+// A key is either "var.field", a field of the innermost "with" scope, or a param.
+// A bare key inside "with" sets both: like the runtime, the param is read
+// when the item has no such field.
+typedef struct {
+    CompileScope *scope;
+    char field[64];
+    CompiledParam *param;
+} CompiledRef;
+
+static bool resolve_key(CompileContext *ctx, const TemplateSegment *seg, CompiledParamType type, bool explicit_type, CompiledRef *ref) {
+    memset(ref, 0, sizeof(*ref));
+
+    const char *dot = memchr(seg->key, '.', seg->key_len);
+    CompileScope *scope = dot ? find_scope(ctx, seg->key, dot - seg->key) : innermost_with(ctx);
+    if (dot && !scope) {
+        compile_error(ctx, seg, "unknown loop variable");
+        return false;
+    }
+
+    if (scope) {
+        const char *field = dot ? dot + 1 : seg->key;
+        size_t field_len = dot ? (size_t)(seg->key + seg->key_len - field) : seg->key_len;
+        ref->scope = &ctx->scopes[scope->owner];
+        if (!use_field(ctx, scope, field, field_len, ref->field)) {
+            compile_error(ctx, seg, "invalid field name");
+            return false;
+        }
+        if (dot) return true;
+    }
+
+    char name[128];
+    if (!copy_identifier(seg->key, seg->key_len, name, sizeof(name))) {
+        compile_error(ctx, seg, "param is not a valid C identifier");
+        return false;
+    }
+    ref->param = use_param(ctx, seg, name, type, explicit_type);
+    return ref->param != NULL;
+}
+
+static void compile_range(CompileContext *ctx, const Template *tpl, int start, int end);
+
+static void compile_literal(CompileContext *ctx, const TemplateSegment *seg) {
+    if (!ctx->emitting) return;
+    int n = ctx->literal_count++;
+    fprintf(ctx->fc, "static const char %s_lit_%d[] =\n", ctx->ident, n);
+    write_c_literal(ctx->fc, seg->text, seg->len);
+    fprintf(ctx->fc, ";\n\n");
+    emit(ctx, "if (!template_output_append(out, %s_lit_%d, sizeof(%s_lit_%d) - 1)) return false;\n",
+         ctx->ident, n, ctx->ident, n);
+}
+
+static const char *escape_name(TemplateEscape escape) {
+    switch (escape) {
+        case ESCAPE_ATTR: return "ESCAPE_ATTR";
+        case ESCAPE_UNQUOTED: return "ESCAPE_UNQUOTED";
+        case ESCAPE_RAW:  return "ESCAPE_RAW";
+        default:          return "ESCAPE_TEXT";
+    }
+}
+
+static void compile_param_value(CompileContext *ctx, const TemplateSegment *seg, const CompiledParam *param) {
+    const char *name = param->name;
+    switch (param->type) {
+        case PARAM_STRING:
+            if (seg->escape == ESCAPE_RAW) {
+                emit(ctx, "if (!template_output_append_str(out, p->%s)) return false;\n", name);
+            } else {
+                emit(ctx, "if (!template_output_escape_str(out, p->%s, %s)) return false;\n",
+                     name, escape_name(seg->escape));
+            }
+            break;
+        case PARAM_INT:
+            emit(ctx, "if (!write_int(out, &p->%s)) return false;\n", name);
+            break;
+        case PARAM_FLOAT:
+            emit(ctx, "if (!write_float(out, &p->%s)) return false;\n", name);
+            break;
+        case PARAM_BOOL:
+            emit(ctx, "if (!write_bool(out, &p->%s)) return false;\n", name);
+            break;
+        case PARAM_LIST:
+            emit(ctx, "if (!write_list(out, p->%s)) return false;\n", name);
+            break;
+    }
+}
+
+static void compile_param(CompileContext *ctx, const TemplateSegment *seg) {
+    CompiledParamType type;
+    if (!parse_param_type(seg, &type)) {
+        compile_error(ctx, seg, "unknown type");
+        return;
+    }
+
+    CompiledRef ref;
+    if (!resolve_key(ctx, seg, type, seg->hint_len > 0, &ref)) return;
+
+    if (!ref.scope) {
+        compile_param_value(ctx, seg, ref.param);
+        return;
+    }
+
+    if (ref.param) {
+        emit(ctx, "if (f%d_%s >= 0) {\n", ref.scope->id, ref.field);
+        ctx->indent++;
+    }
+    emit(ctx, "if (!template_output_field(out, p->%s, item%d, f%d_%s, %s)) return false;\n",
+         ref.scope->list, ref.scope->id, ref.scope->id, ref.field, escape_name(seg->escape));
+    if (ref.param) {
+        ctx->indent--;
+        emit(ctx, "} else {\n");
+        ctx->indent++;
+        compile_param_value(ctx, seg, ref.param);
+        ctx->indent--;
+        emit(ctx, "}\n");
+    }
+}
+
+static int compile_if(CompileContext *ctx, const Template *tpl, int s) {
+    const TemplateSegment *seg = &tpl->segments[s];
+    const TemplateSegment *branch = &tpl->segments[seg->jump];
+    int endif = branch->type == SEGMENT_ELSE ? branch->jump : seg->jump;
+
+    CompiledParamType type;
+    CompiledRef ref;
+    if (!parse_param_type(seg, &type)) {
+        compile_error(ctx, seg, "unknown type");
+        return endif;
+    }
+    if (!resolve_key(ctx, seg, type, seg->hint_len > 0, &ref)) return endif;
+
+    char param_cond[512] = "";
+    if (ref.param) {
+        const char *name = ref.param->name;
+        switch (ref.param->type) {
+            case PARAM_STRING: snprintf(param_cond, sizeof(param_cond), "template_truthy(p->%s)", name); break;
+            case PARAM_INT:    snprintf(param_cond, sizeof(param_cond), "p->%s != 0", name); break;
+            case PARAM_FLOAT:  snprintf(param_cond, sizeof(param_cond), "p->%s != 0.0f", name); break;
+            case PARAM_BOOL:   snprintf(param_cond, sizeof(param_cond), "p->%s", name); break;
+            case PARAM_LIST:   snprintf(param_cond, sizeof(param_cond), "p->%s && p->%s->count > 0", name, name); break;
+        }
+    }
+
+    char cond[1024] = "";
+    if (ref.scope && ref.param) {
+        snprintf(cond, sizeof(cond), "f%d_%s >= 0 ? template_field_truthy(p->%s, item%d, f%d_%s) : (%s)",
+                 ref.scope->id, ref.field, ref.scope->list, ref.scope->id, ref.scope->id, ref.field, param_cond);
+    } else if (ref.scope) {
+        snprintf(cond, sizeof(cond), "template_field_truthy(p->%s, item%d, f%d_%s)",
+                 ref.scope->list, ref.scope->id, ref.scope->id, ref.field);
+    } else {
+        snprintf(cond, sizeof(cond), "%s", param_cond);
+    }
+
+    emit(ctx, "if (%s(%s)) {\n", seg->negate ? "!" : "", cond);
+    ctx->indent++;
+    compile_range(ctx, tpl, s + 1, seg->jump);
+    ctx->indent--;
+    if (branch->type == SEGMENT_ELSE) {
+        emit(ctx, "} else {\n");
+        ctx->indent++;
+        compile_range(ctx, tpl, seg->jump + 1, endif);
+        ctx->indent--;
+    }
+    emit(ctx, "}\n");
+    return endif;
+}
+
+static void compile_for(CompileContext *ctx, const Template *tpl, int s) {
+    const TemplateSegment *seg = &tpl->segments[s];
+
+    char var[64], list[128];
+    if (!copy_identifier(seg->var, seg->var_len, var, sizeof(var)) ||
+        !copy_identifier(seg->key, seg->key_len, list, sizeof(list))) {
+        compile_error(ctx, seg, "loops must iterate a top-level list param");
+        return;
+    }
+    if (ctx->scope_count == TEMPLATE_MAX_DEPTH) {
+        compile_error(ctx, seg, "blocks nested too deep");
+        return;
+    }
+
+    CompiledParam *param = use_param(ctx, seg, list, PARAM_LIST, true);
+    if (!param) return;
+
+    int id = ctx->loop_count++;
+    CompileScope *scope = &ctx->scopes[ctx->scope_count];
+    memset(scope, 0, sizeof(*scope));
+    strcpy(scope->var, var);
+    strcpy(scope->list, list);
+    scope->id = id;
+    scope->owner = ctx->scope_count++;
+
+    // Write the body aside so the fields it reads are known first
+    FILE *outer = ctx->body;
+    char *body_buf = NULL;
+    size_t body_len = 0;
+    int outer_indent = ctx->indent;
+    if (ctx->emitting) {
+        ctx->body = open_memstream(&body_buf, &body_len);
+        ctx->indent = outer_indent + 2;
+    }
+
+    compile_range(ctx, tpl, s + 1, seg->jump);
+
+    if (ctx->emitting) {
+        fclose(ctx->body);
+        ctx->body = outer;
+        ctx->indent = outer_indent;
+
+        emit(ctx, "if (p->%s) {\n", list);
+        ctx->indent++;
+        for (int i = 0; i < scope->field_count; i++) {
+            emit(ctx, "int f%d_%s = template_list_field(p->%s, \"%s\");\n", id, scope->fields[i], list, scope->fields[i]);
+        }
+        emit(ctx, "for (size_t i%d = 0; i%d < p->%s->count; i%d++) {\n", id, id, list, id);
+        ctx->indent++;
+        emit(ctx, "const void *item%d = template_list_item(p->%s, i%d);\n", id, list, id);
+        emit(ctx, "(void)item%d;\n", id);
+        fwrite(body_buf, 1, body_len, ctx->body);
+        ctx->indent--;
+        emit(ctx, "}\n");
+        ctx->indent--;
+        emit(ctx, "}\n");
+    }
+    free(body_buf);
+    ctx->scope_count--;
+}
+
+// Partials are inlined, they share the params struct of the includer
+static void compile_include(CompileContext *ctx, const TemplateSegment *seg) {
+    char path[512];
+    if (seg->key_len >= sizeof(path) || ctx->include_depth == TEMPLATE_MAX_DEPTH) {
+        compile_error(ctx, seg, "include nested too deep");
+        return;
+    }
+    memcpy(path, seg->key, seg->key_len);
+    path[seg->key_len] = '\0';
+
+    const Template *partial = template_load(path);
+    if (!partial) {
+        compile_error(ctx, seg, "included template could not be read");
+        return;
+    }
+
+    bool pushed = false;
+    if (seg->var) {
+        CompileScope *with = find_scope(ctx, seg->var, seg->var_len);
+        if (!with || ctx->scope_count == TEMPLATE_MAX_DEPTH) {
+            compile_error(ctx, seg, "unknown loop variable");
+            return;
+        }
+        CompileScope *scope = &ctx->scopes[ctx->scope_count++];
+        *scope = *with;
+        scope->unqualified = true;
+        pushed = true;
+    }
+
+    ctx->include_depth++;
+    compile_range(ctx, partial, 0, partial->segment_count);
+    ctx->include_depth--;
+
+    if (pushed) ctx->scope_count--;
+}
+
+static void compile_range(CompileContext *ctx, const Template *tpl, int start, int end) {
+    for (int s = start; s < end && ctx->ok; s++) {
+        const TemplateSegment *seg = &tpl->segments[s];
+        switch (seg->type) {
+            case SEGMENT_LITERAL: compile_literal(ctx, seg); break;
+            case SEGMENT_PARAM:   compile_param(ctx, seg); break;
+            case SEGMENT_IF:      s = compile_if(ctx, tpl, s); break;
+            case SEGMENT_FOR:     compile_for(ctx, tpl, s); s = seg->jump; break;
+            case SEGMENT_INCLUDE: compile_include(ctx, seg); break;
+            default: break;
+        }
+    }
+}
+
+static void write_header(CompileContext *ctx, FILE *fh, const char *rel_path) {
+    fprintf(fh,
+        "#pragma once\n"
+        "#include \"../../.engine/HTMLTemplating/HTMLTemplating.h\"\n\n"
+        "// Generated from %s/%s\n"
+        "typedef struct {\n",
+        TEMPLATE_DIR, rel_path
+    );
+
+    for (int i = 0; i < ctx->param_count; i++) {
+        const char *ctype = "const char *";
+        if (ctx->params[i].type == PARAM_INT) ctype = "int ";
+        else if (ctx->params[i].type == PARAM_FLOAT) ctype = "float ";
+        else if (ctx->params[i].type == PARAM_BOOL) ctype = "bool ";
+        else if (ctx->params[i].type == PARAM_LIST) ctype = "const TemplateList *";
+        fprintf(fh, "    %s%s;\n", ctype, ctx->params[i].name);
+    }
+    if (ctx->param_count == 0) fprintf(fh, "    char unused;\n");
+
+    fprintf(fh,
+        "} Template_%s;\n\n"
+        "bool template_%s(const Template_%s *p, TemplateOutput *out);\n"
+        "void render_template_%s(HTTPRequest *request, const Template_%s *p);\n"
+        "char *process_template_%s(const Template_%s *p);\n",
+        ctx->ident,
+        ctx->ident, ctx->ident,
+        ctx->ident, ctx->ident,
+        ctx->ident, ctx->ident
+    );
+}
+
+// Static pages ship their gzip/deflate bodies as arrays, compressed at build time
+static void write_encoded_bodies(FILE *fc, const char *ident, const Template *tpl) {
+    for (int e = ENCODING_GZIP; e < ENCODING_COUNT; e++) {
+        const EncodedBody *body = &tpl->encoded[e];
+        if (!body->data) continue;
+        fprintf(fc, "static const unsigned char %s_%s[%zu] = {", ident, Compression_name(e), body->len);
+        for (size_t i = 0; i < body->len; i++) {
+            fprintf(fc, "%s0x%02x,", (i % 16 == 0) ? "\n    " : " ", (unsigned char)body->data[i]);
+        }
+        fprintf(fc, "\n};\n");
+    }
+
+    fprintf(fc, "static const EncodedBody %s_encoded[ENCODING_COUNT] = {\n", ident);
+    for (int e = 0; e < ENCODING_COUNT; e++) {
+        if (tpl->encoded[e].data) {
+            fprintf(fc, "    { (const char *)%s_%s, sizeof(%s_%s) },\n",
+                    ident, Compression_name(e), ident, Compression_name(e));
+        } else {
+            fprintf(fc, "    { NULL, 0 },\n");
+        }
+    }
+    fprintf(fc, "};\n\n");
+}
+
+static bool generate_template_files(const char *rel_path) {
+    const Template *tpl = template_load(rel_path);
+    if (!tpl) {
+        fprintf(stderr, "%s: could not be read\n", rel_path);
+        return false;
+    }
+
+    char ident[256], path_h[512], path_c[512];
+    template_identifier(rel_path, ident, sizeof(ident));
+    snprintf(path_h, sizeof(path_h), ".cache/templates/%s.h", ident);
+    snprintf(path_c, sizeof(path_c), ".cache/templates/%s.c", ident);
+
+    CompileContext *ctx = calloc(1, sizeof(CompileContext));
+    if (!ctx) return false;
+    ctx->ident = ident;
+    ctx->path = rel_path;
+    ctx->ok = true;
+
+    // Pass 1: settle every param and its type
+    compile_range(ctx, tpl, 0, tpl->segment_count);
+    if (!ctx->ok) {
+        free(ctx);
+        return false;
+    }
+
+    FILE *fh = fopen(path_h, "w");
+    FILE *fc = fopen(path_c, "w");
+    if (!fh || !fc) {
+        if (fh) fclose(fh);
+        if (fc) fclose(fc);
+        free(ctx);
+        return false;
+    }
+
+    append_to_generated_templates_header(ident);
+
+    // --- H file ---
+    write_header(ctx, fh, rel_path);
+    fclose(fh);
+
+    // --- C file ---
+    fprintf(fc,
+        "#include \"%s\"\n"
+        "#include \"Trace.h\"\n"
+        "#include <stdlib.h>\n"
+        "#include <string.h>\n\n",
+        path_h
+    );
+
+    /* LITERALS + BUILD (pass 2) */
+    char *body_buf = NULL;
+    size_t body_len = 0;
+    ctx->emitting = true;
+    ctx->fc = fc;
+    ctx->body = open_memstream(&body_buf, &body_len);
+    ctx->indent = 1;
+    ctx->loop_count = 0;
+    compile_range(ctx, tpl, 0, tpl->segment_count);
+    fclose(ctx->body);
+
+    fprintf(fc,
+        "bool template_%s(const Template_%s *p, TemplateOutput *out) {\n"
+        "    (void)p;\n",
+        ident, ident
+    );
+    fwrite(body_buf, 1, body_len, fc);
+    fprintf(fc, "    return true;\n}\n\n");
+    free(body_buf);
+
+    /* RENDER */
+    if (tpl->is_static) write_encoded_bodies(fc, ident, tpl);
+    // Template name passed to the render_start/render_end probes
+    fprintf(fc, "#define %s_path", ident);
+    write_c_literal(fc, rel_path, strlen(rel_path));
+    fprintf(fc, "\n\n");
+    fprintf(fc,
+        "void render_template_%s(HTTPRequest *request, const Template_%s *p) {\n"
+        "    TemplateOutput out;\n"
+        "    template_output_init(&out);\n",
+        ident, ident
+    );
+    if (tpl->is_static) {
+        // The body never changes, its ETag is computed here at build time
+        fprintf(fc,
+            "    if (template_send_static(request, \"\\\"%.16s\\\"\", %s_encoded)) return;\n"
+            "    int64_t started = HTTPRequest_begin_phase(request, HTTP_PHASE_RENDER);\n"
+            "    TRACE_PROBE1(render_start, %s_path);\n"
+            "    bool ok = template_%s(p, &out);\n"
+            "    TRACE_PROBE2(render_end, %s_path, ok);\n"
+            "    HTTPRequest_add_phase(request, HTTP_PHASE_RENDER, started);\n"
+            "    template_output_send_etag(request, &out, ok, \"\\\"%.16s\\\"\");\n"
+            "}\n\n",
+            tpl->etag + 1, ident, ident, ident, ident, tpl->etag + 1
+        );
+    } else {
+        fprintf(fc,
+            "    int64_t started = HTTPRequest_begin_phase(request, HTTP_PHASE_RENDER);\n"
+            "    TRACE_PROBE1(render_start, %s_path);\n"
+            "    bool ok = template_%s(p, &out);\n"
+            "    TRACE_PROBE2(render_end, %s_path, ok);\n"
+            "    HTTPRequest_add_phase(request, HTTP_PHASE_RENDER, started);\n"
+            "    template_output_send(request, &out, ok);\n"
+            "}\n\n",
+            ident, ident, ident
+        );
+    }
+
+    /* PROCESS */
+    fprintf(fc,
+        "char *process_template_%s(const Template_%s *p) {\n"
+        "    TemplateOutput out;\n"
+        "    template_output_init(&out);\n"
+        "    char *html = template_%s(p, &out) ? template_output_join(&out) : NULL;\n"
+        "    template_output_free(&out);\n"
+        "    return html ? html : strdup(\"\");\n"
+        "}\n",
+        ident, ident, ident
+    );
+    fclose(fc);
+
+    bool ok = ctx->ok;
+    free(ctx);
+    printf("Template %s compiled -> %s\n", rel_path, path_c);
+    return ok;
+}
+
+// Walks TEMPLATE_DIR recursively, rel is the path below it
+static bool compile_dir(const char *rel) {
+    char dir_path[1024];
+    if (rel[0]) snprintf(dir_path, sizeof(dir_path), "%s/%s", TEMPLATE_DIR, rel);
+    else snprintf(dir_path, sizeof(dir_path), "%s", TEMPLATE_DIR);
+
+    DIR *dir = opendir(dir_path);
+    if (!dir) {
+        fprintf(stderr, "Cannot open template dir %s\n", dir_path);
+        return false;
+    }
+
+    bool ok = true;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+
+        char child_rel[1024], child_path[2048];
+        if (rel[0]) snprintf(child_rel, sizeof(child_rel), "%s/%s", rel, entry->d_name);
+        else snprintf(child_rel, sizeof(child_rel), "%s", entry->d_name);
+        snprintf(child_path, sizeof(child_path), "%s/%s", TEMPLATE_DIR, child_rel);
+
+        struct stat st;
+        if (stat(child_path, &st) != 0) continue;
+
+        if (S_ISDIR(st.st_mode)) {
+            ok = compile_dir(child_rel) && ok;
+        } else if (S_ISREG(st.st_mode)) {
+            ok = generate_template_files(child_rel) && ok;
+        }
+    }
+    closedir(dir);
+    return ok;
+}
+
+int main() {
+    mkdir(".cache/templates", 0755);
+    init_generated_templates_header();
+
+    if (!compile_dir("")) {
+        printf("Template compilation failed\n");
+        return 1;
+    }
+    return 0;
+}
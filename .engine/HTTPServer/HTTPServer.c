@@ -1,4 +1,8 @@
 #include "HTTPServer.h"
+#include "Compression.h"
+#include "TLS.h"
+#include "Trace.h"
+#include "config.h"
 #include<sys/types.h>
 #include<netinet/in.h>
 #include<sys/socket.h>
@@ -7,6 +11,17 @@
 #include<string.h>
 #include<arpa/inet.h>
 #include<stdlib.h>
+#include<limits.h>
+#include<errno.h>
+#include<poll.h>
+#include<fcntl.h>
+#include<sys/un.h>
+#include<sys/stat.h>
+#include<time.h>
+
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
 
 bool HTTPRequest_add_header(HTTPRequest *req, const char *key, const char *value) {
     if (!req || !key || !value) return false;
@@ -40,6 +55,53 @@ const char *HTTPRequest_get_header(HTTPRequest *req, const char *key) {
     return NULL;
 }
 
+bool HTTPRequest_remove_header(HTTPRequest *req, const char *key) {
+    if (!req || !key) return false;
+
+    for (size_t i = 0; i < req->header_count; i++) {
+        if (strcasecmp(req->header_list[i].key, key) == 0) {
+            free(req->header_list[i].key);
+            free(req->header_list[i].value);
+            req->header_list[i] = req->header_list[--req->header_count];
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool HTTPRequest_etag_matches(HTTPRequest *req, const char *etag) {
+    const char *p = HTTPRequest_get_header(req, "If-None-Match");
+    if (!p || !etag) return false;
+    if (strncmp(etag, "W/", 2) == 0) etag += 2;  // weak comparison, as for the request side
+    size_t etag_len = strlen(etag);
+
+    while (*p) {
+        while (*p == ' ' || *p == ',') p++;
+        if (*p == '*') return true;
+        if (strncmp(p, "W/", 2) == 0) p += 2;
+
+        const char *end = strchr(p, ',');
+        size_t len = end ? (size_t)(end - p) : strlen(p);
+        while (len > 0 && p[len - 1] == ' ') len--;
+        if (len == etag_len && strncmp(p, etag, len) == 0) return true;
+        if (!end) break;
+        p = end;
+    }
+    return false;
+}
+
+void HTTPServer_format_etag(uint64_t hash, char *etag) {
+    static const char hex[] = "0123456789abcdef";
+    etag[0] = '"';
+    for (int i = 0; i < 16; i++) {
+        etag[16 - i] = hex[hash & 0xf];
+        hash >>= 4;
+    }
+    etag[17] = '"';
+    etag[18] = '\0';
+}
+
 static void parse_headers(HTTPRequest *req) {
     if (!req->headers) return;
 
@@ -108,6 +170,7 @@ static void parse_query_params(HTTPRequest *req, char *query) {
 
 void HTTPRequest_free(HTTPRequest *req) {
     free(req->path);
+    free(req->query);
     free(req->headers);
     free(req->body);
 
@@ -124,20 +187,15 @@ void HTTPRequest_free(HTTPRequest *req) {
     free(req->header_list);
 }
 
-HTTPServer *HTTPServer_create(int port) {
-	HTTPServer *server=malloc(sizeof(HTTPServer));
-	if (!server) {
-		perror("Failed to allocate server");
-		return NULL;
-	}
-
-	server->port=port;
+// Deep enough that bursts (or a proxy opening many connections at once)
+// are queued by the kernel instead of refused
+#define LISTEN_BACKLOG SOMAXCONN
 
+static bool create_tcp_listener(HTTPServer *server, int port) {
 	server->server_fd=socket(AF_INET, SOCK_STREAM, 0);
 	if(server->server_fd < 0) {
 		perror("Socket creation failed");
-		free(server);
-		return NULL;
+		return false;
 	}
 
 	int opt = 1;
@@ -149,54 +207,194 @@ HTTPServer *HTTPServer_create(int port) {
 
 	if(bind(server->server_fd, (struct sockaddr *)&server->address, sizeof(server->address)) < 0) {
 		perror("Bind failed");
-		close(server->server_fd);
-		free(server);
-		return NULL;
+		return false;
 	}
 
-	if (listen(server->server_fd, 3) < 0) {
+	if (listen(server->server_fd, LISTEN_BACKLOG) < 0) {
 		perror("Listen failed");
-		close(server->server_fd);
+		return false;
+	}
+
+	printf("Server created on port %s://localhost:%d\n", TLS_enabled() ? "https" : "http", port);
+	return true;
+}
+
+// Same-host reverse proxies connect here and skip the TCP stack
+static bool create_unix_listener(HTTPServer *server, const char *path) {
+	struct sockaddr_un address = {0};
+	address.sun_family = AF_UNIX;
+	if (strlen(path) >= sizeof(address.sun_path)) {
+		fprintf(stderr, "Unix socket path too long: %s\n", path);
+		return false;
+	}
+	strcpy(address.sun_path, path);
+
+	server->unix_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (server->unix_fd < 0) {
+		perror("Unix socket creation failed");
+		return false;
+	}
+
+	// A socket file left behind by a previous run would make bind fail
+	unlink(path);
+	if (bind(server->unix_fd, (struct sockaddr *)&address, sizeof(address)) < 0) {
+		perror("Unix socket bind failed");
+		return false;
+	}
+	server->unix_path = strdup(path);
+
+	// Reachable by a proxy running as another user, like a loopback port would be
+	chmod(path, 0666);
+
+	if (listen(server->unix_fd, LISTEN_BACKLOG) < 0) {
+		perror("Unix socket listen failed");
+		return false;
+	}
+
+	printf("Server listening on unix:%s\n", path);
+	return true;
+}
+
+// Polled listeners may be shared by several processes: the ones that
+// lose the race for a client must not block in accept on that socket
+static void share_listeners(HTTPServer *server) {
+	if (server->server_fd < 0 || server->unix_fd < 0) return;
+	fcntl(server->server_fd, F_SETFL, fcntl(server->server_fd, F_GETFL) | O_NONBLOCK);
+	fcntl(server->unix_fd, F_SETFL, fcntl(server->unix_fd, F_GETFL) | O_NONBLOCK);
+}
+
+HTTPServer *HTTPServer_create(int port, const char *unix_path) {
+	HTTPServer *server=calloc(1, sizeof(HTTPServer));
+	if (!server) {
+		perror("Failed to allocate server");
+		return NULL;
+	}
+
+	server->port=port;
+	server->server_fd = -1;
+	server->unix_fd = -1;
+	server->owner = getpid();
+
+	bool use_tcp = port > 0;
+	bool use_unix = unix_path && strlen(unix_path) > 0;
+	if (!use_tcp && !use_unix) {
+		fprintf(stderr, "No TCP port or Unix socket path to listen on\n");
 		free(server);
 		return NULL;
 	}
 
-	printf("Server created on port http://localhost:%d\n", port);
+	if ((use_tcp && !create_tcp_listener(server, port)) ||
+	    (use_unix && !create_unix_listener(server, unix_path))) {
+		HTTPServer_destroy(server);
+		return NULL;
+	}
+
+	share_listeners(server);
 	return server;
 }
 
-HTTPRequest HTTPServer_listen(HTTPServer *server) {
-    HTTPRequest request = {0};
-    request.params = NULL;
-    request.param_count = 0;
-    request.param_capacity = 0;
+HTTPServer *HTTPServer_adopt(int server_fd, int unix_fd) {
+	if (server_fd < 0 && unix_fd < 0) return NULL;
 
-    struct sockaddr_in client_address;
-    socklen_t addrlen = sizeof(client_address);
-    int client_socket = accept(
-        server->server_fd,
-        (struct sockaddr *)&client_address,
-        &addrlen
-    );
+	HTTPServer *server=calloc(1, sizeof(HTTPServer));
+	if (!server) {
+		perror("Failed to allocate server");
+		return NULL;
+	}
+	server->server_fd = server_fd;
+	server->unix_fd = unix_fd;
+	server->owner = getpid();
+
+	if (server_fd >= 0) {
+		socklen_t len = sizeof(server->address);
+		if (getsockname(server_fd, (struct sockaddr *)&server->address, &len) < 0) {
+			perror("Inherited TCP listener");
+			HTTPServer_destroy(server);
+			return NULL;
+		}
+		server->port = ntohs(server->address.sin_port);
+		printf("Server inherited port %s://localhost:%d\n", TLS_enabled() ? "https" : "http", server->port);
+	}
+	if (unix_fd >= 0) {
+		struct sockaddr_un address = {0};
+		socklen_t len = sizeof(address);
+		if (getsockname(unix_fd, (struct sockaddr *)&address, &len) < 0 || address.sun_family != AF_UNIX) {
+			perror("Inherited Unix listener");
+			HTTPServer_destroy(server);
+			return NULL;
+		}
+		server->unix_path = strdup(address.sun_path);
+		printf("Server inherited unix:%s\n", server->unix_path);
+	}
+	share_listeners(server);
+	return server;
+}
 
-    if (client_socket < 0) {
-        perror("Failed to accept connection");
-        return request;
-    }
+// Accepts from whichever listener is ready, -1 on error. TLS is only
+// negotiated with TCP clients, the Unix socket is for a local proxy.
+static int accept_client(HTTPServer *server, bool *is_tcp) {
+	int listeners[2];
+	int count = 0;
+	if (server->server_fd >= 0) listeners[count++] = server->server_fd;
+	if (server->unix_fd >= 0) listeners[count++] = server->unix_fd;
+
+	// A single listener stays blocking, the kernel wakes one process per client
+	if (count == 1) {
+		*is_tcp = (listeners[0] == server->server_fd);
+		while (true) {
+			int client_socket = accept(listeners[0], NULL, NULL);
+			if (client_socket >= 0) return client_socket;
+			if (errno != EINTR) {
+				perror("Failed to accept connection");
+				return -1;
+			}
+			if (server->stopping) return -1;
+		}
+	}
 
-    char buffer[8192];
-    int bytes = read(client_socket, buffer, sizeof(buffer) - 1);
-    if (bytes <= 0) {
-        close(client_socket);
-        return request;
-    }
-    buffer[bytes] = '\0';
+	while (true) {
+		struct pollfd fds[2];
+		for (int i = 0; i < count; i++) {
+			fds[i].fd = listeners[i];
+			fds[i].events = POLLIN;
+			fds[i].revents = 0;
+		}
+		if (poll(fds, count, -1) < 0) {
+			if (errno != EINTR) {
+				perror("Failed to poll listeners");
+				return -1;
+			}
+			if (server->stopping) return -1;
+			continue;
+		}
+
+		// Start the scan after the listener served last time
+		for (int i = 0; i < count; i++) {
+			int index = (server->next_listener + i) % count;
+			if (!(fds[index].revents & POLLIN)) continue;
+
+			int client_socket = accept(fds[index].fd, NULL, NULL);
+			if (client_socket >= 0) {
+				server->next_listener = index + 1;
+				*is_tcp = (fds[index].fd == server->server_fd);
+				return client_socket;
+			}
+			// Another process took it first
+			if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+				perror("Failed to accept connection");
+				return -1;
+			}
+		}
+	}
+}
 
+// Request line, query params, headers and body of a raw request
+void HTTPRequest_parse(HTTPRequest *req, const char *buffer) {
     char raw_path[1024];
     sscanf(buffer, "%s %1023s %s",
-        request.method,
+        req->method,
         raw_path,
-        request.version
+        req->version
     );
 
     //SPLIT PATH & QUERY
@@ -207,11 +405,12 @@ HTTPRequest HTTPServer_listen(HTTPServer *server) {
         query++;
     }
 
-    request.path = strdup(raw_path);
+    req->path = strdup(raw_path);
 
     if (query) {
+        req->query = strdup(query);
         char *query_copy = strdup(query);
-        parse_query_params(&request, query_copy);
+        parse_query_params(req, query_copy);
         free(query_copy);
     }
 
@@ -219,17 +418,18 @@ HTTPRequest HTTPServer_listen(HTTPServer *server) {
     char *headers_start = strstr(buffer, "\r\n");
     char *body_start    = strstr(buffer, "\r\n\r\n");
 
-    if (headers_start && body_start) {
+    // Equal when the request has no header lines at all
+    if (headers_start && body_start && body_start > headers_start) {
         size_t len = body_start - headers_start - 2;
-        request.headers = malloc(len + 1);
-        memcpy(request.headers, headers_start + 2, len);
-        request.headers[len] = 0;
-        request.headers_len = len;
-        request.header_list = NULL;
-        request.header_count = 0;
-        request.header_capacity = 0;
+        req->headers = malloc(len + 1);
+        memcpy(req->headers, headers_start + 2, len);
+        req->headers[len] = 0;
+        req->headers_len = len;
+        req->header_list = NULL;
+        req->header_count = 0;
+        req->header_capacity = 0;
 
-        parse_headers(&request);
+        parse_headers(req);
 
     }
 
@@ -237,18 +437,81 @@ HTTPRequest HTTPServer_listen(HTTPServer *server) {
     if (body_start) {
         char *body = body_start + 4;
 
-        request.body_len = strlen(body);
-        request.body = strdup(body);
+        req->body_len = strlen(body);
+        req->body = strdup(body);
     }
+}
+
+void HTTPServer_stop(HTTPServer *server) {
+	server->stopping = 1;
+}
+
+HTTPRequest HTTPServer_listen(HTTPServer *server) {
+    HTTPRequest request = {0};
+    request.params = NULL;
+    request.param_count = 0;
+    request.param_capacity = 0;
 
+    bool is_tcp = false;
+    int client_socket = accept_client(server, &is_tcp);
+    if (client_socket < 0) {
+        return request;
+    }
+    request.received_ns = HTTPServer_now_ns();
     request.client_socket = client_socket;
+    TRACE_PROBE1(accept, client_socket);
+
+    // A client that never sends, or stalls its handshake, gives up a worker
+    // thread after the deadline instead of holding every accept
+    struct timeval timeout = { HTTP_READ_TIMEOUT_SECONDS, 0 };
+    setsockopt(client_socket, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    request.unread = true;
+    request.tls_pending = is_tcp && TLS_enabled();
+    // Bytes already in are read here in one call; otherwise a worker waits
+    struct pollfd ready = { client_socket, POLLIN, 0 };
+    if (!request.tls_pending && poll(&ready, 1, 0) > 0) HTTPServer_read_request(&request);
     return request;
 }
 
+bool HTTPServer_read_request(HTTPRequest *request) {
+    int client_socket = request->client_socket;
+    request->unread = false;
+
+    struct ssl_st *tls = NULL;
+    if (request->tls_pending) {
+        request->tls_pending = false;
+        tls = TLS_accept(client_socket);
+        if (!tls) {
+            close(client_socket);
+            return false;
+        }
+    }
+
+    // The accepting thread takes SIGTERM and SIGALRM without SA_RESTART, to
+    // leave accept; they must not drop a client it is already reading
+    char buffer[8192];
+    ssize_t bytes;
+    do {
+        bytes = tls ? TLS_read(tls, buffer, sizeof(buffer) - 1) : read(client_socket, buffer, sizeof(buffer) - 1);
+    } while (bytes < 0 && errno == EINTR);
+    if (bytes <= 0) {
+        HTTPServer_close(client_socket, tls);
+        return false;
+    }
+    buffer[bytes] = '\0';
+
+    HTTPRequest_parse(request, buffer);
+    TRACE_PROBE3(parse_complete, client_socket, request->method, request->path);
+    request->tls = tls;
+    return true;
+}
+
 const char *get_default_status_message(int status_code) {
 	switch(status_code) {
 		case 200: return "OK";
 		case 201: return "Created";
+		case 304: return "Not Modified";
 		case 400: return "Bad Request";
 		case 404: return "Not Found";
 		case 500: return "Internal Server Error";
@@ -257,28 +520,223 @@ const char *get_default_status_message(int status_code) {
 	}
 }
 
-void HTTPServer_send_response(HTTPRequest *request, const char *body, const char *content_type, int status_code, const char *status_message) {
-	const char *final_status_message = (status_message && strlen(status_message) > 0)? status_message:get_default_status_message(status_code);
-	const char *final_content_type = (content_type && strlen(content_type) > 0)? content_type: "text/html";	
+// Write every iovec, in IOV_MAX batches, resuming after partial writes
+static bool write_all_iov(int fd, struct iovec *iov, int iovcnt) {
+	while (iovcnt > 0) {
+		int batch = iovcnt < IOV_MAX ? iovcnt : IOV_MAX;
+		ssize_t written = writev(fd, iov, batch);
+		if (written < 0) {
+			if (errno == EINTR) continue;
+			return false;
+		}
+
+		while (iovcnt > 0 && (size_t)written >= iov->iov_len) {
+			written -= iov->iov_len;
+			iov++;
+			iovcnt--;
+		}
+		if (iovcnt > 0) {
+			iov->iov_base = (char *)iov->iov_base + written;
+			iov->iov_len -= written;
+		}
+	}
+	return true;
+}
+
+// With kTLS the kernel encrypts, so the socket takes writev as is.
+// The iovecs are consumed.
+static bool write_connection(int fd, struct ssl_st *tls, struct iovec *iov, int iovcnt) {
+	if (tls && !TLS_kernel_send(tls)) return TLS_write_iov(tls, iov, iovcnt);
+	return write_all_iov(fd, iov, iovcnt);
+}
+
+bool HTTPServer_write(int fd, struct ssl_st *tls, const struct iovec *iov, int iov_count) {
+	if (iov_count <= 0) return true;
+
+	// Callers may write the same iovecs to several connections
+	struct iovec *copy = malloc(iov_count * sizeof(struct iovec));
+	if (!copy) return false;
+	memcpy(copy, iov, iov_count * sizeof(struct iovec));
+	bool ok = write_connection(fd, tls, copy, iov_count);
+	free(copy);
+	return ok;
+}
+
+void HTTPServer_close(int fd, struct ssl_st *tls) {
+	TLS_close(tls);
+	close(fd);
+}
+
+// Adds Content-Encoding and Vary to the caller's headers. A strong ETag names
+// the identity bytes, so an encoded body carries its weak form instead.
+static bool encoding_headers(char *buf, size_t size, const char *extra, const char *encoding) {
+	const char *etag = extra ? strstr(extra, "ETag: \"") : NULL;
+	int len;
+	if (etag && encoding) {
+		len = snprintf(buf, size, "%.*sETag: W/%s", (int)(etag - extra), extra, etag + 6);
+	} else {
+		len = snprintf(buf, size, "%s", extra ? extra : "");
+	}
+	if (len < 0 || (size_t)len >= size) return false;
+
+	if (encoding) {
+		len += snprintf(buf + len, size - len, "Content-Encoding: %s\r\n", encoding);
+	}
+	len += snprintf(buf + len, size - len, "Vary: Accept-Encoding\r\n");
+	return (size_t)len < size;
+}
+
+// Server-Timing with the phases measured until the headers go out; the
+// handler and the write are still running, total is the time since accept.
+// Not for responses stored in the response cache: their headers are
+// replayed to other clients.
+static void server_timing(const HTTPRequest *request, char *buf, size_t size) {
+	static const HTTPPhase phases[] = { HTTP_PHASE_QUEUE, HTTP_PHASE_ROUTE, HTTP_PHASE_DB, HTTP_PHASE_RENDER };
+	if (request->received_ns == 0) return;
+
+	size_t len = snprintf(buf, size, "Server-Timing: ");
+	for (size_t i = 0; i < sizeof(phases) / sizeof(phases[0]); i++) {
+		len += snprintf(buf + len, size - len, "%s;dur=%.3f, ", HTTPServer_phase_name(phases[i]),
+				request->phase_ns[phases[i]] / 1e6);
+	}
+	snprintf(buf + len, size - len, "total;dur=%.3f\r\n", (HTTPServer_now_ns() - request->received_ns) / 1e6);
+}
+
+void HTTPServer_send_response_headers(HTTPRequest *request, const struct iovec *body, int body_count, const char *content_type, int status_code, const char *status_message, const char *extra_headers) {
 	int final_status_code = (status_code > 0)?status_code:200;
-	int content_length = strlen(body);
+	const char *final_status_message = (status_message && strlen(status_message) > 0)? status_message:get_default_status_message(final_status_code);
+	const char *final_content_type = (content_type && strlen(content_type) > 0)? content_type: "text/html";
+	size_t content_length = 0;
+	for (int i = 0; i < body_count; i++) {
+		content_length += body[i].iov_len;
+	}
+
+	// Text bodies are compressed for clients that accept it, unless the
+	// caller already sends an encoded body
+	char encoded_headers[1024];
+	struct iovec encoded_body;
+	if (final_status_code == 200 && content_length >= (size_t)COMPRESSION_MIN_SIZE &&
+	    Compression_compressible(final_content_type) &&
+	    !(extra_headers && strstr(extra_headers, "Content-Encoding:"))) {
+		ContentEncoding encoding = Compression_negotiate(HTTPRequest_get_header(request, "Accept-Encoding"));
+		const char *data;
+		size_t len;
+		if (encoding != ENCODING_IDENTITY && Compression_compress(encoding, body, body_count, &data, &len) &&
+		    encoding_headers(encoded_headers, sizeof(encoded_headers), extra_headers, Compression_name(encoding))) {
+			encoded_body.iov_base = (void *)data;
+			encoded_body.iov_len = len;
+			body = &encoded_body;
+			body_count = 1;
+			content_length = len;
+			extra_headers = encoded_headers;
+		} else if (encoding_headers(encoded_headers, sizeof(encoded_headers), extra_headers, NULL)) {
+			extra_headers = encoded_headers;
+		}
+	}
+
+	char timing_header[256] = "";
+	if (SERVER_TIMING && !request->on_response) {
+		server_timing(request, timing_header, sizeof(timing_header));
+	}
+
+	// A 304 has no body and must not announce the length of one
+	char length_header[64] = "";
+	if (final_status_code != 304) {
+		snprintf(length_header, sizeof(length_header), "Content-Length: %zu\r\n", content_length);
+	}
+
+	// Every connection is closed after one response, no keep-alive
 	char response_header[4096];
-	snprintf(response_header, sizeof(response_header),
+	int header_len = snprintf(response_header, sizeof(response_header),
 			"HTTP/1.1 %d %s\r\n"
 			"Content-Type: %s\r\n"
-			"Content-Length: %d\r\n"
+			"Connection: close\r\n"
+			"%s"
+			"%s"
+			"%s"
 			"\r\n",
-			final_status_code, final_status_message, final_content_type, content_length);
-	write(request->client_socket, response_header, strlen(response_header));
-	write(request->client_socket, body, content_length);
-	close(request->client_socket);
+			final_status_code, final_status_message, final_content_type, length_header,
+			extra_headers ? extra_headers : "", timing_header);
+	if (header_len >= (int)sizeof(response_header)) {
+		fprintf(stderr, "Response headers too long\n");
+		HTTPServer_close(request->client_socket, request->tls);
+		return;
+	}
+
+	// Header and body go out in a single writev. The write consumes its
+	// iovecs: the response hook gets a second, untouched set.
+	int iov_count = body_count + 1;
+	struct iovec *iov = malloc((request->on_response ? 2 : 1) * iov_count * sizeof(struct iovec));
+	if (!iov) {
+		HTTPServer_close(request->client_socket, request->tls);
+		return;
+	}
+	iov[0].iov_base = response_header;
+	iov[0].iov_len = header_len;
+	if (body_count > 0) memcpy(iov + 1, body, body_count * sizeof(struct iovec));
+	if (request->on_response) memcpy(iov + iov_count, iov, iov_count * sizeof(struct iovec));
+
+	request->status_code = final_status_code;
+	request->response_bytes = 0;
+	for (int i = 0; i < iov_count; i++) request->response_bytes += iov[i].iov_len;
+	int64_t write_started = HTTPServer_now_ns();
+	if (!write_connection(request->client_socket, request->tls, iov, iov_count)) {
+		perror("Failed to write response");
+	}
+	HTTPRequest_add_phase(request, HTTP_PHASE_WRITE, write_started);
+	TRACE_PROBE4(response_written, request->client_socket, final_status_code, request->response_bytes,
+	             HTTPServer_now_ns() - write_started);
+	HTTPServer_close(request->client_socket, request->tls);
+
+	if (request->on_response) request->on_response(request, final_status_code, iov + iov_count, iov_count);
+	free(iov);
+}
+
+void HTTPServer_send_response_iov(HTTPRequest *request, const struct iovec *body, int body_count, const char *content_type, int status_code, const char *status_message) {
+	HTTPServer_send_response_headers(request, body, body_count, content_type, status_code, status_message, NULL);
+}
+
+void HTTPServer_send_response(HTTPRequest *request, const char *body, const char *content_type, int status_code, const char *status_message) {
+	struct iovec iov = { (void *)body, strlen(body) };
+	HTTPServer_send_response_iov(request, &iov, 1, content_type, status_code, status_message);
 }
 
 void HTTPServer_destroy(HTTPServer *server) {
 	if (!server) return;
 
-	close(server->server_fd);
+	if (server->server_fd >= 0) close(server->server_fd);
+	if (server->unix_fd >= 0) close(server->unix_fd);
+	if (server->unix_path) {
+		// Worker processes share the socket file with the supervisor
+		if (server->owner == getpid()) unlink(server->unix_path);
+		free(server->unix_path);
+	}
 	free(server);
 
 	printf("Server shut down\n");
 }
+
+int64_t HTTPServer_now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+void (*http_phase_hook)(const HTTPRequest *req, HTTPPhase phase, bool entering) = NULL;
+
+int64_t HTTPRequest_begin_phase(HTTPRequest *req, HTTPPhase phase) {
+	if (http_phase_hook) http_phase_hook(req, phase, true);
+	return HTTPServer_now_ns();
+}
+
+void HTTPRequest_add_phase(HTTPRequest *req, HTTPPhase phase, int64_t started_ns) {
+	req->phase_ns[phase] += HTTPServer_now_ns() - started_ns;
+	if (http_phase_hook) http_phase_hook(req, phase, false);
+}
+
+const char *HTTPServer_phase_name(HTTPPhase phase) {
+	static const char *names[HTTP_PHASE_COUNT] = {
+		"queue", "route", "handler", "db", "render", "write"
+	};
+	return (phase >= 0 && phase < HTTP_PHASE_COUNT) ? names[phase] : "unknown";
+}
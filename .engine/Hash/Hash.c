@@ -0,0 +1,128 @@
+#include "Hash.h"
+#include <string.h>
+
+#define PRIME64_1 0x9E3779B185EBCA87ULL
+#define PRIME64_2 0xC2B2AE3D27D4EB4FULL
+#define PRIME64_3 0x165667B19E3779F9ULL
+#define PRIME64_4 0x85EBCA77C2B2AE63ULL
+#define PRIME64_5 0x27D4EB2F165667C5ULL
+
+static inline uint64_t rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+// Input is read little endian, whatever the host
+static inline uint64_t read64(const uint8_t *p) {
+    return (uint64_t)p[0] | (uint64_t)p[1] << 8 | (uint64_t)p[2] << 16 | (uint64_t)p[3] << 24 |
+           (uint64_t)p[4] << 32 | (uint64_t)p[5] << 40 | (uint64_t)p[6] << 48 | (uint64_t)p[7] << 56;
+}
+
+static inline uint32_t read32(const uint8_t *p) {
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+static inline uint64_t hash_round(uint64_t acc, uint64_t input) {
+    acc += input * PRIME64_2;
+    acc = rotl64(acc, 31);
+    return acc * PRIME64_1;
+}
+
+static inline uint64_t merge_round(uint64_t acc, uint64_t val) {
+    acc ^= hash_round(0, val);
+    return acc * PRIME64_1 + PRIME64_4;
+}
+
+// Consumes whole 32 byte stripes, returns how many bytes were used
+static size_t consume_stripes(uint64_t v[4], const uint8_t *p, size_t len) {
+    size_t used = 0;
+    while (len - used >= 32) {
+        v[0] = hash_round(v[0], read64(p + used));
+        v[1] = hash_round(v[1], read64(p + used + 8));
+        v[2] = hash_round(v[2], read64(p + used + 16));
+        v[3] = hash_round(v[3], read64(p + used + 24));
+        used += 32;
+    }
+    return used;
+}
+
+void hash64_init(Hash64State *state, uint64_t seed) {
+    memset(state, 0, sizeof(*state));
+    state->seed = seed;
+    state->v[0] = seed + PRIME64_1 + PRIME64_2;
+    state->v[1] = seed + PRIME64_2;
+    state->v[2] = seed;
+    state->v[3] = seed - PRIME64_1;
+}
+
+void hash64_update(Hash64State *state, const void *data, size_t len) {
+    const uint8_t *p = data;
+    state->total_len += len;
+
+    if (state->buffered + len < 32) {
+        memcpy(state->buffer + state->buffered, p, len);
+        state->buffered += len;
+        return;
+    }
+
+    if (state->buffered) {
+        size_t fill = 32 - state->buffered;
+        memcpy(state->buffer + state->buffered, p, fill);
+        consume_stripes(state->v, state->buffer, 32);
+        p += fill;
+        len -= fill;
+        state->buffered = 0;
+    }
+
+    size_t used = consume_stripes(state->v, p, len);
+    memcpy(state->buffer, p + used, len - used);
+    state->buffered = len - used;
+}
+
+uint64_t hash64_digest(const Hash64State *state) {
+    uint64_t h;
+    if (state->total_len >= 32) {
+        const uint64_t *v = state->v;
+        h = rotl64(v[0], 1) + rotl64(v[1], 7) + rotl64(v[2], 12) + rotl64(v[3], 18);
+        h = merge_round(h, v[0]);
+        h = merge_round(h, v[1]);
+        h = merge_round(h, v[2]);
+        h = merge_round(h, v[3]);
+    } else {
+        h = state->seed + PRIME64_5;
+    }
+    h += state->total_len;
+
+    const uint8_t *p = state->buffer;
+    size_t len = state->buffered;
+    while (len >= 8) {
+        h ^= hash_round(0, read64(p));
+        h = rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+        p += 8;
+        len -= 8;
+    }
+    if (len >= 4) {
+        h ^= (uint64_t)read32(p) * PRIME64_1;
+        h = rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+        len -= 4;
+    }
+    while (len > 0) {
+        h ^= (*p++) * PRIME64_5;
+        h = rotl64(h, 11) * PRIME64_1;
+        len--;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
+
+uint64_t hash64(const void *data, size_t len, uint64_t seed) {
+    Hash64State state;
+    hash64_init(&state, seed);
+    hash64_update(&state, data, len);
+    return hash64_digest(&state);
+}
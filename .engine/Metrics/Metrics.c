@@ -0,0 +1,367 @@
+#include "Metrics.h"
+#include "Database.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <sys/mman.h>
+
+// Status codes counted per route, the last slot collects any others
+#define METRICS_STATUS_SLOTS 8
+
+// Log-linear histogram over microseconds (HDR style): 4 buckets per power
+// of two, so a bucket is at most 25% wide, up to 2^34 us
+#define METRICS_SUB_BUCKETS 4
+#define METRICS_BUCKETS (METRICS_SUB_BUCKETS * 34)
+
+// Exported bounds, the power of two boundaries from 16 us to 33 s
+#define METRICS_EXPORT_MIN_POW 4
+#define METRICS_EXPORT_MAX_POW 25
+
+// Engine phases plus the whole request
+#define METRICS_PHASE_TOTAL HTTP_PHASE_COUNT
+#define METRICS_PHASES (HTTP_PHASE_COUNT + 1)
+
+// Distinct status codes of one route a scrape can merge
+#define METRICS_MAX_CODES 32
+
+typedef struct {
+    uint64_t counts[METRICS_BUCKETS];
+    uint64_t sum_ns;
+    uint64_t count;
+} Histogram;
+
+typedef struct {
+    uint16_t codes[METRICS_STATUS_SLOTS];       // 0 = slot unused
+    uint64_t requests[METRICS_STATUS_SLOTS];
+    Histogram phases[METRICS_PHASES];
+} RouteMetrics;
+
+typedef struct {
+    int64_t gauges[METRICS_GAUGE_COUNT];
+    uint64_t db_reconnects;
+    int next_thread;
+} ProcessMetrics;
+
+// Shared region: a ProcessMetrics per process, then per process and
+// thread one RouteMetrics per route slot
+static char *region = NULL;
+static int region_processes = 0;
+static int region_threads = 0;
+static int route_slots = 0;
+static const char *const *names = NULL;
+static int name_count = 0;
+
+// This process's part of it, private memory for a process past the bound
+static ProcessMetrics *process = NULL;
+static RouteMetrics *process_shards = NULL;
+
+static __thread RouteMetrics *thread_shard = NULL;
+static __thread bool thread_assigned = false;
+static __thread HTTPRequest *current = NULL;
+
+static ProcessMetrics *process_at(int p) {
+    return (ProcessMetrics *)region + p;
+}
+
+static RouteMetrics *shards_of(int p) {
+    char *first = region + sizeof(ProcessMetrics) * region_processes;
+    return (RouteMetrics *)first + (size_t)p * region_threads * route_slots;
+}
+
+static void record_db_time(int64_t elapsed_ns) {
+    if (current) current->phase_ns[HTTP_PHASE_DB] += elapsed_ns;
+}
+
+bool Metrics_init(int processes, int threads, const char *const *route_names, int route_count) {
+    if (processes < 1) processes = 1;
+    route_slots = route_count + 3;
+    size_t size = sizeof(ProcessMetrics) * processes +
+                  sizeof(RouteMetrics) * (size_t)processes * threads * route_slots;
+
+    // Untouched pages are never allocated, the bounds can be generous
+    void *mem = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        perror("Failed to map metrics");
+        return false;
+    }
+    region = mem;
+    region_processes = processes;
+    region_threads = threads;
+    names = route_names;
+    name_count = route_count;
+    db_timing_hook = record_db_time;
+    return true;
+}
+
+void Metrics_attach(int index) {
+    if (!region) return;
+    if (index >= 0 && index < region_processes) {
+        process = process_at(index);
+        process_shards = shards_of(index);
+    } else {
+        process = calloc(1, sizeof(ProcessMetrics));
+        process_shards = calloc((size_t)region_threads * route_slots, sizeof(RouteMetrics));
+        if (!process || !process_shards) {
+            free(process);
+            free(process_shards);
+            process = NULL;
+            process_shards = NULL;
+            return;
+        }
+    }
+    // A restarted process takes over its slot, the threads of the dead one are gone
+    __atomic_store_n(&process->next_thread, 0, __ATOMIC_RELAXED);
+    memset(process->gauges, 0, sizeof(process->gauges));
+}
+
+static RouteMetrics *shard_for_thread(void) {
+    if (!thread_assigned && process_shards) {
+        thread_assigned = true;
+        int t = __atomic_fetch_add(&process->next_thread, 1, __ATOMIC_RELAXED);
+        if (t < region_threads) thread_shard = process_shards + (size_t)t * route_slots;
+    }
+    return thread_shard;
+}
+
+// Only the owning thread writes a shard: a load and a store, no locked
+// instruction, and scrapes never see a torn value
+static inline void bump(uint64_t *counter, uint64_t n) {
+    __atomic_store_n(counter, __atomic_load_n(counter, __ATOMIC_RELAXED) + n, __ATOMIC_RELAXED);
+}
+
+static int bucket_for(uint64_t us) {
+    if (us < METRICS_SUB_BUCKETS) return (int)us;
+    int msb = 63 - __builtin_clzll(us);
+    int bucket = METRICS_SUB_BUCKETS * (msb - 1) + (int)((us >> (msb - 2)) & (METRICS_SUB_BUCKETS - 1));
+    return bucket < METRICS_BUCKETS ? bucket : METRICS_BUCKETS - 1;
+}
+
+static void record(Histogram *h, int64_t ns) {
+    if (ns < 0) ns = 0;
+    bump(&h->counts[bucket_for((uint64_t)ns / 1000)], 1);
+    bump(&h->sum_ns, (uint64_t)ns);
+    bump(&h->count, 1);
+}
+
+static int slot_for_route(int route) {
+    if (route >= 0 && route < name_count) return route;
+    if (route == METRICS_ROUTE_CACHE) return name_count + 1;
+    if (route == METRICS_ROUTE_ADMIN) return name_count + 2;
+    return name_count;
+}
+
+void Metrics_begin(HTTPRequest *request) {
+    current = request;
+}
+
+void Metrics_end(HTTPRequest *request, int route) {
+    current = NULL;
+    // Parked behind a coalesced leader: counted with the leader's response
+    if (request->status_code <= 0) return;
+    RouteMetrics *shard = shard_for_thread();
+    if (!shard) return;
+
+    RouteMetrics *m = &shard[slot_for_route(route)];
+    int slot = METRICS_STATUS_SLOTS - 1;
+    for (int i = 0; i < METRICS_STATUS_SLOTS - 1; i++) {
+        uint16_t code = __atomic_load_n(&m->codes[i], __ATOMIC_RELAXED);
+        if (code == 0) __atomic_store_n(&m->codes[i], (uint16_t)request->status_code, __ATOMIC_RELEASE);
+        if (code == 0 || code == request->status_code) {
+            slot = i;
+            break;
+        }
+    }
+    bump(&m->requests[slot], 1);
+
+    int64_t total = request->received_ns ? HTTPServer_now_ns() - request->received_ns : 0;
+    record(&m->phases[METRICS_PHASE_TOTAL], total);
+    for (int p = 0; p < HTTP_PHASE_COUNT; p++) {
+        record(&m->phases[p], request->phase_ns[p]);
+    }
+}
+
+void Metrics_gauge_add(MetricsGauge gauge, int delta) {
+    if (process) __atomic_add_fetch(&process->gauges[gauge], delta, __ATOMIC_RELAXED);
+}
+
+void Metrics_db_reconnect(void) {
+    if (process) __atomic_add_fetch(&process->db_reconnects, 1, __ATOMIC_RELAXED);
+}
+
+// ---- Exposition ----
+
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+    bool failed;
+} Buffer;
+
+static void appendf(Buffer *b, const char *fmt, ...) {
+    if (b->failed) return;
+    while (true) {
+        va_list args;
+        va_start(args, fmt);
+        int n = vsnprintf(b->data + b->len, b->cap - b->len, fmt, args);
+        va_end(args);
+        if (n < 0) {
+            b->failed = true;
+            return;
+        }
+        if ((size_t)n < b->cap - b->len) {
+            b->len += n;
+            return;
+        }
+        size_t cap = b->cap * 2 + n;
+        char *data = realloc(b->data, cap);
+        if (!data) {
+            b->failed = true;
+            return;
+        }
+        b->data = data;
+        b->cap = cap;
+    }
+}
+
+// Label value with backslash, quote and newline escaped
+static void append_label(Buffer *b, const char *value) {
+    for (const char *p = value; *p; p++) {
+        if (*p == '\\' || *p == '"') appendf(b, "\\%c", *p);
+        else if (*p == '\n') appendf(b, "\\n");
+        else appendf(b, "%c", *p);
+    }
+}
+
+static void append_route(Buffer *b, int slot) {
+    appendf(b, "route=\"");
+    if (slot < name_count) append_label(b, names[slot]);
+    else if (slot == name_count) appendf(b, "(unmatched)");
+    else if (slot == name_count + 1) appendf(b, "(response cache)");
+    else appendf(b, "(metrics)");
+    appendf(b, "\"");
+}
+
+static inline uint64_t load(const uint64_t *counter) {
+    return __atomic_load_n(counter, __ATOMIC_RELAXED);
+}
+
+// Every shard of every process that has one in the region
+static int shard_count(void) {
+    return region_processes * region_threads;
+}
+
+static RouteMetrics *shard_at(int index) {
+    return shards_of(0) + (size_t)index * route_slots;
+}
+
+static void append_requests(Buffer *b, int slot) {
+    uint16_t codes[METRICS_MAX_CODES];
+    uint64_t counts[METRICS_MAX_CODES];
+    int distinct = 0;
+    for (int s = 0; s < shard_count(); s++) {
+        const RouteMetrics *m = &shard_at(s)[slot];
+        for (int i = 0; i < METRICS_STATUS_SLOTS; i++) {
+            uint64_t n = load(&m->requests[i]);
+            if (n == 0) continue;
+            // The overflow slot has no single code
+            uint16_t code = i == METRICS_STATUS_SLOTS - 1 ? 0 : __atomic_load_n(&m->codes[i], __ATOMIC_ACQUIRE);
+            int j = 0;
+            while (j < distinct && codes[j] != code) j++;
+            if (j == distinct) {
+                if (distinct == METRICS_MAX_CODES) j = distinct - 1;
+                else {
+                    codes[distinct] = code;
+                    counts[distinct++] = 0;
+                }
+            }
+            counts[j] += n;
+        }
+    }
+    for (int j = 0; j < distinct; j++) {
+        appendf(b, "http_requests_total{");
+        append_route(b, slot);
+        if (codes[j]) appendf(b, ",code=\"%d\"} %llu\n", codes[j], (unsigned long long)counts[j]);
+        else appendf(b, ",code=\"other\"} %llu\n", (unsigned long long)counts[j]);
+    }
+}
+
+static const char *phase_name(int phase) {
+    return phase == METRICS_PHASE_TOTAL ? "total" : HTTPServer_phase_name(phase);
+}
+
+static void append_histogram(Buffer *b, int slot, int phase) {
+    Histogram merged;
+    memset(&merged, 0, sizeof(merged));
+    for (int s = 0; s < shard_count(); s++) {
+        const Histogram *h = &shard_at(s)[slot].phases[phase];
+        for (int i = 0; i < METRICS_BUCKETS; i++) merged.counts[i] += load(&h->counts[i]);
+        merged.sum_ns += load(&h->sum_ns);
+        merged.count += load(&h->count);
+    }
+    if (merged.count == 0) return;
+
+    // Values below 2^k us are in the buckets under index SUB_BUCKETS * (k - 1)
+    uint64_t cumulative = 0;
+    int next = 0;
+    for (int k = METRICS_EXPORT_MIN_POW; k <= METRICS_EXPORT_MAX_POW; k++) {
+        int end = METRICS_SUB_BUCKETS * (k - 1);
+        for (; next < end; next++) cumulative += merged.counts[next];
+        appendf(b, "http_request_duration_seconds_bucket{");
+        append_route(b, slot);
+        appendf(b, ",phase=\"%s\",le=\"%.9g\"} %llu\n", phase_name(phase), (double)(1ULL << k) / 1e6,
+                (unsigned long long)cumulative);
+    }
+    appendf(b, "http_request_duration_seconds_bucket{");
+    append_route(b, slot);
+    appendf(b, ",phase=\"%s\",le=\"+Inf\"} %llu\n", phase_name(phase), (unsigned long long)merged.count);
+    appendf(b, "http_request_duration_seconds_sum{");
+    append_route(b, slot);
+    appendf(b, ",phase=\"%s\"} %.9f\n", phase_name(phase), merged.sum_ns / 1e9);
+    appendf(b, "http_request_duration_seconds_count{");
+    append_route(b, slot);
+    appendf(b, ",phase=\"%s\"} %llu\n", phase_name(phase), (unsigned long long)merged.count);
+}
+
+char *Metrics_render(size_t *len) {
+    Buffer b = { malloc(16384), 0, 16384, false };
+    if (!b.data) return NULL;
+    b.data[0] = '\0';
+
+    if (region) {
+        appendf(&b, "# HELP http_requests_total Requests answered, by route and status code.\n"
+                    "# TYPE http_requests_total counter\n");
+        for (int slot = 0; slot < route_slots; slot++) append_requests(&b, slot);
+
+        appendf(&b, "# HELP http_request_duration_seconds Time spent in each phase of a request.\n"
+                    "# TYPE http_request_duration_seconds histogram\n");
+        for (int slot = 0; slot < route_slots; slot++) {
+            for (int phase = 0; phase < METRICS_PHASES; phase++) append_histogram(&b, slot, phase);
+        }
+
+        int64_t gauges[METRICS_GAUGE_COUNT] = {0};
+        uint64_t reconnects = 0;
+        for (int p = 0; p < region_processes; p++) {
+            for (int g = 0; g < METRICS_GAUGE_COUNT; g++) {
+                gauges[g] += __atomic_load_n(&process_at(p)->gauges[g], __ATOMIC_RELAXED);
+            }
+            reconnects += load(&process_at(p)->db_reconnects);
+        }
+        appendf(&b, "# HELP http_queue_depth Requests waiting for a worker thread.\n"
+                    "# TYPE http_queue_depth gauge\n"
+                    "http_queue_depth %lld\n", (long long)gauges[METRICS_QUEUE_DEPTH]);
+        appendf(&b, "# HELP http_active_workers Worker threads handling a request.\n"
+                    "# TYPE http_active_workers gauge\n"
+                    "http_active_workers %lld\n", (long long)gauges[METRICS_ACTIVE_WORKERS]);
+        appendf(&b, "# HELP db_reconnects_total Database connections reopened after going stale.\n"
+                    "# TYPE db_reconnects_total counter\n"
+                    "db_reconnects_total %llu\n", (unsigned long long)reconnects);
+    }
+
+    if (b.failed) {
+        free(b.data);
+        return NULL;
+    }
+    *len = b.len;
+    return b.data;
+}
@@ -0,0 +1,29 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Sampling CPU profiler for a running process. A CPU-time timer sends
+// SIGPROF at a fixed rate of the CPU the process uses, so every busy thread
+// is sampled in proportion to its CPU time; the handler records the stack
+// with backtrace(). The result is folded stacks, root first, one line per
+// distinct stack with its sample count:
+//
+//   worker_thread;handle_request;route_match 12
+//
+// Frames are the function name when the dynamic symbol table has it (the
+// server is linked with -rdynamic), else module+offset for addr2line.
+// Needs <execinfo.h> (glibc); elsewhere Profiler_available() is false.
+
+#define PROFILER_MAX_SECONDS 60
+#define PROFILER_MAX_HZ 1000
+
+bool Profiler_available(void);
+
+// Samples the whole process for seconds at hz (clamped to the limits
+// above) and returns the folded stacks, malloc'ed. Blocks the caller for
+// the duration. NULL when unavailable or another profile is running.
+char *Profiler_run(int seconds, int hz, size_t *len);
+
+#endif
@@ -0,0 +1,111 @@
+#include "RequestQueue.h"
+#include "Metrics.h"
+#include "Trace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+
+// Initialize the request queue
+void init_queue(RequestQueue *q) {
+    q->front = q->rear = NULL;
+    q->depth = 0;
+    pthread_mutex_init(&q->mutex, NULL);
+    pthread_cond_init(&q->cond, NULL);
+    q->stop = false;
+    q->running = 0;
+}
+
+// Add a request to the queue
+void enqueue(RequestQueue *q, HTTPRequest *request) {
+    RequestNode *node = malloc(sizeof(RequestNode));
+    if (!node) {
+        perror("Failed to allocate memory for request node");
+        return;
+    }
+    node->request = *request; // Copy the request
+    node->next = NULL;
+
+    pthread_mutex_lock(&q->mutex);
+
+    if (q->rear) {
+        q->rear->next = node;
+    } else {
+        q->front = node;
+    }
+    q->rear = node;
+    q->depth++;
+    Metrics_gauge_add(METRICS_QUEUE_DEPTH, 1);
+    TRACE_PROBE2(enqueue, request->client_socket, request->path);
+
+    pthread_cond_signal(&q->cond); // Signal a worker thread
+    pthread_mutex_unlock(&q->mutex);
+}
+
+// Remove a request from the queue
+bool dequeue(RequestQueue *q, HTTPRequest *request) {
+    pthread_mutex_lock(&q->mutex);
+
+    while (q->front == NULL && !q->stop) {
+        pthread_cond_wait(&q->cond, &q->mutex);
+    }
+
+    if (q->stop && q->front == NULL) {
+        pthread_mutex_unlock(&q->mutex);
+        return false;
+    }
+
+    RequestNode *node = q->front;
+    *request = node->request; // Copy the request
+    q->front = node->next;
+
+    if (q->front == NULL) {
+        q->rear = NULL;
+    }
+    q->depth--;
+    Metrics_gauge_add(METRICS_QUEUE_DEPTH, -1);
+    TRACE_PROBE2(dequeue, request->client_socket, request->path);
+
+    free(node);
+    pthread_mutex_unlock(&q->mutex);
+    return true;
+}
+
+// Requests waiting and when the oldest of them was received
+void queue_stats(RequestQueue *q, size_t *depth, int64_t *oldest_received_ns) {
+    pthread_mutex_lock(&q->mutex);
+    *depth = q->depth;
+    *oldest_received_ns = q->front ? q->front->request.received_ns : 0;
+    pthread_mutex_unlock(&q->mutex);
+}
+
+// Lets the threads finish every queued request, then waits for them to
+// exit for up to timeout_seconds. False if some are still busy by then.
+bool drain_queue(RequestQueue *q, int timeout_seconds) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout_seconds;
+
+    pthread_mutex_lock(&q->mutex);
+    q->stop = true;
+    pthread_cond_broadcast(&q->cond); // Wake up all waiting threads
+    while (q->running > 0) {
+        if (pthread_cond_timedwait(&q->cond, &q->mutex, &deadline) == ETIMEDOUT) break;
+    }
+    bool drained = (q->running == 0);
+    pthread_mutex_unlock(&q->mutex);
+    return drained;
+}
+
+// Destroy the request queue, once its threads are gone
+void destroy_queue(RequestQueue *q) {
+    while (q->front) {
+        RequestNode *node = q->front;
+        q->front = node->next;
+        HTTPRequest_free(&node->request);
+        free(node);
+    }
+
+    pthread_mutex_destroy(&q->mutex);
+    pthread_cond_destroy(&q->cond);
+}
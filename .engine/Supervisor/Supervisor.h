@@ -0,0 +1,39 @@
+#ifndef SUPERVISOR_H
+#define SUPERVISOR_H
+
+#include <stdbool.h>
+#include "HTTPServer.h"
+
+// Prefork supervisor: the listen sockets are bound once, then N worker
+// processes inherit them and accept on their own. Each process has its own
+// heap, queue, threads and DB connections, so a crash takes down only that
+// process, and only that one is restarted.
+
+// Entry point of a worker process, index is its slot in [0, processes)
+typedef int (*WorkerMain)(HTTPServer *server, int index);
+
+// Forks the workers and restarts any that die. On SIGTERM/SIGINT the
+// workers are told to drain and waited for. On SIGHUP the supervisor
+// re-executes its binary (a deploy): the listen sockets are handed to the
+// new image, which starts fresh workers and then drains the old ones.
+// Returns the exit status.
+int Supervisor_run(HTTPServer *server, int processes, const char *pin, WorkerMain worker_main);
+
+// Listen sockets handed over by a SIGHUP re-exec, NULL on a fresh start
+HTTPServer *Supervisor_inherited(void);
+
+// cpu_set_t needs _GNU_SOURCE defined before the first system include
+#ifdef _GNU_SOURCE
+#include <sched.h>
+
+// Splits the CPUs this process may run on between worker processes.
+// pin is "core" (one CPU each), "numa" (one node each) or "" (no pinning).
+// processes <= 0 means one per CPU, or per node with "numa". Returns how
+// many processes to start, and fills sets[i] for each when *pinned.
+int Supervisor_plan(const char *pin, int processes, cpu_set_t *sets, int max_sets, bool *pinned);
+
+// Parses a kernel CPU list such as "0-3,8,10-11"
+bool Supervisor_parse_cpulist(const char *list, cpu_set_t *set);
+#endif
+
+#endif
@@ -0,0 +1,137 @@
+#include "TLS.h"
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+
+// Largest TLS record payload, a full buffer goes out as one record
+#define TLS_RECORD_SIZE 16384
+
+static SSL_CTX *server_ctx = NULL;
+
+bool TLS_init(const char *cert_file, const char *key_file) {
+    if (!cert_file || !*cert_file || !key_file || !*key_file) return false;
+
+    SSL_CTX *ctx = SSL_CTX_new(TLS_server_method());
+    if (!ctx) {
+        ERR_print_errors_fp(stderr);
+        return false;
+    }
+
+    SSL_CTX_set_min_proto_version(ctx, TLS1_2_VERSION);
+    SSL_CTX_set_options(ctx, SSL_OP_NO_RENEGOTIATION | SSL_OP_CIPHER_SERVER_PREFERENCE);
+#ifdef SSL_OP_ENABLE_KTLS
+    SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+#endif
+
+    // Every response closes the connection, so resumption is what keeps
+    // repeat visits cheap: TLS 1.3 tickets, plus the session cache for 1.2
+    static const unsigned char session_context[] = "HTTPClientC";
+    SSL_CTX_set_session_id_context(ctx, session_context, sizeof(session_context) - 1);
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_SERVER);
+    SSL_CTX_set_num_tickets(ctx, 1);
+
+    if (SSL_CTX_use_certificate_chain_file(ctx, cert_file) != 1 ||
+        SSL_CTX_use_PrivateKey_file(ctx, key_file, SSL_FILETYPE_PEM) != 1 ||
+        SSL_CTX_check_private_key(ctx) != 1) {
+        fprintf(stderr, "TLS: could not load %s / %s\n", cert_file, key_file);
+        ERR_print_errors_fp(stderr);
+        SSL_CTX_free(ctx);
+        return false;
+    }
+
+    server_ctx = ctx;
+    return true;
+}
+
+bool TLS_enabled(void) {
+    return server_ctx != NULL;
+}
+
+void TLS_cleanup(void) {
+    SSL_CTX_free(server_ctx);
+    server_ctx = NULL;
+}
+
+struct ssl_st *TLS_accept(int fd) {
+    if (!server_ctx) return NULL;
+
+    SSL *ssl = SSL_new(server_ctx);
+    if (!ssl) return NULL;
+
+    if (SSL_set_fd(ssl, fd) != 1 || SSL_accept(ssl) != 1) {
+        ERR_clear_error();
+        SSL_free(ssl);
+        return NULL;
+    }
+    return ssl;
+}
+
+// The socket BIO reports a signal as a retry, like the timeout of
+// SO_RCVTIMEO: only the signal is worth retrying on a blocking socket
+static bool interrupted(SSL *ssl, int ret) {
+    int error = SSL_get_error(ssl, ret);
+    bool eintr = errno == EINTR;
+    ERR_clear_error();
+    return (error == SSL_ERROR_WANT_READ || error == SSL_ERROR_WANT_WRITE) && eintr;
+}
+
+ssize_t TLS_read(struct ssl_st *tls, void *buf, size_t len) {
+    size_t bytes = 0;
+    int ret = SSL_read_ex(tls, buf, len, &bytes);
+    if (ret != 1) {
+        // Errors other than EINTR must not look like one to the caller
+        errno = interrupted(tls, ret) ? EINTR : EIO;
+        return -1;
+    }
+    return (ssize_t)bytes;
+}
+
+bool TLS_kernel_send(struct ssl_st *tls) {
+#ifndef OPENSSL_NO_KTLS
+    return BIO_get_ktls_send(SSL_get_wbio(tls));
+#else
+    (void)tls;
+    return false;
+#endif
+}
+
+static bool write_record(SSL *ssl, const char *data, size_t len) {
+    size_t written;
+    int ret;
+    while ((ret = SSL_write_ex(ssl, data, len, &written)) != 1) {
+        if (!interrupted(ssl, ret)) return false;
+    }
+    return true;
+}
+
+bool TLS_write_iov(struct ssl_st *tls, const struct iovec *iov, int iov_count) {
+    char record[TLS_RECORD_SIZE];
+    size_t used = 0;
+
+    for (int i = 0; i < iov_count; i++) {
+        const char *data = iov[i].iov_base;
+        size_t len = iov[i].iov_len;
+        while (len > 0) {
+            size_t chunk = len < TLS_RECORD_SIZE - used ? len : TLS_RECORD_SIZE - used;
+            memcpy(record + used, data, chunk);
+            used += chunk;
+            data += chunk;
+            len -= chunk;
+
+            if (used == TLS_RECORD_SIZE) {
+                if (!write_record(tls, record, used)) return false;
+                used = 0;
+            }
+        }
+    }
+    return used == 0 || write_record(tls, record, used);
+}
+
+void TLS_close(struct ssl_st *tls) {
+    if (!tls) return;
+    SSL_shutdown(tls);
+    ERR_clear_error();
+    SSL_free(tls);
+}
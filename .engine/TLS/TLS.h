@@ -0,0 +1,35 @@
+#ifndef TLS_H
+#define TLS_H
+
+#include <stdbool.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+// OpenSSL termination for the listener. Session tickets and the server
+// session cache let returning clients resume without a full handshake,
+// and where the kernel supports it the record layer is handed to kTLS so
+// plain writev on the socket keeps working after the handshake.
+
+struct ssl_st;
+
+// Loads the certificate chain and key, false leaves TLS off
+bool TLS_init(const char *cert_file, const char *key_file);
+bool TLS_enabled(void);
+void TLS_cleanup(void);
+
+// Server handshake on an accepted socket, NULL if it failed
+struct ssl_st *TLS_accept(int fd);
+
+// -1 with errno EINTR when a signal interrupted it, as read does
+ssize_t TLS_read(struct ssl_st *tls, void *buf, size_t len);
+
+// True once the kernel encrypts writes on this connection's socket
+bool TLS_kernel_send(struct ssl_st *tls);
+
+// Writes through OpenSSL, coalescing the iovecs into full records
+bool TLS_write_iov(struct ssl_st *tls, const struct iovec *iov, int iov_count);
+
+// Sends close_notify and frees the connection, the socket stays open
+void TLS_close(struct ssl_st *tls);
+
+#endif
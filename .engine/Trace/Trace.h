@@ -0,0 +1,34 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+// Static tracepoints (USDT) on the request path, provider "cframework":
+//
+//   accept(fd)                              parse_complete(fd, method, path)
+//   enqueue(fd, path)                       dequeue(fd, path)
+//   route_matched(route, path)              handler_start(route, path)
+//   handler_end(route, path, status)        db_query_start(sql)
+//   db_query_end(sql, ok)                   render_start(template)
+//   render_end(template, ok)                response_written(fd, status, bytes, write_ns)
+//
+// Strings are char pointers, read them with str() in bpftrace:
+//
+//   bpftrace -e 'usdt:.cache/build/server:cframework:route_matched { @[str(arg0)] = count(); }'
+//   perf probe -x .cache/build/server sdt_cframework:db_query_end
+//
+// Built in with make USDT=1, which needs <sys/sdt.h> (systemtap-sdt-dev).
+// Each probe is then a single nop until a tracer attaches. Otherwise they
+// compile to nothing and their arguments are never evaluated.
+#ifdef ENGINE_USDT
+#include <sys/sdt.h>
+#define TRACE_PROBE1(name, a) DTRACE_PROBE1(cframework, name, a)
+#define TRACE_PROBE2(name, a, b) DTRACE_PROBE2(cframework, name, a, b)
+#define TRACE_PROBE3(name, a, b, c) DTRACE_PROBE3(cframework, name, a, b, c)
+#define TRACE_PROBE4(name, a, b, c, d) DTRACE_PROBE4(cframework, name, a, b, c, d)
+#else
+#define TRACE_PROBE1(name, a) do { } while (0)
+#define TRACE_PROBE2(name, a, b) do { } while (0)
+#define TRACE_PROBE3(name, a, b, c) do { } while (0)
+#define TRACE_PROBE4(name, a, b, c, d) do { } while (0)
+#endif
+
+#endif
@@ -0,0 +1,256 @@
+#include "WorkerStatus.h"
+#include "Database.h"
+#include <sched.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define WORKER_STATUS_PATH_SIZE 160
+#define WORKER_STATUS_SQL_SIZE 256
+// Reads of a slot retried while its worker keeps rewriting it
+#define WORKER_STATUS_READ_TRIES 1000
+
+enum { WORKER_DB_NONE, WORKER_DB_CONNECTED, WORKER_DB_DOWN };
+
+// seq is odd while the owning thread writes the rest, a reader copies the
+// slot and keeps the copy if seq was even and unchanged around it
+typedef struct {
+    uint32_t seq __attribute__((aligned(64)));
+    WorkerState state;
+    int db;
+    int64_t state_ns;       // when the state was entered
+    int64_t request_ns;     // received_ns of the request being handled
+    uint64_t handled;       // requests taken, the current one included
+    char method[8];
+    char path[WORKER_STATUS_PATH_SIZE];
+    char sql[WORKER_STATUS_SQL_SIZE];
+} WorkerSlot;
+
+static WorkerSlot *slots = NULL;
+static int slot_count = 0;
+static __thread WorkerSlot *thread_slot = NULL;
+// Where a statement or a render returns to
+static __thread WorkerState resume_state = WORKER_IDLE;
+
+static void write_begin(WorkerSlot *s) {
+    __atomic_store_n(&s->seq, s->seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void write_end(WorkerSlot *s) {
+    __atomic_store_n(&s->seq, s->seq + 1, __ATOMIC_RELEASE);
+}
+
+static bool read_slot(const WorkerSlot *s, WorkerSlot *copy) {
+    for (int tries = 0; tries < WORKER_STATUS_READ_TRIES; tries++) {
+        uint32_t before = __atomic_load_n(&s->seq, __ATOMIC_ACQUIRE);
+        if (before & 1) {
+            sched_yield();
+            continue;
+        }
+        memcpy(copy, s, sizeof(*copy));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&s->seq, __ATOMIC_RELAXED) == before) return true;
+    }
+    return false;
+}
+
+static void set_state(WorkerSlot *s, WorkerState state) {
+    write_begin(s);
+    s->state = state;
+    s->state_ns = HTTPServer_now_ns();
+    write_end(s);
+}
+
+static void on_statement(const char *sql) {
+    WorkerSlot *s = thread_slot;
+    if (!s) return;
+    write_begin(s);
+    if (sql) {
+        if (s->state != WORKER_DB) resume_state = s->state;
+        s->state = WORKER_DB;
+        snprintf(s->sql, sizeof(s->sql), "%s", sql);
+    } else {
+        s->state = resume_state;
+        s->sql[0] = '\0';
+    }
+    s->state_ns = HTTPServer_now_ns();
+    write_end(s);
+}
+
+static void on_phase(const HTTPRequest *req, HTTPPhase phase, bool entering) {
+    (void)req;
+    WorkerSlot *s = thread_slot;
+    if (!s || phase != HTTP_PHASE_RENDER) return;
+    if (entering) {
+        resume_state = s->state;
+        set_state(s, WORKER_RENDERING);
+    } else if (s->state == WORKER_RENDERING) {
+        set_state(s, resume_state);
+    }
+}
+
+bool WorkerStatus_init(int workers) {
+    if (slots) return true;
+    if (workers < 1) return false;
+    void *memory = NULL;
+    if (posix_memalign(&memory, 64, sizeof(WorkerSlot) * workers) != 0) {
+        perror("Failed to allocate worker status");
+        return false;
+    }
+    memset(memory, 0, sizeof(WorkerSlot) * workers);
+    int64_t now = HTTPServer_now_ns();
+    slots = memory;
+    for (int i = 0; i < workers; i++) slots[i].state_ns = now;
+    slot_count = workers;
+    db_statement_hook = on_statement;
+    http_phase_hook = on_phase;
+    return true;
+}
+
+void WorkerStatus_attach(int id) {
+    thread_slot = (slots && id >= 0 && id < slot_count) ? &slots[id] : NULL;
+    resume_state = WORKER_IDLE;
+}
+
+void WorkerStatus_begin(const HTTPRequest *request) {
+    WorkerSlot *s = thread_slot;
+    if (!s) return;
+    write_begin(s);
+    s->state = WORKER_HANDLING;
+    s->state_ns = HTTPServer_now_ns();
+    s->request_ns = request->received_ns;
+    snprintf(s->method, sizeof(s->method), "%s", request->method);
+    snprintf(s->path, sizeof(s->path), "%s", request->path ? request->path : "");
+    s->sql[0] = '\0';
+    s->handled++;
+    write_end(s);
+    resume_state = WORKER_HANDLING;
+}
+
+void WorkerStatus_end(void) {
+    WorkerSlot *s = thread_slot;
+    if (!s) return;
+    write_begin(s);
+    s->state = WORKER_IDLE;
+    s->state_ns = HTTPServer_now_ns();
+    write_end(s);
+    resume_state = WORKER_IDLE;
+}
+
+void WorkerStatus_reading(const HTTPRequest *request) {
+    WorkerSlot *s = thread_slot;
+    if (!s) return;
+    write_begin(s);
+    s->state = WORKER_READING;
+    s->state_ns = HTTPServer_now_ns();
+    s->request_ns = request->received_ns;
+    write_end(s);
+}
+
+void WorkerStatus_connecting(void) {
+    if (thread_slot) set_state(thread_slot, WORKER_CONNECTING);
+}
+
+void WorkerStatus_db_connected(bool connected) {
+    WorkerSlot *s = thread_slot;
+    if (!s) return;
+    write_begin(s);
+    s->db = connected ? WORKER_DB_CONNECTED : WORKER_DB_DOWN;
+    write_end(s);
+}
+
+const char *WorkerStatus_state_name(WorkerState state) {
+    static const char *names[WORKER_STATE_COUNT] = {
+        "idle", "connecting", "reading", "handling", "db", "rendering"
+    };
+    return (state >= 0 && state < WORKER_STATE_COUNT) ? names[state] : "unknown";
+}
+
+typedef struct {
+    char *data;
+    size_t len;
+    size_t capacity;
+} Output;
+
+static void append(Output *out, const char *format, ...) __attribute__((format(printf, 2, 3)));
+
+static void append(Output *out, const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    int n = vsnprintf(out->data + out->len, out->capacity - out->len, format, args);
+    va_end(args);
+    if (n > 0) out->len += ((size_t)n < out->capacity - out->len) ? (size_t)n : out->capacity - out->len - 1;
+}
+
+// JSON string of text, control characters escaped
+static void append_string(Output *out, const char *key, const char *text) {
+    append(out, ",\"%s\":\"", key);
+    for (const unsigned char *c = (const unsigned char *)text; *c && out->len + 8 < out->capacity; c++) {
+        if (*c == '"' || *c == '\\') {
+            out->data[out->len++] = '\\';
+            out->data[out->len++] = *c;
+        } else if (*c < 0x20) {
+            out->len += snprintf(out->data + out->len, 7, "\\u%04x", *c);
+        } else {
+            out->data[out->len++] = *c;
+        }
+    }
+    out->data[out->len] = '\0';
+    append(out, "\"");
+}
+
+char *WorkerStatus_render(size_t queue_depth, int64_t oldest_queued_ns, size_t *len) {
+    if (!slots) return NULL;
+    // Every character escaped as \u00XX at worst
+    Output out = { NULL, 0, 256 + (size_t)slot_count * (6 * (WORKER_STATUS_PATH_SIZE + WORKER_STATUS_SQL_SIZE) + 256) };
+    out.data = malloc(out.capacity);
+    if (!out.data) return NULL;
+    out.data[0] = '\0';
+
+    int64_t now = HTTPServer_now_ns();
+    WorkerSlot *copies = malloc(sizeof(WorkerSlot) * slot_count);
+    bool *fresh = malloc(sizeof(bool) * slot_count);
+    if (!copies || !fresh) {
+        free(copies);
+        free(fresh);
+        free(out.data);
+        return NULL;
+    }
+    int busy = 0;
+    for (int i = 0; i < slot_count; i++) {
+        fresh[i] = read_slot(&slots[i], &copies[i]);
+        if (fresh[i] && copies[i].state != WORKER_IDLE) busy++;
+    }
+
+    append(&out, "{\"pid\":%d,\"workers_busy\":%d,\"queue_depth\":%zu,\"oldest_queued_ms\":%.3f,\"workers\":[",
+           (int)getpid(), busy, queue_depth, oldest_queued_ns ? (now - oldest_queued_ns) / 1e6 : 0.0);
+    for (int i = 0; i < slot_count; i++) {
+        const WorkerSlot *s = &copies[i];
+        append(&out, "%s\n{\"id\":%d", i ? "," : "", i);
+        if (!fresh[i]) {
+            // Rewritten throughout the retries: busy, but its details unknown
+            append(&out, ",\"state\":\"unknown\"}");
+            continue;
+        }
+        static const char *db_names[] = { "none", "connected", "down" };
+        append(&out, ",\"state\":\"%s\",\"state_ms\":%.3f,\"db\":\"%s\",\"handled\":%llu",
+               WorkerStatus_state_name(s->state), (now - s->state_ns) / 1e6, db_names[s->db],
+               (unsigned long long)s->handled);
+        if (s->state == WORKER_READING) append(&out, ",\"request_ms\":%.3f", (now - s->request_ns) / 1e6);
+        if (s->state >= WORKER_HANDLING) {
+            append_string(&out, "method", s->method);
+            append_string(&out, "path", s->path);
+            append(&out, ",\"request_ms\":%.3f", (now - s->request_ns) / 1e6);
+        }
+        if (s->state == WORKER_DB) append_string(&out, "sql", s->sql);
+        append(&out, "}");
+    }
+    append(&out, "\n]}\n");
+    free(copies);
+    free(fresh);
+    *len = out.len;
+    return out.data;
+}
@@ -0,0 +1,52 @@
+#ifndef WORKER_STATUS_H
+#define WORKER_STATUS_H
+
+#include "HTTPServer.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// What every worker thread of this process is doing right now, readable by
+// another thread while they run. Each worker writes only its own slot,
+// under a sequence counter: a snapshot never waits on a worker, a stuck one
+// included, and a worker never waits on a snapshot.
+//
+// Requests, statements (db_statement_hook) and renders (http_phase_hook)
+// are followed once WorkerStatus_init has run; threads that never called
+// WorkerStatus_attach are ignored.
+
+typedef enum {
+    WORKER_IDLE,            // waiting for a request
+    WORKER_CONNECTING,      // opening its database connection
+    WORKER_READING,         // TLS handshake or request bytes of a client
+    WORKER_HANDLING,        // in the route handler
+    WORKER_DB,              // in a statement, sql says which
+    WORKER_RENDERING,       // rendering a template
+    WORKER_STATE_COUNT
+} WorkerState;
+
+// Slots for threads ids 0..workers-1, once per process before they start
+bool WorkerStatus_init(int workers);
+
+// On a worker thread: it publishes into slot id from now on
+void WorkerStatus_attach(int id);
+
+// The thread took request, until WorkerStatus_end puts it back to idle
+void WorkerStatus_begin(const HTTPRequest *request);
+void WorkerStatus_end(void);
+
+// The thread reads request, accepted but unread, until WorkerStatus_begin
+void WorkerStatus_reading(const HTTPRequest *request);
+
+void WorkerStatus_connecting(void);
+// Whether the thread holds a working database connection
+void WorkerStatus_db_connected(bool connected);
+
+// JSON snapshot of every worker, with the queue depth and when its oldest
+// request was received (0 for none). Malloc'ed, NULL before init.
+char *WorkerStatus_render(size_t queue_depth, int64_t oldest_queued_ns, size_t *len);
+
+// Lower case name of a state, as in the snapshot
+const char *WorkerStatus_state_name(WorkerState state);
+
+#endif
@@ -0,0 +1,4 @@
+#pragma once
+
+#include ".cache/models/User.h"
+#include ".cache/models/Group.h"
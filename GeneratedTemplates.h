@@ -0,0 +1,8 @@
+#pragma once
+
+#include ".cache/templates/subfolder_about.h"
+#include ".cache/templates/home.h"
+#include ".cache/templates/about.h"
+#include ".cache/templates/create_user.h"
+#include ".cache/templates/label_content.h"
+#include ".cache/templates/example.h"
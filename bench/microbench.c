@@ -0,0 +1,434 @@
+// Microbenchmarks of the engine's hot functions, one JSON object per line:
+//
+//   {"name":"route_match","params":"routes=64","iterations":400000,"ns_per_op":812.4,"allocs_per_op":2.00}
+//
+// Every benchmark is calibrated to run for about MICROBENCH_RUN_MS, then
+// run MICROBENCH_RUNS times; ns_per_op is the median run. allocs_per_op
+// counts malloc, calloc and realloc calls, including the ones made inside
+// libc (strdup), and is null where the allocator cannot be interposed.
+//
+//   microbench [name-filter]
+#include "HTTPServer.h"
+#include "HTMLTemplating.h"
+#include "Routing.h"
+#include "RequestQueue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+
+#define MICROBENCH_RUN_MS 200
+#define MICROBENCH_RUNS 5
+
+// The DB layer is not linked, its timing hook is all Metrics needs of it
+void (*db_timing_hook)(int64_t elapsed_ns) = NULL;
+
+// In HTMLTemplating.c, outside its header
+char *replace_template_params(const char *template, TemplateParam *params, int param_count);
+
+// ------------------------------------------------------------
+// Allocation counting
+// ------------------------------------------------------------
+
+static uint64_t allocations = 0;
+
+#ifdef __GLIBC__
+#define COUNTS_ALLOCATIONS 1
+extern void *__libc_malloc(size_t size);
+extern void *__libc_calloc(size_t count, size_t size);
+extern void *__libc_realloc(void *ptr, size_t size);
+
+void *malloc(size_t size) {
+    __atomic_add_fetch(&allocations, 1, __ATOMIC_RELAXED);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+    __atomic_add_fetch(&allocations, 1, __ATOMIC_RELAXED);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+    __atomic_add_fetch(&allocations, 1, __ATOMIC_RELAXED);
+    return __libc_realloc(ptr, size);
+}
+#else
+#define COUNTS_ALLOCATIONS 0
+#endif
+
+// ------------------------------------------------------------
+// Harness
+// ------------------------------------------------------------
+
+typedef void (*BenchOp)(void *ctx, long iterations);
+
+static const char *filter = NULL;
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void measure(const char *name, const char *params, BenchOp op, void *ctx) {
+    if (filter && !strstr(name, filter)) return;
+
+    // Doubles the iterations until a run is long enough to time, which
+    // also warms the caches and the allocator
+    long iterations = 1;
+    int64_t elapsed;
+    while (true) {
+        int64_t started = now_ns();
+        op(ctx, iterations);
+        elapsed = now_ns() - started;
+        if (elapsed >= MICROBENCH_RUN_MS * 1000000LL / 20 || iterations >= (1L << 40)) break;
+        iterations *= 2;
+    }
+    iterations = (long)(iterations * (MICROBENCH_RUN_MS * 1e6 / (elapsed > 0 ? elapsed : 1)));
+    if (iterations < 1) iterations = 1;
+
+    double ns_per_op[MICROBENCH_RUNS];
+    uint64_t allocated = 0;
+    for (int run = 0; run < MICROBENCH_RUNS; run++) {
+        uint64_t allocations_before = __atomic_load_n(&allocations, __ATOMIC_RELAXED);
+        int64_t started = now_ns();
+        op(ctx, iterations);
+        ns_per_op[run] = (double)(now_ns() - started) / iterations;
+        allocated += __atomic_load_n(&allocations, __ATOMIC_RELAXED) - allocations_before;
+    }
+    qsort(ns_per_op, MICROBENCH_RUNS, sizeof(double), compare_double);
+
+    printf("{\"name\":\"%s\",\"params\":\"%s\",\"iterations\":%ld,\"ns_per_op\":%.1f,\"allocs_per_op\":",
+           name, params, iterations, ns_per_op[MICROBENCH_RUNS / 2]);
+    if (COUNTS_ALLOCATIONS) printf("%.2f}\n", (double)allocated / ((double)iterations * MICROBENCH_RUNS));
+    else printf("null}\n");
+    fflush(stdout);
+}
+
+// Keeps results alive without the compiler noticing they are unused
+static volatile uintptr_t sink;
+
+static void free_params(HTTPRequest *request) {
+    for (size_t i = 0; i < request->param_count; i++) {
+        free(request->params[i].key);
+        free(request->params[i].value);
+    }
+    request->param_count = 0;
+}
+
+// ------------------------------------------------------------
+// route_match: handle_request's scan of the routes table, the path
+// matching the last route
+// ------------------------------------------------------------
+
+typedef struct {
+    char **templates;
+    int count;
+    char path[128];
+} RouteBench;
+
+static void route_op(void *arg, long iterations) {
+    RouteBench *b = arg;
+    HTTPRequest request = {0};
+    for (long n = 0; n < iterations; n++) {
+        for (int i = 0; i < b->count; i++) {
+            bool matched = route_match(b->templates[i], b->path, &request);
+            free_params(&request);
+            if (matched) {
+                sink += i;
+                break;
+            }
+        }
+    }
+    free(request.params);
+}
+
+static void bench_route_match(void) {
+    static const int sizes[] = { 8, 64, 512 };
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        RouteBench b = { malloc(sizes[s] * sizeof(char *)), sizes[s], "" };
+        for (int i = 0; i < b.count; i++) {
+            b.templates[i] = malloc(64);
+            // A mix of static and parameterized routes, like a real table
+            if (i % 2) snprintf(b.templates[i], 64, "/section%d/<id>/items", i);
+            else snprintf(b.templates[i], 64, "/section%d/about", i);
+        }
+        snprintf(b.path, sizeof(b.path), "/section%d/%s", b.count - 1,
+                 (b.count - 1) % 2 ? "12345/items" : "about");
+
+        char params[32];
+        snprintf(params, sizeof(params), "routes=%d", b.count);
+        measure("route_match", params, route_op, &b);
+
+        for (int i = 0; i < b.count; i++) free(b.templates[i]);
+        free(b.templates);
+    }
+}
+
+// ------------------------------------------------------------
+// parse_headers, through HTTPRequest_parse (it is static)
+// ------------------------------------------------------------
+
+static void parse_op(void *arg, long iterations) {
+    const char *raw = arg;
+    for (long n = 0; n < iterations; n++) {
+        HTTPRequest request = {0};
+        HTTPRequest_parse(&request, raw);
+        sink += request.header_count;
+        HTTPRequest_free(&request);
+    }
+}
+
+static void bench_parse_headers(void) {
+    static const int counts[] = { 4, 16, 64 };
+    for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+        char raw[8192];
+        size_t len = snprintf(raw, sizeof(raw), "GET /items/42?page=2&sort=name HTTP/1.1\r\n");
+        for (int i = 0; i < counts[c]; i++) {
+            len += snprintf(raw + len, sizeof(raw) - len, "X-Header-%d: value-%d; some=parameter\r\n", i, i);
+        }
+        snprintf(raw + len, sizeof(raw) - len, "\r\n");
+
+        char params[32];
+        snprintf(params, sizeof(params), "headers=%d", counts[c]);
+        measure("parse_headers", params, parse_op, raw);
+    }
+}
+
+// ------------------------------------------------------------
+// replace_template_params: parse and render of a whole template
+// ------------------------------------------------------------
+
+typedef struct {
+    char *template;
+    TemplateParam *params;
+    int param_count;
+} TemplateBench;
+
+static void template_op(void *arg, long iterations) {
+    TemplateBench *b = arg;
+    for (long n = 0; n < iterations; n++) {
+        char *html = replace_template_params(b->template, b->params, b->param_count);
+        sink += (uintptr_t)html;
+        free(html);
+    }
+}
+
+static void bench_replace_template_params(void) {
+    static const int sizes[] = { 1024, 16384, 131072 };
+    static const int param_counts[] = { 4, 32 };
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        for (size_t p = 0; p < sizeof(param_counts) / sizeof(param_counts[0]); p++) {
+            int count = param_counts[p];
+            TemplateBench b = { malloc(sizes[s] + 64), calloc(count, sizeof(TemplateParam)), count };
+            char (*names)[16] = malloc(count * sizeof(*names));
+            static const int number = 42;
+            for (int i = 0; i < count; i++) {
+                snprintf(names[i], sizeof(names[i]), "param%d", i);
+                b.params[i].key = names[i];
+                b.params[i].value = i % 2 ? (const void *)&number : "<b>text</b>";
+                b.params[i].converter = i % 2 ? convert_int : convert_string;
+            }
+
+            // Markup with a placeholder every 64 bytes, cycling through the params
+            size_t len = 0;
+            for (int i = 0; len + 64 < (size_t)sizes[s]; i++) {
+                len += snprintf(b.template + len, sizes[s] + 64 - len,
+                                "<div class=\"row\"><span>{{param%d}}</span></div>\n", i % count);
+            }
+
+            char params[48];
+            snprintf(params, sizeof(params), "bytes=%d,params=%d", sizes[s], count);
+            measure("replace_template_params", params, template_op, &b);
+
+            free(names);
+            free(b.params);
+            free(b.template);
+        }
+    }
+}
+
+// ------------------------------------------------------------
+// Converters
+// ------------------------------------------------------------
+
+typedef struct {
+    ValueConverter converter;
+    const void *value;
+} ConverterBench;
+
+static void converter_op(void *arg, long iterations) {
+    ConverterBench *b = arg;
+    for (long n = 0; n < iterations; n++) {
+        char *s = b->converter(b->value);
+        sink += (uintptr_t)s;
+        free(s);
+    }
+}
+
+static void bench_converters(void) {
+    static const int integer = -1234567;
+    static const float real = 3.14159f;
+    static const bool flag = true;
+    static const TemplateList list = { NULL, 12, 0, NULL, 0 };
+    ConverterBench benches[] = {
+        { convert_string, "a short string value" },
+        { convert_int, &integer },
+        { convert_float, &real },
+        { convert_bool, &flag },
+        { convert_list, &list },
+    };
+    static const char *names[] = { "convert_string", "convert_int", "convert_float", "convert_bool", "convert_list" };
+    for (size_t i = 0; i < sizeof(benches) / sizeof(benches[0]); i++) {
+        measure(names[i], "", converter_op, &benches[i]);
+    }
+}
+
+// ------------------------------------------------------------
+// Includes: a page of label_content.html cards over a list, rendered
+// plain or "cached" through the fragment cache, by 1 or 8 threads at
+// once. An operation is one page.
+// ------------------------------------------------------------
+
+#define INCLUDE_CARDS 24
+
+typedef struct {
+    char title[32];
+    char description[64];
+} IncludeJob;
+
+typedef struct {
+    Template page;
+    TemplateParam params[1];
+    int threads;
+    long per_thread;
+} IncludeBench;
+
+static void *render_pages(void *arg) {
+    IncludeBench *b = arg;
+    TemplateOutput out;
+    template_output_init(&out);
+    for (long n = 0; n < b->per_thread; n++) {
+        template_render(&b->page, b->params, 1, &out);
+        sink += out.total_len;
+        template_output_free(&out);
+    }
+    return NULL;
+}
+
+static void include_op(void *arg, long iterations) {
+    IncludeBench *b = arg;
+    b->per_thread = (iterations + b->threads - 1) / b->threads;
+    pthread_t threads[b->threads];
+    for (int i = 0; i < b->threads; i++) pthread_create(&threads[i], NULL, render_pages, b);
+    for (int i = 0; i < b->threads; i++) pthread_join(threads[i], NULL);
+}
+
+static void bench_include(void) {
+    // Six distinct cards, each repeated
+    static IncludeJob jobs[INCLUDE_CARDS];
+    for (int i = 0; i < INCLUDE_CARDS; i++) {
+        snprintf(jobs[i].title, sizeof(jobs[i].title), "Job %d", i % 6);
+        snprintf(jobs[i].description, sizeof(jobs[i].description), "Description of job %d & more", i % 6);
+    }
+    static const TemplateField fields[] = {
+        TEMPLATE_FIELD_WRITER(IncludeJob, title, write_string),
+        TEMPLATE_FIELD_WRITER(IncludeJob, description, write_string)
+    };
+    static TemplateList list = TEMPLATE_LIST(jobs, INCLUDE_CARDS, fields);
+    static const char *pages[] = {
+        "{% for job in jobs %}{% include \"label_content.html\" with job %}{% endfor %}",
+        "{% for job in jobs %}{% include \"label_content.html\" with job cached %}{% endfor %}"
+    };
+    static const int thread_counts[] = { 1, 8 };
+
+    for (int cached = 0; cached < 2; cached++) {
+        for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]); t++) {
+            IncludeBench b = { .threads = thread_counts[t] };
+            b.page.content = (char *)pages[cached];
+            b.page.content_len = strlen(pages[cached]);
+            if (!template_parse(&b.page)) return;
+            b.params[0] = (TemplateParam){ "jobs", &list, NULL, write_list };
+
+            char params[48];
+            snprintf(params, sizeof(params), "cards=%d,threads=%d", INCLUDE_CARDS, b.threads);
+            measure(cached ? "include_cached" : "include", params, include_op, &b);
+            free(b.page.segments);
+        }
+    }
+    template_fragment_cache_clear();
+}
+
+// ------------------------------------------------------------
+// RequestQueue: producers and consumers moving requests through one
+// queue, an operation is one enqueue and its dequeue
+// ------------------------------------------------------------
+
+typedef struct {
+    RequestQueue queue;
+    int producers;
+    int consumers;
+    long per_producer;
+} QueueBench;
+
+static void *produce(void *arg) {
+    QueueBench *b = arg;
+    HTTPRequest request = {0};
+    for (long n = 0; n < b->per_producer; n++) enqueue(&b->queue, &request);
+    return NULL;
+}
+
+static void *consume(void *arg) {
+    QueueBench *b = arg;
+    HTTPRequest request;
+    while (dequeue(&b->queue, &request)) sink++;
+
+    pthread_mutex_lock(&b->queue.mutex);
+    b->queue.running--;
+    pthread_cond_broadcast(&b->queue.cond);
+    pthread_mutex_unlock(&b->queue.mutex);
+    return NULL;
+}
+
+static void queue_op(void *arg, long iterations) {
+    QueueBench *b = arg;
+    b->per_producer = (iterations + b->producers - 1) / b->producers;
+    init_queue(&b->queue);
+    b->queue.running = b->consumers;
+
+    pthread_t threads[b->producers + b->consumers];
+    for (int i = 0; i < b->consumers; i++) pthread_create(&threads[i], NULL, consume, b);
+    for (int i = 0; i < b->producers; i++) pthread_create(&threads[b->consumers + i], NULL, produce, b);
+    for (int i = 0; i < b->producers; i++) pthread_join(threads[b->consumers + i], NULL);
+    drain_queue(&b->queue, 60);
+    for (int i = 0; i < b->consumers; i++) pthread_join(threads[i], NULL);
+    destroy_queue(&b->queue);
+}
+
+static void bench_request_queue(void) {
+    static const int shapes[][2] = { { 1, 1 }, { 1, 4 }, { 4, 4 }, { 4, 16 } };
+    for (size_t s = 0; s < sizeof(shapes) / sizeof(shapes[0]); s++) {
+        QueueBench b = { .producers = shapes[s][0], .consumers = shapes[s][1] };
+        char params[48];
+        snprintf(params, sizeof(params), "producers=%d,consumers=%d", b.producers, b.consumers);
+        measure("request_queue", params, queue_op, &b);
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1) filter = argv[1];
+    bench_route_match();
+    bench_parse_headers();
+    bench_replace_template_params();
+    bench_converters();
+    bench_include();
+    bench_request_queue();
+    return 0;
+}
@@ -0,0 +1,107 @@
+// Routes of the server make perf runs, one per scenario in bench/perf/*.jsonl.
+// Built with tests/mock_config.c (SQLite) and the models of
+// tests/mock_models.c instead of the app's config.c and routes.c, so the
+// numbers only move with the engine.
+#include "HTTPFramework.h"
+#include "Database.h"
+#include "../../.cache/models/User.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+#define SEEDED_USERS 100
+
+static const char *STATIC_PAGE =
+    "<!DOCTYPE html>\n<html lang=\"en\">\n<head><meta charset=\"UTF-8\" /><title>Static</title></head>\n"
+    "<body>\n<h1>Static page</h1>\n"
+    "<p>Lorem ipsum dolor sit amet, consectetur adipiscing elit, sed do eiusmod tempor incididunt ut labore "
+    "et dolore magna aliqua. Ut enim ad minim veniam, quis nostrud exercitation ullamco laboris nisi ut "
+    "aliquip ex ea commodo consequat.</p>\n"
+    "<p>Duis aute irure dolor in reprehenderit in voluptate velit esse cillum dolore eu fugiat nulla "
+    "pariatur. Excepteur sint occaecat cupidatat non proident, sunt in culpa qui officia deserunt mollit "
+    "anim id est laborum.</p>\n</body>\n</html>\n";
+
+static const char *route_param(HTTPRequest *request, const char *key) {
+    for (size_t i = 0; i < request->param_count; i++) {
+        if (strcmp(request->params[i].key, key) == 0) return request->params[i].value;
+    }
+    return NULL;
+}
+
+static void static_page(HTTPRequest *request, Database *db) {
+    (void)db;
+    HTTPServer_send_response(request, STATIC_PAGE, "", 200, "");
+}
+
+static void template_page(HTTPRequest *request, Database *db) {
+    (void)db;
+    TemplateParam params[] = {
+        { "title", route_param(request, "name"), NULL, write_string },
+        { "description", "Rendered with a route parameter", NULL, write_string },
+    };
+    render_html(request, "label_content.html", params, 2);
+}
+
+// The users point reads look up, created by the first read
+static pthread_mutex_t seed_lock = PTHREAD_MUTEX_INITIALIZER;
+static atomic_bool seeded;
+
+static void seed_users(Database *db) {
+    char keys[SEEDED_USERS][32];
+    User items[SEEDED_USERS];
+    for (int i = 0; i < SEEDED_USERS; i++) {
+        snprintf(keys[i], sizeof(keys[i]), "perf-seed-%d", i);
+        items[i] = (User){ keys[i], "Seeded User", 20 + i % 60, "seed@example.com", 0 };
+    }
+    UserList list = { items, SEEDED_USERS };
+    User_create_many(db, &list);
+}
+
+static void user_read(HTTPRequest *request, Database *db) {
+    if (!atomic_load(&seeded)) {
+        pthread_mutex_lock(&seed_lock);
+        if (!atomic_load(&seeded)) seed_users(db);
+        atomic_store(&seeded, true);
+        pthread_mutex_unlock(&seed_lock);
+    }
+
+    User user = {0};
+    if (!User_read(db, (char *)route_param(request, "DNI"), &user)) {
+        HTTPServer_send_response(request, "", "", 404, "");
+        return;
+    }
+    char body[256];
+    snprintf(body, sizeof(body), "{\"DNI\":\"%s\",\"name\":\"%s\",\"age\":%d,\"email\":\"%s\"}",
+             user.DNI, user.name, user.age, user.email);
+    User_free(&user);
+    HTTPServer_send_response(request, body, "application/json", 200, "");
+}
+
+// SQLite takes one writer at a time and the connections have no busy
+// timeout: writes are serialized here so the scenario measures inserts
+// rather than how fast "database is locked" comes back
+static pthread_mutex_t write_lock = PTHREAD_MUTEX_INITIALIZER;
+static long users_created;
+
+static void user_create(HTTPRequest *request, Database *db) {
+    char key[32];
+    pthread_mutex_lock(&write_lock);
+    snprintf(key, sizeof(key), "perf-%ld", users_created++);
+    User user = { key, "Created User", 42, "created@example.com", 0 };
+    bool created = User_create(db, &user);
+    pthread_mutex_unlock(&write_lock);
+    if (!created) {
+        HTTPServer_send_response(request, "", "", 500, "");
+        return;
+    }
+    HTTPServer_send_response(request, "", "", 201, "");
+}
+
+Route routes[] = {
+    {"/perf/static", static_page, 0, 0},
+    {"/perf/hello/<name>", template_page, 0, 0},
+    {"/perf/user/<DNI>", user_read, 0, 0},
+    {"/perf/users", user_create, 0, 0},
+    {NULL, NULL, 0, 0}
+};
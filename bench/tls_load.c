@@ -0,0 +1,176 @@
+// TLS load client: every request is a new connection, like browsers
+// hitting the engine without keep-alive. Sessions are resumed by default
+// so both the full and the resumed handshake cost can be measured.
+//
+//   tls_load <host> <port> [path] [threads] [seconds] [--full]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+
+#define MAX_SAMPLES (1 << 20)
+
+typedef struct {
+    pthread_t thread;
+    double *latencies_ms;
+    long completed;
+    long failed;
+    long resumed;
+} Worker;
+
+static const char *host;
+static const char *port;
+static const char *path = "/";
+static bool resume = true;
+static double deadline;
+static SSL_CTX *ctx;
+static struct addrinfo *address;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// One connection, handshake, request and full response; false on any error
+static bool run_request(SSL_SESSION **session, bool *was_resumed) {
+    int fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+    if (fd < 0) return false;
+    if (connect(fd, address->ai_addr, address->ai_addrlen) < 0) {
+        close(fd);
+        return false;
+    }
+
+    SSL *ssl = SSL_new(ctx);
+    SSL_set_fd(ssl, fd);
+    SSL_set_tlsext_host_name(ssl, host);
+    if (resume && *session) SSL_set_session(ssl, *session);
+
+    bool ok = false;
+    char request[1024];
+    int request_len = snprintf(request, sizeof(request),
+                               "GET %s HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n\r\n", path, host);
+    if (SSL_connect(ssl) == 1 && SSL_write(ssl, request, request_len) == request_len) {
+        char buf[16384];
+        int n, total = 0;
+        bool status_ok = false;
+        while ((n = SSL_read(ssl, buf, sizeof(buf))) > 0) {
+            if (total == 0) status_ok = (n >= 12 && strncmp(buf + 9, "200", 3) == 0);
+            total += n;
+        }
+        ok = status_ok;
+        *was_resumed = SSL_session_reused(ssl);
+
+        // TLS 1.3 tickets arrive after the handshake, so take the session now
+        if (resume) {
+            SSL_SESSION *fresh = SSL_get1_session(ssl);
+            if (fresh) {
+                SSL_SESSION_free(*session);
+                *session = fresh;
+            }
+        }
+    }
+
+    ERR_clear_error();
+    SSL_shutdown(ssl);
+    SSL_free(ssl);
+    close(fd);
+    return ok;
+}
+
+static void *worker_main(void *arg) {
+    Worker *w = arg;
+    SSL_SESSION *session = NULL;
+
+    while (now_seconds() < deadline) {
+        double start = now_seconds();
+        bool was_resumed = false;
+        if (!run_request(&session, &was_resumed)) {
+            w->failed++;
+            continue;
+        }
+        if (w->completed < MAX_SAMPLES) w->latencies_ms[w->completed] = (now_seconds() - start) * 1000;
+        w->completed++;
+        if (was_resumed) w->resumed++;
+    }
+    SSL_SESSION_free(session);
+    return NULL;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <host> <port> [path] [threads] [seconds] [--full]\n", argv[0]);
+        return 2;
+    }
+    host = argv[1];
+    port = argv[2];
+    if (argc > 3) path = argv[3];
+    int threads = argc > 4 ? atoi(argv[4]) : 4;
+    int seconds = argc > 5 ? atoi(argv[5]) : 10;
+    if (argc > 6 && strcmp(argv[6], "--full") == 0) resume = false;
+    if (threads <= 0 || seconds <= 0) {
+        fprintf(stderr, "threads and seconds must be positive\n");
+        return 2;
+    }
+
+    struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM };
+    if (getaddrinfo(host, port, &hints, &address) != 0) {
+        fprintf(stderr, "cannot resolve %s:%s\n", host, port);
+        return 1;
+    }
+
+    // Local load testing against a self-signed certificate: no verification
+    ctx = SSL_CTX_new(TLS_client_method());
+    SSL_CTX_set_verify(ctx, SSL_VERIFY_NONE, NULL);
+    SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT);
+
+    Worker *workers = calloc(threads, sizeof(Worker));
+    deadline = now_seconds() + seconds;
+    for (int i = 0; i < threads; i++) {
+        workers[i].latencies_ms = malloc(MAX_SAMPLES * sizeof(double));
+        pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]);
+    }
+
+    long completed = 0, failed = 0, resumed = 0, samples = 0;
+    for (int i = 0; i < threads; i++) {
+        pthread_join(workers[i].thread, NULL);
+        completed += workers[i].completed;
+        failed += workers[i].failed;
+        resumed += workers[i].resumed;
+    }
+
+    double *all = malloc((completed ? completed : 1) * sizeof(double));
+    for (int i = 0; i < threads; i++) {
+        long n = workers[i].completed < MAX_SAMPLES ? workers[i].completed : MAX_SAMPLES;
+        memcpy(all + samples, workers[i].latencies_ms, n * sizeof(double));
+        samples += n;
+        free(workers[i].latencies_ms);
+    }
+    qsort(all, samples, sizeof(double), compare_double);
+
+    printf("requests:  %ld ok, %ld failed in %ds (%.0f req/s)\n",
+           completed, failed, seconds, completed / (double)seconds);
+    printf("resumed:   %.1f%%\n", completed ? 100.0 * resumed / completed : 0.0);
+    if (samples > 0) {
+        printf("latency:   p50 %.2fms  p90 %.2fms  p99 %.2fms  max %.2fms\n",
+               all[samples / 2], all[samples * 9 / 10], all[samples * 99 / 100], all[samples - 1]);
+    }
+
+    free(all);
+    free(workers);
+    SSL_CTX_free(ctx);
+    freeaddrinfo(address);
+    return failed > 0 && completed == 0;
+}
@@ -1,9 +1,14 @@
 #include<views.c>
 
+// {path, handler, cache_ttl, cache_stale}: a route with a cache_ttl serves
+// anonymous GETs from the response cache for that many seconds, and an
+// expired response cache_stale seconds more while one request refreshes it,
+// e.g. {"/example", example, 5, 30}. 0, 0 renders every request.
 Route routes[] = {
-	{"/", home},
-  {"/wait", wait},
-  {"/create-user", create_user_view},
-  {"/user/<DNI>/profile", create_user_view},
-  {"/example", example}
+	{"/", home, 0, 0},
+  {"/wait", wait, 0, 0},
+  {"/create-user", create_user_view, 0, 0},
+  {"/user/<DNI>/profile", create_user_view, 0, 0},
+  {"/example", example, 0, 0},
+  {NULL, NULL, 0, 0}
 };
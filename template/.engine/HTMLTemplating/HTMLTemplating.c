@@ -1,179 +1,1662 @@
-#include"HTMLTemplating.h"
-#include<stdio.h>
-#include<stdlib.h>
-#include<string.h>
-#include<stdbool.h>
-#include<ctype.h>
-#include<math.h>
-
-// Example converter functions
-char* convert_string(const void* value) {
-	return strdup((const char*)value);
-}
-
-char* convert_int(const void* value) {
-    char buffer[64];
-    snprintf(buffer, sizeof(buffer), "%d", *(const int*)value);
-    return strdup(buffer);
-}
-
-char* convert_float(const void* value) {
-    char buffer[64];
-    snprintf(buffer, sizeof(buffer), "%.2f", *(const float*)value);
-    return strdup(buffer);
-}
-
-char* convert_bool(const void* value) {
-    return strdup(*(const bool*)value ? "true" : "false");
-}
-
-// Helper function to check if a value looks like a string
-bool is_string(const void* value) {
-    const char* str = (const char*)value;
-    // Check if it points to valid memory and looks like a string
-    if (!str) return false;
-    
-    // Check first few characters to see if they're printable
-    for (int i = 0; i < 8 && str[i] != '\0'; i++) {
-        if (!isprint(str[i])) return false;
-    }
-    return true;
-}
-
-// Helper function to check if a value looks like a number
-bool is_number(const void* value, size_t size) {
-    
-    // Check for common float patterns in memory
-    if (size == sizeof(float)) {
-        float f = *(const float*)value;
-        return !isnan(f) && !isinf(f);
-    }
-    
-    // For integers, check if the value looks reasonable
-    if (size == sizeof(int)) {
-        int i = *(const int*)value;
-        return i > -1000000000 && i < 1000000000; // Reasonable range
-    }
-    
-    return false;
-}
-
-// Helper function to find and replace template parameters
-char* replace_template_params(const char* template, TemplateParam* params, int param_count) {
-    char* result = strdup(template);
-    
-    for (int i = 0; i < param_count; i++) {
-        const char *patterns[2];
-        char buf1[128], buf2[128];
-
-        snprintf(buf1, sizeof(buf1), "{{%s}}", params[i].key);
-        snprintf(buf2, sizeof(buf2), "{{ %s }}", params[i].key);
-
-        patterns[0] = buf1;
-        patterns[1] = buf2;
-
-        ValueConverter converter = params[i].converter ? params[i].converter : convert_string;
-        
-        // Convert the value using the converter function
-        char* value_str = converter(params[i].value);
-        if (!value_str) {
-            free(result);
-            return NULL;
-        }
- 
-        for (int p = 0; p < 2; p++) {
-            const char *pattern = patterns[p];
-            char *pos;
-
-            while ((pos = strstr(result, pattern)) != NULL) {
-                int value_len = strlen(value_str);
-                int pattern_len = strlen(pattern);
-                int new_size = strlen(result) - pattern_len + value_len + 1;
-
-                char *new_result = malloc(new_size);
-
-                strncpy(new_result, result, pos - result);
-                strcpy(new_result + (pos - result), value_str);
-                strcpy(new_result + (pos - result) + value_len, pos + pattern_len);
-
-                free(result);
-                result = new_result;
-            }
-        }
-        free(value_str);
-    }
-    
-    return result;
-}
-
-void render_html(HTTPRequest *request, const char *file_path, TemplateParam* params, int param_count) {
-    size_t len = snprintf(NULL, 0, "%s/%s", TEMPLATE_DIR, file_path) + 1;
-    char *fullpath = malloc(len);
-    snprintf(fullpath, len, "%s/%s", TEMPLATE_DIR, file_path);
-    FILE *file = fopen(fullpath, "r");
-    if (!file) {
-        const char *body = "<h1>404 Not Found</h1>";
-        HTTPServer_send_response(request, body, "", 404, "");
-        return;
-    }
-
-    fseek(file, 0, SEEK_END);
-    long file_size = ftell(file);
-    fseek(file, 0, SEEK_SET);
-
-    char *file_content = (char *)malloc(file_size + 1);
-    if (!file_content) {
-        fclose(file);
-        const char *body = "<h1>500 Internal Server Error</h1>";
-        HTTPServer_send_response(request, body, "", 500, "");
-        return;
-    }
-
-    fread(file_content, 1, file_size, file);
-    file_content[file_size] = '\0';
-    fclose(file);
-
-    char* processed_content = replace_template_params(file_content, params, param_count);
-    free(file_content);
-    if (!processed_content) {
-        const char *body = "<h1>500 Internal Server Error</h1>";
-        HTTPServer_send_response(request, body, "", 500, "");
-        return;
-    }
-
-    HTTPServer_send_response(request, processed_content, "", 0, "");
-
-    free(processed_content);
-}
-
-char *process_html(const char *file_path, TemplateParam* params, int param_count) {
-    size_t len = snprintf(NULL, 0, "%s/%s", TEMPLATE_DIR, file_path) + 1;
-    char *fullpath = malloc(len);
-    snprintf(fullpath, len, "%s/%s", TEMPLATE_DIR, file_path);
-    FILE *file = fopen(fullpath, "r");
-    if (!file) {
-        return strdup("");
-    }
-
-    fseek(file, 0, SEEK_END);
-    long file_size = ftell(file);
-    fseek(file, 0, SEEK_SET);
-
-    char *file_content = (char *)malloc(file_size + 1);
-    if (!file_content) {
-        fclose(file);
-        return strdup("");
-    }
-
-    fread(file_content, 1, file_size, file);
-    file_content[file_size] = '\0';
-    fclose(file);
-
-    char* processed_content = replace_template_params(file_content, params, param_count);
-    free(file_content);
-    if (!processed_content) {
-        return strdup("");
-    }
-
-    return processed_content;
-}
+#include"HTMLTemplating.h"
+#include<stdio.h>
+#include<stdlib.h>
+#include<string.h>
+#include<stdbool.h>
+#include<ctype.h>
+#include<math.h>
+#include<pthread.h>
+#include<time.h>
+#include<sys/stat.h>
+#include"Hash.h"
+#include"Trace.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define ESCAPE_SIMD 1
+#include<immintrin.h>
+#endif
+
+// ---- Number formatting ----
+// Formats right to left into the end of a caller buffer, two digits per
+// division and always with '.' as the decimal point, whatever the locale.
+
+#define FORMAT_BUFFER_SIZE 32
+
+static const char digit_pairs[] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static char *format_uint(char *end, unsigned long long value) {
+    while (value >= 100) {
+        const char *pair = &digit_pairs[(value % 100) * 2];
+        value /= 100;
+        *--end = pair[1];
+        *--end = pair[0];
+    }
+    if (value >= 10) {
+        *--end = digit_pairs[value * 2 + 1];
+        *--end = digit_pairs[value * 2];
+    } else {
+        *--end = (char)('0' + value);
+    }
+    return end;
+}
+
+static char *format_int(char *buffer, long long value, size_t *len) {
+    char *end = buffer + FORMAT_BUFFER_SIZE;
+    unsigned long long magnitude = value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+    char *start = format_uint(end, magnitude);
+    if (value < 0) *--start = '-';
+    *len = end - start;
+    return start;
+}
+
+// Same output as "%.2f". printf rounds the exact binary value, half to
+// even on a tie (0.125 gives "0.12"): values within the error of the
+// multiplication from a tie, and huge or non-finite ones, are left to it.
+static char *format_float(char *buffer, double value, size_t *len) {
+    unsigned long long whole = 0;
+    double fraction = 0.5;
+    if (!isnan(value) && !isinf(value) && fabs(value) < 1e9) {
+        double hundredths = fabs(value) * 100.0;
+        whole = (unsigned long long)hundredths;
+        fraction = hundredths - (double)whole;
+    }
+    if (fabs(fraction - 0.5) < 1e-4) {
+        *len = snprintf(buffer, FORMAT_BUFFER_SIZE, "%.2f", value);
+        return buffer;
+    }
+
+    unsigned long long scaled = whole + (fraction > 0.5);
+    char *end = buffer + FORMAT_BUFFER_SIZE;
+    const char *pair = &digit_pairs[(scaled % 100) * 2];
+    *--end = pair[1];
+    *--end = pair[0];
+    *--end = '.';
+    char *start = format_uint(end, scaled / 100);
+    if (signbit(value)) *--start = '-';
+    *len = buffer + FORMAT_BUFFER_SIZE - start;
+    return start;
+}
+
+static char *dup_formatted(const char *start, size_t len) {
+    char *result = malloc(len + 1);
+    if (!result) return NULL;
+    memcpy(result, start, len);
+    result[len] = '\0';
+    return result;
+}
+
+// Example converter functions
+char* convert_string(const void* value) {
+	return strdup((const char*)value);
+}
+
+char* convert_int(const void* value) {
+    char buffer[FORMAT_BUFFER_SIZE];
+    size_t len;
+    char *start = format_int(buffer, *(const int*)value, &len);
+    return dup_formatted(start, len);
+}
+
+char* convert_float(const void* value) {
+    char buffer[FORMAT_BUFFER_SIZE];
+    size_t len;
+    char *start = format_float(buffer, *(const float*)value, &len);
+    return dup_formatted(start, len);
+}
+
+char* convert_bool(const void* value) {
+    return strdup(*(const bool*)value ? "true" : "false");
+}
+
+char* convert_list(const void* value) {
+    char buffer[FORMAT_BUFFER_SIZE];
+    size_t len;
+    char *start = format_int(buffer, value ? (long long)((const TemplateList*)value)->count : 0, &len);
+    return dup_formatted(start, len);
+}
+
+// ---- Value writers ----
+
+bool write_string(TemplateOutput *out, const void *value) {
+    return template_output_append_str(out, value);
+}
+
+bool write_int(TemplateOutput *out, const void *value) {
+    char buffer[FORMAT_BUFFER_SIZE];
+    size_t len;
+    const char *start = format_int(buffer, *(const int*)value, &len);
+    return template_output_copy(out, start, len);
+}
+
+bool write_float(TemplateOutput *out, const void *value) {
+    char buffer[FORMAT_BUFFER_SIZE];
+    size_t len;
+    const char *start = format_float(buffer, *(const float*)value, &len);
+    return template_output_copy(out, start, len);
+}
+
+bool write_bool(TemplateOutput *out, const void *value) {
+    return *(const bool*)value ? template_output_append(out, "true", 4) : template_output_append(out, "false", 5);
+}
+
+bool write_list(TemplateOutput *out, const void *value) {
+    char buffer[FORMAT_BUFFER_SIZE];
+    size_t len;
+    const char *start = format_uint(buffer + FORMAT_BUFFER_SIZE, value ? ((const TemplateList*)value)->count : 0);
+    len = buffer + FORMAT_BUFFER_SIZE - start;
+    return template_output_copy(out, start, len);
+}
+
+// Built-in converters are served by their writer, other converters go
+// through template_output_convert and keep their strdup'd result
+static ValueWriter converter_writer(ValueConverter converter) {
+    if (!converter || converter == convert_string) return write_string;
+    if (converter == convert_int) return write_int;
+    if (converter == convert_float) return write_float;
+    if (converter == convert_bool) return write_bool;
+    if (converter == convert_list) return write_list;
+    return NULL;
+}
+
+static bool output_own(TemplateOutput *out, char *data);
+
+// Numbers, bools and list counts never contain characters that need escaping
+static bool writer_is_safe(ValueWriter writer) {
+    return writer == write_int || writer == write_float || writer == write_bool || writer == write_list;
+}
+
+static bool output_value(TemplateOutput *out, ValueConverter converter, ValueWriter writer,
+                         const void *value, TemplateEscape escape) {
+    if (!writer) writer = converter_writer(converter);
+    if (writer == write_string) return template_output_escape_str(out, value, escape);
+    if (escape == ESCAPE_RAW || writer_is_safe(writer)) {
+        return writer ? writer(out, value) : template_output_convert(out, converter, value);
+    }
+
+    // Custom writer or converter: escape what it prints
+    TemplateOutput tmp;
+    template_output_init(&tmp);
+    bool ok = writer ? writer(&tmp, value) : template_output_convert(&tmp, converter, value);
+    char *printed = ok ? template_output_join(&tmp) : NULL;
+    template_output_free(&tmp);
+    if (!printed || !output_own(out, printed)) {
+        free(printed);
+        return false;
+    }
+    return template_output_escape(out, printed, strlen(printed), escape);
+}
+
+static bool value_is_list(ValueConverter converter, ValueWriter writer) {
+    return (writer ? writer : converter_writer(converter)) == write_list;
+}
+
+static bool value_truthy(ValueConverter converter, ValueWriter writer, const void *value) {
+    if (!value) return false;
+    if (!writer) writer = converter_writer(converter);
+
+    if (writer == write_string) return template_truthy(value);
+    if (writer == write_int) return *(const int*)value != 0;
+    if (writer == write_float) return *(const float*)value != 0.0f;
+    if (writer == write_bool) return *(const bool*)value;
+    if (writer == write_list) return ((const TemplateList*)value)->count > 0;
+
+    // Custom writer or converter: look at what it would print
+    TemplateOutput tmp;
+    template_output_init(&tmp);
+    char *printed = output_value(&tmp, converter, writer, value, ESCAPE_RAW) ? template_output_join(&tmp) : NULL;
+    template_output_free(&tmp);
+    bool truthy = template_truthy(printed);
+    free(printed);
+    return truthy;
+}
+
+// Helper function to check if a value looks like a string
+bool is_string(const void* value) {
+    const char* str = (const char*)value;
+    // Check if it points to valid memory and looks like a string
+    if (!str) return false;
+    
+    // Check first few characters to see if they're printable
+    for (int i = 0; i < 8 && str[i] != '\0'; i++) {
+        if (!isprint(str[i])) return false;
+    }
+    return true;
+}
+
+// Helper function to check if a value looks like a number
+bool is_number(const void* value, size_t size) {
+    
+    // Check for common float patterns in memory
+    if (size == sizeof(float)) {
+        float f = *(const float*)value;
+        return !isnan(f) && !isinf(f);
+    }
+    
+    // For integers, check if the value looks reasonable
+    if (size == sizeof(int)) {
+        int i = *(const int*)value;
+        return i > -1000000000 && i < 1000000000; // Reasonable range
+    }
+    
+    return false;
+}
+
+
+// ---- Template cache ----
+// Templates are read and segmented once, then shared by every worker.
+// Every TEMPLATE_RECHECK_SECONDS a lookup stats the file and, when its
+// mtime moved, parses it again into a new entry ahead of the old one.
+// Entries are never evicted so segment pointers stay valid while a
+// response that references them is being written.
+
+typedef struct TemplateCacheEntry {
+    Template tpl;
+    struct timespec mtime;
+    time_t checked;     // monotonic second of the last stat
+    struct TemplateCacheEntry *next;
+} TemplateCacheEntry;
+
+static TemplateCacheEntry *template_cache = NULL;
+static pthread_rwlock_t template_cache_lock = PTHREAD_RWLOCK_INITIALIZER;
+
+static time_t monotonic_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec;
+}
+
+static bool push_segment(Template *tpl, int *capacity, TemplateSegment seg) {
+    if (tpl->segment_count == *capacity) {
+        int new_capacity = *capacity ? *capacity * 2 : 16;
+        TemplateSegment *tmp = realloc(tpl->segments, new_capacity * sizeof(TemplateSegment));
+        if (!tmp) return false;
+        tpl->segments = tmp;
+        *capacity = new_capacity;
+    }
+    tpl->segments[tpl->segment_count++] = seg;
+    return true;
+}
+
+typedef struct {
+    const char *ptr;
+    size_t len;
+} TagToken;
+
+static bool token_is(const TagToken *t, const char *word) {
+    return t->len == strlen(word) && strncmp(t->ptr, word, t->len) == 0;
+}
+
+// Splits a {% %} tag body on whitespace, quotes are stripped
+static int tokenize_tag(const char *p, const char *end, TagToken *tokens, int max_tokens) {
+    int count = 0;
+    while (p < end && count < max_tokens) {
+        while (p < end && isspace((unsigned char)*p)) p++;
+        if (p >= end) break;
+
+        if (*p == '"' || *p == '\'') {
+            char quote = *p++;
+            const char *start = p;
+            while (p < end && *p != quote) p++;
+            tokens[count++] = (TagToken){ start, (size_t)(p - start) };
+            if (p < end) p++;
+        } else {
+            const char *start = p;
+            while (p < end && !isspace((unsigned char)*p)) p++;
+            tokens[count++] = (TagToken){ start, (size_t)(p - start) };
+        }
+    }
+    return count;
+}
+
+// Fills seg from the body of a {% %} tag
+static bool parse_block_tag(const char *body, const char *body_end, TemplateSegment *seg) {
+    TagToken t[6];
+    int n = tokenize_tag(body, body_end, t, 6);
+    if (n == 0) return false;
+
+    if (token_is(&t[0], "if") && (n == 2 || (n == 3 && token_is(&t[1], "not")))) {
+        seg->type = SEGMENT_IF;
+        seg->negate = (n == 3);
+        seg->key = t[n - 1].ptr;
+        seg->key_len = t[n - 1].len;
+
+        const char *hint = memchr(seg->key, ':', seg->key_len);
+        if (hint) {
+            seg->hint = hint + 1;
+            seg->hint_len = seg->key + seg->key_len - seg->hint;
+            seg->key_len = hint - seg->key;
+        }
+        return true;
+    }
+    if (token_is(&t[0], "for") && n == 4 && token_is(&t[2], "in")) {
+        seg->type = SEGMENT_FOR;
+        seg->var = t[1].ptr;
+        seg->var_len = t[1].len;
+        seg->key = t[3].ptr;
+        seg->key_len = t[3].len;
+        return true;
+    }
+    if (token_is(&t[0], "include") &&
+        (n == 2 || ((n == 4 || (n == 5 && token_is(&t[4], "cached"))) && token_is(&t[2], "with")))) {
+        seg->type = SEGMENT_INCLUDE;
+        seg->key = t[1].ptr;
+        seg->key_len = t[1].len;
+        if (n >= 4) {
+            seg->var = t[3].ptr;
+            seg->var_len = t[3].len;
+        }
+        seg->cached = (n == 5);
+        return true;
+    }
+    if (n == 1 && token_is(&t[0], "else"))   { seg->type = SEGMENT_ELSE;   return true; }
+    if (n == 1 && token_is(&t[0], "endif"))  { seg->type = SEGMENT_ENDIF;  return true; }
+    if (n == 1 && token_is(&t[0], "endfor")) { seg->type = SEGMENT_ENDFOR; return true; }
+    return false;
+}
+
+// Links if/else/endif and for/endfor through their jump index
+static bool link_block(Template *tpl, int *stack, int *depth, int index) {
+    TemplateSegment *seg = &tpl->segments[index];
+    switch (seg->type) {
+        case SEGMENT_IF:
+        case SEGMENT_FOR:
+            if (*depth == TEMPLATE_MAX_DEPTH) return false;
+            stack[(*depth)++] = index;
+            return true;
+        case SEGMENT_ELSE:
+            if (*depth == 0 || tpl->segments[stack[*depth - 1]].type != SEGMENT_IF) return false;
+            tpl->segments[stack[*depth - 1]].jump = index;
+            stack[*depth - 1] = index;
+            return true;
+        case SEGMENT_ENDIF:
+            if (*depth == 0) return false;
+            if (tpl->segments[stack[*depth - 1]].type != SEGMENT_IF &&
+                tpl->segments[stack[*depth - 1]].type != SEGMENT_ELSE) return false;
+            tpl->segments[stack[--(*depth)]].jump = index;
+            return true;
+        case SEGMENT_ENDFOR:
+            if (*depth == 0 || tpl->segments[stack[*depth - 1]].type != SEGMENT_FOR) return false;
+            seg->jump = stack[*depth - 1];
+            tpl->segments[stack[--(*depth)]].jump = index;
+            return true;
+        default:
+            return true;
+    }
+}
+
+// Where the parser is in the surrounding HTML, used to pick the escaping
+// of each {{ }} slot
+typedef enum {
+    HTML_TEXT,
+    HTML_TAG,
+    HTML_ATTR_VALUE,
+    HTML_COMMENT
+} HtmlContext;
+
+static void scan_html_context(HtmlContext *context, char *quote, const char *p, const char *end) {
+    for (; p < end; p++) {
+        switch (*context) {
+            case HTML_TEXT:
+                if (*p != '<' || p + 1 >= end) break;
+                if (end - p >= 4 && strncmp(p, "<!--", 4) == 0) {
+                    *context = HTML_COMMENT;
+                    p += 3;
+                } else if (isalpha((unsigned char)p[1]) || p[1] == '/' || p[1] == '!') {
+                    *context = HTML_TAG;
+                }
+                break;
+            case HTML_TAG:
+                if (*p == '>') *context = HTML_TEXT;
+                else if (*p == '"' || *p == '\'') {
+                    *context = HTML_ATTR_VALUE;
+                    *quote = *p;
+                }
+                break;
+            case HTML_ATTR_VALUE:
+                if (*p == *quote) *context = HTML_TAG;
+                break;
+            case HTML_COMMENT:
+                if (end - p >= 3 && strncmp(p, "-->", 3) == 0) {
+                    *context = HTML_TEXT;
+                    p += 2;
+                }
+                break;
+        }
+    }
+}
+
+// Split content into literal runs, {{ key }} / {{ key:type }} slots and
+// {% %} block tags, with every block linked to its closing tag. Slots are
+// HTML-escaped for the context they appear in unless marked {{ key|raw }}.
+bool template_parse(Template *tpl) {
+    const char *p = tpl->content;
+    const char *end = tpl->content + tpl->content_len;
+    const char *literal = p;
+    int capacity = 0;
+    int stack[TEMPLATE_MAX_DEPTH];
+    int depth = 0;
+    const char *name = tpl->path ? tpl->path : "template";
+    HtmlContext context = HTML_TEXT;
+    char quote = '"';
+    const char *scanned = p;
+
+    tpl->segments = NULL;
+    tpl->segment_count = 0;
+
+    while (p < end) {
+        const char *open = strchr(p, '{');
+        if (!open) break;
+        if (open[1] != '{' && open[1] != '%') {
+            p = open + 1;
+            continue;
+        }
+
+        bool is_block = (open[1] == '%');
+        const char *close = strstr(open + 2, is_block ? "%}" : "}}");
+        if (!close) break;
+
+        const char *key = open + 2;
+        const char *key_end = close;
+        while (key < key_end && isspace((unsigned char)*key)) key++;
+        while (key_end > key && isspace((unsigned char)key_end[-1])) key_end--;
+
+        if (key == key_end) {
+            p = open + 2;
+            continue;
+        }
+
+        TemplateSegment seg = {0};
+        seg.text = open;
+        seg.len = close + 2 - open;
+
+        scan_html_context(&context, &quote, scanned, open);
+        scanned = close + 2;
+
+        if (is_block) {
+            if (!parse_block_tag(key, key_end, &seg)) {
+                fprintf(stderr, "%s: unknown tag %.*s\n", name, (int)seg.len, seg.text);
+                return false;
+            }
+        } else {
+            seg.type = SEGMENT_PARAM;
+            seg.escape = context == HTML_ATTR_VALUE ? ESCAPE_ATTR
+                       : context == HTML_TAG ? ESCAPE_UNQUOTED : ESCAPE_TEXT;
+
+            const char *filter = memchr(key, '|', key_end - key);
+            if (filter) {
+                const char *filter_end = key_end;
+                key_end = filter++;
+                while (key_end > key && isspace((unsigned char)key_end[-1])) key_end--;
+                while (filter < filter_end && isspace((unsigned char)*filter)) filter++;
+                if (filter_end - filter != 3 || strncmp(filter, "raw", 3) != 0) {
+                    fprintf(stderr, "%s: unknown filter in %.*s\n", name, (int)seg.len, seg.text);
+                    return false;
+                }
+                seg.escape = ESCAPE_RAW;
+            }
+
+            const char *hint = memchr(key, ':', key_end - key);
+            const char *hint_end = key_end;
+            if (hint) {
+                key_end = hint++;
+                while (key_end > key && isspace((unsigned char)key_end[-1])) key_end--;
+                while (hint < hint_end && isspace((unsigned char)*hint)) hint++;
+                seg.hint = hint;
+                seg.hint_len = hint_end - hint;
+            }
+            seg.key = key;
+            seg.key_len = key_end - key;
+        }
+
+        if (open > literal) {
+            TemplateSegment lit = { .type = SEGMENT_LITERAL, .text = literal, .len = (size_t)(open - literal) };
+            if (!push_segment(tpl, &capacity, lit)) return false;
+        }
+
+        if (!push_segment(tpl, &capacity, seg)) return false;
+        if (!link_block(tpl, stack, &depth, tpl->segment_count - 1)) {
+            fprintf(stderr, "%s: unbalanced %.*s\n", name, (int)seg.len, seg.text);
+            return false;
+        }
+
+        p = literal = close + 2;
+    }
+
+    if (depth > 0) {
+        fprintf(stderr, "%s: unclosed %.*s\n", name,
+                (int)tpl->segments[stack[depth - 1]].len, tpl->segments[stack[depth - 1]].text);
+        return false;
+    }
+
+    if (end > literal) {
+        TemplateSegment lit = { .type = SEGMENT_LITERAL, .text = literal, .len = (size_t)(end - literal) };
+        if (!push_segment(tpl, &capacity, lit)) return false;
+    }
+
+    // Pages without tags always render the same bytes, hash them once
+    tpl->is_static = true;
+    Hash64State state;
+    hash64_init(&state, 0);
+    for (int i = 0; i < tpl->segment_count && tpl->is_static; i++) {
+        tpl->is_static = (tpl->segments[i].type == SEGMENT_LITERAL);
+        hash64_update(&state, tpl->segments[i].text, tpl->segments[i].len);
+    }
+    if (tpl->is_static) HTTPServer_format_etag(hash64_digest(&state), tpl->etag);
+    return true;
+}
+
+static char *template_full_path(const char *file_path) {
+    size_t len = snprintf(NULL, 0, "%s/%s", TEMPLATE_DIR, file_path) + 1;
+    char *fullpath = malloc(len);
+    if (fullpath) snprintf(fullpath, len, "%s/%s", TEMPLATE_DIR, file_path);
+    return fullpath;
+}
+
+static bool template_file_mtime(const char *file_path, struct timespec *mtime) {
+    char *fullpath = template_full_path(file_path);
+    if (!fullpath) return false;
+    struct stat st;
+    bool ok = stat(fullpath, &st) == 0;
+    free(fullpath);
+    if (ok) *mtime = st.st_mtim;
+    return ok;
+}
+
+static char *read_template_file(const char *file_path, size_t *out_len) {
+    char *fullpath = template_full_path(file_path);
+    if (!fullpath) return NULL;
+
+    FILE *file = fopen(fullpath, "r");
+    free(fullpath);
+    if (!file) return NULL;
+
+    fseek(file, 0, SEEK_END);
+    long file_size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+
+    char *content = malloc(file_size + 1);
+    if (!content) {
+        fclose(file);
+        return NULL;
+    }
+
+    size_t read = fread(content, 1, file_size, file);
+    content[read] = '\0';
+    fclose(file);
+
+    *out_len = read;
+    return content;
+}
+
+// Newest first, a reloaded template shadows the entries it replaced
+static TemplateCacheEntry *template_cache_find(const char *file_path) {
+    for (TemplateCacheEntry *e = template_cache; e; e = e->next) {
+        if (strcmp(e->tpl.path, file_path) == 0) return e;
+    }
+    return NULL;
+}
+
+// True once per TEMPLATE_RECHECK_SECONDS per entry when the file on disk
+// is no longer the one that was parsed. One caller wins the check, the
+// others keep rendering the current entry meanwhile.
+static bool template_changed(TemplateCacheEntry *entry) {
+    if (TEMPLATE_RECHECK_SECONDS <= 0) return false;
+
+    time_t now = monotonic_seconds();
+    time_t checked = __atomic_load_n(&entry->checked, __ATOMIC_RELAXED);
+    if (now - checked < TEMPLATE_RECHECK_SECONDS) return false;
+    if (!__atomic_compare_exchange_n(&entry->checked, &checked, now, false,
+                                     __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        return false;
+    }
+
+    struct timespec mtime;
+    return template_file_mtime(entry->tpl.path, &mtime) &&
+           (mtime.tv_sec != entry->mtime.tv_sec || mtime.tv_nsec != entry->mtime.tv_nsec);
+}
+
+static void template_entry_free(TemplateCacheEntry *entry) {
+    for (int i = 0; i < ENCODING_COUNT; i++) {
+        free((char *)entry->tpl.encoded[i].data);
+    }
+    free(entry->tpl.content);
+    free(entry->tpl.path);
+    free(entry->tpl.segments);
+    free(entry);
+}
+
+// A static page's bytes never change, so each coding is produced once here
+static void template_precompress(Template *tpl) {
+    if (!tpl->is_static) return;
+
+    size_t total = 0;
+    struct iovec *iov = malloc((tpl->segment_count + 1) * sizeof(struct iovec));
+    if (!iov) return;
+    for (int i = 0; i < tpl->segment_count; i++) {
+        iov[i].iov_base = (void *)tpl->segments[i].text;
+        iov[i].iov_len = tpl->segments[i].len;
+        total += tpl->segments[i].len;
+    }
+
+    for (int e = ENCODING_GZIP; e < ENCODING_COUNT && total >= (size_t)COMPRESSION_MIN_SIZE; e++) {
+        const char *data;
+        size_t len;
+        if (!Compression_compress(e, iov, tpl->segment_count, &data, &len)) continue;
+        char *copy = malloc(len);
+        if (!copy) continue;
+        memcpy(copy, data, len);
+        tpl->encoded[e].data = copy;
+        tpl->encoded[e].len = len;
+    }
+    free(iov);
+}
+
+const Template *template_load(const char *file_path) {
+    pthread_rwlock_rdlock(&template_cache_lock);
+    TemplateCacheEntry *current = template_cache_find(file_path);
+    pthread_rwlock_unlock(&template_cache_lock);
+    if (current && !template_changed(current)) return &current->tpl;
+
+    TemplateCacheEntry *entry = calloc(1, sizeof(TemplateCacheEntry));
+    if (!entry) return current ? &current->tpl : NULL;
+
+    // Stat before reading so a write racing the read is seen next check
+    bool stamped = template_file_mtime(file_path, &entry->mtime);
+    entry->checked = monotonic_seconds();
+    entry->tpl.content = read_template_file(file_path, &entry->tpl.content_len);
+    entry->tpl.path = strdup(file_path);
+    if (!stamped || !entry->tpl.content || !entry->tpl.path || !template_parse(&entry->tpl)) {
+        // A half-saved edit keeps the last good parse
+        template_entry_free(entry);
+        return current ? &current->tpl : NULL;
+    }
+    template_precompress(&entry->tpl);
+
+    pthread_rwlock_wrlock(&template_cache_lock);
+    TemplateCacheEntry *found = template_cache_find(file_path);
+    if (found == current) {
+        entry->next = template_cache;
+        template_cache = entry;
+        found = entry;
+        entry = NULL;
+    }
+    pthread_rwlock_unlock(&template_cache_lock);
+
+    // Another thread loaded it first
+    if (entry) template_entry_free(entry);
+    return &found->tpl;
+}
+
+// ---- Render output ----
+
+void template_output_init(TemplateOutput *out) {
+    memset(out, 0, sizeof(*out));
+}
+
+// Drops the rendered values but keeps the buffers for the next render
+static void template_output_reset(TemplateOutput *out) {
+    for (int i = 0; i < out->owned_count; i++) {
+        free(out->owned[i]);
+    }
+    out->owned_count = 0;
+    out->iov_count = 0;
+    out->scratch_used = 0;
+    out->total_len = 0;
+}
+
+void template_output_free(TemplateOutput *out) {
+    for (int i = 0; i < out->owned_count; i++) {
+        free(out->owned[i]);
+    }
+    free(out->owned);
+    free(out->scratch);
+    free(out->iov);
+    memset(out, 0, sizeof(*out));
+}
+
+bool template_output_append(TemplateOutput *out, const char *data, size_t len) {
+    if (len == 0) return true;
+    if (out->iov_count == out->iov_capacity) {
+        int new_capacity = out->iov_capacity ? out->iov_capacity * 2 : 32;
+        struct iovec *tmp = realloc(out->iov, new_capacity * sizeof(struct iovec));
+        if (!tmp) return false;
+        out->iov = tmp;
+        out->iov_capacity = new_capacity;
+    }
+    out->iov[out->iov_count].iov_base = (void *)data;
+    out->iov[out->iov_count].iov_len = len;
+    out->iov_count++;
+    out->total_len += len;
+    return true;
+}
+
+static bool output_own(TemplateOutput *out, char *data) {
+    if (out->owned_count == out->owned_capacity) {
+        int new_capacity = out->owned_capacity ? out->owned_capacity * 2 : 16;
+        char **tmp = realloc(out->owned, new_capacity * sizeof(char *));
+        if (!tmp) return false;
+        out->owned = tmp;
+        out->owned_capacity = new_capacity;
+    }
+    out->owned[out->owned_count++] = data;
+    return true;
+}
+
+// Strings are referenced in place, the caller keeps them alive until sent
+bool template_output_append_str(TemplateOutput *out, const char *str) {
+    return str ? template_output_append(out, str, strlen(str)) : true;
+}
+
+// Copies short formatted values into the scratch block. Consecutive
+// copies land next to each other and share a single iovec.
+bool template_output_copy(TemplateOutput *out, const char *data, size_t len) {
+    if (len == 0) return true;
+    if (out->scratch_size - out->scratch_used < len) {
+        size_t size = len > TEMPLATE_SCRATCH_BLOCK ? len : TEMPLATE_SCRATCH_BLOCK;
+        char *block = malloc(size);
+        if (!block) return false;
+        // Earlier blocks are still referenced by the iovec
+        if (out->scratch && !output_own(out, out->scratch)) {
+            free(block);
+            return false;
+        }
+        out->scratch = block;
+        out->scratch_size = size;
+        out->scratch_used = 0;
+    }
+
+    char *dst = out->scratch + out->scratch_used;
+    memcpy(dst, data, len);
+    out->scratch_used += len;
+
+    if (out->iov_count > 0) {
+        struct iovec *last = &out->iov[out->iov_count - 1];
+        if ((char *)last->iov_base + last->iov_len == dst) {
+            last->iov_len += len;
+            out->total_len += len;
+            return true;
+        }
+    }
+    return template_output_append(out, dst, len);
+}
+
+// Adapter for legacy converters, the returned string is owned by out
+bool template_output_convert(TemplateOutput *out, ValueConverter converter, const void *value) {
+    char *converted = converter(value);
+    if (!converted) return false;
+    if (!output_own(out, converted)) {
+        free(converted);
+        return false;
+    }
+    return template_output_append(out, converted, strlen(converted));
+}
+
+// ---- HTML escaping ----
+// The scanners return the length of the leading run that needs no
+// escaping. Runs are found 16 or 32 bytes at a time with SSE2/AVX2 and
+// bulk appended, only the special characters themselves are replaced.
+
+// 1: escaped everywhere, 2: escaped in attributes only, 4: escaped in
+// unquoted attribute values only, where they would end the value
+static const unsigned char escape_class[256] = {
+    ['&'] = 1, ['<'] = 1, ['>'] = 1, ['"'] = 2, ['\''] = 2,
+    [' '] = 4, ['\t'] = 4, ['\n'] = 4, ['\r'] = 4, ['\f'] = 4, ['='] = 4, ['`'] = 4
+};
+
+static size_t escape_scan_mask(const char *data, size_t len, unsigned char mask) {
+    size_t i = 0;
+    while (i < len && !(escape_class[(unsigned char)data[i]] & mask)) i++;
+    return i;
+}
+
+static size_t escape_scan_scalar(const char *data, size_t len, bool attr) {
+    return escape_scan_mask(data, len, attr ? 3 : 1);
+}
+
+#ifdef ESCAPE_SIMD
+static size_t escape_scan_sse2(const char *data, size_t len, bool attr) {
+    const __m128i amp = _mm_set1_epi8('&');
+    const __m128i lt = _mm_set1_epi8('<');
+    const __m128i gt = _mm_set1_epi8('>');
+    const __m128i quot = _mm_set1_epi8('"');
+    const __m128i apos = _mm_set1_epi8('\'');
+
+    size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(data + i));
+        __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, amp), _mm_cmpeq_epi8(v, lt)),
+                                   _mm_cmpeq_epi8(v, gt));
+        if (attr) hit = _mm_or_si128(hit, _mm_or_si128(_mm_cmpeq_epi8(v, quot), _mm_cmpeq_epi8(v, apos)));
+        int mask = _mm_movemask_epi8(hit);
+        if (mask) return i + __builtin_ctz(mask);
+    }
+    return i + escape_scan_scalar(data + i, len - i, attr);
+}
+
+__attribute__((target("avx2")))
+static size_t escape_scan_avx2(const char *data, size_t len, bool attr) {
+    const __m256i amp = _mm256_set1_epi8('&');
+    const __m256i lt = _mm256_set1_epi8('<');
+    const __m256i gt = _mm256_set1_epi8('>');
+    const __m256i quot = _mm256_set1_epi8('"');
+    const __m256i apos = _mm256_set1_epi8('\'');
+
+    size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(data + i));
+        __m256i hit = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, amp), _mm256_cmpeq_epi8(v, lt)),
+                                      _mm256_cmpeq_epi8(v, gt));
+        if (attr) hit = _mm256_or_si256(hit, _mm256_or_si256(_mm256_cmpeq_epi8(v, quot), _mm256_cmpeq_epi8(v, apos)));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(hit);
+        if (mask) return i + __builtin_ctz(mask);
+    }
+    return i + escape_scan_sse2(data + i, len - i, attr);
+}
+
+typedef size_t (*EscapeScanFn)(const char *data, size_t len, bool attr);
+
+static EscapeScanFn escape_scan_impl = escape_scan_sse2;
+static pthread_once_t escape_scan_once = PTHREAD_ONCE_INIT;
+
+static void escape_scan_init(void) {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) escape_scan_impl = escape_scan_avx2;
+}
+
+static size_t escape_scan(const char *data, size_t len, bool attr) {
+    pthread_once(&escape_scan_once, escape_scan_init);
+    return escape_scan_impl(data, len, attr);
+}
+#else
+#define escape_scan escape_scan_scalar
+#endif
+
+static const char *escape_entity(char c, size_t *len) {
+    switch (c) {
+        case '&':  *len = 5; return "&amp;";
+        case '<':  *len = 4; return "&lt;";
+        case '>':  *len = 4; return "&gt;";
+        case '"':  *len = 6; return "&quot;";
+        case '\'': *len = 5; return "&#39;";
+        case ' ':  *len = 5; return "&#32;";
+        case '\t': *len = 4; return "&#9;";
+        case '\n': *len = 5; return "&#10;";
+        case '\r': *len = 5; return "&#13;";
+        case '\f': *len = 5; return "&#12;";
+        case '=':  *len = 5; return "&#61;";
+        default:   *len = 5; return "&#96;";
+    }
+}
+
+// Clean runs at least this long are referenced in place, shorter ones are
+// copied so a value full of entities does not explode into tiny iovecs
+#define ESCAPE_REF_MIN 64
+
+bool template_output_escape(TemplateOutput *out, const char *data, size_t len, TemplateEscape escape) {
+    if (escape == ESCAPE_RAW) return template_output_append(out, data, len);
+
+    bool attr = (escape == ESCAPE_ATTR);
+    bool unquoted = (escape == ESCAPE_UNQUOTED);
+    size_t i = 0;
+    while (i < len) {
+        // Unquoted slots are rare, the scalar scan does for them
+        size_t run = unquoted ? escape_scan_mask(data + i, len - i, 7) : escape_scan(data + i, len - i, attr);
+        if (run > 0) {
+            bool whole = (i == 0 && run == len);
+            bool ok = (whole || run >= ESCAPE_REF_MIN) ? template_output_append(out, data + i, run)
+                                                      : template_output_copy(out, data + i, run);
+            if (!ok) return false;
+            i += run;
+        }
+        if (i < len) {
+            size_t entity_len;
+            const char *entity = escape_entity(data[i], &entity_len);
+            if (!template_output_copy(out, entity, entity_len)) return false;
+            i++;
+        }
+    }
+    return true;
+}
+
+bool template_output_escape_str(TemplateOutput *out, const char *str, TemplateEscape escape) {
+    return str ? template_output_escape(out, str, strlen(str), escape) : true;
+}
+
+uint64_t template_output_hash(const TemplateOutput *out) {
+    Hash64State state;
+    hash64_init(&state, 0);
+    for (int i = 0; i < out->iov_count; i++) {
+        hash64_update(&state, out->iov[i].iov_base, out->iov[i].iov_len);
+    }
+    return hash64_digest(&state);
+}
+
+// Sends the rendered body (or a 500 if rendering failed) and releases it.
+// The ETag is an XXH64 of the body; a matching If-None-Match gets a 304.
+void template_output_send(HTTPRequest *request, TemplateOutput *out, bool ok) {
+    char etag[HTTP_ETAG_SIZE] = "";
+    if (ok) HTTPServer_format_etag(template_output_hash(out), etag);
+    template_output_send_etag(request, out, ok, etag);
+}
+
+void template_output_send_etag(HTTPRequest *request, TemplateOutput *out, bool ok, const char *etag) {
+    if (!ok) {
+        const char *body = "<h1>500 Internal Server Error</h1>";
+        HTTPServer_send_response(request, body, "", 500, "");
+        template_output_free(out);
+        return;
+    }
+
+    char etag_header[HTTP_ETAG_SIZE + 16];
+    snprintf(etag_header, sizeof(etag_header), "ETag: %s\r\n", etag);
+
+    if (HTTPRequest_etag_matches(request, etag)) {
+        HTTPServer_send_response_headers(request, NULL, 0, "", 304, "", etag_header);
+    } else {
+        HTTPServer_send_response_headers(request, out->iov, out->iov_count, "", 0, "", etag_header);
+    }
+    template_output_free(out);
+}
+
+bool template_send_static(HTTPRequest *request, const char *etag, const EncodedBody *encoded) {
+    char headers[256];
+    if (HTTPRequest_etag_matches(request, etag)) {
+        snprintf(headers, sizeof(headers), "ETag: %s\r\n", etag);
+        HTTPServer_send_response_headers(request, NULL, 0, "", 304, "", headers);
+        return true;
+    }
+
+    ContentEncoding encoding = Compression_negotiate(HTTPRequest_get_header(request, "Accept-Encoding"));
+    if (encoding == ENCODING_IDENTITY || !encoded || !encoded[encoding].data) return false;
+
+    // Weak ETag, the strong one names the identity bytes
+    snprintf(headers, sizeof(headers), "ETag: W/%s\r\nContent-Encoding: %s\r\nVary: Accept-Encoding\r\n",
+             etag, Compression_name(encoding));
+    struct iovec body = { (void *)encoded[encoding].data, encoded[encoding].len };
+    HTTPServer_send_response_headers(request, &body, 1, "", 0, "", headers);
+    return true;
+}
+
+static int find_param(TemplateParam *params, int param_count, const char *key, size_t key_len) {
+    for (int i = 0; i < param_count; i++) {
+        if (params[i].key && strncmp(params[i].key, key, key_len) == 0 && params[i].key[key_len] == '\0') {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// ---- List helpers ----
+
+bool template_truthy(const char *value) {
+    return value && value[0] && strcmp(value, "0") != 0 && strcmp(value, "false") != 0;
+}
+
+const void *template_list_item(const TemplateList *list, size_t index) {
+    return (const char *)list->items + index * list->item_size;
+}
+
+static int find_field(const TemplateList *list, const char *name, size_t name_len) {
+    for (int i = 0; list && i < list->field_count; i++) {
+        if (strncmp(list->fields[i].name, name, name_len) == 0 && list->fields[i].name[name_len] == '\0') {
+            return i;
+        }
+    }
+    return -1;
+}
+
+int template_list_field(const TemplateList *list, const char *name) {
+    return find_field(list, name, strlen(name));
+}
+
+static const void *field_value(const TemplateList *list, const void *item, int field) {
+    const TemplateField *f = &list->fields[field];
+    const char *base = (const char *)item + f->offset;
+    return f->indirect ? *(const void * const *)base : base;
+}
+
+bool template_output_field(TemplateOutput *out, const TemplateList *list, const void *item, int field, TemplateEscape escape) {
+    if (field < 0) return false;
+    const void *value = field_value(list, item, field);
+    if (!value) return true;
+    return output_value(out, list->fields[field].converter, list->fields[field].writer, value, escape);
+}
+
+bool template_field_truthy(const TemplateList *list, const void *item, int field) {
+    if (field < 0) return false;
+    const TemplateField *f = &list->fields[field];
+    return value_truthy(f->converter, f->writer, field_value(list, item, field));
+}
+
+// ---- Rendering ----
+
+// One level of {% for %}, or an {% include ... with var %} that exposes
+// the item's fields without the "var." prefix
+typedef struct {
+    const char *var;
+    size_t var_len;
+    const TemplateList *list;
+    const void *item;
+    bool unqualified;
+} TemplateScope;
+
+typedef struct {
+    TemplateParam *params;
+    int param_count;
+    char **values;          // legacy converter results so far, owned by out
+    size_t *value_lens;
+    TemplateScope scopes[TEMPLATE_MAX_DEPTH];
+    int scope_count;
+    int include_depth;
+    TemplateOutput *out;
+} RenderContext;
+
+typedef struct {
+    bool found;
+    int param;              // >= 0 for top-level params
+    const TemplateList *list;
+    const void *item;
+    int field;
+} ResolvedValue;
+
+static const TemplateScope *find_scope(RenderContext *ctx, const char *var, size_t var_len) {
+    for (int i = ctx->scope_count - 1; i >= 0; i--) {
+        const TemplateScope *scope = &ctx->scopes[i];
+        if (scope->var_len == var_len && strncmp(scope->var, var, var_len) == 0) return scope;
+    }
+    return NULL;
+}
+
+// "item.field" reads a loop variable, a bare key is looked up in the
+// innermost "with" scope first and then in the params
+static ResolvedValue resolve(RenderContext *ctx, const char *key, size_t key_len) {
+    ResolvedValue r = { false, -1, NULL, NULL, -1 };
+
+    const char *dot = memchr(key, '.', key_len);
+    if (dot) {
+        const TemplateScope *scope = find_scope(ctx, key, dot - key);
+        if (scope) {
+            r.field = find_field(scope->list, dot + 1, key + key_len - dot - 1);
+            if (r.field >= 0) {
+                r.found = true;
+                r.list = scope->list;
+                r.item = scope->item;
+            }
+            return r;
+        }
+    } else {
+        for (int i = ctx->scope_count - 1; i >= 0; i--) {
+            if (!ctx->scopes[i].unqualified) continue;
+            int field = find_field(ctx->scopes[i].list, key, key_len);
+            if (field >= 0) {
+                r.found = true;
+                r.list = ctx->scopes[i].list;
+                r.item = ctx->scopes[i].item;
+                r.field = field;
+                return r;
+            }
+            break;
+        }
+    }
+
+    r.param = find_param(ctx->params, ctx->param_count, key, key_len);
+    r.found = (r.param >= 0);
+    return r;
+}
+
+static const void *resolved_value(RenderContext *ctx, const ResolvedValue *r) {
+    return r->param >= 0 ? ctx->params[r->param].value : field_value(r->list, r->item, r->field);
+}
+
+static bool emit_value(RenderContext *ctx, const ResolvedValue *r, TemplateEscape escape) {
+    if (r->param < 0) {
+        return template_output_field(ctx->out, r->list, r->item, r->field, escape);
+    }
+
+    const TemplateParam *param = &ctx->params[r->param];
+    ValueWriter writer = param->writer ? param->writer : converter_writer(param->converter);
+    if (writer) return output_value(ctx->out, NULL, writer, param->value, escape);
+
+    // A legacy converter runs at most once per param
+    int idx = r->param;
+    if (!ctx->values[idx]) {
+        ctx->values[idx] = param->converter(param->value);
+        if (!ctx->values[idx] || !output_own(ctx->out, ctx->values[idx])) {
+            free(ctx->values[idx]);
+            ctx->values[idx] = NULL;
+            return false;
+        }
+        ctx->value_lens[idx] = strlen(ctx->values[idx]);
+    }
+    return template_output_escape(ctx->out, ctx->values[idx], ctx->value_lens[idx], escape);
+}
+
+static bool is_truthy(RenderContext *ctx, const ResolvedValue *r) {
+    if (!r->found) return false;
+    if (r->param < 0) return template_field_truthy(r->list, r->item, r->field);
+
+    const TemplateParam *param = &ctx->params[r->param];
+    return value_truthy(param->converter, param->writer, param->value);
+}
+
+static bool is_list(RenderContext *ctx, const ResolvedValue *r) {
+    if (r->param >= 0) return value_is_list(ctx->params[r->param].converter, ctx->params[r->param].writer);
+    return value_is_list(r->list->fields[r->field].converter, r->list->fields[r->field].writer);
+}
+
+static bool render_range(RenderContext *ctx, const Template *tpl, int start, int end);
+static bool render_include_cached(RenderContext *ctx, const Template *partial, const TemplateScope *with);
+
+static bool render_for(RenderContext *ctx, const Template *tpl, const TemplateSegment *seg, int body, int end) {
+    ResolvedValue r = resolve(ctx, seg->key, seg->key_len);
+    if (!r.found || !is_list(ctx, &r)) return true;
+
+    const TemplateList *list = resolved_value(ctx, &r);
+    if (!list) return true;
+    if (ctx->scope_count == TEMPLATE_MAX_DEPTH) return false;
+
+    TemplateScope *scope = &ctx->scopes[ctx->scope_count++];
+    scope->var = seg->var;
+    scope->var_len = seg->var_len;
+    scope->list = list;
+    scope->unqualified = false;
+
+    bool ok = true;
+    for (size_t i = 0; ok && i < list->count; i++) {
+        scope->item = template_list_item(list, i);
+        ok = render_range(ctx, tpl, body, end);
+    }
+    ctx->scope_count--;
+    return ok;
+}
+
+static bool render_include(RenderContext *ctx, const TemplateSegment *seg) {
+    char path[512];
+    if (seg->key_len >= sizeof(path) || ctx->include_depth == TEMPLATE_MAX_DEPTH) return false;
+    memcpy(path, seg->key, seg->key_len);
+    path[seg->key_len] = '\0';
+
+    const Template *partial = template_load(path);
+    if (!partial) return false;
+
+    bool pushed = false;
+    if (seg->var) {
+        const TemplateScope *with = find_scope(ctx, seg->var, seg->var_len);
+        if (!with || ctx->scope_count == TEMPLATE_MAX_DEPTH) return false;
+        TemplateScope *scope = &ctx->scopes[ctx->scope_count++];
+        *scope = *with;
+        scope->unqualified = true;
+        pushed = true;
+    }
+
+    ctx->include_depth++;
+    bool ok = seg->cached ? render_include_cached(ctx, partial, &ctx->scopes[ctx->scope_count - 1])
+                          : render_range(ctx, partial, 0, partial->segment_count);
+    ctx->include_depth--;
+
+    if (pushed) ctx->scope_count--;
+    return ok;
+}
+
+static bool render_range(RenderContext *ctx, const Template *tpl, int start, int end) {
+    for (int s = start; s < end; s++) {
+        const TemplateSegment *seg = &tpl->segments[s];
+        bool ok = true;
+
+        switch (seg->type) {
+            case SEGMENT_LITERAL:
+                ok = template_output_append(ctx->out, seg->text, seg->len);
+                break;
+
+            case SEGMENT_PARAM: {
+                ResolvedValue r = resolve(ctx, seg->key, seg->key_len);
+                ok = r.found ? emit_value(ctx, &r, seg->escape) : template_output_append(ctx->out, seg->text, seg->len);
+                break;
+            }
+
+            case SEGMENT_IF: {
+                ResolvedValue r = resolve(ctx, seg->key, seg->key_len);
+                bool cond = is_truthy(ctx, &r) != seg->negate;
+                const TemplateSegment *branch = &tpl->segments[seg->jump];
+                int endif = branch->type == SEGMENT_ELSE ? branch->jump : seg->jump;
+
+                if (cond) ok = render_range(ctx, tpl, s + 1, seg->jump);
+                else if (branch->type == SEGMENT_ELSE) ok = render_range(ctx, tpl, seg->jump + 1, endif);
+                s = endif;
+                break;
+            }
+
+            case SEGMENT_FOR:
+                ok = render_for(ctx, tpl, seg, s + 1, seg->jump);
+                s = seg->jump;
+                break;
+
+            case SEGMENT_INCLUDE:
+                ok = render_include(ctx, seg);
+                break;
+
+            default:
+                break;
+        }
+        if (!ok) return false;
+    }
+    return true;
+}
+
+// Build the iovec for a template in a single pass. Values are written
+// straight into the output; a legacy converter runs at most once per
+// param, no matter how many times it appears. Unknown keys are kept verbatim.
+bool template_render(const Template *tpl, TemplateParam *params, int param_count, TemplateOutput *out) {
+    RenderContext ctx = {0};
+    ctx.params = params;
+    ctx.param_count = param_count;
+    ctx.out = out;
+
+    if (param_count > 0) {
+        ctx.values = calloc(param_count, sizeof(char *));
+        ctx.value_lens = calloc(param_count, sizeof(size_t));
+        if (!ctx.values || !ctx.value_lens) {
+            free(ctx.values);
+            free(ctx.value_lens);
+            return false;
+        }
+    }
+
+    bool ok = render_range(&ctx, tpl, 0, tpl->segment_count);
+
+    free(ctx.values);
+    free(ctx.value_lens);
+    return ok;
+}
+
+char *template_output_join(const TemplateOutput *out) {
+    char *result = malloc(out->total_len + 1);
+    if (!result) return NULL;
+
+    char *dst = result;
+    for (int i = 0; i < out->iov_count; i++) {
+        memcpy(dst, out->iov[i].iov_base, out->iov[i].iov_len);
+        dst += out->iov[i].iov_len;
+    }
+    *dst = '\0';
+    return result;
+}
+
+// Helper function to find and replace template parameters
+char* replace_template_params(const char* template, TemplateParam* params, int param_count) {
+    Template tpl = {0};
+    tpl.content = (char *)template;
+    tpl.content_len = strlen(template);
+    if (!template_parse(&tpl)) {
+        free(tpl.segments);
+        return NULL;
+    }
+
+    TemplateOutput out;
+    template_output_init(&out);
+    char *result = template_render(&tpl, params, param_count, &out) ? template_output_join(&out) : NULL;
+
+    template_output_free(&out);
+    free(tpl.segments);
+    return result;
+}
+
+// Streams the page: literal segments go to the socket straight from the
+// template cache, no full copy of the body is ever built.
+void render_html(HTTPRequest *request, const char *file_path, TemplateParam* params, int param_count) {
+    const Template *tpl = template_load(file_path);
+    if (!tpl) {
+        const char *body = "<h1>404 Not Found</h1>";
+        HTTPServer_send_response(request, body, "", 404, "");
+        return;
+    }
+
+    // Static page: precomputed ETag and bodies, usually nothing to render
+    if (tpl->is_static && template_send_static(request, tpl->etag, tpl->encoded)) return;
+
+    TemplateOutput out;
+    template_output_init(&out);
+    int64_t started = HTTPRequest_begin_phase(request, HTTP_PHASE_RENDER);
+    TRACE_PROBE1(render_start, file_path);
+    bool ok = template_render(tpl, params, param_count, &out);
+    TRACE_PROBE2(render_end, file_path, ok);
+    HTTPRequest_add_phase(request, HTTP_PHASE_RENDER, started);
+    if (tpl->is_static) template_output_send_etag(request, &out, ok, tpl->etag);
+    else template_output_send(request, &out, ok);
+}
+
+char *process_html(const char *file_path, TemplateParam* params, int param_count) {
+    const Template *tpl = template_load(file_path);
+    if (!tpl) {
+        return strdup("");
+    }
+
+    TemplateOutput out;
+    template_output_init(&out);
+    char *processed_content = template_render(tpl, params, param_count, &out) ? template_output_join(&out) : NULL;
+    template_output_free(&out);
+
+    if (!processed_content) {
+        return strdup("");
+    }
+
+    return processed_content;
+}
+
+// ---- Fragment cache ----
+// Keyed by an XXH64 of the template path and of every param's printed
+// value (list items field by field). Entries are spread over shards by
+// key, each a hash table and an LRU list under its own mutex, so workers
+// rendering different fragments rarely meet on a lock; a shard drops its
+// least recently used entries past its share of FRAGMENT_CACHE_BYTES.
+
+#define FRAGMENT_CACHE_SHARDS 16
+#define FRAGMENT_CACHE_BUCKETS 256     // per shard
+
+typedef struct FragmentEntry {
+    uint64_t key;
+    char *path;
+    char *html;
+    size_t len;
+    size_t cost;
+    time_t expires;         // 0 = no TTL
+    struct FragmentEntry *bucket_next;
+    struct FragmentEntry *lru_prev;
+    struct FragmentEntry *lru_next;
+} FragmentEntry;
+
+typedef struct {
+    pthread_mutex_t lock;
+    FragmentEntry *buckets[FRAGMENT_CACHE_BUCKETS];
+    FragmentEntry *lru_head;    // most recently used
+    FragmentEntry *lru_tail;
+    size_t bytes;
+} __attribute__((aligned(64))) FragmentShard;
+
+static FragmentShard fragment_shards[FRAGMENT_CACHE_SHARDS];
+static pthread_once_t fragment_shards_once = PTHREAD_ONCE_INIT;
+
+static void init_fragment_shards(void) {
+    for (int i = 0; i < FRAGMENT_CACHE_SHARDS; i++) {
+        pthread_mutex_init(&fragment_shards[i].lock, NULL);
+    }
+}
+
+static FragmentShard *fragment_shard(uint64_t key) {
+    pthread_once(&fragment_shards_once, init_fragment_shards);
+    return &fragment_shards[key % FRAGMENT_CACHE_SHARDS];
+}
+
+static size_t fragment_shard_limit(void) {
+    return FRAGMENT_CACHE_BYTES > 0 ? (size_t)FRAGMENT_CACHE_BYTES / FRAGMENT_CACHE_SHARDS : 0;
+}
+
+// Hashes what was written to out followed by its length, then clears it
+static void hash_output(Hash64State *state, TemplateOutput *out) {
+    for (int i = 0; i < out->iov_count; i++) {
+        hash64_update(state, out->iov[i].iov_base, out->iov[i].iov_len);
+    }
+    uint64_t len = out->total_len;
+    hash64_update(state, &len, sizeof(len));
+    template_output_reset(out);
+}
+
+static bool fragment_key(const Template *tpl, TemplateParam *params, int param_count, uint64_t *key) {
+    Hash64State state;
+    hash64_init(&state, 0);
+    hash64_update(&state, tpl->path, strlen(tpl->path) + 1);
+    hash64_update(&state, &tpl, sizeof(tpl));  // a reloaded template misses
+
+    TemplateOutput tmp;
+    template_output_init(&tmp);
+    bool ok = true;
+
+    for (int i = 0; ok && i < param_count; i++) {
+        const TemplateParam *param = &params[i];
+        if (param->key) hash64_update(&state, param->key, strlen(param->key) + 1);
+        if (!param->value) {
+            hash_output(&state, &tmp);
+            continue;
+        }
+
+        if (!value_is_list(param->converter, param->writer)) {
+            ok = output_value(&tmp, param->converter, param->writer, param->value, ESCAPE_RAW);
+            hash_output(&state, &tmp);
+            continue;
+        }
+
+        const TemplateList *list = param->value;
+        uint64_t count = list->count;
+        hash64_update(&state, &count, sizeof(count));
+        for (size_t item = 0; ok && item < list->count; item++) {
+            for (int field = 0; ok && field < list->field_count; field++) {
+                ok = template_output_field(&tmp, list, template_list_item(list, item), field, ESCAPE_RAW);
+                hash_output(&state, &tmp);
+            }
+        }
+    }
+
+    template_output_free(&tmp);
+    *key = hash64_digest(&state);
+    return ok;
+}
+
+static void fragment_lru_unlink(FragmentShard *shard, FragmentEntry *e) {
+    if (e->lru_prev) e->lru_prev->lru_next = e->lru_next;
+    else shard->lru_head = e->lru_next;
+    if (e->lru_next) e->lru_next->lru_prev = e->lru_prev;
+    else shard->lru_tail = e->lru_prev;
+    e->lru_prev = e->lru_next = NULL;
+}
+
+static void fragment_lru_push(FragmentShard *shard, FragmentEntry *e) {
+    e->lru_prev = NULL;
+    e->lru_next = shard->lru_head;
+    if (shard->lru_head) shard->lru_head->lru_prev = e;
+    shard->lru_head = e;
+    if (!shard->lru_tail) shard->lru_tail = e;
+}
+
+static FragmentEntry *fragment_find(FragmentShard *shard, uint64_t key, const char *file_path) {
+    for (FragmentEntry *e = shard->buckets[(key / FRAGMENT_CACHE_SHARDS) % FRAGMENT_CACHE_BUCKETS]; e; e = e->bucket_next) {
+        if (e->key == key && strcmp(e->path, file_path) == 0) return e;
+    }
+    return NULL;
+}
+
+static void fragment_remove(FragmentShard *shard, FragmentEntry *e) {
+    FragmentEntry **link = &shard->buckets[(e->key / FRAGMENT_CACHE_SHARDS) % FRAGMENT_CACHE_BUCKETS];
+    while (*link != e) link = &(*link)->bucket_next;
+    *link = e->bucket_next;
+
+    fragment_lru_unlink(shard, e);
+    shard->bytes -= e->cost;
+    free(e->path);
+    free(e->html);
+    free(e);
+}
+
+static void fragment_store(uint64_t key, const char *file_path, const char *html, size_t len, int ttl_seconds) {
+    size_t cost = sizeof(FragmentEntry) + strlen(file_path) + 1 + len + 1;
+    if (cost > fragment_shard_limit()) return;
+
+    FragmentEntry *e = calloc(1, sizeof(FragmentEntry));
+    if (!e) return;
+    e->key = key;
+    e->path = strdup(file_path);
+    e->html = malloc(len + 1);
+    if (!e->path || !e->html) {
+        free(e->path);
+        free(e->html);
+        free(e);
+        return;
+    }
+    memcpy(e->html, html, len + 1);
+    e->len = len;
+    e->cost = cost;
+    e->expires = ttl_seconds > 0 ? monotonic_seconds() + ttl_seconds : 0;
+
+    FragmentShard *shard = fragment_shard(key);
+    pthread_mutex_lock(&shard->lock);
+    // Another worker may have rendered the same fragment meanwhile
+    FragmentEntry *existing = fragment_find(shard, key, file_path);
+    if (existing) fragment_remove(shard, existing);
+
+    FragmentEntry **bucket = &shard->buckets[(key / FRAGMENT_CACHE_SHARDS) % FRAGMENT_CACHE_BUCKETS];
+    e->bucket_next = *bucket;
+    *bucket = e;
+    fragment_lru_push(shard, e);
+    shard->bytes += cost;
+
+    while (shard->bytes > fragment_shard_limit() && shard->lru_tail) {
+        fragment_remove(shard, shard->lru_tail);
+    }
+    pthread_mutex_unlock(&shard->lock);
+}
+
+// A live entry, moved to the front of its shard's LRU. The shard stays
+// locked until fragment_release, so the bytes can be copied out.
+static FragmentEntry *fragment_acquire(uint64_t key, const char *file_path) {
+    FragmentShard *shard = fragment_shard(key);
+    pthread_mutex_lock(&shard->lock);
+    FragmentEntry *e = fragment_find(shard, key, file_path);
+    if (e && e->expires && monotonic_seconds() >= e->expires) {
+        fragment_remove(shard, e);
+        e = NULL;
+    }
+    if (e) {
+        fragment_lru_unlink(shard, e);
+        fragment_lru_push(shard, e);
+    }
+    return e;
+}
+
+static void fragment_release(uint64_t key) {
+    pthread_mutex_unlock(&fragment_shard(key)->lock);
+}
+
+// Malloc'ed copy of a live entry and its length, NULL when there is none
+static char *fragment_get(uint64_t key, const char *file_path, size_t *len) {
+    FragmentEntry *e = fragment_acquire(key, file_path);
+    char *copy = NULL;
+    if (e) {
+        copy = malloc(e->len + 1);
+        if (copy) memcpy(copy, e->html, e->len + 1);
+        *len = e->len;
+    }
+    fragment_release(key);
+    return copy;
+}
+
+char *process_html_cached(const char *file_path, TemplateParam* params, int param_count, int ttl_seconds) {
+    const Template *tpl = template_load(file_path);
+    if (!tpl) {
+        return strdup("");
+    }
+
+    uint64_t key;
+    if (!fragment_key(tpl, params, param_count, &key)) {
+        return process_html(file_path, params, param_count);
+    }
+
+    size_t cached_len;
+    char *cached = fragment_get(key, file_path, &cached_len);
+    if (cached) return cached;
+
+    TemplateOutput out;
+    template_output_init(&out);
+    char *html = template_render(tpl, params, param_count, &out) ? template_output_join(&out) : NULL;
+    size_t len = out.total_len;
+    template_output_free(&out);
+
+    if (!html) {
+        return strdup("");
+    }
+
+    fragment_store(key, file_path, html, len, ttl_seconds);
+    return html;
+}
+
+// The key of an {% include ... with item %} whose partial reads nothing
+// but the item's fields: its path and the fields in the order it reads
+// them. False for any other partial.
+static bool include_key(const Template *partial, const TemplateScope *with, uint64_t *key) {
+    Hash64State state;
+    hash64_init(&state, 1);     // apart from the process_html_cached keys
+    hash64_update(&state, partial->path, strlen(partial->path) + 1);
+    hash64_update(&state, &partial, sizeof(partial));  // a reloaded partial misses
+
+    TemplateOutput tmp;
+    template_output_init(&tmp);
+    bool ok = true;
+
+    for (int s = 0; ok && s < partial->segment_count; s++) {
+        const TemplateSegment *seg = &partial->segments[s];
+        if (seg->type == SEGMENT_FOR || seg->type == SEGMENT_INCLUDE) {
+            ok = false;
+        } else if (seg->type == SEGMENT_PARAM || seg->type == SEGMENT_IF) {
+            int field = memchr(seg->key, '.', seg->key_len) ? -1 : find_field(with->list, seg->key, seg->key_len);
+            ok = field >= 0 && template_output_field(&tmp, with->list, with->item, field, ESCAPE_RAW);
+            if (ok && seg->type == SEGMENT_IF) {
+                bool truthy = template_field_truthy(with->list, with->item, field);
+                hash64_update(&state, &truthy, sizeof(truthy));
+            }
+            hash_output(&state, &tmp);
+        }
+    }
+
+    template_output_free(&tmp);
+    *key = hash64_digest(&state);
+    return ok;
+}
+
+// {% include ... with item cached %}: partials that read only the item's
+// fields render the same bytes for the same values, so a hit is copied
+// out of the fragment cache instead of rendered again. Worth it when the
+// partial costs more than formatting its fields for the key.
+static bool render_include_cached(RenderContext *ctx, const Template *partial, const TemplateScope *with) {
+    uint64_t key;
+    if (FRAGMENT_CACHE_BYTES <= 0 || !include_key(partial, with, &key)) {
+        return render_range(ctx, partial, 0, partial->segment_count);
+    }
+
+    FragmentEntry *e = fragment_acquire(key, partial->path);
+    if (e) {
+        bool ok = template_output_copy(ctx->out, e->html, e->len);
+        fragment_release(key);
+        return ok;
+    }
+    fragment_release(key);
+
+    TemplateOutput *out = ctx->out;
+    TemplateOutput tmp;
+    template_output_init(&tmp);
+    ctx->out = &tmp;
+    bool ok = render_range(ctx, partial, 0, partial->segment_count);
+    ctx->out = out;
+    char *html = ok ? template_output_join(&tmp) : NULL;
+    size_t len = tmp.total_len;
+    template_output_free(&tmp);
+    if (!html) return false;
+    fragment_store(key, partial->path, html, len, 0);
+
+    if (!output_own(ctx->out, html)) {
+        free(html);
+        return false;
+    }
+    return template_output_append(ctx->out, html, len);
+}
+
+void template_fragment_cache_clear(void) {
+    for (int i = 0; i < FRAGMENT_CACHE_SHARDS; i++) {
+        FragmentShard *shard = fragment_shard(i);
+        pthread_mutex_lock(&shard->lock);
+        while (shard->lru_tail) {
+            fragment_remove(shard, shard->lru_tail);
+        }
+        pthread_mutex_unlock(&shard->lock);
+    }
+}
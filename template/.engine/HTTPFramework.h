@@ -7,6 +7,8 @@
 typedef struct {
 	const char *path;
 	void (*handler)(HTTPRequest *request, Database *db);
+	int cache_ttl;	// seconds anonymous GET responses are served from the response cache, 0 = off
+	int cache_stale;	// seconds an expired response is still served while one request refreshes it
 }Route;
 
 extern Route routes[];
@@ -0,0 +1,24 @@
+#ifndef HASH_H
+#define HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// XXH64, fast non-cryptographic hash used for cache keys and ETags
+
+typedef struct {
+    uint64_t total_len;
+    uint64_t v[4];
+    uint8_t buffer[32];
+    size_t buffered;
+    uint64_t seed;
+} Hash64State;
+
+uint64_t hash64(const void *data, size_t len, uint64_t seed);
+
+// Streaming variant, same result as hash64 over the concatenated input
+void hash64_init(Hash64State *state, uint64_t seed);
+void hash64_update(Hash64State *state, const void *data, size_t len);
+uint64_t hash64_digest(const Hash64State *state);
+
+#endif
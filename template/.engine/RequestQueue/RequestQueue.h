@@ -0,0 +1,47 @@
+#ifndef REQUEST_QUEUE_H
+#define REQUEST_QUEUE_H
+
+#include "HTTPServer.h"
+#include <pthread.h>
+#include <stdbool.h>
+
+// FIFO of accepted requests between the acceptor and the worker threads
+
+typedef struct RequestNode {
+    HTTPRequest request;
+    struct RequestNode *next;
+} RequestNode;
+
+typedef struct {
+    RequestNode *front;
+    RequestNode *rear;
+    size_t depth; // Requests waiting
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    bool stop; // Signal to stop the threads
+    int running; // Threads that have not exited yet
+} RequestQueue;
+
+// Initialize the request queue
+void init_queue(RequestQueue *q);
+
+// Add a request to the queue, it is copied
+void enqueue(RequestQueue *q, HTTPRequest *request);
+
+// Remove a request from the queue, waiting for one. False once the queue
+// is stopped and empty.
+bool dequeue(RequestQueue *q, HTTPRequest *request);
+
+// Requests waiting and when the oldest of them was received (its
+// received_ns, 0 when none)
+void queue_stats(RequestQueue *q, size_t *depth, int64_t *oldest_received_ns);
+
+// Lets the threads finish every queued request, then waits for them to
+// exit (running drops to 0) for up to timeout_seconds. False if some are
+// still busy by then.
+bool drain_queue(RequestQueue *q, int timeout_seconds);
+
+// Destroy the request queue, once its threads are gone
+void destroy_queue(RequestQueue *q);
+
+#endif
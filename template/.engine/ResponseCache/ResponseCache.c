@@ -0,0 +1,431 @@
+#include "ResponseCache.h"
+#include "Hash.h"
+#include "Compression.h"
+#include "config.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <sys/socket.h>
+
+// Entries are spread over shards by key hash, each with its own rwlock,
+// so concurrent hits only share a read lock with the requests that land
+// on the same shard. Every shard holds RESPONSE_CACHE_BYTES / SHARDS.
+#define RESPONSE_CACHE_SHARDS 16
+#define RESPONSE_CACHE_BUCKETS 256
+#define RESPONSE_CACHE_KEY_MAX 2048
+// Send timeout of a parked connection. Waiters are written one after
+// another by the leader's worker: a client that does not take its
+// response within this is dropped instead of holding the others.
+#define RESPONSE_CACHE_WAITER_SEND_MS 1000
+// Send timeout of a hit written by a thread that must not block, in case
+// the socket buffer takes less than send_room promised
+#define RESPONSE_CACHE_NONBLOCKING_SEND_MS 10
+
+typedef struct CachedResponse {
+    uint64_t hash;
+    char *key;
+    size_t key_len;
+    char *data;
+    size_t len;
+    size_t cost;
+    int64_t expires_ms;
+    int64_t stale_until_ms;     // served stale until then while a refresh runs
+    char etag[HTTP_ETAG_SIZE + 2];  // from the stored ETag header (W/ when encoded), "" if none
+    int refs;               // one for the shard, one per write in progress
+    struct CachedResponse *bucket_next;
+    struct CachedResponse *older;
+    struct CachedResponse *newer;
+} CachedResponse;
+
+// A parked client connection
+typedef struct {
+    int socket;
+    struct ssl_st *tls;
+} Waiter;
+
+// A request being handled by a worker, with the connections of the
+// identical requests waiting for its response
+typedef struct Flight {
+    uint64_t hash;
+    char *key;
+    size_t key_len;
+    const HTTPRequest *leader;
+    Waiter *waiters;
+    int waiter_count;
+    int waiter_capacity;
+    struct Flight *next;
+} Flight;
+
+typedef struct {
+    pthread_rwlock_t lock;
+    CachedResponse *buckets[RESPONSE_CACHE_BUCKETS];
+    CachedResponse *oldest;     // insertion order, evicted first
+    CachedResponse *newest;
+    size_t bytes;
+    Flight *flights;
+} CacheShard;
+
+static CacheShard shards[RESPONSE_CACHE_SHARDS];
+static pthread_once_t shards_once = PTHREAD_ONCE_INIT;
+
+static void init_shards(void) {
+    for (int i = 0; i < RESPONSE_CACHE_SHARDS; i++) {
+        pthread_rwlock_init(&shards[i].lock, NULL);
+    }
+}
+
+static CacheShard *shard_for(uint64_t hash) {
+    pthread_once(&shards_once, init_shards);
+    return &shards[hash % RESPONSE_CACHE_SHARDS];
+}
+
+static size_t shard_limit(void) {
+    return RESPONSE_CACHE_BYTES > 0 ? (size_t)RESPONSE_CACHE_BYTES / RESPONSE_CACHE_SHARDS : 0;
+}
+
+static int64_t monotonic_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static bool append_key(char *key, size_t *len, const char *part) {
+    size_t part_len = strlen(part);
+    if (*len + part_len + 1 >= RESPONSE_CACHE_KEY_MAX) return false;
+    memcpy(key + *len, part, part_len);
+    *len += part_len;
+    key[*len] = '\n';
+    (*len)++;
+    return true;
+}
+
+// "GET\n/path\nquery\nvary-value\n..." into a RESPONSE_CACHE_KEY_MAX buffer
+static bool request_key(const HTTPRequest *request, char *key, size_t *len) {
+    HTTPRequest *req = (HTTPRequest *)request;
+    if (strcmp(request->method, "GET") != 0 || !request->path) return false;
+    if (HTTPRequest_get_header(req, "Cookie") || HTTPRequest_get_header(req, "Authorization")) return false;
+
+    *len = 0;
+    if (!append_key(key, len, request->method)) return false;
+    if (!append_key(key, len, request->path)) return false;
+    if (!append_key(key, len, request->query ? request->query : "")) return false;
+    for (int i = 0; i < NUM_RESPONSE_CACHE_VARY; i++) {
+        const char *value = HTTPRequest_get_header(req, RESPONSE_CACHE_VARY[i]);
+        if (!append_key(key, len, value ? value : "")) return false;
+    }
+
+    // Bodies are stored encoded, keyed by the coding the client gets rather
+    // than the raw Accept-Encoding so browsers share a handful of entries
+    const char *encoding = Compression_name(Compression_negotiate(HTTPRequest_get_header(req, "Accept-Encoding")));
+    if (!append_key(key, len, encoding ? encoding : "identity")) return false;
+    return true;
+}
+
+bool ResponseCache_cacheable(const HTTPRequest *request) {
+    char key[RESPONSE_CACHE_KEY_MAX];
+    size_t len;
+    return request_key(request, key, &len);
+}
+
+static CachedResponse *find_entry(CacheShard *shard, uint64_t hash, const char *key, size_t key_len) {
+    CachedResponse *e = shard->buckets[(hash / RESPONSE_CACHE_SHARDS) % RESPONSE_CACHE_BUCKETS];
+    for (; e; e = e->bucket_next) {
+        if (e->hash == hash && e->key_len == key_len && memcmp(e->key, key, key_len) == 0) return e;
+    }
+    return NULL;
+}
+
+static Flight *find_flight(CacheShard *shard, uint64_t hash, const char *key, size_t key_len) {
+    for (Flight *f = shard->flights; f; f = f->next) {
+        if (f->hash == hash && f->key_len == key_len && memcmp(f->key, key, key_len) == 0) return f;
+    }
+    return NULL;
+}
+
+static void release_entry(CachedResponse *e) {
+    if (__atomic_sub_fetch(&e->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        free(e->key);
+        free(e->data);
+        free(e);
+    }
+}
+
+// Caller holds the shard's write lock
+static void remove_entry(CacheShard *shard, CachedResponse *e) {
+    CachedResponse **link = &shard->buckets[(e->hash / RESPONSE_CACHE_SHARDS) % RESPONSE_CACHE_BUCKETS];
+    while (*link != e) link = &(*link)->bucket_next;
+    *link = e->bucket_next;
+
+    if (e->older) e->older->newer = e->newer;
+    else shard->oldest = e->newer;
+    if (e->newer) e->newer->older = e->older;
+    else shard->newest = e->older;
+
+    shard->bytes -= e->cost;
+    release_entry(e);
+}
+
+static bool write_bytes(int fd, struct ssl_st *tls, const char *data, size_t len) {
+    struct iovec iov = { (void *)data, len };
+    return HTTPServer_write(fd, tls, &iov, 1);
+}
+
+// Bytes a fresh socket takes without its client reading any. getsockopt
+// reports twice the buffer size set, the other half being kept for the
+// kernel's bookkeeping.
+static size_t send_room(int fd) {
+    int size = 0;
+    socklen_t len = sizeof(size);
+    if (getsockopt(fd, SOL_SOCKET, SO_SNDBUF, &size, &len) != 0 || size <= 0) return 0;
+    return (size_t)size / 2;
+}
+
+bool ResponseCache_serve(HTTPRequest *request, bool may_block) {
+    char key[RESPONSE_CACHE_KEY_MAX];
+    size_t key_len;
+    if (!request_key(request, key, &key_len)) return false;
+
+    uint64_t hash = hash64(key, key_len, 0);
+    CacheShard *shard = shard_for(hash);
+
+    pthread_rwlock_rdlock(&shard->lock);
+    CachedResponse *e = find_entry(shard, hash, key, key_len);
+    if (e && e->expires_ms <= monotonic_ms()) {
+        // Stale copies only go out while someone else refreshes them
+        bool refreshing = find_flight(shard, hash, key, key_len) != NULL;
+        if (!refreshing || e->stale_until_ms <= monotonic_ms()) e = NULL;
+    }
+    if (e) __atomic_add_fetch(&e->refs, 1, __ATOMIC_RELAXED);
+    pthread_rwlock_unlock(&shard->lock);
+
+    if (!e) return false;
+
+    // The entry can be evicted meanwhile, our reference keeps the bytes alive
+    if (e->etag[0] && HTTPRequest_etag_matches(request, e->etag)) {
+        char not_modified[128];
+        int len = snprintf(not_modified, sizeof(not_modified),
+                           "HTTP/1.1 304 Not Modified\r\nETag: %s\r\nConnection: close\r\n\r\n", e->etag);
+        write_bytes(request->client_socket, request->tls, not_modified, len);
+        request->status_code = 304;
+        request->response_bytes = len;
+    } else {
+        // A client that does not read would hold the thread: left to one that may wait
+        if (!may_block) {
+            if (e->len > send_room(request->client_socket)) {
+                release_entry(e);
+                return false;
+            }
+            struct timeval timeout = { 0, RESPONSE_CACHE_NONBLOCKING_SEND_MS * 1000 };
+            setsockopt(request->client_socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+        }
+        if (!write_bytes(request->client_socket, request->tls, e->data, e->len)) {
+            perror("Failed to write cached response");
+        }
+        // Only 200 responses are stored
+        request->status_code = 200;
+        request->response_bytes = e->len;
+    }
+    HTTPServer_close(request->client_socket, request->tls);
+    release_entry(e);
+    return true;
+}
+
+static const char *find_bytes(const char *data, size_t len, const char *needle, size_t needle_len) {
+    for (size_t i = 0; i + needle_len <= len; i++) {
+        if (data[i] == needle[0] && memcmp(data + i, needle, needle_len) == 0) return data + i;
+    }
+    return NULL;
+}
+
+// Copies the ETag header value out of a stored response's header block
+static void find_etag(const char *data, size_t len, char *etag) {
+    etag[0] = '\0';
+    const char *headers_end = find_bytes(data, len, "\r\n\r\n", 4);
+    if (!headers_end) return;
+
+    const char *header = find_bytes(data, headers_end - data, "\r\nETag: ", 8);
+    if (!header) return;
+    header += 8;
+    const char *end = find_bytes(header, headers_end + 2 - header, "\r\n", 2);
+    if (end && end - header < HTTP_ETAG_SIZE + 2) {
+        memcpy(etag, header, end - header);
+        etag[end - header] = '\0';
+    }
+}
+
+void ResponseCache_store(const HTTPRequest *request, int ttl_seconds, int stale_seconds,
+                         const struct iovec *iov, int iov_count) {
+    char key[RESPONSE_CACHE_KEY_MAX];
+    size_t key_len;
+    if (ttl_seconds <= 0 || !request_key(request, key, &key_len)) return;
+
+    size_t len = 0;
+    for (int i = 0; i < iov_count; i++) {
+        len += iov[i].iov_len;
+    }
+    size_t cost = sizeof(CachedResponse) + key_len + len;
+    if (cost > shard_limit()) return;
+
+    CachedResponse *e = calloc(1, sizeof(CachedResponse));
+    if (!e) return;
+    e->key = malloc(key_len);
+    e->data = malloc(len);
+    if (!e->key || !e->data) {
+        free(e->key);
+        free(e->data);
+        free(e);
+        return;
+    }
+
+    memcpy(e->key, key, key_len);
+    char *dst = e->data;
+    for (int i = 0; i < iov_count; i++) {
+        memcpy(dst, iov[i].iov_base, iov[i].iov_len);
+        dst += iov[i].iov_len;
+    }
+    find_etag(e->data, len, e->etag);
+    e->hash = hash64(key, key_len, 0);
+    e->key_len = key_len;
+    e->len = len;
+    e->cost = cost;
+    e->refs = 1;
+
+    int64_t now = monotonic_ms();
+    e->expires_ms = now + (int64_t)ttl_seconds * 1000;
+    e->stale_until_ms = e->expires_ms + (stale_seconds > 0 ? (int64_t)stale_seconds * 1000 : 0);
+
+    CacheShard *shard = shard_for(e->hash);
+    pthread_rwlock_wrlock(&shard->lock);
+
+    CachedResponse *existing = find_entry(shard, e->hash, key, key_len);
+    if (existing) remove_entry(shard, existing);
+
+    CachedResponse **bucket = &shard->buckets[(e->hash / RESPONSE_CACHE_SHARDS) % RESPONSE_CACHE_BUCKETS];
+    e->bucket_next = *bucket;
+    *bucket = e;
+    e->older = shard->newest;
+    if (shard->newest) shard->newest->newer = e;
+    else shard->oldest = e;
+    shard->newest = e;
+    shard->bytes += cost;
+
+    // Make room, dropping dead entries at the old end on the way
+    while (shard->oldest && (shard->bytes > shard_limit() || shard->oldest->stale_until_ms <= now)) {
+        remove_entry(shard, shard->oldest);
+    }
+    pthread_rwlock_unlock(&shard->lock);
+}
+
+bool ResponseCache_join(const HTTPRequest *request) {
+    char key[RESPONSE_CACHE_KEY_MAX];
+    size_t key_len;
+    if (!request_key(request, key, &key_len)) return false;
+
+    uint64_t hash = hash64(key, key_len, 0);
+    CacheShard *shard = shard_for(hash);
+    bool parked = false;
+
+    pthread_rwlock_wrlock(&shard->lock);
+    Flight *f = find_flight(shard, hash, key, key_len);
+    if (f) {
+        if (f->waiter_count == f->waiter_capacity) {
+            int new_capacity = f->waiter_capacity ? f->waiter_capacity * 2 : 8;
+            Waiter *tmp = realloc(f->waiters, new_capacity * sizeof(Waiter));
+            if (tmp) {
+                f->waiters = tmp;
+                f->waiter_capacity = new_capacity;
+            }
+        }
+        // Without room the request simply runs on its own
+        if (f->waiter_count < f->waiter_capacity) {
+            struct timeval timeout = { RESPONSE_CACHE_WAITER_SEND_MS / 1000, RESPONSE_CACHE_WAITER_SEND_MS % 1000 * 1000 };
+            setsockopt(request->client_socket, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+            f->waiters[f->waiter_count++] = (Waiter){ request->client_socket, request->tls };
+            parked = true;
+        }
+    } else {
+        f = calloc(1, sizeof(Flight));
+        if (f) f->key = malloc(key_len);
+        if (f && f->key) {
+            memcpy(f->key, key, key_len);
+            f->hash = hash;
+            f->key_len = key_len;
+            f->leader = request;
+            f->next = shard->flights;
+            shard->flights = f;
+        } else if (f) {
+            free(f);
+        }
+    }
+    pthread_rwlock_unlock(&shard->lock);
+    return parked;
+}
+
+// Unlinks the flight led by this request, NULL if it already ended
+static Flight *take_flight(const HTTPRequest *leader) {
+    char key[RESPONSE_CACHE_KEY_MAX];
+    size_t key_len;
+    if (!request_key(leader, key, &key_len)) return NULL;
+
+    uint64_t hash = hash64(key, key_len, 0);
+    CacheShard *shard = shard_for(hash);
+
+    pthread_rwlock_wrlock(&shard->lock);
+    Flight **link = &shard->flights;
+    while (*link && !((*link)->leader == leader && (*link)->hash == hash &&
+                      (*link)->key_len == key_len && memcmp((*link)->key, key, key_len) == 0)) {
+        link = &(*link)->next;
+    }
+    Flight *f = *link;
+    if (f) *link = f->next;
+    pthread_rwlock_unlock(&shard->lock);
+    return f;
+}
+
+static void free_flight(Flight *f) {
+    free(f->waiters);
+    free(f->key);
+    free(f);
+}
+
+void ResponseCache_complete(const HTTPRequest *leader, const struct iovec *iov, int iov_count) {
+    Flight *f = take_flight(leader);
+    if (!f) return;
+
+    for (int i = 0; i < f->waiter_count; i++) {
+        HTTPServer_write(f->waiters[i].socket, f->waiters[i].tls, iov, iov_count);
+        HTTPServer_close(f->waiters[i].socket, f->waiters[i].tls);
+    }
+    free_flight(f);
+}
+
+void ResponseCache_abandon(const HTTPRequest *leader) {
+    Flight *f = take_flight(leader);
+    if (!f) return;
+
+    static const char unavailable[] =
+        "HTTP/1.1 503 Service Unavailable\r\n"
+        "Content-Type: text/html\r\n"
+        "Content-Length: 0\r\n"
+        "Connection: close\r\n"
+        "\r\n";
+    for (int i = 0; i < f->waiter_count; i++) {
+        write_bytes(f->waiters[i].socket, f->waiters[i].tls, unavailable, sizeof(unavailable) - 1);
+        HTTPServer_close(f->waiters[i].socket, f->waiters[i].tls);
+    }
+    free_flight(f);
+}
+
+void ResponseCache_clear(void) {
+    for (int i = 0; i < RESPONSE_CACHE_SHARDS; i++) {
+        CacheShard *shard = shard_for(i);
+        pthread_rwlock_wrlock(&shard->lock);
+        while (shard->oldest) {
+            remove_entry(shard, shard->oldest);
+        }
+        pthread_rwlock_unlock(&shard->lock);
+    }
+}
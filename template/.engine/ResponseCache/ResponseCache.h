@@ -0,0 +1,43 @@
+#ifndef RESPONSE_CACHE_H
+#define RESPONSE_CACHE_H
+
+#include "HTTPServer.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Micro-cache of whole responses for anonymous GET routes with a
+// cache_ttl. A response is stored as the exact bytes that went to the
+// socket, so a hit is served by the acceptor thread with one write when
+// it fits in the socket buffer, by a worker otherwise.
+// The key is the method, path, query, the RESPONSE_CACHE_VARY headers and
+// the negotiated content coding.
+
+// GET without Cookie/Authorization, and a key that fits
+bool ResponseCache_cacheable(const HTTPRequest *request);
+
+// Writes a fresh cached response and closes the socket, false on a miss.
+// An expired entry still inside its stale window is served too while
+// another request is refreshing it. A request whose If-None-Match names
+// the stored ETag gets a 304 instead of the body. Unless may_block (the
+// accepting thread), a response the socket buffer cannot take at once is
+// a miss, for a worker to serve.
+bool ResponseCache_serve(HTTPRequest *request, bool may_block);
+
+// Kept for ttl_seconds, then served stale for stale_seconds more during a refresh
+void ResponseCache_store(const HTTPRequest *request, int ttl_seconds, int stale_seconds,
+                         const struct iovec *iov, int iov_count);
+
+// Single-flight: the first request for a key becomes the leader and runs
+// the handler. Identical requests arriving meanwhile are parked (true is
+// returned and the flight now owns their connection) until the leader's
+// response is written to them by ResponseCache_complete, once the leader's
+// own client has it. Parked connections get a short send timeout.
+bool ResponseCache_join(const HTTPRequest *request);
+void ResponseCache_complete(const HTTPRequest *leader, const struct iovec *iov, int iov_count);
+
+// Ends the leader's flight if the handler sent no response, waiters get a 503
+void ResponseCache_abandon(const HTTPRequest *leader);
+
+void ResponseCache_clear(void);
+
+#endif
@@ -0,0 +1,290 @@
+#define _GNU_SOURCE
+#include "Supervisor.h"
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+
+// Upper bound on worker processes, and on NUMA nodes probed
+#define SUPERVISOR_MAX_PROCESSES 256
+
+// A worker that dies sooner than this after starting is restarted with a
+// delay, so a crash on startup does not turn into a fork loop
+#define SUPERVISOR_CRASH_LOOP_SECONDS 1
+
+// Workers get DRAIN_TIMEOUT_SECONDS to finish on a stop, then this much
+// longer before they are killed
+#define SUPERVISOR_KILL_GRACE_SECONDS 2
+
+// Set across a SIGHUP re-exec: the listen sockets, and the workers of the
+// previous image, which the new one drains once its own are running
+#define SUPERVISOR_LISTEN_FDS_ENV "SUPERVISOR_LISTEN_FDS"
+#define SUPERVISOR_DRAIN_PIDS_ENV "SUPERVISOR_DRAIN_PIDS"
+
+// Resolved at startup: after a deploy replaces the file, /proc/self/exe
+// names the deleted old binary instead of the new one
+static char executable[PATH_MAX];
+
+// Workers of the previous image, still finishing their requests
+static pid_t previous[SUPERVISOR_MAX_PROCESSES];
+static int previous_count = 0;
+
+bool Supervisor_parse_cpulist(const char *list, cpu_set_t *set) {
+    CPU_ZERO(set);
+    const char *p = list;
+    while (*p && *p != '\n') {
+        char *end;
+        long first = strtol(p, &end, 10);
+        if (end == p || first < 0) return false;
+        long last = first;
+        if (*end == '-') {
+            p = end + 1;
+            last = strtol(p, &end, 10);
+            if (end == p || last < first) return false;
+        }
+        for (long cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) {
+            CPU_SET(cpu, set);
+        }
+        p = end;
+        if (*p == ',') p++;
+    }
+    return CPU_COUNT(set) > 0;
+}
+
+// CPUs of each NUMA node that this process may use, empty nodes skipped
+static int numa_nodes(const cpu_set_t *allowed, cpu_set_t *nodes, int max_nodes) {
+    int count = 0;
+    for (int node = 0; node < SUPERVISOR_MAX_PROCESSES && count < max_nodes; node++) {
+        char path[128], list[4096];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        FILE *f = fopen(path, "r");
+        if (!f) break;
+        bool read = fgets(list, sizeof(list), f) != NULL;
+        fclose(f);
+
+        cpu_set_t cpus;
+        if (!read || !Supervisor_parse_cpulist(list, &cpus)) continue;
+        CPU_AND(&nodes[count], &cpus, allowed);
+        if (CPU_COUNT(&nodes[count]) > 0) count++;
+    }
+    return count;
+}
+
+int Supervisor_plan(const char *pin, int processes, cpu_set_t *sets, int max_sets, bool *pinned) {
+    *pinned = false;
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        // Without the affinity mask, no pinning and one process per online CPU
+        long online = sysconf(_SC_NPROCESSORS_ONLN);
+        return processes > 0 ? processes : (online > 0 ? (int)online : 1);
+    }
+
+    int groups = 0;
+    cpu_set_t group_cpus[SUPERVISOR_MAX_PROCESSES];
+    if (pin && strcmp(pin, "numa") == 0) {
+        groups = numa_nodes(&allowed, group_cpus, SUPERVISOR_MAX_PROCESSES);
+    }
+    if (groups == 0) {
+        // "core", or "numa" on a machine that does not expose nodes
+        for (int cpu = 0; cpu < CPU_SETSIZE && groups < SUPERVISOR_MAX_PROCESSES; cpu++) {
+            if (!CPU_ISSET(cpu, &allowed)) continue;
+            CPU_ZERO(&group_cpus[groups]);
+            CPU_SET(cpu, &group_cpus[groups]);
+            groups++;
+        }
+    }
+
+    if (processes <= 0) processes = groups;
+    if (processes > max_sets) processes = max_sets;
+
+    // A single process keeps every CPU for its threads
+    if (!pin || !*pin || processes <= 1) return processes;
+
+    for (int i = 0; i < processes; i++) {
+        sets[i] = group_cpus[i % groups];
+    }
+    *pinned = true;
+    return processes;
+}
+
+static pid_t spawn_worker(HTTPServer *server, int index, const cpu_set_t *cpus, WorkerMain worker_main) {
+    pid_t supervisor = getpid();
+    pid_t pid = fork();
+    if (pid < 0) perror("fork");
+    if (pid != 0) return pid;
+
+    // Child: the supervisor waits for its signals, the worker handles its own
+    sigset_t none;
+    sigemptyset(&none);
+    sigprocmask(SIG_SETMASK, &none, NULL);
+    // Stop with the supervisor, even if it was killed without a chance to ask
+    prctl(PR_SET_PDEATHSIG, SIGTERM);
+    if (getppid() != supervisor) _exit(0);
+
+    if (cpus && sched_setaffinity(0, sizeof(*cpus), cpus) != 0) {
+        perror("sched_setaffinity");
+    }
+    exit(worker_main(server, index));
+}
+
+HTTPServer *Supervisor_inherited(void) {
+    const char *fds = getenv(SUPERVISOR_LISTEN_FDS_ENV);
+    if (!fds) return NULL;
+
+    int server_fd = -1;
+    int unix_fd = -1;
+    bool parsed = sscanf(fds, "%d,%d", &server_fd, &unix_fd) == 2;
+    unsetenv(SUPERVISOR_LISTEN_FDS_ENV);
+    return parsed ? HTTPServer_adopt(server_fd, unix_fd) : NULL;
+}
+
+// Takes the previous image's workers out of the environment, so the new
+// workers do not inherit the list
+static void load_previous_workers(void) {
+    const char *list = getenv(SUPERVISOR_DRAIN_PIDS_ENV);
+    if (!list) return;
+
+    const char *p = list;
+    while (*p && previous_count < SUPERVISOR_MAX_PROCESSES) {
+        char *end;
+        long pid = strtol(p, &end, 10);
+        if (end == p) break;
+        if (pid > 0) previous[previous_count++] = (pid_t)pid;
+        p = (*end == ',') ? end + 1 : end;
+    }
+    unsetenv(SUPERVISOR_DRAIN_PIDS_ENV);
+}
+
+// Replaces the supervisor with a fresh image of the binary, keeping its pid
+// and its children. The listen sockets stay open across exec, so clients
+// keep queueing on them, and the running workers keep serving until the
+// new image has started its own. Returns only if exec failed.
+static void reexec(HTTPServer *server, const pid_t *pids, int processes) {
+    char fds[32];
+    snprintf(fds, sizeof(fds), "%d,%d", server->server_fd, server->unix_fd);
+
+    char drain[SUPERVISOR_MAX_PROCESSES * 2 * 12];
+    size_t used = 0;
+    drain[0] = '\0';
+    for (int i = 0; i < processes + previous_count; i++) {
+        pid_t pid = i < processes ? pids[i] : previous[i - processes];
+        if (pid <= 0 || used >= sizeof(drain)) continue;
+        used += snprintf(drain + used, sizeof(drain) - used, "%s%d", used ? "," : "", (int)pid);
+    }
+
+    setenv(SUPERVISOR_LISTEN_FDS_ENV, fds, 1);
+    setenv(SUPERVISOR_DRAIN_PIDS_ENV, drain, 1);
+    printf("Supervisor re-executing %s\n", executable);
+
+    char *argv[] = {executable, NULL};
+    execv(executable, argv);
+
+    perror("Re-exec failed, keeping the running workers");
+    unsetenv(SUPERVISOR_LISTEN_FDS_ENV);
+    unsetenv(SUPERVISOR_DRAIN_PIDS_ENV);
+}
+
+// Reaps every worker that exited and restarts the ones that belong to a slot
+static void restart_dead(HTTPServer *server, pid_t *pids, time_t *started, int processes,
+                         const cpu_set_t *sets, WorkerMain worker_main) {
+    int status;
+    pid_t pid;
+    while ((pid = waitpid(-1, &status, WNOHANG)) > 0) {
+        int slot = -1;
+        for (int i = 0; i < processes; i++) {
+            if (pids[i] == pid) slot = i;
+        }
+        if (slot < 0) {
+            printf("Previous worker (pid %d) finished draining\n", (int)pid);
+            continue;
+        }
+
+        printf("Worker %d (pid %d) died with status %d. Restarting it...\n", slot, (int)pid, status);
+        if (time(NULL) - started[slot] < SUPERVISOR_CRASH_LOOP_SECONDS) {
+            sleep(SUPERVISOR_CRASH_LOOP_SECONDS);
+        }
+        pids[slot] = spawn_worker(server, slot, sets ? &sets[slot] : NULL, worker_main);
+        started[slot] = time(NULL);
+    }
+}
+
+// Waits for every child up to timeout_seconds, then kills the rest
+static void reap_workers(const pid_t *pids, int processes, int timeout_seconds) {
+    time_t deadline = time(NULL) + timeout_seconds;
+    while (time(NULL) < deadline) {
+        pid_t pid = waitpid(-1, NULL, WNOHANG);
+        if (pid < 0 && errno == ECHILD) return;
+        if (pid == 0) usleep(50 * 1000);
+    }
+
+    fprintf(stderr, "Workers still running after %d s, killing them\n", timeout_seconds);
+    for (int i = 0; i < processes + previous_count; i++) {
+        pid_t pid = i < processes ? pids[i] : previous[i - processes];
+        if (pid > 0) kill(pid, SIGKILL);
+    }
+    while (waitpid(-1, NULL, 0) > 0 || errno == EINTR) {
+    }
+}
+
+int Supervisor_run(HTTPServer *server, int processes, const char *pin, WorkerMain worker_main) {
+    static cpu_set_t sets[SUPERVISOR_MAX_PROCESSES];
+    bool pinned;
+    processes = Supervisor_plan(pin, processes, sets, SUPERVISOR_MAX_PROCESSES, &pinned);
+
+    pid_t pids[SUPERVISOR_MAX_PROCESSES];
+    time_t started[SUPERVISOR_MAX_PROCESSES];
+
+    ssize_t len = readlink("/proc/self/exe", executable, sizeof(executable) - 1);
+    executable[len > 0 ? len : 0] = '\0';
+    load_previous_workers();
+
+    // Handled synchronously with sigwaitinfo: nothing can arrive between a
+    // check and the wait, and the handlers are free to fork and exec
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGHUP);
+    sigaddset(&signals, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &signals, NULL);
+
+    printf("Supervisor starting %d worker process%s%s\n", processes, processes == 1 ? "" : "es",
+           pinned ? (strcmp(pin, "numa") == 0 ? ", one per NUMA node" : ", one per core") : "");
+    for (int i = 0; i < processes; i++) {
+        pids[i] = spawn_worker(server, i, pinned ? &sets[i] : NULL, worker_main);
+        started[i] = time(NULL);
+    }
+
+    // The new workers share the sockets now, the old ones can stop accepting
+    for (int i = 0; i < previous_count; i++) {
+        kill(previous[i], SIGTERM);
+    }
+
+    bool stopping = false;
+    while (!stopping) {
+        int sig = sigwaitinfo(&signals, NULL);
+        if (sig == SIGTERM || sig == SIGINT) {
+            stopping = true;
+        } else if (sig == SIGHUP) {
+            if (executable[0]) reexec(server, pids, processes);
+        } else if (sig == SIGCHLD) {
+            restart_dead(server, pids, started, processes, pinned ? sets : NULL, worker_main);
+        }
+    }
+
+    printf("Supervisor stopping workers...\n");
+    for (int i = 0; i < processes; i++) {
+        if (pids[i] > 0) kill(pids[i], SIGTERM);
+    }
+    // New clients are refused from here on instead of queueing for nobody
+    HTTPServer_destroy(server);
+    reap_workers(pids, processes, DRAIN_TIMEOUT_SECONDS + SUPERVISOR_KILL_GRACE_SECONDS);
+    return 0;
+}
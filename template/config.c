@@ -5,9 +5,66 @@
 
 // Server settings
 const char *TEMPLATE_DIR = "templates";
+const int TEMPLATE_RECHECK_SECONDS = 1;
 const int SERVER_PORT = 8080;
+char *UNIX_SOCKET_PATH = "";
 const int NUM_WORKERS = 4;
 
+// Worker processes
+int   PREFORK_PROCESSES = 1;
+char *PREFORK_PIN       = "core";
+int   DRAIN_TIMEOUT_SECONDS = 10;
+
+// Access log: 0 off, 1 errors, 2 every request, 3 with query and headers
+int   ACCESS_LOG_LEVEL  = 2;
+int   ACCESS_LOG_SAMPLE = 1;
+char *ACCESS_LOG_FILE   = "";
+
+// Prometheus metrics path, "" to disable
+char *METRICS_PATH = "";
+
+// Sampling CPU profiler path, "" to disable
+char *PROFILE_PATH = "";
+
+// Worker threads snapshot path, "" to disable
+char *WORKERS_PATH = "";
+
+// Per-request phase timing
+int SERVER_TIMING   = 0;
+int SLOW_REQUEST_MS = 0;
+
+// Traffic capture for bench/loadgen, "" to disable
+char *CAPTURE_FILE       = "";
+int   CAPTURE_SAMPLE     = 100;
+int   CAPTURE_BODY_BYTES = 4096;
+const char *CAPTURE_HEADERS[] = {
+    "Accept",
+    "Accept-Encoding",
+    "Accept-Language",
+    "Content-Type",
+    "If-None-Match",
+    "User-Agent",
+};
+const int NUM_CAPTURE_HEADERS = 6;
+
+// Rendered fragment cache
+const int FRAGMENT_CACHE_BYTES = 8 * 1024 * 1024;
+
+// Response cache
+const int RESPONSE_CACHE_BYTES = 32 * 1024 * 1024;
+const char *RESPONSE_CACHE_VARY[] = {
+    "Accept-Language",
+};
+const int NUM_RESPONSE_CACHE_VARY = 1;
+
+// Response compression
+const int COMPRESSION_LEVEL = 6;
+const int COMPRESSION_MIN_SIZE = 1024;
+
+// TLS certificate and key (PEM), leave empty to serve plain HTTP
+char *TLS_CERT_FILE = "";
+char *TLS_KEY_FILE  = "";
+
 // Model directories
 const char *MODEL_PATHS[] = {
     "models",
@@ -54,6 +111,64 @@ void load_config_from_env() {
     env_val = getenv("SQLITE_PATH");
     if (env_val && strlen(env_val) > 0) SQLITE_PATH = env_val;
 
+    // Load listener Env
+    env_val = getenv("UNIX_SOCKET_PATH");
+    if (env_val && strlen(env_val) > 0) UNIX_SOCKET_PATH = env_val;
+
+    // Load prefork Env
+    env_val = getenv("PREFORK_PROCESSES");
+    if (env_val && strlen(env_val) > 0) PREFORK_PROCESSES = atoi(env_val);
+
+    env_val = getenv("PREFORK_PIN");
+    if (env_val) PREFORK_PIN = env_val;
+
+    env_val = getenv("DRAIN_TIMEOUT_SECONDS");
+    if (env_val && strlen(env_val) > 0) DRAIN_TIMEOUT_SECONDS = atoi(env_val);
+
+    // Load access log Env
+    env_val = getenv("ACCESS_LOG_LEVEL");
+    if (env_val && strlen(env_val) > 0) ACCESS_LOG_LEVEL = atoi(env_val);
+
+    env_val = getenv("ACCESS_LOG_SAMPLE");
+    if (env_val && strlen(env_val) > 0) ACCESS_LOG_SAMPLE = atoi(env_val);
+
+    env_val = getenv("ACCESS_LOG_FILE");
+    if (env_val && strlen(env_val) > 0) ACCESS_LOG_FILE = env_val;
+
+    // Load metrics Env
+    env_val = getenv("METRICS_PATH");
+    if (env_val) METRICS_PATH = env_val;
+
+    env_val = getenv("PROFILE_PATH");
+    if (env_val) PROFILE_PATH = env_val;
+
+    env_val = getenv("WORKERS_PATH");
+    if (env_val) WORKERS_PATH = env_val;
+
+    // Load request timing Env
+    env_val = getenv("SERVER_TIMING");
+    if (env_val && strlen(env_val) > 0) SERVER_TIMING = atoi(env_val);
+
+    env_val = getenv("SLOW_REQUEST_MS");
+    if (env_val && strlen(env_val) > 0) SLOW_REQUEST_MS = atoi(env_val);
+
+    // Load capture Env
+    env_val = getenv("CAPTURE_FILE");
+    if (env_val) CAPTURE_FILE = env_val;
+
+    env_val = getenv("CAPTURE_SAMPLE");
+    if (env_val && strlen(env_val) > 0) CAPTURE_SAMPLE = atoi(env_val);
+
+    env_val = getenv("CAPTURE_BODY_BYTES");
+    if (env_val && strlen(env_val) > 0) CAPTURE_BODY_BYTES = atoi(env_val);
+
+    // Load TLS Env
+    env_val = getenv("TLS_CERT_FILE");
+    if (env_val && strlen(env_val) > 0) TLS_CERT_FILE = env_val;
+
+    env_val = getenv("TLS_KEY_FILE");
+    if (env_val && strlen(env_val) > 0) TLS_KEY_FILE = env_val;
+
     // Smart Logging based on active backend
     printf("--- Configuration Loaded ---\n");
     printf("Backend: %s\n", DB_BACKEND);
@@ -65,5 +180,8 @@ void load_config_from_env() {
     else if (strcmp(DB_BACKEND, "sqlite") == 0) {
         printf("SQLite: Path=%s\n", SQLITE_PATH);
     }
+    if (strlen(TLS_CERT_FILE) > 0) {
+        printf("TLS: Cert=%s, Key=%s\n", TLS_CERT_FILE, TLS_KEY_FILE);
+    }
     printf("---------------------------\n");
 }
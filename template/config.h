@@ -1,11 +1,88 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
-// Server settings
+// Server settings: SERVER_PORT <= 0 disables TCP, UNIX_SOCKET_PATH ("" for
+// none) is for a reverse proxy on the same host
 extern const int SERVER_PORT;
+extern char *UNIX_SOCKET_PATH;
 extern const char *TEMPLATE_DIR;
+// How often a cached template's file is checked for edits, in seconds
+// (0 parses each template once for the life of the process)
+extern const int TEMPLATE_RECHECK_SECONDS;
 extern const int NUM_WORKERS;
 
+// Prefork: worker processes sharing the listen sockets (0 = one per CPU, or
+// per NUMA node with "numa"; 1 = a single process) and how each is pinned:
+// "core", "numa" or "" for no pinning
+extern int PREFORK_PROCESSES;
+extern char *PREFORK_PIN;
+
+// On SIGTERM a worker stops accepting and finishes queued and in-flight
+// requests for up to this long before exiting
+extern int DRAIN_TIMEOUT_SECONDS;
+
+// Access log written by a background thread: level (0 off, 1 status >= 400,
+// 2 every request, 3 also query and headers), 1 in ACCESS_LOG_SAMPLE
+// successful requests logged, and the file to append to ("" for stdout)
+extern int ACCESS_LOG_LEVEL;
+extern int ACCESS_LOG_SAMPLE;
+extern char *ACCESS_LOG_FILE;
+
+// Path answering with Prometheus metrics of all worker processes, e.g.
+// "/metrics"; "" (the default) to disable. It is served on every listener,
+// the engine's own TLS port included, and shows route names, traffic and
+// DB reconnects: enable it behind a proxy that restricts it, or where only
+// the Unix socket is exposed.
+extern char *METRICS_PATH;
+
+// Path answering with a CPU profile of the worker process that serves it:
+// ?seconds=10&hz=99, folded stacks for flamegraph.pl. "" to disable; like
+// METRICS_PATH it is on the public listeners.
+extern char *PROFILE_PATH;
+
+// Path answering with what every worker thread of the process that serves
+// it is doing: state, request path and age, current SQL, plus the queue.
+// Answered by the accepting thread, so it works with every worker stuck
+// (not over TLS: those requests are read by a worker).
+// "" to disable; it shows paths and SQL, keep it off the public listeners.
+extern char *WORKERS_PATH;
+
+// SERVER_TIMING != 0 adds a Server-Timing header with the phases of the
+// request so far (not on responses stored in the response cache).
+// Requests slower than SLOW_REQUEST_MS (0 = off) are written to the access
+// log with every phase, whatever its level.
+extern int SERVER_TIMING;
+extern int SLOW_REQUEST_MS;
+
+// Traffic capture in the JSONL format of bench/loadgen: file to append to
+// ("" for off, one file per worker process with ".<index>" appended unless
+// PREFORK_PROCESSES is 1), 1 in CAPTURE_SAMPLE requests, body bytes kept,
+// and the request headers kept (all when empty). Credentials are always
+// scrubbed.
+extern char *CAPTURE_FILE;
+extern int CAPTURE_SAMPLE;
+extern int CAPTURE_BODY_BYTES;
+extern const char *CAPTURE_HEADERS[];
+extern const int NUM_CAPTURE_HEADERS;
+
+// Rendered fragment cache, total bytes kept: process_html_cached, and
+// {% include ... with item cached %} partials (0 for off)
+extern const int FRAGMENT_CACHE_BYTES;
+
+// Response cache for routes with a cache_ttl: total bytes kept and the
+// request headers that are part of the cache key
+extern const int RESPONSE_CACHE_BYTES;
+extern const char *RESPONSE_CACHE_VARY[];
+extern const int NUM_RESPONSE_CACHE_VARY;
+
+// Response compression: zlib level (1-9) and the smallest body worth compressing
+extern const int COMPRESSION_LEVEL;
+extern const int COMPRESSION_MIN_SIZE;
+
+// TLS on the listener: PEM certificate chain and key, plain HTTP while empty
+extern char *TLS_CERT_FILE;
+extern char *TLS_KEY_FILE;
+
 // Models
 extern const char *MODEL_PATHS[];
 extern const int NUM_MODEL_DIRS;
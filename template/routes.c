@@ -1,5 +1,6 @@
 #include<views.c>
 
 Route routes[] = {
-	{"/", home},
+	{"/", home, 0, 0},
+	{NULL, NULL, 0, 0}
 };
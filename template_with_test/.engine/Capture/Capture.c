@@ -0,0 +1,250 @@
+#include "Capture.h"
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+// Lines waiting for the writer, a power of two
+#define CAPTURE_RING_SIZE 256
+#define CAPTURE_FLUSH_MS 50
+
+// Credentials never written to a capture file, whatever CAPTURE_HEADERS says
+static const char *scrubbed_headers[] = {
+    "Authorization", "Proxy-Authorization", "Cookie", "X-Api-Key", "X-Auth-Token", "X-CSRF-Token",
+};
+
+// Any thread produces (the acceptor, or a worker that read the request),
+// the writer is the only consumer. A producer claims position head by
+// moving it forward, fills the slot, then publishes it by setting seq to
+// position + 1; the writer takes slots in order while they are published
+// and hands each back with seq = position + CAPTURE_RING_SIZE.
+typedef struct {
+    uint64_t seq;
+    char *line;
+} CaptureSlot;
+
+static CaptureSlot ring[CAPTURE_RING_SIZE];
+static uint64_t head __attribute__((aligned(64)));
+static uint64_t tail __attribute__((aligned(64)));
+static uint64_t dropped = 0;
+
+static int capture_sample = 0;
+static size_t capture_body_bytes = 0;
+static unsigned sample_counter = 0;
+static int64_t last_captured_ns = 0;
+static int capture_fd = -1;
+static bool running = false;
+static bool stop_requested = false;
+static pthread_t writer;
+
+static bool kept_header(const char *name) {
+    if (NUM_CAPTURE_HEADERS == 0) return true;
+    for (int i = 0; i < NUM_CAPTURE_HEADERS; i++) {
+        if (strcasecmp(name, CAPTURE_HEADERS[i]) == 0) return true;
+    }
+    return false;
+}
+
+static bool scrubbed_header(const char *name) {
+    for (size_t i = 0; i < sizeof(scrubbed_headers) / sizeof(scrubbed_headers[0]); i++) {
+        if (strcasecmp(name, scrubbed_headers[i]) == 0) return true;
+    }
+    return false;
+}
+
+// A JSON string body; bytes above 0x7F are copied as they are. Needs up to
+// 6 bytes per input byte.
+static size_t append_escaped(char *out, const char *s, size_t n) {
+    size_t len = 0;
+    for (size_t i = 0; i < n; i++) {
+        unsigned char c = s[i];
+        if (c == '"' || c == '\\') {
+            out[len++] = '\\';
+            out[len++] = c;
+        } else if (c == '\n') {
+            out[len++] = '\\';
+            out[len++] = 'n';
+        } else if (c == '\r') {
+            out[len++] = '\\';
+            out[len++] = 'r';
+        } else if (c == '\t') {
+            out[len++] = '\\';
+            out[len++] = 't';
+        } else if (c < 0x20) {
+            len += sprintf(out + len, "\\u%04x", c);
+        } else {
+            out[len++] = c;
+        }
+    }
+    return len;
+}
+
+static size_t append_field(char *out, const char *prefix, const char *s, size_t n) {
+    size_t len = strlen(prefix);
+    memcpy(out, prefix, len);
+    len += append_escaped(out + len, s, n);
+    out[len++] = '"';
+    return len;
+}
+
+// The JSONL line of a request, malloc'ed
+static char *format_line(const HTTPRequest *request, double gap_ms) {
+    const char *path = request->path ? request->path : "/";
+    const char *query = request->query ? request->query : "";
+    size_t body_len = request->body ? request->body_len : 0;
+    if (body_len > capture_body_bytes) body_len = capture_body_bytes;
+
+    size_t size = 128 + 6 * (strlen(request->method) + strlen(path) + strlen(query) + body_len);
+    for (size_t i = 0; i < request->header_count; i++) {
+        const HTTPHeader *h = &request->header_list[i];
+        if (h->key && h->value) size += 16 + 6 * (strlen(h->key) + strlen(h->value));
+    }
+    char *line = malloc(size);
+    if (!line) return NULL;
+
+    size_t len = append_field(line, "{\"method\":\"", request->method, strlen(request->method));
+    len += append_field(line + len, ",\"path\":\"", path, strlen(path));
+    if (*query) len += append_field(line + len, ",\"query\":\"", query, strlen(query));
+
+    bool first = true;
+    for (size_t i = 0; i < request->header_count; i++) {
+        const HTTPHeader *h = &request->header_list[i];
+        if (!h->key || !h->value || !kept_header(h->key)) continue;
+        const char *value = scrubbed_header(h->key) ? "scrubbed" : h->value;
+        len += append_field(line + len, first ? ",\"headers\":{\"" : ",\"", h->key, strlen(h->key));
+        len += append_field(line + len, ":\"", value, strlen(value));
+        first = false;
+    }
+    if (!first) line[len++] = '}';
+
+    if (body_len > 0) len += append_field(line + len, ",\"body\":\"", request->body, body_len);
+    len += snprintf(line + len, size - len, ",\"gap_ms\":%.3f}\n", gap_ms);
+    return line;
+}
+
+// Claims the next free slot and publishes line in it, false when the ring is full
+static bool ring_push(char *line) {
+    uint64_t position = __atomic_load_n(&head, __ATOMIC_RELAXED);
+    while (true) {
+        CaptureSlot *slot = &ring[position & (CAPTURE_RING_SIZE - 1)];
+        uint64_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        if (seq == position) {
+            if (__atomic_compare_exchange_n(&head, &position, position + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                slot->line = line;
+                __atomic_store_n(&slot->seq, position + 1, __ATOMIC_RELEASE);
+                return true;
+            }
+        } else if (seq < position) {
+            // The writer has not handed this slot back yet
+            return false;
+        } else {
+            position = __atomic_load_n(&head, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+void Capture_request(const HTTPRequest *request) {
+    if (!__atomic_load_n(&running, __ATOMIC_ACQUIRE)) return;
+    if (__atomic_add_fetch(&sample_counter, 1, __ATOMIC_RELAXED) % capture_sample != 0) return;
+
+    int64_t received = request->received_ns ? request->received_ns : HTTPServer_now_ns();
+    int64_t previous = __atomic_exchange_n(&last_captured_ns, received, __ATOMIC_RELAXED);
+    double gap_ms = previous ? (received - previous) / 1e6 / capture_sample : 0;
+    if (gap_ms < 0) gap_ms = 0;
+
+    // Not worth formatting a line the ring has no room for
+    if (__atomic_load_n(&head, __ATOMIC_RELAXED) - __atomic_load_n(&tail, __ATOMIC_ACQUIRE) >= CAPTURE_RING_SIZE) {
+        __atomic_add_fetch(&dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+    char *line = format_line(request, gap_ms);
+    if (!line) return;
+    if (!ring_push(line)) {
+        free(line);
+        __atomic_add_fetch(&dropped, 1, __ATOMIC_RELAXED);
+    }
+}
+
+// One write per line: the file is opened O_APPEND, so lines stay whole
+static void write_line(const char *line) {
+    size_t len = strlen(line), written = 0;
+    while (written < len) {
+        ssize_t n = write(capture_fd, line + written, len - written);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        written += n;
+    }
+}
+
+static void *writer_thread(void *arg) {
+    (void)arg;
+    bool stopping = false;
+    while (!stopping) {
+        stopping = __atomic_load_n(&stop_requested, __ATOMIC_ACQUIRE);
+        // Up to the first slot claimed but not yet published
+        for (uint64_t i = tail;; i++) {
+            CaptureSlot *slot = &ring[i & (CAPTURE_RING_SIZE - 1)];
+            if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != i + 1) break;
+            write_line(slot->line);
+            free(slot->line);
+            slot->line = NULL;
+            __atomic_store_n(&slot->seq, i + CAPTURE_RING_SIZE, __ATOMIC_RELEASE);
+            __atomic_store_n(&tail, i + 1, __ATOMIC_RELEASE);
+        }
+        if (!stopping) {
+            struct timespec pause = { 0, CAPTURE_FLUSH_MS * 1000000 };
+            nanosleep(&pause, NULL);
+        }
+    }
+    return NULL;
+}
+
+bool Capture_start(const char *path, int sample, int body_bytes) {
+    if (running || !path || !*path || sample <= 0) return true;
+
+    capture_fd = open(path, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0600);
+    if (capture_fd < 0) {
+        perror("Failed to open capture file");
+        return false;
+    }
+    capture_sample = sample;
+    capture_body_bytes = body_bytes > 0 ? body_bytes : 0;
+    sample_counter = 0;
+    last_captured_ns = 0;
+    // Lines a producer published after the last writer was gone
+    for (uint64_t i = 0; i < CAPTURE_RING_SIZE; i++) {
+        free(ring[i].line);
+        ring[i].line = NULL;
+        ring[i].seq = i;
+    }
+    head = tail = 0;
+    __atomic_store_n(&stop_requested, false, __ATOMIC_RELEASE);
+    if (pthread_create(&writer, NULL, writer_thread, NULL) != 0) {
+        perror("Failed to start capture writer");
+        close(capture_fd);
+        capture_fd = -1;
+        return false;
+    }
+    __atomic_store_n(&running, true, __ATOMIC_RELEASE);
+    return true;
+}
+
+void Capture_stop(void) {
+    if (!running) return;
+    __atomic_store_n(&running, false, __ATOMIC_RELEASE);
+    __atomic_store_n(&stop_requested, true, __ATOMIC_RELEASE);
+    pthread_join(writer, NULL);
+    close(capture_fd);
+    capture_fd = -1;
+}
+
+uint64_t Capture_dropped(void) {
+    return __atomic_load_n(&dropped, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,34 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include "HTTPServer.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+// Traffic capture for replay with bench/loadgen. The thread that parsed a
+// request formats one in CAPTURE_SAMPLE requests into a JSONL line and
+// hands it to a writer thread through a bounded ring; a full ring drops
+// the line instead of waiting. A line looks like
+//
+//   {"method":"POST","path":"/login","query":"next=%2F","headers":{"Cookie":"scrubbed"},"body":"...","gap_ms":12.500}
+//
+// gap_ms is the time since the previous captured request divided by the
+// sample rate, so a replay at the recorded gaps runs at the original
+// request rate. Only the headers of CAPTURE_HEADERS are kept (all of them
+// if it is empty), and the values of credentials such as Authorization and
+// Cookie are always replaced. Bodies are cut at CAPTURE_BODY_BYTES.
+
+// Starts the writer thread appending to path, "" or sample <= 0 disables
+// capture. Safe to call again after stop.
+bool Capture_start(const char *path, int sample, int body_bytes);
+
+// Writes the lines left in the ring and stops the writer thread
+void Capture_stop(void);
+
+// Samples a parsed request, from any thread
+void Capture_request(const HTTPRequest *request);
+
+// Lines lost to a full ring since start
+uint64_t Capture_dropped(void);
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef COMPRESSION_H
+#define COMPRESSION_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <sys/uio.h>
+
+// gzip/deflate content coding for response bodies (zlib)
+
+typedef enum {
+    ENCODING_IDENTITY,
+    ENCODING_GZIP,
+    ENCODING_DEFLATE,
+    ENCODING_COUNT
+} ContentEncoding;
+
+// A body already encoded with one of the codings, data is NULL if not available
+typedef struct {
+    const char *data;
+    size_t len;
+} EncodedBody;
+
+// Picks the coding the client prefers from an Accept-Encoding value, honouring
+// q-values and "*". gzip wins ties. NULL or nothing acceptable is identity.
+ContentEncoding Compression_negotiate(const char *accept_encoding);
+
+// Content-Encoding token, NULL for identity
+const char *Compression_name(ContentEncoding encoding);
+
+// Text-like types that are worth compressing
+bool Compression_compressible(const char *content_type);
+
+// Compresses the body into a per-thread buffer that stays valid until the
+// thread's next call. The thread's zlib stream is reused across calls.
+bool Compression_compress(ContentEncoding encoding, const struct iovec *iov, int iov_count,
+                          const char **out, size_t *out_len);
+
+#endif
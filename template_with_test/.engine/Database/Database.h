@@ -1,5 +1,6 @@
 #pragma once
 #include <stdbool.h>
+#include <stdint.h>
 #include "config.h"
 
 typedef struct Database Database;
@@ -12,6 +13,12 @@ typedef enum {
 
 DbStatus db_get_status(Database *db);
 
+/* Called with the duration of every statement sent to the database, NULL = off */
+extern void (*db_timing_hook)(int64_t elapsed_ns);
+
+/* Called with the SQL as a statement starts and with NULL once it is done, NULL = off */
+extern void (*db_statement_hook)(const char *sql);
+
 /* Lifecycle */
 bool db_open(Database **db);
 void db_close(Database *db);
@@ -42,3 +49,8 @@ bool db_query_safe(Database *db, const char *sql, DBResult **r);
 bool db_exec_params(Database *db, const char *sql, int nparams, const char *params[]);
 
 bool db_query_params(Database *db, const char *sql, int nparams, const char *params[], DBResult **out);
+
+/* Transactions, nested ones as savepoints */
+bool db_begin(Database *db);
+bool db_commit(Database *db);
+bool db_rollback(Database *db);
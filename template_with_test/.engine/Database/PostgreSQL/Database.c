@@ -1,8 +1,10 @@
 #include "Database.h"
+#include "Trace.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <pthread.h>
+#include <time.h>
 #include <libpq-fe.h>
 
 struct Database {
@@ -15,6 +17,27 @@ struct DBResult {
     int current_row;
 };
 
+/* -------------------- Timing hooks -------------------- */
+
+void (*db_timing_hook)(int64_t elapsed_ns) = NULL;
+void (*db_statement_hook)(const char *sql) = NULL;
+
+static int64_t timing_start(const char *sql) {
+    if (db_statement_hook) db_statement_hook(sql);
+    if (!db_timing_hook) return 0;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void timing_end(int64_t started) {
+    if (db_statement_hook) db_statement_hook(NULL);
+    if (!started || !db_timing_hook) return;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    db_timing_hook((int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec - started);
+}
+
 /* -------------------- Lifecycle -------------------- */
 
 bool db_open(Database **db) {
@@ -84,7 +107,7 @@ static void log_db_error(Database *db, const char *context) {
 
 /* -------------------- Simple exec -------------------- */
 
-bool db_exec(Database *db, const char *sql) {
+static bool run_exec(Database *db, const char *sql) {
     if (db_get_status(db) != DB_STATUS_OK) return false;
 
     PGresult *res = PQexec(db->conn, sql);
@@ -101,7 +124,7 @@ bool db_exec(Database *db, const char *sql) {
 
 /* -------------------- Query helpers -------------------- */
 
-bool db_query(Database *db, const char *sql, DBResult **out) {
+static bool run_query(Database *db, const char *sql, DBResult **out) {
     if (db_get_status(db) != DB_STATUS_OK || !out) return false;
 
     PGresult *res = PQexec(db->conn, sql);
@@ -216,7 +239,7 @@ bool db_rollback(Database *db)
     }
 }
 
-bool db_exec_params(Database *db, const char *sql, int nparams, const char *params[]) {
+static bool run_exec_params(Database *db, const char *sql, int nparams, const char *params[]) {
     if (db_get_status(db) != DB_STATUS_OK) return false;
 
     PGresult *res = PQexecParams(db->conn, sql, nparams, NULL, params, NULL, NULL, 0);
@@ -231,7 +254,7 @@ bool db_exec_params(Database *db, const char *sql, int nparams, const char *para
     return true;
 }
 
-bool db_query_params(Database *db, const char *sql, int nparams, const char *params[], DBResult **out) {
+static bool run_query_params(Database *db, const char *sql, int nparams, const char *params[], DBResult **out) {
     if (db_get_status(db) != DB_STATUS_OK || !out) return false;
 
     PGresult *res = PQexecParams(db->conn, sql, nparams, NULL, params, NULL, NULL, 0);
@@ -253,3 +276,41 @@ bool db_query_params(Database *db, const char *sql, int nparams, const char *par
     *out = r;
     return true;
 }
+
+/* -------------------- Timed entry points -------------------- */
+
+bool db_exec(Database *db, const char *sql) {
+    int64_t started = timing_start(sql);
+    TRACE_PROBE1(db_query_start, sql);
+    bool ok = run_exec(db, sql);
+    TRACE_PROBE2(db_query_end, sql, ok);
+    timing_end(started);
+    return ok;
+}
+
+bool db_query(Database *db, const char *sql, DBResult **out) {
+    int64_t started = timing_start(sql);
+    TRACE_PROBE1(db_query_start, sql);
+    bool ok = run_query(db, sql, out);
+    TRACE_PROBE2(db_query_end, sql, ok);
+    timing_end(started);
+    return ok;
+}
+
+bool db_exec_params(Database *db, const char *sql, int nparams, const char *params[]) {
+    int64_t started = timing_start(sql);
+    TRACE_PROBE1(db_query_start, sql);
+    bool ok = run_exec_params(db, sql, nparams, params);
+    TRACE_PROBE2(db_query_end, sql, ok);
+    timing_end(started);
+    return ok;
+}
+
+bool db_query_params(Database *db, const char *sql, int nparams, const char *params[], DBResult **out) {
+    int64_t started = timing_start(sql);
+    TRACE_PROBE1(db_query_start, sql);
+    bool ok = run_query_params(db, sql, nparams, params, out);
+    TRACE_PROBE2(db_query_end, sql, ok);
+    timing_end(started);
+    return ok;
+}
@@ -1,9 +1,11 @@
 #include "Database.h"
+#include "Trace.h"
 #include <sqlite3.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <pthread.h>
+#include <time.h>
 
 struct Database {
     sqlite3 *conn;
@@ -15,6 +17,27 @@ struct DBResult {
     int current_row;
 };
 
+/* -------------------- Timing hooks -------------------- */
+
+void (*db_timing_hook)(int64_t elapsed_ns) = NULL;
+void (*db_statement_hook)(const char *sql) = NULL;
+
+static int64_t timing_start(const char *sql) {
+    if (db_statement_hook) db_statement_hook(sql);
+    if (!db_timing_hook) return 0;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void timing_end(int64_t started) {
+    if (db_statement_hook) db_statement_hook(NULL);
+    if (!started || !db_timing_hook) return;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    db_timing_hook((int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec - started);
+}
+
 bool db_open(Database **db) {
     if (!db) return false;
     *db = malloc(sizeof(Database));
@@ -53,7 +76,7 @@ DbStatus db_get_status(Database *db) {
     return DB_STATUS_OK;
 }
 
-bool db_exec(Database *db, const char *sql) {
+static bool run_exec(Database *db, const char *sql) {
     char *err = NULL;
     int rc = sqlite3_exec(db->conn, sql, NULL, NULL, &err);
     if (rc != SQLITE_OK) {
@@ -64,7 +87,7 @@ bool db_exec(Database *db, const char *sql) {
     return true;
 }
 
-bool db_query(Database *db, const char *sql, DBResult **out) {
+static bool run_query(Database *db, const char *sql, DBResult **out) {
     DBResult *r = malloc(sizeof(DBResult));
     if (!r) return false;
 
@@ -79,7 +102,7 @@ bool db_query(Database *db, const char *sql, DBResult **out) {
 
 /* --------------- SQL Injection safe functions ---------------------- */
 
-bool db_exec_params(Database *db, const char *sql, int nparams, const char *params[]) {
+static bool run_exec_params(Database *db, const char *sql, int nparams, const char *params[]) {
     if (!db) return false;
 
     sqlite3_stmt *stmt;
@@ -102,7 +125,7 @@ bool db_exec_params(Database *db, const char *sql, int nparams, const char *para
     return true;
 }
 
-bool db_query_params(Database *db, const char *sql, int nparams, const char *params[], DBResult **out) {
+static bool run_query_params(Database *db, const char *sql, int nparams, const char *params[], DBResult **out) {
     if (!db || !out) return false;
 
     sqlite3_stmt *stmt;
@@ -129,7 +152,7 @@ bool db_query_params(Database *db, const char *sql, int nparams, const char *par
 
 /* -------------------- Helper functions ---------------------------- */
 
-bool db_result_next(DBResult *r) {
+static bool run_result_next(DBResult *r) {
     return sqlite3_step(r->stmt) == SQLITE_ROW;
 }
 
@@ -213,3 +236,49 @@ bool db_rollback(Database *db)
         return db_exec(db, sql);
     }
 }
+
+/* -------------------- Timed entry points -------------------- */
+
+bool db_exec(Database *db, const char *sql) {
+    int64_t started = timing_start(sql);
+    TRACE_PROBE1(db_query_start, sql);
+    bool ok = run_exec(db, sql);
+    TRACE_PROBE2(db_query_end, sql, ok);
+    timing_end(started);
+    return ok;
+}
+
+bool db_query(Database *db, const char *sql, DBResult **out) {
+    int64_t started = timing_start(sql);
+    TRACE_PROBE1(db_query_start, sql);
+    bool ok = run_query(db, sql, out);
+    TRACE_PROBE2(db_query_end, sql, ok);
+    timing_end(started);
+    return ok;
+}
+
+bool db_exec_params(Database *db, const char *sql, int nparams, const char *params[]) {
+    int64_t started = timing_start(sql);
+    TRACE_PROBE1(db_query_start, sql);
+    bool ok = run_exec_params(db, sql, nparams, params);
+    TRACE_PROBE2(db_query_end, sql, ok);
+    timing_end(started);
+    return ok;
+}
+
+bool db_query_params(Database *db, const char *sql, int nparams, const char *params[], DBResult **out) {
+    int64_t started = timing_start(sql);
+    TRACE_PROBE1(db_query_start, sql);
+    bool ok = run_query_params(db, sql, nparams, params, out);
+    TRACE_PROBE2(db_query_end, sql, ok);
+    timing_end(started);
+    return ok;
+}
+
+bool db_result_next(DBResult *r) {
+    // Rows are stepped here, still part of the statement
+    int64_t started = timing_start(sqlite3_sql(r->stmt));
+    bool ok = run_result_next(r);
+    timing_end(started);
+    return ok;
+}
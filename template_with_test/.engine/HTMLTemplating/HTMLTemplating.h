@@ -1,26 +1,182 @@
-#ifndef HTML_TEMPLATING_H
-#define HTML_TEMPLATING_H
-
-#include"HTTPServer.h"
-#include "config.h"
-
-// Function pointer type for value conversion
-typedef char* (*ValueConverter)(const void* value);
-
-// Converter declarations
-char* convert_string(const void* value);
-char* convert_int(const void* value);
-char* convert_float(const void* value);
-char* convert_bool(const void* value);
-
-typedef struct {
-    const char* key;
-    const void* value;
-    ValueConverter converter;
-} TemplateParam;
-
-void render_html(HTTPRequest *request, const char *file_path, TemplateParam* params, int param_count);
-
-char *process_html(const char *file_path, TemplateParam* params, int param_count);
-
-#endif
+#ifndef HTML_TEMPLATING_H
+#define HTML_TEMPLATING_H
+
+#include"HTTPServer.h"
+#include "Compression.h"
+#include "config.h"
+#include <sys/uio.h>
+#include <stddef.h>
+
+// Function pointer type for value conversion
+typedef char* (*ValueConverter)(const void* value);
+
+typedef struct TemplateOutput TemplateOutput;
+
+// Appends the formatted value straight into the render output, strings
+// are referenced in place and numbers are formatted without snprintf.
+// Writers emit raw bytes, the renderer escapes string output per slot.
+typedef bool (*ValueWriter)(TemplateOutput *out, const void *value);
+
+// Converter declarations
+char* convert_string(const void* value);
+char* convert_int(const void* value);
+char* convert_float(const void* value);
+char* convert_bool(const void* value);
+// Marks a value as a TemplateList for {% for %}; printed directly it renders the item count
+char* convert_list(const void* value);
+
+// Writer declarations, the built-in converters above map to these
+bool write_string(TemplateOutput *out, const void *value);
+bool write_int(TemplateOutput *out, const void *value);
+bool write_float(TemplateOutput *out, const void *value);
+bool write_bool(TemplateOutput *out, const void *value);
+bool write_list(TemplateOutput *out, const void *value);
+
+// Set either converter (legacy, returns a malloc'd string) or writer
+typedef struct {
+    const char* key;
+    const void* value;
+    ValueConverter converter;
+    ValueWriter writer;
+} TemplateParam;
+
+// Field accessor used to read list items inside {% for %} blocks
+typedef struct {
+    const char *name;
+    size_t offset;
+    ValueConverter converter;
+    bool indirect;      // member is a pointer to the value (char *), not the value itself
+    ValueWriter writer; // used instead of converter when set
+} TemplateField;
+
+// Array of structs (or a generated <Model>List) exposed to a template
+typedef struct {
+    const void *items;
+    size_t count;
+    size_t item_size;
+    const TemplateField *fields;
+    int field_count;
+} TemplateList;
+
+#define TEMPLATE_FIELD(type, member, conv)     { #member, offsetof(type, member), conv, false, NULL }
+#define TEMPLATE_FIELD_PTR(type, member, conv) { #member, offsetof(type, member), conv, true, NULL }
+#define TEMPLATE_FIELD_WRITER(type, member, writer)     { #member, offsetof(type, member), NULL, false, writer }
+#define TEMPLATE_FIELD_PTR_WRITER(type, member, writer) { #member, offsetof(type, member), NULL, true, writer }
+#define TEMPLATE_LIST(array, n, field_table) \
+    { (array), (n), sizeof(*(array)), (field_table), (int)(sizeof(field_table) / sizeof((field_table)[0])) }
+
+// How a {{ value }} is escaped, picked at parse time from where the slot sits
+typedef enum {
+    ESCAPE_TEXT,        // element content: & < >
+    ESCAPE_ATTR,        // quoted attribute value: & < > " '
+    ESCAPE_UNQUOTED,    // elsewhere in a tag: also whitespace = ` so no attribute can be added
+    ESCAPE_RAW          // {{ value|raw }}, for trusted HTML fragments
+} TemplateEscape;
+
+// Max nesting of blocks, loops and includes
+#define TEMPLATE_MAX_DEPTH 16
+
+// A template is split once into literal runs, {{ param }} slots and {% block %} tags
+typedef enum {
+    SEGMENT_LITERAL,
+    SEGMENT_PARAM,
+    SEGMENT_IF,         // {% if [not] key %}
+    SEGMENT_ELSE,       // {% else %}
+    SEGMENT_ENDIF,      // {% endif %}
+    SEGMENT_FOR,        // {% for var in key %}
+    SEGMENT_ENDFOR,     // {% endfor %}
+    SEGMENT_INCLUDE     // {% include "file" [with var [cached]] %}
+} TemplateSegmentType;
+
+typedef struct {
+    TemplateSegmentType type;
+    const char *text;   // literal bytes, or the whole tag
+    size_t len;
+    const char *key;    // param name, list, condition or include path (not NUL terminated)
+    size_t key_len;
+    const char *hint;   // optional "{{ key:type }}" hint, used by the template compiler
+    size_t hint_len;
+    const char *var;    // loop variable of {% for %}, or the "with" variable of {% include %}
+    size_t var_len;
+    int jump;           // index of the matching else/endif/endfor
+    bool negate;        // {% if not key %}
+    bool cached;        // {% include ... with var cached %}, through the fragment cache
+    TemplateEscape escape;
+} TemplateSegment;
+
+typedef struct {
+    char *path;
+    char *content;      // file bytes, kept for the life of the process
+    size_t content_len;
+    TemplateSegment *segments;
+    int segment_count;
+    bool is_static;             // literal text only, the body never changes
+    char etag[HTTP_ETAG_SIZE];  // precomputed for static templates
+    EncodedBody encoded[ENCODING_COUNT];  // static templates compressed once at load
+} Template;
+
+// Size of the scratch blocks formatted numbers are copied into
+#define TEMPLATE_SCRATCH_BLOCK 1024
+
+// Render output: literal segments point into the cached template,
+// converted values are owned and released by template_output_free.
+// Formatted numbers share scratch blocks that never move once handed out.
+struct TemplateOutput {
+    struct iovec *iov;
+    int iov_count;
+    int iov_capacity;
+    char **owned;
+    int owned_count;
+    int owned_capacity;
+    char *scratch;
+    size_t scratch_used;
+    size_t scratch_size;
+    size_t total_len;
+};
+
+// Parsed once and shared. With TEMPLATE_RECHECK_SECONDS > 0 a later load
+// stats the file at most that often and parses it again when its mtime
+// changed; the old parse stays valid for renders still using it.
+// Compiled templates are fixed at build time and never reload.
+const Template *template_load(const char *file_path);
+bool template_parse(Template *tpl);
+
+void template_output_init(TemplateOutput *out);
+void template_output_free(TemplateOutput *out);
+bool template_output_append(TemplateOutput *out, const char *data, size_t len);
+bool template_output_append_str(TemplateOutput *out, const char *str);
+bool template_output_copy(TemplateOutput *out, const char *data, size_t len);
+bool template_output_convert(TemplateOutput *out, ValueConverter converter, const void *value);
+bool template_output_escape(TemplateOutput *out, const char *data, size_t len, TemplateEscape escape);
+bool template_output_escape_str(TemplateOutput *out, const char *str, TemplateEscape escape);
+char *template_output_join(const TemplateOutput *out);
+uint64_t template_output_hash(const TemplateOutput *out);
+// Both answer with a bodyless 304 when If-None-Match already has the ETag
+void template_output_send(HTTPRequest *request, TemplateOutput *out, bool ok);
+void template_output_send_etag(HTTPRequest *request, TemplateOutput *out, bool ok, const char *etag);
+// Answers a static page without rendering it: a 304, or the precompressed
+// body in the coding the client accepts. False if it must be rendered.
+bool template_send_static(HTTPRequest *request, const char *etag, const EncodedBody *encoded);
+
+bool template_render(const Template *tpl, TemplateParam *params, int param_count, TemplateOutput *out);
+
+// List helpers shared with compiled templates
+bool template_truthy(const char *value);
+const void *template_list_item(const TemplateList *list, size_t index);
+int template_list_field(const TemplateList *list, const char *name);
+bool template_output_field(TemplateOutput *out, const TemplateList *list, const void *item, int field, TemplateEscape escape);
+bool template_field_truthy(const TemplateList *list, const void *item, int field);
+
+void render_html(HTTPRequest *request, const char *file_path, TemplateParam* params, int param_count);
+
+char *process_html(const char *file_path, TemplateParam* params, int param_count);
+
+// Same as process_html, but renders of the same template with the same
+// param values are copied out of a size-bounded LRU cache. ttl_seconds
+// <= 0 keeps an entry until it is evicted. The same cache serves
+// {% include ... with item cached %} partials that read only the item's
+// fields (rendered by the runtime renderer; compiled templates inline them).
+char *process_html_cached(const char *file_path, TemplateParam* params, int param_count, int ttl_seconds);
+void template_fragment_cache_clear(void);
+
+#endif
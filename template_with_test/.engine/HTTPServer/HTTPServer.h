@@ -2,7 +2,11 @@
 #define HTTPSERVER_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include<netinet/in.h>
+#include<signal.h>
+#include<sys/types.h>
+#include<sys/uio.h>
 
 typedef struct {
     char *key;
@@ -14,11 +18,30 @@ typedef struct {
     char *value;
 } HTTPHeader;
 
-typedef struct {
+struct HTTPRequest;
+struct ssl_st;
+
+// Phases of a request timed by the engine, in HTTPRequest.phase_ns
+typedef enum {
+    HTTP_PHASE_QUEUE,       // accepted until a worker thread picked it up
+    HTTP_PHASE_ROUTE,       // matching the path against the routes table
+    HTTP_PHASE_HANDLER,     // route handler, DB and render time included
+    HTTP_PHASE_DB,          // statements run through the Database layer
+    HTTP_PHASE_RENDER,      // template rendering
+    HTTP_PHASE_WRITE,       // response written to the client
+    HTTP_PHASE_COUNT
+} HTTPPhase;
+
+// Called with the exact bytes of a response (status line, headers and
+// body) once they are written to the client and its connection closed
+typedef void (*HTTPResponseHook)(struct HTTPRequest *request, int status_code, const struct iovec *iov, int iov_count);
+
+typedef struct HTTPRequest {
     char method[8];
     char version[16];
 
     char *path;
+    char *query;        // raw query string without '?', NULL if none
     char *headers;
     char *body;
 
@@ -34,22 +57,99 @@ typedef struct {
     size_t header_capacity;
 
     int client_socket;
+    struct ssl_st *tls;     // NULL for plain TCP
+    bool unread;            // accepted only, see HTTPServer_read_request
+    bool tls_pending;       // with unread: the TLS handshake is still to do
+
+    HTTPResponseHook on_response;
+    void *response_ctx;
+
+    int64_t received_ns;    // monotonic clock when the connection was accepted
+    int status_code;        // of the response sent, 0 until then
+    size_t response_bytes;  // header and body as written
+    int64_t phase_ns[HTTP_PHASE_COUNT];
 } HTTPRequest;
 
 typedef struct {
-	int server_fd;
+	int server_fd;          // TCP listener, -1 when only the Unix socket is used
 	int port;
 	struct sockaddr_in address;
+	int unix_fd;            // Unix domain listener, -1 if none
+	char *unix_path;
+	int next_listener;      // where the next poll scan starts, so neither starves
+	pid_t owner;            // process that bound the sockets, the only one to unlink
+	volatile sig_atomic_t stopping;  // set by HTTPServer_stop
 }HTTPServer;
 
-HTTPServer *HTTPServer_create(int port);
+// Listens on the TCP port (skipped when port <= 0), on the Unix socket path
+// (skipped when NULL or empty), or on both; TLS only applies to TCP clients
+HTTPServer *HTTPServer_create(int port, const char *unix_path);
+
+// Wraps listeners that are already bound and listening, handed over by the
+// previous image of a re-executed process; -1 for one that is not used.
+// The port and socket path are read back from the sockets.
+HTTPServer *HTTPServer_adopt(int server_fd, int unix_fd);
  
+// Deadline for the TLS handshake and the request bytes of a client
+#define HTTP_READ_TIMEOUT_SECONDS 10
+
+// Waits for a client on any listener and reads its request. Clients that
+// would hold the accepting thread come back unread: TLS ones, whose
+// handshake costs round trips and CPU, and plain ones whose bytes are not
+// in yet: the accepting thread never waits for them.
+// Signals do not end the wait (a profiler's SIGPROF included) unless
+// HTTPServer_stop was called.
 HTTPRequest HTTPServer_listen(HTTPServer *server);
 
+// Async-signal-safe, for a signal handler: the wait of HTTPServer_listen
+// returns an empty request the next time a signal interrupts it
+void HTTPServer_stop(HTTPServer *server);
+
+// Handshake and read of an unread request, on a thread that may block.
+// False (the connection closed) if the client failed or timed out.
+bool HTTPServer_read_request(HTTPRequest *request);
+
+// Fills a zeroed request from the NUL-terminated bytes read off a client
+void HTTPRequest_parse(HTTPRequest *req, const char *buffer);
+
 void HTTPServer_send_response(HTTPRequest *request, const char *body, const char *content_type, int status_code, const char *status_message);
 
+void HTTPServer_send_response_iov(HTTPRequest *request, const struct iovec *body, int body_count, const char *content_type, int status_code, const char *status_message);
+
+// Writes to a client connection, through TLS when tls is set
+bool HTTPServer_write(int fd, struct ssl_st *tls, const struct iovec *iov, int iov_count);
+
+// Ends the TLS session if any and closes the socket
+void HTTPServer_close(int fd, struct ssl_st *tls);
+
+// extra_headers is a block of "Name: value\r\n" lines, or NULL. Text bodies
+// of COMPRESSION_MIN_SIZE or more are gzip/deflate encoded when the client
+// accepts it, unless extra_headers already names a Content-Encoding.
+void HTTPServer_send_response_headers(HTTPRequest *request, const struct iovec *body, int body_count, const char *content_type, int status_code, const char *status_message, const char *extra_headers);
+
+// Quoted ETag of a 64-bit body hash: '"' + 16 hex digits + '"' + NUL
+#define HTTP_ETAG_SIZE 19
+void HTTPServer_format_etag(uint64_t hash, char *etag);
+
 void HTTPServer_destroy(HTTPServer *server);
 
+// Monotonic clock in nanoseconds, for request timing
+int64_t HTTPServer_now_ns(void);
+
+// Adds the time since started_ns (from HTTPServer_now_ns) to a phase
+void HTTPRequest_add_phase(HTTPRequest *req, HTTPPhase phase, int64_t started_ns);
+
+// HTTPServer_now_ns for a phase that HTTPRequest_add_phase closes, telling
+// the phase hook the request entered it
+int64_t HTTPRequest_begin_phase(HTTPRequest *req, HTTPPhase phase);
+
+// Called as a request enters a phase through HTTPRequest_begin_phase and
+// leaves one through HTTPRequest_add_phase, on that thread. NULL = off.
+extern void (*http_phase_hook)(const HTTPRequest *req, HTTPPhase phase, bool entering);
+
+// Lower case name of a phase, as in Server-Timing and the logs
+const char *HTTPServer_phase_name(HTTPPhase phase);
+
 void HTTPRequest_free(HTTPRequest *req);
 
 bool HTTPRequest_add_param(HTTPRequest *req, const char *key, const char *value);
@@ -60,4 +160,9 @@ bool HTTPRequest_add_header(HTTPRequest *req, const char *key, const char *value
 
 const char *HTTPRequest_get_header(HTTPRequest *req, const char *key);
 
+bool HTTPRequest_remove_header(HTTPRequest *req, const char *key);
+
+// True if the request's If-None-Match lists etag (weak or strong) or is "*"
+bool HTTPRequest_etag_matches(HTTPRequest *req, const char *etag);
+
 #endif
@@ -0,0 +1,45 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include "HTTPServer.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+// Request counters and latency histograms, exported in Prometheus text
+// format. Every thread records into its own shard with plain stores; a
+// scrape merges the shards. The shards live in memory shared by all worker
+// processes, mapped before the fork, so any process can answer a scrape
+// with the totals of all of them.
+
+// Route indexes besides the ones of the routes table
+#define METRICS_ROUTE_UNMATCHED -1     // no route, or no DB connection
+#define METRICS_ROUTE_CACHE     -2     // answered by the acceptor from the response cache
+#define METRICS_ROUTE_ADMIN     -3     // the metrics, profile and workers endpoints
+
+typedef enum {
+    METRICS_QUEUE_DEPTH,        // requests waiting for a worker thread
+    METRICS_ACTIVE_WORKERS,     // worker threads handling a request
+    METRICS_GAUGE_COUNT
+} MetricsGauge;
+
+// Called once before the worker processes are forked. route_names are the
+// route patterns, used as labels. processes and threads are upper bounds
+// (a process or thread past them records nothing).
+bool Metrics_init(int processes, int threads, const char *const *route_names, int route_count);
+
+// In each worker process, with its index in [0, processes)
+void Metrics_attach(int process);
+
+// Starts timing the DB statements of request on this thread
+void Metrics_begin(HTTPRequest *request);
+
+// Records the finished request under a route index, stops DB timing
+void Metrics_end(HTTPRequest *request, int route);
+
+void Metrics_gauge_add(MetricsGauge gauge, int delta);
+void Metrics_db_reconnect(void);
+
+// The Prometheus text exposition of every process, malloc'ed
+char *Metrics_render(size_t *len);
+
+#endif
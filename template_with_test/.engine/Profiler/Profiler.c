@@ -0,0 +1,238 @@
+#define _GNU_SOURCE
+#include "Profiler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#if defined(__has_include)
+#if __has_include(<execinfo.h>)
+#define PROFILER_HAS_BACKTRACE 1
+#endif
+#endif
+
+#ifdef PROFILER_HAS_BACKTRACE
+#include <execinfo.h>
+#include <dlfcn.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+
+#define PROFILER_MAX_DEPTH 32
+#define PROFILER_MAX_SAMPLES (1 << 16)
+// The handler and the signal trampoline
+#define PROFILER_SKIP_FRAMES 2
+
+typedef struct {
+    int depth;              // 0 until the handler has filled pc
+    void *pc[PROFILER_MAX_DEPTH];
+} Sample;
+
+static Sample *samples = NULL;
+static size_t sample_capacity = 0;
+static size_t sample_count = 0;
+static bool sampling = false;
+static bool running = false;
+static bool handler_installed = false;
+
+// Runs on whichever thread was on the CPU: only async-signal-safe work.
+// backtrace() is, once libgcc has been loaded by a first call.
+static void on_sigprof(int sig, siginfo_t *info, void *context) {
+    (void)sig;
+    (void)info;
+    (void)context;
+    if (!__atomic_load_n(&sampling, __ATOMIC_ACQUIRE)) return;
+    int saved_errno = errno;
+    size_t slot = __atomic_fetch_add(&sample_count, 1, __ATOMIC_RELAXED);
+    if (slot < sample_capacity) {
+        Sample *s = &samples[slot];
+        int depth = backtrace(s->pc, PROFILER_MAX_DEPTH);
+        __atomic_store_n(&s->depth, depth, __ATOMIC_RELEASE);
+    }
+    errno = saved_errno;
+}
+
+// The handler stays installed once set: a SIGPROF still pending when a
+// profile ends must not hit the default action, which kills the process
+static bool install_handler(void) {
+    if (handler_installed) return true;
+    void *warm_up[1];
+    backtrace(warm_up, 1);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = on_sigprof;
+    sa.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(SIGPROF, &sa, NULL) != 0) return false;
+    handler_installed = true;
+    return true;
+}
+
+static void sleep_seconds(int seconds) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += seconds;
+    // Interrupted by the samples landing on this thread
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR) {
+    }
+}
+
+static int compare_samples(const void *a, const void *b) {
+    const Sample *x = *(const Sample *const *)a, *y = *(const Sample *const *)b;
+    if (x->depth != y->depth) return x->depth - y->depth;
+    return memcmp(x->pc, y->pc, x->depth * sizeof(void *));
+}
+
+// Function name, or module+offset. Callers' return addresses point after
+// the call, one byte back is inside it.
+static int frame_name(void *pc, bool caller, char *out, size_t size) {
+    uintptr_t address = (uintptr_t)pc - (caller ? 1 : 0);
+    Dl_info info;
+    if (dladdr((void *)address, &info) && info.dli_sname) return snprintf(out, size, "%s", info.dli_sname);
+    if (info.dli_fname && info.dli_fname[0]) {
+        const char *module = strrchr(info.dli_fname, '/');
+        return snprintf(out, size, "%s+0x%lx", module ? module + 1 : info.dli_fname,
+                        (unsigned long)(address - (uintptr_t)info.dli_fbase));
+    }
+    return snprintf(out, size, "0x%lx", (unsigned long)address);
+}
+
+typedef struct {
+    char *data;
+    size_t len;
+    size_t capacity;
+} Output;
+
+static bool output_reserve(Output *out, size_t more) {
+    if (out->len + more < out->capacity) return true;
+    size_t capacity = out->capacity ? out->capacity : 4096;
+    while (out->len + more >= capacity) capacity *= 2;
+    char *data = realloc(out->data, capacity);
+    if (!data) return false;
+    out->data = data;
+    out->capacity = capacity;
+    return true;
+}
+
+static bool append_stack(Output *out, const Sample *s, size_t count) {
+    for (int i = s->depth - 1; i >= PROFILER_SKIP_FRAMES; i--) {
+        if (!output_reserve(out, 512)) return false;
+        if (i < s->depth - 1) out->data[out->len++] = ';';
+        int n = frame_name(s->pc[i], i > PROFILER_SKIP_FRAMES, out->data + out->len, 500);
+        if (n > 0) out->len += n < 500 ? n : 499;
+    }
+    if (!output_reserve(out, 32)) return false;
+    out->len += snprintf(out->data + out->len, 32, " %zu\n", count);
+    return true;
+}
+
+static char *fold(size_t *len) {
+    size_t count = sample_count < sample_capacity ? sample_count : sample_capacity;
+    Sample **sorted = malloc((count ? count : 1) * sizeof(Sample *));
+    if (!sorted) return NULL;
+    size_t filled = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (__atomic_load_n(&samples[i].depth, __ATOMIC_ACQUIRE) > PROFILER_SKIP_FRAMES) {
+            sorted[filled++] = &samples[i];
+        }
+    }
+    qsort(sorted, filled, sizeof(Sample *), compare_samples);
+
+    Output out = {0};
+    bool ok = output_reserve(&out, 1);
+    for (size_t i = 0; ok && i < filled;) {
+        size_t same = 1;
+        while (i + same < filled && compare_samples(&sorted[i], &sorted[i + same]) == 0) same++;
+        ok = append_stack(&out, sorted[i], same);
+        i += same;
+    }
+    // Past the buffer: still visible in the flame graph
+    if (ok && sample_count > sample_capacity && output_reserve(&out, 64)) {
+        out.len += snprintf(out.data + out.len, 64, "[dropped] %zu\n", sample_count - sample_capacity);
+    }
+    free(sorted);
+    if (!ok) {
+        free(out.data);
+        return NULL;
+    }
+    out.data[out.len] = '\0';
+    *len = out.len;
+    return out.data;
+}
+
+bool Profiler_available(void) {
+    return true;
+}
+
+char *Profiler_run(int seconds, int hz, size_t *len) {
+    if (seconds < 1) seconds = 1;
+    if (seconds > PROFILER_MAX_SECONDS) seconds = PROFILER_MAX_SECONDS;
+    if (hz < 1) hz = 1;
+    if (hz > PROFILER_MAX_HZ) hz = PROFILER_MAX_HZ;
+
+    bool expected = false;
+    if (!__atomic_compare_exchange_n(&running, &expected, true, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        return NULL;
+    }
+
+    // Every CPU may be busy with a thread of this process
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t capacity = (size_t)seconds * hz * (cpus > 0 ? cpus : 1) + 64;
+    if (capacity > PROFILER_MAX_SAMPLES) capacity = PROFILER_MAX_SAMPLES;
+    samples = calloc(capacity, sizeof(Sample));
+
+    timer_t timer;
+    struct sigevent event;
+    memset(&event, 0, sizeof(event));
+    event.sigev_notify = SIGEV_SIGNAL;
+    event.sigev_signo = SIGPROF;
+    if (!samples || !install_handler() || timer_create(CLOCK_PROCESS_CPUTIME_ID, &event, &timer) != 0) {
+        perror("Failed to start the profiler");
+        free(samples);
+        samples = NULL;
+        __atomic_store_n(&running, false, __ATOMIC_RELEASE);
+        return NULL;
+    }
+
+    long interval_ns = 1000000000L / hz;
+    struct itimerspec spec = {
+        { interval_ns / 1000000000L, interval_ns % 1000000000L },
+        { interval_ns / 1000000000L, interval_ns % 1000000000L }
+    };
+    sample_capacity = capacity;
+    __atomic_store_n(&sample_count, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&sampling, true, __ATOMIC_RELEASE);
+    timer_settime(timer, 0, &spec, NULL);
+
+    sleep_seconds(seconds);
+
+    timer_delete(timer);
+    __atomic_store_n(&sampling, false, __ATOMIC_RELEASE);
+    // Lets a handler that already passed the check finish its backtrace
+    struct timespec settle = { 0, 10 * 1000000L };
+    nanosleep(&settle, NULL);
+
+    char *folded = fold(len);
+    free(samples);
+    samples = NULL;
+    sample_capacity = 0;
+    __atomic_store_n(&running, false, __ATOMIC_RELEASE);
+    return folded;
+}
+
+#else
+
+bool Profiler_available(void) {
+    return false;
+}
+
+char *Profiler_run(int seconds, int hz, size_t *len) {
+    (void)seconds;
+    (void)hz;
+    (void)len;
+    return NULL;
+}
+
+#endif
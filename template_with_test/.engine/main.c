@@ -1,28 +1,27 @@
 #include "HTTPFramework.h"
 #include "Routing/Routing.h"
+#include "ResponseCache/ResponseCache.h"
+#include "TLS/TLS.h"
+#include "Supervisor/Supervisor.h"
+#include "AccessLog/AccessLog.h"
+#include "Capture/Capture.h"
+#include "RequestQueue/RequestQueue.h"
+#include "Metrics/Metrics.h"
+#include "Profiler/Profiler.h"
+#include "WorkerStatus/WorkerStatus.h"
+#include "Trace/Trace.h"
 #include <stdio.h>
+#include <errno.h>
+#include <time.h>
 #include <string.h>
 #include <pthread.h>
 #include <stdlib.h>
 #include <stdbool.h>
+#include <limits.h>
 #include <signal.h>
 #include <unistd.h>
 #include <sys/wait.h>
 
-// Define the FIFO queue
-typedef struct RequestNode {
-    HTTPRequest request;
-    struct RequestNode *next;
-} RequestNode;
-
-typedef struct {
-    RequestNode *front;
-    RequestNode *rear;
-    pthread_mutex_t mutex;
-    pthread_cond_t cond;
-    bool stop; // Signal to stop the threads
-} RequestQueue;
-
 typedef struct {
     int thread_id;
 } WorkerContext;
@@ -31,108 +30,136 @@ typedef struct {
 RequestQueue queue;
 HTTPServer *server;
 
-// Initialize the request queue
-void init_queue(RequestQueue *q) {
-    q->front = q->rear = NULL;
-    pthread_mutex_init(&q->mutex, NULL);
-    pthread_cond_init(&q->cond, NULL);
-    q->stop = false;
+// Set by SIGTERM/SIGINT: the listening loop stops and the process drains
+static volatile sig_atomic_t draining = 0;
+
+// Keeps successful responses of routes with a cache_ttl and hands the
+// bytes to the identical requests that waited for this one
+static void cache_response(HTTPRequest *request, int status_code, const struct iovec *iov, int iov_count) {
+    const Route *route = request->response_ctx;
+    if (status_code == 200) {
+        ResponseCache_store(request, route->cache_ttl, route->cache_stale, iov, iov_count);
+    }
+    ResponseCache_complete(request, iov, iov_count);
 }
 
-// Add a request to the queue
-void enqueue(RequestQueue *q, HTTPRequest *request) {
-    RequestNode *node = malloc(sizeof(RequestNode));
-    if (!node) {
-        perror("Failed to allocate memory for request node");
+// Answers the metrics endpoint with the totals of every worker process
+static void serve_metrics(HTTPRequest *request) {
+    size_t len;
+    char *body = Metrics_render(&len);
+    if (!body) {
+        HTTPServer_send_response(request, "", "", 503, "Service Unavailable");
         return;
     }
-    node->request = *request; // Copy the request
-    node->next = NULL;
-
-    pthread_mutex_lock(&q->mutex);
+    struct iovec iov = { body, len };
+    HTTPServer_send_response_iov(request, &iov, 1, "text/plain; version=0.0.4", 200, "");
+    free(body);
+}
 
-    if (q->rear) {
-        q->rear->next = node;
-    } else {
-        q->front = node;
+// Answers the profiler endpoint with folded stacks of this worker process,
+// holding this worker thread for the whole profile
+static void serve_profile(HTTPRequest *request) {
+    if (!Profiler_available()) {
+        HTTPServer_send_response(request, "", "", 501, "Not Implemented");
+        return;
     }
-    q->rear = node;
-
-    pthread_cond_signal(&q->cond); // Signal a worker thread
-    pthread_mutex_unlock(&q->mutex);
+    int seconds = 10, hz = 99;
+    for (size_t i = 0; i < request->param_count; i++) {
+        if (strcmp(request->params[i].key, "seconds") == 0) seconds = atoi(request->params[i].value);
+        else if (strcmp(request->params[i].key, "hz") == 0) hz = atoi(request->params[i].value);
+    }
+    size_t len;
+    char *body = Profiler_run(seconds, hz, &len);
+    if (!body) {
+        // Another profile is running
+        HTTPServer_send_response(request, "", "", 503, "Service Unavailable");
+        return;
+    }
+    struct iovec iov = { body, len };
+    HTTPServer_send_response_iov(request, &iov, 1, "text/plain", 200, "");
+    free(body);
 }
 
-// Remove a request from the queue
-bool dequeue(RequestQueue *q, HTTPRequest *request) {
-    pthread_mutex_lock(&q->mutex);
-
-    while (q->front == NULL && !q->stop) {
-        pthread_cond_wait(&q->cond, &q->mutex);
+// Answers the workers endpoint from the accepting thread, which keeps
+// going when every worker thread is stuck
+static void serve_workers(HTTPRequest *request) {
+    size_t depth, len;
+    int64_t oldest;
+    queue_stats(&queue, &depth, &oldest);
+    char *body = WorkerStatus_render(depth, oldest, &len);
+    if (!body) {
+        HTTPServer_send_response(request, "", "", 503, "Service Unavailable");
+        return;
     }
+    struct iovec iov = { body, len };
+    HTTPServer_send_response_iov(request, &iov, 1, "application/json", 200, "");
+    free(body);
+}
 
-    if (q->stop && q->front == NULL) {
-        pthread_mutex_unlock(&q->mutex);
+// Capture, then what is answered without a worker: the workers endpoint
+// and fresh cached responses. True when the request was answered, and
+// freed. On the accepting thread (may_block false: large hits are left to
+// a worker), or the worker that read the request.
+static bool serve_without_worker(HTTPRequest *request, bool may_block) {
+    Capture_request(request);
+
+    if (strlen(WORKERS_PATH) > 0 && strcmp(request->path, WORKERS_PATH) == 0) {
+        serve_workers(request);
+        Metrics_end(request, METRICS_ROUTE_ADMIN);
+    } else if (ResponseCache_serve(request, may_block)) {
+        Metrics_end(request, METRICS_ROUTE_CACHE);
+    } else {
         return false;
     }
-
-    RequestNode *node = q->front;
-    *request = node->request; // Copy the request
-    q->front = node->next;
-
-    if (q->front == NULL) {
-        q->rear = NULL;
-    }
-
-    free(node);
-    pthread_mutex_unlock(&q->mutex);
+    AccessLog_request(request);
+    HTTPRequest_free(request);
     return true;
 }
 
-// Destroy the request queue
-void destroy_queue(RequestQueue *q) {
-    pthread_mutex_lock(&q->mutex);
-    q->stop = true;
-    pthread_cond_broadcast(&q->cond); // Wake up all waiting threads
-    pthread_mutex_unlock(&q->mutex);
-
-    while (q->front) {
-        RequestNode *node = q->front;
-        q->front = node->next;
-        HTTPRequest_free(&node->request);
-        free(node);
-    }
-
-    pthread_mutex_destroy(&q->mutex);
-    pthread_cond_destroy(&q->cond);
+static void run_handler(const Route *route, HTTPRequest *request, Database *db) {
+    int64_t started = HTTPServer_now_ns();
+    TRACE_PROBE2(handler_start, route->path, request->path);
+    route->handler(request, db);
+    HTTPRequest_add_phase(request, HTTP_PHASE_HANDLER, started);
+    TRACE_PROBE3(handler_end, route->path, request->path, request->status_code);
 }
 
-// Handle a single request
-void handle_request(HTTPRequest *request, Database *db) {
+// Handle a single request, returns the index of the route that answered it
+int handle_request(HTTPRequest *request, Database *db) {
+    if (strlen(METRICS_PATH) > 0 && strcmp(request->path, METRICS_PATH) == 0) {
+        serve_metrics(request);
+        return METRICS_ROUTE_ADMIN;
+    }
+    if (strlen(PROFILE_PATH) > 0 && strcmp(request->path, PROFILE_PATH) == 0) {
+        serve_profile(request);
+        return METRICS_ROUTE_ADMIN;
+    }
+    int64_t started = HTTPServer_now_ns();
     for (int i = 0; routes[i].path != NULL; i++) {
         if (route_match(routes[i].path, request->path, request)) {
-            // ---- Print query params ----
-            if (request->param_count > 0) {
-                printf("Query params:\n");
-                for (size_t j = 0; j < request->param_count; j++) {
-                    printf("  %s = %s\n",
-                        request->params[j].key   ? request->params[j].key   : "(null)",
-                        request->params[j].value ? request->params[j].value : "(null)");
-                }
-            }
-            // ---- Print headers ----
-            if (request->header_count > 0) {
-                printf("Headers:\n");
-                for (size_t j = 0; j < request->header_count; j++) {
-                    printf("  %s: %s\n",
-                        request->header_list[j].key   ? request->header_list[j].key   : "(null)",
-                        request->header_list[j].value ? request->header_list[j].value : "(null)");
-                }
+            HTTPRequest_add_phase(request, HTTP_PHASE_ROUTE, started);
+            TRACE_PROBE2(route_matched, routes[i].path, request->path);
+            if (routes[i].cache_ttl > 0 && ResponseCache_cacheable(request)) {
+                // Filled while queued, or already being rendered by another worker
+                if (ResponseCache_serve(request, true) || ResponseCache_join(request)) return i;
+
+                // The response is cached and shared with waiters, so it must be the
+                // full body; conditional requests are answered from the cache
+                HTTPRequest_remove_header(request, "If-None-Match");
+
+                request->on_response = cache_response;
+                request->response_ctx = &routes[i];
+                run_handler(&routes[i], request, db);
+                ResponseCache_abandon(request);
+                return i;
             }
-            routes[i].handler(request, db);
-            return;
+            run_handler(&routes[i], request, db);
+            return i;
         }
     }
+    HTTPRequest_add_phase(request, HTTP_PHASE_ROUTE, started);
     HTTPServer_send_response(request, "", "", 404, "<h1>404 Not Found</h1>");
+    return METRICS_ROUTE_UNMATCHED;
 }
 
 // Worker thread function
@@ -140,85 +167,156 @@ void *worker_thread(void *arg) {
     WorkerContext *ctx = (WorkerContext *)arg;
     int tid = ctx->thread_id;
     Database *thread_db = NULL;
+    WorkerStatus_attach(tid);
 
     while (true) {
         HTTPRequest request;
         if (!dequeue(&queue, &request)) break;
+        request.phase_ns[HTTP_PHASE_QUEUE] = HTTPServer_now_ns() - request.received_ns;
+        if (request.unread) {
+            WorkerStatus_reading(&request);
+            bool parsed = HTTPServer_read_request(&request);
+            WorkerStatus_end();
+            if (!parsed) {
+                HTTPRequest_free(&request);
+                continue;
+            }
+            if (serve_without_worker(&request, true)) continue;
+        }
 
         // Check if we need to (re)connect
         if (db_get_status(thread_db) != DB_STATUS_OK) {
             if (thread_db) {
                 printf("[thread %d] Connection stale, cleaning up...\n", tid);
+                Metrics_db_reconnect();
                 db_close(thread_db);
                 thread_db = NULL;
             }
             printf("[thread %d] Attempting DB connection...\n", tid);
-            if (!db_open(&thread_db)) {
+            WorkerStatus_connecting();
+            bool connected = db_open(&thread_db);
+            WorkerStatus_db_connected(connected);
+            WorkerStatus_end();
+            if (!connected) {
                 fprintf(stderr, "[thread %d] DB is down. 503 Sent.\n", tid);
                 HTTPServer_send_response(&request, "", "", 503, "Service Unavailable");
+                Metrics_end(&request, METRICS_ROUTE_UNMATCHED);
+                AccessLog_request(&request);
                 HTTPRequest_free(&request);
                 continue;
             }
         }
-        handle_request(&request, thread_db);
+        Metrics_gauge_add(METRICS_ACTIVE_WORKERS, 1);
+        Metrics_begin(&request);
+        WorkerStatus_begin(&request);
+        int route = handle_request(&request, thread_db);
+        WorkerStatus_end();
+        Metrics_end(&request, route);
+        Metrics_gauge_add(METRICS_ACTIVE_WORKERS, -1);
+        AccessLog_request(&request);
         HTTPRequest_free(&request);
     }
     if (thread_db) db_close(thread_db);
+
+    pthread_mutex_lock(&queue.mutex);
+    queue.running--;
+    pthread_cond_broadcast(&queue.cond);
+    pthread_mutex_unlock(&queue.mutex);
     return NULL;
 }
 
 // Signal handler for graceful shutdown
 void signal_handler(int sig) {
     if (sig == SIGINT || sig == SIGTERM) {
-        destroy_queue(&queue);
-        printf("Shutting down server...\n");
-        HTTPServer_destroy(server);
-        exit(0);
+        draining = 1;
+        if (server) HTTPServer_stop(server);
+        // The signal may land just before accept is entered: the alarm
+        // interrupts it again so the flag is seen
+        alarm(1);
     }
 }
 
-int run_worker() {
-    // Set up signal handling
-    signal(SIGINT, signal_handler);
-    signal(SIGTERM, signal_handler);
-
-    server = HTTPServer_create(SERVER_PORT);
-    if (!server) {
-        printf("Failed to create server\n");
-        return 1;
-    }
+// One worker process: the listen sockets come from main, already bound
+int run_worker(HTTPServer *listener, int index) {
+    server = listener;
+    printf("Worker process %d started (pid %d)\n", index, (int)getpid());
+
+    // Set up signal handling. No SA_RESTART: the signal must interrupt accept,
+    // which other signals (SIGPROF of a profile) only restart.
+    struct sigaction sa = {0};
+    sa.sa_handler = signal_handler;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    sigaction(SIGALRM, &sa, NULL);
+
+    // Per process: threads do not survive the fork
+    Metrics_attach(index);
+    AccessLog_start(ACCESS_LOG_LEVEL, ACCESS_LOG_SAMPLE, SLOW_REQUEST_MS, ACCESS_LOG_FILE);
+    char capture_path[PATH_MAX];
+    snprintf(capture_path, sizeof(capture_path), PREFORK_PROCESSES == 1 || !*CAPTURE_FILE ? "%s" : "%s.%d",
+             CAPTURE_FILE, index);
+    Capture_start(capture_path, CAPTURE_SAMPLE, CAPTURE_BODY_BYTES);
 
     // Initialize the request queue
     init_queue(&queue);
-
-    // Create a pool of worker threads
+    queue.running = NUM_WORKERS;
+    WorkerStatus_init(NUM_WORKERS);
+
+    // Create a pool of worker threads, with the signals left to this thread
+    sigset_t signals, previous_mask;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGALRM);
+    pthread_sigmask(SIG_BLOCK, &signals, &previous_mask);
     pthread_t workers[NUM_WORKERS];
     WorkerContext contexts[NUM_WORKERS];
     for (int i = 0; i < NUM_WORKERS; i++) {
         contexts[i].thread_id = i;
         pthread_create(&workers[i], NULL, worker_thread, &contexts[i]);
     }
+    pthread_sigmask(SIG_SETMASK, &previous_mask, NULL);
 
     // Listening loop
-    while (true) {
+    while (!draining) {
         HTTPRequest request = HTTPServer_listen(server);
 
+        // TLS handshake, or a client yet to send: read on a worker thread
+        if (request.unread) {
+            enqueue(&queue, &request);
+            continue;
+        }
         if (strlen(request.method) == 0) {
-            printf("Invalid Request\n");
+            if (!draining) printf("Invalid Request\n");
             HTTPRequest_free(&request);
             continue;
         }
-        enqueue(&queue, &request);
+
+        // Fresh cached responses never reach a worker
+        if (!serve_without_worker(&request, false)) enqueue(&queue, &request);
     }
 
-    // Cleanup (should not be reached but just in case)
-    destroy_queue(&queue);
+    // Stop accepting. Other processes sharing the sockets keep taking
+    // clients, a standalone worker refuses them from here on.
+    printf("Shutting down server...\n");
     HTTPServer_destroy(server);
 
+    if (!drain_queue(&queue, DRAIN_TIMEOUT_SECONDS)) {
+        fprintf(stderr, "Worker process %d: requests still running after %d s, dropping them\n",
+                index, DRAIN_TIMEOUT_SECONDS);
+        AccessLog_stop();
+        Capture_stop();
+        return 1;
+    }
     for (int i = 0; i < NUM_WORKERS; i++) {
         pthread_join(workers[i], NULL);
     }
-
+    destroy_queue(&queue);
+    AccessLog_stop();
+    Capture_stop();
+    TLS_cleanup();
+    printf("Worker process %d drained\n", index);
     return 0;
 }
 
@@ -228,26 +326,38 @@ int main() {
     load_config_from_env();
     bool in_container = (getpid() == 1);
 
-    if (in_container) {
-        // Docker: run worker directly, no supervisor
-        return run_worker();
-    }
-
-    while (1) {
-        pid_t pid = fork();
+    // A client hanging up mid-response (or before close_notify) must not kill us
+    signal(SIGPIPE, SIG_IGN);
 
-        if (pid == 0) {
-            // CHILD → run the server normally
-            exit(run_worker());
-        }
+    // Before any fork, so every worker process shares the session ticket keys
+    if (strlen(TLS_CERT_FILE) > 0 && !TLS_init(TLS_CERT_FILE, TLS_KEY_FILE)) {
+        printf("Failed to set up TLS\n");
+        return 1;
+    }
 
-        // PARENT → supervisor
-        int status;
-        waitpid(pid, &status, 0);
+    // Bound once: restarted workers inherit the same sockets, so the
+    // accept queue survives a crash, and a SIGHUP re-exec hands them over
+    HTTPServer *listener = Supervisor_inherited();
+    if (!listener) listener = HTTPServer_create(SERVER_PORT, UNIX_SOCKET_PATH);
+    if (!listener) {
+        printf("Failed to create server\n");
+        return 1;
+    }
 
-        printf("Worker died with status %d. Restarting in 1 second...\n", status);
+    // Mapped before the fork so every worker process records into it and a
+    // scrape of any one of them sees the totals. The acceptor records too.
+    static const char *route_names[256];
+    int route_count = 0;
+    while (route_count < 256 && routes[route_count].path) {
+        route_names[route_count] = routes[route_count].path;
+        route_count++;
+    }
+    int processes = PREFORK_PROCESSES > 0 ? PREFORK_PROCESSES : (int)sysconf(_SC_NPROCESSORS_CONF);
+    Metrics_init(processes, NUM_WORKERS + 1, route_names, route_count);
 
-        sleep(1);
+    if (in_container && PREFORK_PROCESSES == 1) {
+        // Docker: a single worker runs directly, no supervisor
+        return run_worker(listener, 0);
     }
+    return Supervisor_run(listener, PREFORK_PROCESSES, PREFORK_PIN, run_worker);
 }
-
@@ -0,0 +1,423 @@
+// Database layer benchmark on the models of tests/mock_models.c, against
+// the backend of tests/mock_config.c (a SQLite file, or the PostgreSQL of
+// docker-compose.postgres.yaml). Every case runs for a fixed time at each
+// concurrency level, one connection per thread as in the server, and
+// prints one JSON line:
+//
+//   {"backend":"sqlite","name":"point_read","threads":4,"ops":81234,"errors":0,
+//    "ops_per_sec":40617,"p50_us":21.3,"p99_us":88.0,"max_us":1503.2}
+//
+// point_read goes through db_query_params like the generated models, which
+// prepares the statement on every call; point_read_literal uses db_query
+// and point_read_cached a statement prepared once on a raw driver
+// connection, the lower bound for a statement cache in the DB layer.
+// Failed operations count as errors; on SQLite these are mostly concurrent
+// writers getting "database is locked".
+//
+//   dbbench [seconds] [rows] [threads,threads,...]
+#include "../.cache/models/User.h"
+#include "../.cache/models/Group.h"
+#include "../.engine/Database/Database.h"
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef DB_BACKEND_SQLITE
+#include <sqlite3.h>
+#define BACKEND "sqlite"
+#else
+#include <libpq-fe.h>
+#define BACKEND "postgres"
+#endif
+
+#define MAX_SAMPLES (1 << 20)
+#define BATCH 100
+#define MAX_LEVELS 8
+
+#define READ_SQL "SELECT \"DNI\", \"name\", \"age\", \"email\", \"group_id\" FROM \"User\" WHERE \"DNI\" = "
+
+typedef struct {
+    pthread_t thread;
+    int index;
+    Database *db;
+    unsigned seed;
+    long counter;           // for unique keys
+    User user;
+    User batch_items[BATCH];
+    char batch_keys[BATCH][48];
+    UserList batch;
+#ifdef DB_BACKEND_SQLITE
+    sqlite3 *raw;
+    sqlite3_stmt *cached;
+#else
+    PGconn *raw;
+#endif
+    int64_t *samples;
+    long ops;
+    long errors;
+} Worker;
+
+typedef struct {
+    const char *name;
+    bool (*setup)(Worker *w);       // untimed, once per thread
+    int64_t (*op)(Worker *w);       // the measured time in ns, -1 on error
+} Case;
+
+static int rows = 10000;
+static int group_id = 0;
+static double deadline;
+static const Case *current;
+
+static int64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void random_seed_key(Worker *w, char *key, size_t size) {
+    snprintf(key, size, "bench-seed-%d", rand_r(&w->seed) % rows);
+}
+
+// A batch of rows owned by this thread, new keys every call
+static void fill_batch(Worker *w) {
+    for (int i = 0; i < BATCH; i++) {
+        snprintf(w->batch_keys[i], sizeof(w->batch_keys[i]), "bench-t%d-%ld", w->index, w->counter++);
+        w->batch_items[i] = (User){ w->batch_keys[i], "Bench User", 30 + i % 40, "bench@example.com", group_id };
+    }
+    w->batch.items = w->batch_items;
+    w->batch.count = BATCH;
+}
+
+// ------------------------------------------------------------
+// Cases
+// ------------------------------------------------------------
+
+static int64_t point_read(Worker *w) {
+    char key[48];
+    random_seed_key(w, key, sizeof(key));
+    int64_t started = now_ns();
+    bool ok = User_read(w->db, key, &w->user);
+    return ok ? now_ns() - started : -1;
+}
+
+static int64_t point_read_literal(Worker *w) {
+    char key[48], sql[256];
+    random_seed_key(w, key, sizeof(key));
+    int64_t started = now_ns();
+    snprintf(sql, sizeof(sql), READ_SQL "'%s'", key);
+    DBResult *r;
+    if (!db_query(w->db, sql, &r)) return -1;
+    bool ok = db_result_next(r);
+    if (ok) {
+        free(db_result_string(r, 0));
+        free(db_result_string(r, 1));
+        w->user.age = db_result_int(r, 2);
+        free(db_result_string(r, 3));
+        w->user.group_id = db_result_int(r, 4);
+    }
+    db_result_free(r);
+    return ok ? now_ns() - started : -1;
+}
+
+#ifdef DB_BACKEND_SQLITE
+static bool open_cached(Worker *w) {
+    if (sqlite3_open(SQLITE_PATH, &w->raw) != SQLITE_OK) return false;
+    sqlite3_exec(w->raw, "PRAGMA journal_mode=WAL;", NULL, NULL, NULL);
+    return sqlite3_prepare_v2(w->raw, READ_SQL "?1", -1, &w->cached, NULL) == SQLITE_OK;
+}
+
+static int64_t point_read_cached(Worker *w) {
+    char key[48];
+    random_seed_key(w, key, sizeof(key));
+    int64_t started = now_ns();
+    sqlite3_bind_text(w->cached, 1, key, -1, SQLITE_TRANSIENT);
+    bool ok = sqlite3_step(w->cached) == SQLITE_ROW;
+    if (ok) {
+        free(strdup((const char *)sqlite3_column_text(w->cached, 0)));
+        free(strdup((const char *)sqlite3_column_text(w->cached, 1)));
+        w->user.age = sqlite3_column_int(w->cached, 2);
+        free(strdup((const char *)sqlite3_column_text(w->cached, 3)));
+        w->user.group_id = sqlite3_column_int(w->cached, 4);
+    }
+    sqlite3_reset(w->cached);
+    return ok ? now_ns() - started : -1;
+}
+#else
+static bool open_cached(Worker *w) {
+    char conninfo[1024];
+    snprintf(conninfo, sizeof(conninfo), "host=%s port=%d dbname=%s user=%s password=%s sslmode=%s",
+             PG_HOST, PG_PORT, PG_DBNAME, PG_USER, PG_PASSWORD, PG_SSLMODE);
+    w->raw = PQconnectdb(conninfo);
+    if (PQstatus(w->raw) != CONNECTION_OK) return false;
+    PGresult *res = PQprepare(w->raw, "bench_read", READ_SQL "$1", 1, NULL);
+    bool ok = PQresultStatus(res) == PGRES_COMMAND_OK;
+    PQclear(res);
+    return ok;
+}
+
+static int64_t point_read_cached(Worker *w) {
+    char key[48];
+    random_seed_key(w, key, sizeof(key));
+    const char *params[1] = { key };
+    int64_t started = now_ns();
+    PGresult *res = PQexecPrepared(w->raw, "bench_read", 1, params, NULL, NULL, 0);
+    bool ok = PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) == 1;
+    if (ok) {
+        free(strdup(PQgetvalue(res, 0, 0)));
+        free(strdup(PQgetvalue(res, 0, 1)));
+        w->user.age = atoi(PQgetvalue(res, 0, 2));
+        free(strdup(PQgetvalue(res, 0, 3)));
+        w->user.group_id = atoi(PQgetvalue(res, 0, 4));
+    }
+    PQclear(res);
+    return ok ? now_ns() - started : -1;
+}
+#endif
+
+static int64_t scan(Worker *w) {
+    UserList list = {0};
+    int64_t started = now_ns();
+    bool ok = User_read_all(w->db, &list);
+    int64_t elapsed = now_ns() - started;
+    UserList_free(&list);
+    return ok ? elapsed : -1;
+}
+
+static int64_t insert(Worker *w) {
+    char key[48];
+    snprintf(key, sizeof(key), "bench-t%d-%ld", w->index, w->counter++);
+    User u = { key, "Bench User", 42, "bench@example.com", group_id };
+    int64_t started = now_ns();
+    return User_create(w->db, &u) ? now_ns() - started : -1;
+}
+
+// The rows are deleted again, untimed, so the table keeps its size
+static int64_t create_many(Worker *w) {
+    fill_batch(w);
+    int64_t started = now_ns();
+    bool ok = User_create_many(w->db, &w->batch);
+    int64_t elapsed = now_ns() - started;
+    User_delete_many(w->db, &w->batch);
+    return ok ? elapsed : -1;
+}
+
+static bool create_batch(Worker *w) {
+    fill_batch(w);
+    return User_create_many(w->db, &w->batch);
+}
+
+static int64_t update_many(Worker *w) {
+    for (int i = 0; i < BATCH; i++) w->batch_items[i].age++;
+    int64_t started = now_ns();
+    return User_update_many(w->db, &w->batch) ? now_ns() - started : -1;
+}
+
+static int64_t delete_many(Worker *w) {
+    if (!create_batch(w)) return -1;
+    int64_t started = now_ns();
+    return User_delete_many(w->db, &w->batch) ? now_ns() - started : -1;
+}
+
+// Read-modify-write of one row in a transaction
+static int64_t transaction(Worker *w) {
+    char key[48];
+    random_seed_key(w, key, sizeof(key));
+    int64_t started = now_ns();
+    if (!db_begin(w->db)) return -1;
+    bool ok = User_read(w->db, key, &w->user);
+    if (ok) {
+        w->user.age = w->user.age % 90 + 1;
+        ok = User_update(w->db, &w->user);
+    }
+    if (!ok) {
+        db_rollback(w->db);
+        return -1;
+    }
+    return db_commit(w->db) ? now_ns() - started : -1;
+}
+
+static const Case cases[] = {
+    { "point_read", NULL, point_read },
+    { "point_read_literal", NULL, point_read_literal },
+    { "point_read_cached", open_cached, point_read_cached },
+    { "scan", NULL, scan },
+    { "insert", NULL, insert },
+    { "create_many", NULL, create_many },
+    { "update_many", create_batch, update_many },
+    { "delete_many", NULL, delete_many },
+    { "transaction", NULL, transaction },
+};
+
+// ------------------------------------------------------------
+// Runner
+// ------------------------------------------------------------
+
+static double now_seconds(void) {
+    return now_ns() / 1e9;
+}
+
+static void *worker_main(void *arg) {
+    Worker *w = arg;
+    if (current->setup && !current->setup(w)) {
+        w->errors++;
+        return NULL;
+    }
+    while (now_seconds() < deadline) {
+        int64_t elapsed = current->op(w);
+        if (elapsed < 0) {
+            w->errors++;
+            continue;
+        }
+        if (w->ops < MAX_SAMPLES) w->samples[w->ops] = elapsed;
+        w->ops++;
+    }
+    return NULL;
+}
+
+static int compare_int64(const void *a, const void *b) {
+    int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+    return (x > y) - (x < y);
+}
+
+static void close_worker(Worker *w) {
+#ifdef DB_BACKEND_SQLITE
+    if (w->cached) sqlite3_finalize(w->cached);
+    if (w->raw) sqlite3_close(w->raw);
+#else
+    if (w->raw) PQfinish(w->raw);
+#endif
+    User_free(&w->user);
+    db_close(w->db);
+    free(w->samples);
+}
+
+static void run_case(const Case *c, int threads, int seconds) {
+    Worker *workers = calloc(threads, sizeof(Worker));
+    for (int i = 0; i < threads; i++) {
+        workers[i].index = i;
+        workers[i].seed = 1234 + i;
+        workers[i].samples = malloc(MAX_SAMPLES * sizeof(int64_t));
+        if (!db_open(&workers[i].db)) {
+            fprintf(stderr, "%s: cannot open connection %d\n", c->name, i);
+            for (int j = 0; j < i; j++) close_worker(&workers[j]);
+            free(workers[i].samples);
+            free(workers);
+            return;
+        }
+    }
+
+    current = c;
+    double started = now_seconds();
+    deadline = started + seconds;
+    for (int i = 0; i < threads; i++) pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]);
+    long ops = 0, errors = 0, samples = 0;
+    for (int i = 0; i < threads; i++) {
+        pthread_join(workers[i].thread, NULL);
+        ops += workers[i].ops;
+        errors += workers[i].errors;
+    }
+    double elapsed = now_seconds() - started;
+
+    int64_t *all = malloc((ops ? ops : 1) * sizeof(int64_t));
+    for (int i = 0; i < threads; i++) {
+        long n = workers[i].ops < MAX_SAMPLES ? workers[i].ops : MAX_SAMPLES;
+        memcpy(all + samples, workers[i].samples, n * sizeof(int64_t));
+        samples += n;
+    }
+    qsort(all, samples, sizeof(int64_t), compare_int64);
+
+    printf("{\"backend\":\"%s\",\"name\":\"%s\",\"threads\":%d,\"ops\":%ld,\"errors\":%ld,\"ops_per_sec\":%.0f",
+           BACKEND, c->name, threads, ops, errors, ops / elapsed);
+    if (samples > 0) {
+        printf(",\"p50_us\":%.1f,\"p99_us\":%.1f,\"max_us\":%.1f", all[samples / 2] / 1e3,
+               all[samples * 99 / 100] / 1e3, all[samples - 1] / 1e3);
+    }
+    printf("}\n");
+    fflush(stdout);
+
+    // Rows written by the case, so every case sees the same table
+    db_exec(workers[0].db, "DELETE FROM \"User\" WHERE \"DNI\" LIKE 'bench-t%'");
+    for (int i = 0; i < threads; i++) close_worker(&workers[i]);
+    free(all);
+    free(workers);
+}
+
+// ------------------------------------------------------------
+// Data set
+// ------------------------------------------------------------
+
+static void remove_bench_rows(Database *db) {
+    db_exec(db, "DELETE FROM \"User\" WHERE \"DNI\" LIKE 'bench-%'");
+}
+
+static bool seed(Database *db) {
+    remove_bench_rows(db);
+    db_exec(db, "DELETE FROM \"Group\" WHERE \"name\" = 'bench'");
+    Group g = { .name = "bench", .num_members = rows };
+    GroupList groups = {0};
+    if (!Group_create(db, &g) || !Group_query_unsafe(db, "\"name\" = 'bench'", &groups) || groups.count == 0) {
+        GroupList_free(&groups);
+        return false;
+    }
+    group_id = groups.items[0].id;
+    GroupList_free(&groups);
+
+    User *items = malloc(1000 * sizeof(User));
+    char (*keys)[48] = malloc(1000 * sizeof(*keys));
+    bool ok = true;
+    for (int done = 0; ok && done < rows; done += 1000) {
+        UserList list = { items, 0 };
+        for (int i = done; i < rows && i < done + 1000; i++, list.count++) {
+            snprintf(keys[list.count], sizeof(keys[list.count]), "bench-seed-%d", i);
+            items[list.count] = (User){ keys[list.count], "Seeded User", 20 + i % 60, "seed@example.com", group_id };
+        }
+        ok = User_create_many(db, &list);
+    }
+    free(items);
+    free(keys);
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    int seconds = argc > 1 ? atoi(argv[1]) : 2;
+    if (argc > 2) rows = atoi(argv[2]);
+    int levels[MAX_LEVELS] = { 1, 4, 16 };
+    int level_count = 3;
+    if (argc > 3) {
+        level_count = 0;
+        for (char *p = argv[3]; *p && level_count < MAX_LEVELS; p = strchr(p, ',') ? strchr(p, ',') + 1 : p + strlen(p)) {
+            levels[level_count++] = atoi(p);
+        }
+    }
+    if (seconds <= 0 || rows <= 0) {
+        fprintf(stderr, "usage: %s [seconds] [rows] [threads,threads,...]\n", argv[0]);
+        return 2;
+    }
+
+    Database *db;
+    if (!db_open(&db)) {
+        fprintf(stderr, "cannot connect to the %s database of tests/mock_config.c\n", BACKEND);
+        return 1;
+    }
+    fprintf(stderr, "Seeding %d users...\n", rows);
+    if (!seed(db)) {
+        fprintf(stderr, "seeding failed, run make test_migrate first\n");
+        db_close(db);
+        return 1;
+    }
+
+    for (size_t c = 0; c < sizeof(cases) / sizeof(cases[0]); c++) {
+        for (int l = 0; l < level_count; l++) {
+            if (levels[l] > 0) run_case(&cases[c], levels[l], seconds);
+        }
+    }
+
+    remove_bench_rows(db);
+    db_exec(db, "DELETE FROM \"Group\" WHERE \"name\" = 'bench'");
+    db_close(db);
+    return 0;
+}
@@ -0,0 +1,518 @@
+// HTTP load generator replaying a JSONL file of requests, one object per
+// line (only path is required, gap_ms is the time since the previous
+// request):
+//
+//   {"method":"POST","path":"/items","query":"page=2","headers":{"Accept":"*/*"},"body":"a=1","gap_ms":12.5}
+//
+// Closed loop (default): each connection sends its next request as soon as
+// the previous response is in; latency is the time of one exchange.
+// Open loop (-r): requests are due at a fixed rate, or at the recorded gaps
+// with -r recorded, whatever the responses. Latency counts from when a
+// request was due, so a stalled server is charged for every request it
+// held up instead of hiding them (coordinated omission).
+// With -j name the summary is one JSON line instead (see make perf):
+//
+//   {"name":"static","responses":51234,"status_errors":0,"failed":0,"req_per_sec":10245,
+//    "p50_ms":0.712,"p99_ms":2.104,"p999_ms":4.880,"max_ms":9.021}
+//
+//   loadgen [-c connections] [-d seconds] [-r rate|recorded] [-k] [-j name] <host> <port> <requests.jsonl>
+//
+// -k keeps connections open for servers that support it. This engine does
+// not: it answers with Connection: close and closes after every response,
+// so against it -k changes nothing but the Connection header sent.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <strings.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#define MAX_SAMPLES (1 << 20)
+#define MAX_LINE (1 << 20)
+
+typedef struct {
+    char *data;             // the raw request, Host and Connection included
+    size_t len;
+    double due_s;           // offset in the recorded timeline
+} Request;
+
+typedef struct {
+    pthread_t thread;
+    double *latencies_ms;
+    long completed;         // responses read, any status
+    long errors;            // status >= 400
+    long failed;            // connect, write or read errors
+} Worker;
+
+static const char *host;
+static const char *port;
+static struct addrinfo *address;
+static Request *requests;
+static long request_count;
+static double timeline_s;   // one pass over the recorded gaps
+static bool keep_alive = false;
+static bool recorded = false;
+static double rate = 0;     // requests per second, 0 for a closed loop
+static double start;
+static double deadline;
+static long next_slot = 0;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void sleep_until(double t) {
+    struct timespec ts = { (time_t)t, (long)((t - (time_t)t) * 1e9) };
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {}
+}
+
+// ------------------------------------------------------------
+// JSONL: flat objects of strings, a headers object and numbers
+// ------------------------------------------------------------
+
+static void skip_ws(const char **p) {
+    while (**p == ' ' || **p == '\t' || **p == '\r' || **p == '\n') (*p)++;
+}
+
+// Decodes a string starting at its opening quote, NULL if malformed.
+// \u escapes outside ASCII are written as UTF-8.
+static char *parse_string(const char **p) {
+    if (**p != '"') return NULL;
+    const char *s = ++*p;
+    char *out = malloc(strlen(s) + 1);
+    size_t n = 0;
+    while (*s && *s != '"') {
+        if (*s != '\\') {
+            out[n++] = *s++;
+            continue;
+        }
+        s++;
+        switch (*s) {
+            case 'n': out[n++] = '\n'; break;
+            case 'r': out[n++] = '\r'; break;
+            case 't': out[n++] = '\t'; break;
+            case 'b': out[n++] = '\b'; break;
+            case 'f': out[n++] = '\f'; break;
+            case 'u': {
+                unsigned code = 0;
+                for (int i = 1; i <= 4; i++) {
+                    char c = s[i];
+                    int digit = (c >= '0' && c <= '9') ? c - '0' : (c | 0x20) >= 'a' && (c | 0x20) <= 'f' ? (c | 0x20) - 'a' + 10 : -1;
+                    if (digit < 0) {
+                        free(out);
+                        return NULL;
+                    }
+                    code = code * 16 + digit;
+                }
+                if (code < 0x80) {
+                    out[n++] = code;
+                } else if (code < 0x800) {
+                    out[n++] = 0xC0 | (code >> 6);
+                    out[n++] = 0x80 | (code & 0x3F);
+                } else {
+                    out[n++] = 0xE0 | (code >> 12);
+                    out[n++] = 0x80 | ((code >> 6) & 0x3F);
+                    out[n++] = 0x80 | (code & 0x3F);
+                }
+                s += 4;
+                break;
+            }
+            case '\0': free(out); return NULL;
+            default: out[n++] = *s; break;      // \" \\ \/
+        }
+        s++;
+    }
+    if (*s != '"') {
+        free(out);
+        return NULL;
+    }
+    out[n] = '\0';
+    *p = s + 1;
+    return out;
+}
+
+// Skips the value of a key we do not use, up to the separator after it
+static bool skip_value(const char **p) {
+    int depth = 0;
+    while (**p) {
+        if (**p == '"') {
+            char *s = parse_string(p);
+            if (!s) return false;
+            free(s);
+            continue;
+        }
+        if (depth == 0 && (**p == ',' || **p == '}' || **p == ']')) return true;
+        if (**p == '{' || **p == '[') depth++;
+        else if (**p == '}' || **p == ']') depth--;
+        (*p)++;
+    }
+    return false;
+}
+
+typedef struct {
+    char *method, *path, *query, *body;
+    char headers[8192];     // "Name: value\r\n" lines
+    size_t headers_len;
+    double gap_ms;
+} Entry;
+
+static bool parse_headers(const char **p, Entry *e) {
+    (*p)++;
+    skip_ws(p);
+    while (**p == '"') {
+        char *name = parse_string(p);
+        skip_ws(p);
+        if (!name || **p != ':') {
+            free(name);
+            return false;
+        }
+        (*p)++;
+        skip_ws(p);
+        char *value = parse_string(p);
+        if (!value) {
+            free(name);
+            return false;
+        }
+        // The generator sets these itself
+        if (strcasecmp(name, "Host") != 0 && strcasecmp(name, "Connection") != 0 &&
+            strcasecmp(name, "Content-Length") != 0) {
+            int n = snprintf(e->headers + e->headers_len, sizeof(e->headers) - e->headers_len,
+                             "%s: %s\r\n", name, value);
+            if (n > 0 && (size_t)n < sizeof(e->headers) - e->headers_len) e->headers_len += n;
+        }
+        free(name);
+        free(value);
+        skip_ws(p);
+        if (**p == ',') {
+            (*p)++;
+            skip_ws(p);
+        }
+    }
+    if (**p != '}') return false;
+    (*p)++;
+    return true;
+}
+
+static bool parse_entry(const char *line, Entry *e) {
+    const char *p = line;
+    skip_ws(&p);
+    if (*p != '{') return false;
+    p++;
+    skip_ws(&p);
+    while (*p == '"') {
+        char *key = parse_string(&p);
+        skip_ws(&p);
+        if (!key || *p != ':') {
+            free(key);
+            return false;
+        }
+        p++;
+        skip_ws(&p);
+        bool ok = true;
+        char **field = strcmp(key, "method") == 0 ? &e->method :
+                       strcmp(key, "path") == 0 ? &e->path :
+                       strcmp(key, "query") == 0 ? &e->query :
+                       strcmp(key, "body") == 0 ? &e->body : NULL;
+        if (field && *p == '"') {
+            free(*field);
+            ok = (*field = parse_string(&p)) != NULL;
+        } else if (strcmp(key, "headers") == 0 && *p == '{') {
+            ok = parse_headers(&p, e);
+        } else if (strcmp(key, "gap_ms") == 0) {
+            char *end;
+            e->gap_ms = strtod(p, &end);
+            ok = end != p;
+            p = end;
+        } else {
+            ok = skip_value(&p);
+        }
+        free(key);
+        if (!ok) return false;
+        skip_ws(&p);
+        if (*p == ',') {
+            p++;
+            skip_ws(&p);
+        }
+    }
+    return *p == '}' && e->path;
+}
+
+static bool load_requests(const char *file) {
+    FILE *f = fopen(file, "r");
+    if (!f) {
+        perror(file);
+        return false;
+    }
+    char *line = malloc(MAX_LINE);
+    long capacity = 64, line_number = 0;
+    requests = malloc(capacity * sizeof(Request));
+    double due = 0;
+    while (fgets(line, MAX_LINE, f)) {
+        line_number++;
+        const char *p = line;
+        skip_ws(&p);
+        if (*p == '\0') continue;
+
+        Entry e = {0};
+        if (!parse_entry(line, &e)) {
+            fprintf(stderr, "%s:%ld: not a request, skipped\n", file, line_number);
+        } else {
+            size_t body_len = e.body ? strlen(e.body) : 0;
+            size_t size = strlen(e.path) + (e.query ? strlen(e.query) : 0) + e.headers_len + body_len + 512;
+            if (request_count == capacity) requests = realloc(requests, (capacity *= 2) * sizeof(Request));
+            Request *r = &requests[request_count++];
+            r->data = malloc(size);
+            int n = snprintf(r->data, size, "%s %s%s%s HTTP/1.1\r\nHost: %s:%s\r\n%s",
+                             e.method ? e.method : "GET", e.path, e.query && *e.query ? "?" : "",
+                             e.query ? e.query : "", host, port, e.headers);
+            if (body_len > 0) n += snprintf(r->data + n, size - n, "Content-Length: %zu\r\n", body_len);
+            n += snprintf(r->data + n, size - n, "Connection: %s\r\n\r\n", keep_alive ? "keep-alive" : "close");
+            if (body_len > 0) memcpy(r->data + n, e.body, body_len);
+            r->len = n + body_len;
+            due += e.gap_ms > 0 ? e.gap_ms / 1000 : 0;
+            r->due_s = due;
+        }
+        free(e.method);
+        free(e.path);
+        free(e.query);
+        free(e.body);
+    }
+    free(line);
+    fclose(f);
+    timeline_s = due;
+    if (request_count == 0) fprintf(stderr, "%s: no requests\n", file);
+    return request_count > 0;
+}
+
+// ------------------------------------------------------------
+// Connections
+// ------------------------------------------------------------
+
+static int open_connection(void) {
+    int fd = socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+    if (fd < 0) return -1;
+    if (connect(fd, address->ai_addr, address->ai_addrlen) < 0) {
+        close(fd);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+static bool write_all(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+// Reads one response, the body up to Content-Length or until the server
+// closes. Returns the status, 0 on error; *reusable when the connection
+// can carry the next request.
+static int read_response(int fd, bool *reusable) {
+    char buf[16384];
+    size_t len = 0;
+    char *end = NULL;
+    *reusable = false;
+    while (!end) {
+        if (len == sizeof(buf) - 1) return 0;
+        ssize_t n = recv(fd, buf + len, sizeof(buf) - 1 - len, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return 0;
+        len += n;
+        buf[len] = '\0';
+        end = strstr(buf, "\r\n\r\n");
+    }
+    int status = 0;
+    if (sscanf(buf, "HTTP/1.%*d %d", &status) != 1) return 0;
+
+    long content_length = -1;
+    bool closing = false;
+    for (char *line = strstr(buf, "\r\n"); line && line < end; line = strstr(line + 2, "\r\n")) {
+        if (strncasecmp(line + 2, "Content-Length:", 15) == 0) content_length = atol(line + 17);
+        if (strncasecmp(line + 2, "Connection: close", 17) == 0) closing = true;
+    }
+
+    size_t body = len - (end + 4 - buf);
+    while (content_length < 0 || body < (size_t)content_length) {
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return 0;
+        if (n == 0) {
+            if (content_length >= 0) return 0;
+            break;
+        }
+        body += n;
+    }
+    *reusable = keep_alive && !closing && content_length >= 0;
+    return status;
+}
+
+// Whether an idle kept-alive connection was closed by the server, or got
+// bytes nobody asked for: either way it cannot carry the next request
+static bool peer_closed(int fd) {
+    char c;
+    ssize_t n = recv(fd, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+    return n >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR);
+}
+
+static void *worker_main(void *arg) {
+    Worker *w = arg;
+    int fd = -1;
+
+    while (true) {
+        long slot = __atomic_fetch_add(&next_slot, 1, __ATOMIC_RELAXED);
+        const Request *r = &requests[slot % request_count];
+        double due;
+        if (recorded) due = start + (slot / request_count) * timeline_s + r->due_s;
+        else if (rate > 0) due = start + slot / rate;
+        else due = now_seconds();
+        if (due >= deadline || now_seconds() >= deadline) break;
+        if (recorded || rate > 0) sleep_until(due);
+
+        // A kept-alive connection the server closed is reopened up front,
+        // one it closes while the request is sent gets one retry
+        if (fd >= 0 && peer_closed(fd)) {
+            close(fd);
+            fd = -1;
+        }
+        int status = 0;
+        bool reusable = false;
+        for (int attempt = 0; attempt < 2 && status == 0; attempt++) {
+            bool reused = fd >= 0;
+            if (fd < 0) fd = open_connection();
+            if (fd >= 0 && write_all(fd, r->data, r->len)) status = read_response(fd, &reusable);
+            if (status == 0 || !reusable) {
+                if (fd >= 0) close(fd);
+                fd = -1;
+            }
+            if (!reused) break;
+        }
+        if (status == 0) {
+            w->failed++;
+            continue;
+        }
+        if (w->completed < MAX_SAMPLES) w->latencies_ms[w->completed] = (now_seconds() - due) * 1000;
+        w->completed++;
+        if (status >= 400) w->errors++;
+    }
+    if (fd >= 0) close(fd);
+    return NULL;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void usage(const char *name) {
+    fprintf(stderr, "usage: %s [-c connections] [-d seconds] [-r rate|recorded] [-k] [-j name] <host> <port> <requests.jsonl>\n", name);
+}
+
+int main(int argc, char **argv) {
+    int connections = 16;
+    int seconds = 10;
+    const char *json_name = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "c:d:r:kj:")) != -1) {
+        switch (opt) {
+            case 'c': connections = atoi(optarg); break;
+            case 'd': seconds = atoi(optarg); break;
+            case 'r':
+                if (strcmp(optarg, "recorded") == 0) recorded = true;
+                else rate = atof(optarg);
+                break;
+            case 'k': keep_alive = true; break;
+            case 'j': json_name = optarg; break;
+            default: usage(argv[0]); return 2;
+        }
+    }
+    if (argc - optind != 3) {
+        usage(argv[0]);
+        return 2;
+    }
+    host = argv[optind];
+    port = argv[optind + 1];
+    if (connections <= 0 || seconds <= 0 || rate < 0) {
+        fprintf(stderr, "connections, seconds and rate must be positive\n");
+        return 2;
+    }
+    if (!load_requests(argv[optind + 2])) return 1;
+    if (recorded && timeline_s <= 0) {
+        fprintf(stderr, "-r recorded needs gap_ms in the requests\n");
+        return 2;
+    }
+
+    struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM };
+    if (getaddrinfo(host, port, &hints, &address) != 0) {
+        fprintf(stderr, "cannot resolve %s:%s\n", host, port);
+        return 1;
+    }
+
+    Worker *workers = calloc(connections, sizeof(Worker));
+    start = now_seconds();
+    deadline = start + seconds;
+    for (int i = 0; i < connections; i++) {
+        workers[i].latencies_ms = malloc(MAX_SAMPLES * sizeof(double));
+        pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]);
+    }
+
+    long completed = 0, errors = 0, failed = 0, samples = 0;
+    for (int i = 0; i < connections; i++) {
+        pthread_join(workers[i].thread, NULL);
+        completed += workers[i].completed;
+        errors += workers[i].errors;
+        failed += workers[i].failed;
+    }
+    double elapsed = now_seconds() - start;
+
+    double *all = malloc((completed ? completed : 1) * sizeof(double));
+    for (int i = 0; i < connections; i++) {
+        long n = workers[i].completed < MAX_SAMPLES ? workers[i].completed : MAX_SAMPLES;
+        memcpy(all + samples, workers[i].latencies_ms, n * sizeof(double));
+        samples += n;
+        free(workers[i].latencies_ms);
+    }
+    qsort(all, samples, sizeof(double), compare_double);
+
+    if (json_name) {
+        printf("{\"name\":\"%s\",\"responses\":%ld,\"status_errors\":%ld,\"failed\":%ld,\"req_per_sec\":%.0f",
+               json_name, completed, errors, failed, completed / elapsed);
+        if (samples > 0) {
+            printf(",\"p50_ms\":%.3f,\"p99_ms\":%.3f,\"p999_ms\":%.3f,\"max_ms\":%.3f", all[samples / 2],
+                   all[samples * 99 / 100], all[samples * 999 / 1000], all[samples - 1]);
+        }
+        printf("}\n");
+    } else {
+        if (recorded) printf("mode:      open loop at the recorded gaps, %d connections\n", connections);
+        else if (rate > 0) printf("mode:      open loop at %.0f req/s, %d connections\n", rate, connections);
+        else printf("mode:      closed loop, %d connections\n", connections);
+        printf("requests:  %ld responses (%ld status >= 400), %ld failed in %.1fs (%.0f req/s)\n",
+               completed, errors, failed, elapsed, completed / elapsed);
+        if (samples > 0) {
+            printf("latency:   p50 %.2fms  p99 %.2fms  p99.9 %.2fms  max %.2fms\n",
+                   all[samples / 2], all[samples * 99 / 100], all[samples * 999 / 1000], all[samples - 1]);
+        }
+    }
+
+    free(all);
+    free(workers);
+    for (long i = 0; i < request_count; i++) free(requests[i].data);
+    free(requests);
+    freeaddrinfo(address);
+    return failed > 0 && completed == 0;
+}
@@ -0,0 +1,146 @@
+// Compares a make perf run with a baseline, both JSON lines of
+// loadgen -j: a scenario regresses when its p99 is more than threshold
+// percent above the baseline or its throughput more than threshold
+// percent below it, or when its share of failed and >= 400 responses grows
+// by more than a point (failures answer fast and would pass for a
+// speedup). A scenario run several times is compared by its medians.
+// Exits 1 on any regression, so it can gate a change.
+//
+//   perfcheck <baseline.json> <results.json> [threshold_percent]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+
+#define MAX_SCENARIOS 64
+#define MAX_ROUNDS 16
+
+typedef struct {
+    char name[64];
+    int rounds;
+    double req_per_sec[MAX_ROUNDS];
+    double p99_ms[MAX_ROUNDS];
+    double error_rate[MAX_ROUNDS];  // failed and status >= 400 per request sent
+} Scenario;
+
+typedef struct {
+    const char *name;
+    double req_per_sec;
+    double p99_ms;
+    double error_rate;
+} Result;
+
+static bool field(const char *line, const char *key, double *out) {
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    const char *p = strstr(line, pattern);
+    if (!p) return false;
+    *out = atof(p + strlen(pattern));
+    return true;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double median(const double *values, int count) {
+    double sorted[MAX_ROUNDS];
+    memcpy(sorted, values, count * sizeof(double));
+    qsort(sorted, count, sizeof(double), compare_double);
+    return count % 2 ? sorted[count / 2] : (sorted[count / 2 - 1] + sorted[count / 2]) / 2;
+}
+
+// One Result per scenario name, in order of first appearance
+static int load(const char *file, Scenario *scenarios, Result *results) {
+    FILE *f = fopen(file, "r");
+    if (!f) {
+        perror(file);
+        return -1;
+    }
+    char line[1024];
+    int count = 0;
+    while (fgets(line, sizeof(line), f)) {
+        const char *name = strstr(line, "\"name\":\"");
+        double req_per_sec, p99_ms, responses = 0, status_errors = 0, failed = 0;
+        if (!name || !field(line, "req_per_sec", &req_per_sec) || !field(line, "p99_ms", &p99_ms)) continue;
+        name += strlen("\"name\":\"");
+        size_t len = strcspn(name, "\"");
+        if (len >= sizeof(scenarios[0].name)) len = sizeof(scenarios[0].name) - 1;
+
+        int i = 0;
+        while (i < count && (strlen(scenarios[i].name) != len || strncmp(scenarios[i].name, name, len) != 0)) i++;
+        if (i == count) {
+            if (count == MAX_SCENARIOS) continue;
+            memset(&scenarios[i], 0, sizeof(Scenario));
+            memcpy(scenarios[i].name, name, len);
+            count++;
+        }
+        Scenario *s = &scenarios[i];
+        if (s->rounds == MAX_ROUNDS) continue;
+        field(line, "responses", &responses);
+        field(line, "status_errors", &status_errors);
+        field(line, "failed", &failed);
+        s->req_per_sec[s->rounds] = req_per_sec;
+        s->p99_ms[s->rounds] = p99_ms;
+        s->error_rate[s->rounds] = responses + failed > 0 ? (status_errors + failed) / (responses + failed) : 0;
+        s->rounds++;
+    }
+    fclose(f);
+
+    for (int i = 0; i < count; i++) {
+        results[i] = (Result){ scenarios[i].name, median(scenarios[i].req_per_sec, scenarios[i].rounds),
+                               median(scenarios[i].p99_ms, scenarios[i].rounds),
+                               median(scenarios[i].error_rate, scenarios[i].rounds) };
+    }
+    return count;
+}
+
+static const Result *find(const Result *results, int count, const char *name) {
+    for (int i = 0; i < count; i++) {
+        if (strcmp(results[i].name, name) == 0) return &results[i];
+    }
+    return NULL;
+}
+
+static double change(double now, double before) {
+    return before > 0 ? (now - before) / before * 100 : 0;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s <baseline.json> <results.json> [threshold_percent]\n", argv[0]);
+        return 2;
+    }
+    double threshold = argc > 3 ? atof(argv[3]) : 10;
+    static Scenario baseline_runs[MAX_SCENARIOS], result_runs[MAX_SCENARIOS];
+    Result baseline[MAX_SCENARIOS], results[MAX_SCENARIOS];
+    int baseline_count = load(argv[1], baseline_runs, baseline);
+    int result_count = load(argv[2], result_runs, results);
+    if (baseline_count < 0 || result_count <= 0) return 2;
+
+    int regressions = 0;
+    printf("%-12s %12s %8s %12s %8s\n", "scenario", "req/s", "change", "p99 ms", "change");
+    for (int i = 0; i < result_count; i++) {
+        const Result *now = &results[i];
+        const Result *before = find(baseline, baseline_count, now->name);
+        if (!before) {
+            printf("%-12s %12.0f %8s %12.3f %8s  no baseline\n", now->name, now->req_per_sec, "", now->p99_ms, "");
+            continue;
+        }
+        double throughput = change(now->req_per_sec, before->req_per_sec);
+        double p99 = change(now->p99_ms, before->p99_ms);
+        bool slower = throughput < -threshold || p99 > threshold;
+        bool failing = now->error_rate > before->error_rate + 0.01;
+        printf("%-12s %12.0f %+7.1f%% %12.3f %+7.1f%%%s%s\n", now->name, now->req_per_sec, throughput,
+               now->p99_ms, p99, slower ? "  REGRESSION" : "", failing ? "  MORE ERRORS" : "");
+        if (slower || failing) regressions++;
+    }
+
+    if (regressions > 0) {
+        printf("%d of %d scenarios regressed beyond %.0f%%\n", regressions, result_count, threshold);
+        return 1;
+    }
+    printf("No regression beyond %.0f%%\n", threshold);
+    return 0;
+}
@@ -1,9 +1,10 @@
 #include<views.c>
 
 Route routes[] = {
-	{"/", home},
-  {"/wait", wait},
-  {"/create-user", create_user_view},
-  {"/user/<DNI>/profile", create_user_view},
-  {"/example", example}
+	{"/", home, 5, 30},
+  {"/wait", wait, 0, 0},
+  {"/create-user", create_user_view, 0, 0},
+  {"/user/<DNI>/profile", create_user_view, 0, 0},
+  {"/example", example, 5, 30},
+  {NULL, NULL, 0, 0}
 };
@@ -0,0 +1,155 @@
+#include "unity/unity.h"
+#include "../.engine/AccessLog/AccessLog.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static char log_path[64];
+static char contents[1 << 20];
+
+void setUp(void) {
+    snprintf(log_path, sizeof(log_path), "/tmp/test_access_log.%d.log", (int)getpid());
+    unlink(log_path);
+}
+
+void tearDown(void) {
+    AccessLog_stop();
+    unlink(log_path);
+}
+
+static int read_log(void) {
+    FILE *f = fopen(log_path, "r");
+    if (!f) return 0;
+    size_t len = fread(contents, 1, sizeof(contents) - 1, f);
+    contents[len] = '\0';
+    fclose(f);
+
+    int lines = 0;
+    for (char *p = contents; (p = strchr(p, '\n')); p++) lines++;
+    return lines;
+}
+
+static HTTPRequest make_request(const char *path, int status) {
+    HTTPRequest request = {0};
+    strcpy(request.method, "GET");
+    request.path = (char *)path;
+    request.status_code = status;
+    request.response_bytes = 512;
+    request.received_ns = HTTPServer_now_ns() - 1500000;
+    return request;
+}
+
+void test_Line_Format(void) {
+    TEST_ASSERT_TRUE(AccessLog_start(ACCESS_LOG_ALL, 1, 0, log_path));
+    HTTPRequest request = make_request("/items", 200);
+    AccessLog_request(&request);
+    AccessLog_stop();
+
+    TEST_ASSERT_EQUAL_INT(1, read_log());
+    // 2026-01-31T12:00:00.123Z t0 GET /items 200 512 1.500ms
+    TEST_ASSERT_EQUAL_CHAR('T', contents[10]);
+    TEST_ASSERT_EQUAL_CHAR('Z', contents[23]);
+    TEST_ASSERT_NOT_NULL(strstr(contents, " GET /items 200 512 1."));
+    TEST_ASSERT_NOT_NULL(strstr(contents, "ms\n"));
+}
+
+void test_Errors_Only_And_Sampling(void) {
+    TEST_ASSERT_TRUE(AccessLog_start(ACCESS_LOG_ERRORS, 1, 0, log_path));
+    HTTPRequest ok = make_request("/ok", 200);
+    HTTPRequest missing = make_request("/missing", 404);
+    AccessLog_request(&ok);
+    AccessLog_request(&missing);
+    AccessLog_stop();
+    TEST_ASSERT_EQUAL_INT(1, read_log());
+    TEST_ASSERT_NOT_NULL(strstr(contents, "/missing 404"));
+
+    // 1 in 4 successes, every error
+    unlink(log_path);
+    TEST_ASSERT_TRUE(AccessLog_start(ACCESS_LOG_ALL, 4, 0, log_path));
+    for (int i = 0; i < 40; i++) AccessLog_request(&ok);
+    AccessLog_request(&missing);
+    AccessLog_stop();
+    TEST_ASSERT_EQUAL_INT(11, read_log());
+}
+
+void test_Verbose_Adds_Query_And_Headers(void) {
+    TEST_ASSERT_TRUE(AccessLog_start(ACCESS_LOG_VERBOSE, 1, 0, log_path));
+    HTTPRequest request = make_request("/search", 200);
+    request.query = "q=shoes";
+    HTTPRequest_add_header(&request, "Host", "shop");
+    HTTPRequest_add_header(&request, "Accept", "*/*");
+    AccessLog_request(&request);
+    AccessLog_stop();
+
+    read_log();
+    TEST_ASSERT_NOT_NULL(strstr(contents, "ms ?q=shoes {Host: shop, Accept: */*}\n"));
+    request.path = NULL;
+    request.query = NULL;
+    HTTPRequest_free(&request);
+}
+
+void test_Slow_Requests_Logged_With_Phases(void) {
+    // Logged even with the log off; 1.5ms since accept in make_request
+    TEST_ASSERT_TRUE(AccessLog_start(ACCESS_LOG_OFF, 1, 1, log_path));
+    HTTPRequest slow = make_request("/report", 200);
+    slow.phase_ns[HTTP_PHASE_QUEUE] = 250000;
+    slow.phase_ns[HTTP_PHASE_DB] = 1000000;
+    HTTPRequest fast = make_request("/fast", 200);
+    fast.received_ns = HTTPServer_now_ns();
+    AccessLog_request(&slow);
+    AccessLog_request(&fast);
+    AccessLog_stop();
+
+    TEST_ASSERT_EQUAL_INT(1, read_log());
+    TEST_ASSERT_NOT_NULL(strstr(contents, " GET /report 200 512 1."));
+    TEST_ASSERT_NOT_NULL(strstr(contents, "ms slow queue=0.250ms route=0.000ms handler=0.000ms db=1.000ms"
+                                          " render=0.000ms write=0.000ms\n"));
+}
+
+static void *log_many(void *arg) {
+    HTTPRequest request = make_request(arg, 200);
+    for (int i = 0; i < 500; i++) AccessLog_request(&request);
+    return NULL;
+}
+
+void test_Threads_Get_Their_Own_Ring(void) {
+    TEST_ASSERT_TRUE(AccessLog_start(ACCESS_LOG_ALL, 1, 0, log_path));
+    uint64_t dropped_before = AccessLog_dropped();
+    pthread_t threads[4];
+    const char *paths[4] = {"/a", "/b", "/c", "/d"};
+    for (int i = 0; i < 4; i++) pthread_create(&threads[i], NULL, log_many, (void *)paths[i]);
+    for (int i = 0; i < 4; i++) pthread_join(threads[i], NULL);
+    AccessLog_stop();
+
+    // Each ring holds more than one thread writes here, nothing is lost
+    TEST_ASSERT_EQUAL_UINT64(dropped_before, AccessLog_dropped());
+    TEST_ASSERT_EQUAL_INT(2000, read_log());
+}
+
+void test_Full_Ring_Drops_Instead_Of_Blocking(void) {
+    TEST_ASSERT_TRUE(AccessLog_start(ACCESS_LOG_ALL, 1, 0, log_path));
+    uint64_t dropped_before = AccessLog_dropped();
+    HTTPRequest request = make_request("/burst", 200);
+    for (int i = 0; i < 20000; i++) AccessLog_request(&request);
+    AccessLog_stop();
+
+    uint64_t dropped = AccessLog_dropped() - dropped_before;
+    int logged = 0;
+    read_log();
+    for (char *p = contents; (p = strstr(p, " /burst ")); p++) logged++;
+    TEST_ASSERT_EQUAL_INT(20000, logged + (int)dropped);
+    if (dropped > 0) TEST_ASSERT_NOT_NULL(strstr(contents, "records dropped"));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_Line_Format);
+    RUN_TEST(test_Errors_Only_And_Sampling);
+    RUN_TEST(test_Verbose_Adds_Query_And_Headers);
+    RUN_TEST(test_Slow_Requests_Logged_With_Phases);
+    RUN_TEST(test_Threads_Get_Their_Own_Ring);
+    RUN_TEST(test_Full_Ring_Drops_Instead_Of_Blocking);
+    return UNITY_END();
+}
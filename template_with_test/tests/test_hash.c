@@ -0,0 +1,41 @@
+#include "unity/unity.h"
+#include "../.engine/Hash/Hash.h"
+#include <string.h>
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_Hash64_Reference_Vectors(void) {
+    const char *text = "Nobody inspects the spammish repetition";
+
+    TEST_ASSERT_TRUE(hash64("", 0, 0) == 0xEF46DB3751D8E999ULL);
+    TEST_ASSERT_TRUE(hash64("abc", 3, 0) == 0x44BC2CF5AD770999ULL);
+    TEST_ASSERT_TRUE(hash64(text, strlen(text), 0) == 0xFBCEA83C8A378BF1ULL);
+}
+
+void test_Hash64_Streaming_Matches_One_Shot(void) {
+    char data[200];
+    for (int i = 0; i < 200; i++) data[i] = (char)(i * 7);
+
+    // Feed the input in uneven pieces that straddle the 32 byte stripes
+    size_t pieces[] = {1, 30, 33, 0, 64, 5, 67};
+    Hash64State state;
+    hash64_init(&state, 42);
+    size_t offset = 0;
+    for (size_t i = 0; i < sizeof(pieces) / sizeof(pieces[0]); i++) {
+        hash64_update(&state, data + offset, pieces[i]);
+        offset += pieces[i];
+    }
+
+    TEST_ASSERT_EQUAL_INT(200, offset);
+    TEST_ASSERT_TRUE(hash64_digest(&state) == hash64(data, 200, 42));
+    TEST_ASSERT_TRUE(hash64(data, 200, 42) != hash64(data, 200, 0));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_Hash64_Reference_Vectors);
+    RUN_TEST(test_Hash64_Streaming_Matches_One_Shot);
+    return UNITY_END();
+}
@@ -0,0 +1,330 @@
+#include "unity/unity.h"
+#include "../.engine/HTTPServer/HTTPServer.h"
+#include "../config.h"
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <arpa/inet.h>
+
+static char socket_path[64];
+
+void setUp(void) {
+    snprintf(socket_path, sizeof(socket_path), "/tmp/test_http_server.%d.sock", (int)getpid());
+}
+
+void tearDown(void) {
+    unlink(socket_path);
+}
+
+typedef struct {
+    int family;             // AF_UNIX or AF_INET
+    int port;
+    const char *request;
+    char response[1024];
+} Client;
+
+static void *run_client(void *arg) {
+    Client *c = arg;
+    int fd = socket(c->family, SOCK_STREAM, 0);
+    int connected;
+    if (c->family == AF_UNIX) {
+        struct sockaddr_un addr = { .sun_family = AF_UNIX };
+        strcpy(addr.sun_path, socket_path);
+        connected = connect(fd, (struct sockaddr *)&addr, sizeof(addr));
+    } else {
+        struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(c->port) };
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        connected = connect(fd, (struct sockaddr *)&addr, sizeof(addr));
+    }
+    if (connected == 0) {
+        write(fd, c->request, strlen(c->request));
+        size_t len = 0;
+        ssize_t n;
+        while ((n = read(fd, c->response + len, sizeof(c->response) - 1 - len)) > 0) len += n;
+        c->response[len] = '\0';
+    }
+    close(fd);
+    return NULL;
+}
+
+// Accepts one request, answers with its path and returns a copy of it
+static HTTPRequest answer_one(HTTPServer *server) {
+    HTTPRequest request = HTTPServer_listen(server);
+    // Its bytes came after the accepting thread stopped waiting
+    if (request.unread) HTTPServer_read_request(&request);
+    HTTPServer_send_response(&request, request.path ? request.path : "", "text/plain", 200, "");
+    return request;
+}
+
+void test_Needs_A_Listener(void) {
+    TEST_ASSERT_NULL(HTTPServer_create(0, NULL));
+    TEST_ASSERT_NULL(HTTPServer_create(0, ""));
+}
+
+void test_Unix_Socket_Only(void) {
+    HTTPServer *server = HTTPServer_create(0, socket_path);
+    TEST_ASSERT_NOT_NULL(server);
+    TEST_ASSERT_EQUAL_INT(-1, server->server_fd);
+    TEST_ASSERT_EQUAL_INT(0, access(socket_path, F_OK));
+
+    Client client = { AF_UNIX, 0, "GET /items?page=2 HTTP/1.1\r\nHost: app\r\nX-Forwarded-For: 10.0.0.1\r\n\r\n", "" };
+    pthread_t thread;
+    pthread_create(&thread, NULL, run_client, &client);
+
+    HTTPRequest request = answer_one(server);
+    pthread_join(thread, NULL);
+
+    TEST_ASSERT_EQUAL_STRING("GET", request.method);
+    TEST_ASSERT_EQUAL_STRING("/items", request.path);
+    TEST_ASSERT_EQUAL_STRING("page=2", request.query);
+    TEST_ASSERT_EQUAL_STRING("10.0.0.1", HTTPRequest_get_header(&request, "X-Forwarded-For"));
+    TEST_ASSERT_EQUAL_INT(0, strncmp(client.response, "HTTP/1.1 200 OK\r\n", 17));
+    TEST_ASSERT_NOT_NULL(strstr(client.response, "\r\n\r\n/items"));
+    // No keep-alive: the client is told the connection ends here
+    TEST_ASSERT_NOT_NULL(strstr(client.response, "\r\nConnection: close\r\n"));
+    HTTPRequest_free(&request);
+
+    // The socket file goes away with the server
+    HTTPServer_destroy(server);
+    TEST_ASSERT_EQUAL_INT(-1, access(socket_path, F_OK));
+}
+
+void test_Tcp_And_Unix_Together(void) {
+    int port = 20000 + getpid() % 20000;
+    HTTPServer *server = HTTPServer_create(port, socket_path);
+    if (!server) TEST_IGNORE_MESSAGE("TCP port unavailable");
+
+    Client clients[2] = {
+        { AF_UNIX, 0, "GET /over-unix HTTP/1.1\r\n\r\n", "" },
+        { AF_INET, port, "GET /over-tcp HTTP/1.1\r\n\r\n", "" }
+    };
+    pthread_t threads[2];
+    for (int i = 0; i < 2; i++) pthread_create(&threads[i], NULL, run_client, &clients[i]);
+
+    for (int i = 0; i < 2; i++) {
+        HTTPRequest request = answer_one(server);
+        HTTPRequest_free(&request);
+    }
+    for (int i = 0; i < 2; i++) pthread_join(threads[i], NULL);
+
+    TEST_ASSERT_NOT_NULL(strstr(clients[0].response, "\r\n\r\n/over-unix"));
+    TEST_ASSERT_NOT_NULL(strstr(clients[1].response, "\r\n\r\n/over-tcp"));
+    HTTPServer_destroy(server);
+}
+
+void test_Adopt_Inherited_Listeners(void) {
+    int port = 20000 + (getpid() + 1) % 20000;
+    HTTPServer *original = HTTPServer_create(port, socket_path);
+    if (!original) TEST_IGNORE_MESSAGE("TCP port unavailable");
+    TEST_ASSERT_NULL(HTTPServer_adopt(-1, -1));
+
+    // What a re-executed image gets: the same listening sockets, as fds
+    HTTPServer *server = HTTPServer_adopt(dup(original->server_fd), dup(original->unix_fd));
+    TEST_ASSERT_NOT_NULL(server);
+    TEST_ASSERT_EQUAL_INT(port, server->port);
+    TEST_ASSERT_EQUAL_STRING(socket_path, server->unix_path);
+
+    Client client = { AF_UNIX, 0, "GET /handed-over HTTP/1.1\r\n\r\n", "" };
+    pthread_t thread;
+    pthread_create(&thread, NULL, run_client, &client);
+    HTTPRequest request = answer_one(server);
+    pthread_join(thread, NULL);
+    HTTPRequest_free(&request);
+    TEST_ASSERT_NOT_NULL(strstr(client.response, "\r\n\r\n/handed-over"));
+
+    HTTPServer_destroy(server);
+    HTTPServer_destroy(original);
+}
+
+void test_Silent_Client_Left_Unread(void) {
+    HTTPServer *server = HTTPServer_create(0, socket_path);
+    TEST_ASSERT_NOT_NULL(server);
+
+    int silent = socket(AF_UNIX, SOCK_STREAM, 0);
+    struct sockaddr_un addr = { .sun_family = AF_UNIX };
+    strcpy(addr.sun_path, socket_path);
+    TEST_ASSERT_EQUAL_INT(0, connect(silent, (struct sockaddr *)&addr, sizeof(addr)));
+    int64_t started = HTTPServer_now_ns();
+    HTTPRequest first = HTTPServer_listen(server);
+    TEST_ASSERT_TRUE(first.unread);
+    // Handed over at once, the accepting thread does not wait for its bytes
+    TEST_ASSERT_LESS_THAN_INT64(5000000LL, HTTPServer_now_ns() - started);
+
+    // One whose request is already in is read right there
+    int eager = socket(AF_UNIX, SOCK_STREAM, 0);
+    TEST_ASSERT_EQUAL_INT(0, connect(eager, (struct sockaddr *)&addr, sizeof(addr)));
+    const char *raw = "GET /eager HTTP/1.1\r\n\r\n";
+    write(eager, raw, strlen(raw));
+    HTTPRequest read_now = HTTPServer_listen(server);
+    TEST_ASSERT_FALSE(read_now.unread);
+    TEST_ASSERT_EQUAL_STRING("/eager", read_now.path);
+    HTTPServer_close(read_now.client_socket, NULL);
+    HTTPRequest_free(&read_now);
+    close(eager);
+
+    // The next client is served while the first one still says nothing
+    Client client = { AF_UNIX, 0, "GET /next HTTP/1.1\r\n\r\n", "" };
+    pthread_t thread;
+    pthread_create(&thread, NULL, run_client, &client);
+    HTTPRequest second = answer_one(server);
+    pthread_join(thread, NULL);
+    TEST_ASSERT_NOT_NULL(strstr(client.response, "\r\n\r\n/next"));
+
+    const char *late = "GET /late HTTP/1.1\r\n\r\n";
+    write(silent, late, strlen(late));
+    TEST_ASSERT_TRUE(HTTPServer_read_request(&first));
+    TEST_ASSERT_EQUAL_STRING("/late", first.path);
+    HTTPServer_close(first.client_socket, NULL);
+    close(silent);
+
+    HTTPRequest_free(&first);
+    HTTPRequest_free(&second);
+    HTTPServer_destroy(server);
+}
+
+static void on_signal(int sig) {
+    (void)sig;
+}
+
+static void *read_one(void *arg) {
+    HTTPRequest *request = arg;
+    HTTPServer_read_request(request);
+    return NULL;
+}
+
+void test_Signal_Does_Not_Drop_A_Client_Being_Read(void) {
+    // As the accepting thread: no SA_RESTART, so accept can be left
+    struct sigaction sa = {0}, previous;
+    sa.sa_handler = on_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGUSR1, &sa, &previous);
+
+    int fds[2];
+    TEST_ASSERT_EQUAL_INT(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    HTTPRequest request = {0};
+    request.client_socket = fds[0];
+    request.unread = true;
+    pthread_t thread;
+    pthread_create(&thread, NULL, read_one, &request);
+    usleep(100 * 1000);
+    pthread_kill(thread, SIGUSR1);
+    usleep(100 * 1000);
+
+    const char *raw = "GET /after-signal HTTP/1.1\r\n\r\n";
+    write(fds[1], raw, strlen(raw));
+    pthread_join(thread, NULL);
+    TEST_ASSERT_EQUAL_STRING("/after-signal", request.path);
+
+    HTTPServer_close(fds[0], NULL);
+    close(fds[1]);
+    HTTPRequest_free(&request);
+    sigaction(SIGUSR1, &previous, NULL);
+}
+
+typedef struct {
+    HTTPServer *server;
+    HTTPRequest request;
+    volatile bool done;
+} Listener;
+
+static void *listen_one(void *arg) {
+    Listener *l = arg;
+    l->request = HTTPServer_listen(l->server);
+    l->done = true;
+    return NULL;
+}
+
+void test_Signal_Does_Not_End_Listen(void) {
+    struct sigaction sa = {0}, previous;
+    sa.sa_handler = on_signal;
+    sigemptyset(&sa.sa_mask);
+    sigaction(SIGUSR1, &sa, &previous);
+
+    // Both listeners, so the wait is in poll
+    int port = 20000 + (getpid() + 2) % 20000;
+    HTTPServer *server = HTTPServer_create(port, socket_path);
+    if (!server) TEST_IGNORE_MESSAGE("TCP port unavailable");
+
+    // A profiler's SIGPROF, say: the wait goes on
+    Listener listener = { .server = server };
+    pthread_t thread;
+    pthread_create(&thread, NULL, listen_one, &listener);
+    usleep(100 * 1000);
+    pthread_kill(thread, SIGUSR1);
+    usleep(100 * 1000);
+    TEST_ASSERT_FALSE(listener.done);
+
+    Client client = { AF_UNIX, 0, "GET /after-signal HTTP/1.1\r\n\r\n", "" };
+    pthread_t client_thread;
+    pthread_create(&client_thread, NULL, run_client, &client);
+    pthread_join(thread, NULL);
+    if (listener.request.unread) HTTPServer_read_request(&listener.request);
+    TEST_ASSERT_EQUAL_STRING("/after-signal", listener.request.path);
+    HTTPServer_send_response(&listener.request, "ok", "text/plain", 200, "");
+    pthread_join(client_thread, NULL);
+    HTTPRequest_free(&listener.request);
+
+    // Once stopped, the next interruption ends it with an empty request
+    listener.done = false;
+    pthread_create(&thread, NULL, listen_one, &listener);
+    usleep(100 * 1000);
+    HTTPServer_stop(server);
+    pthread_kill(thread, SIGUSR1);
+    pthread_join(thread, NULL);
+    TEST_ASSERT_EQUAL_STRING("", listener.request.method);
+    HTTPRequest_free(&listener.request);
+
+    HTTPServer_destroy(server);
+    sigaction(SIGUSR1, &previous, NULL);
+}
+
+static void read_response(int fd, char *buf, size_t size) {
+    size_t len = 0;
+    ssize_t n;
+    while ((n = read(fd, buf + len, size - 1 - len)) > 0) len += n;
+    buf[len] = '\0';
+    close(fd);
+}
+
+void test_Server_Timing_Header(void) {
+    char response[1024];
+    int fds[2];
+    TEST_ASSERT_EQUAL_INT(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    HTTPRequest request = {0};
+    request.client_socket = fds[0];
+    request.received_ns = HTTPServer_now_ns() - 3000000;
+    request.phase_ns[HTTP_PHASE_QUEUE] = 1500000;
+    request.phase_ns[HTTP_PHASE_DB] = 250000;
+
+    SERVER_TIMING = 0;
+    HTTPServer_send_response(&request, "ok", "text/plain", 200, "");
+    read_response(fds[1], response, sizeof(response));
+    TEST_ASSERT_NULL(strstr(response, "Server-Timing"));
+
+    TEST_ASSERT_EQUAL_INT(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    request.client_socket = fds[0];
+    SERVER_TIMING = 1;
+    HTTPServer_send_response(&request, "ok", "text/plain", 200, "");
+    SERVER_TIMING = 0;
+    read_response(fds[1], response, sizeof(response));
+    TEST_ASSERT_NOT_NULL(strstr(response, "\r\nServer-Timing: queue;dur=1.500, route;dur=0.000, "
+                                          "db;dur=0.250, render;dur=0.000, total;dur=3."));
+    TEST_ASSERT_NOT_NULL(strstr(response, "\r\n\r\nok"));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_Needs_A_Listener);
+    RUN_TEST(test_Unix_Socket_Only);
+    RUN_TEST(test_Tcp_And_Unix_Together);
+    RUN_TEST(test_Adopt_Inherited_Listeners);
+    RUN_TEST(test_Silent_Client_Left_Unread);
+    RUN_TEST(test_Signal_Does_Not_Drop_A_Client_Being_Read);
+    RUN_TEST(test_Signal_Does_Not_End_Listen);
+    RUN_TEST(test_Server_Timing_Header);
+    return UNITY_END();
+}
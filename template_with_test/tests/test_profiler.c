@@ -0,0 +1,84 @@
+#include "unity/unity.h"
+#include "../.engine/Profiler/Profiler.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static volatile bool spinning;
+
+void setUp(void) {}
+void tearDown(void) {}
+
+__attribute__((noinline)) void profiler_test_spin(void) {
+    volatile unsigned long x = 0;
+    while (spinning) x++;
+}
+
+static void *spin_thread(void *arg) {
+    (void)arg;
+    profiler_test_spin();
+    return NULL;
+}
+
+static void *profile_thread(void *arg) {
+    size_t len;
+    *(char **)arg = Profiler_run(1, 50, &len);
+    return NULL;
+}
+
+// Sum of the counts, -1 if a line is not "frame;frame;... count"
+static long folded_total(const char *folded) {
+    long total = 0;
+    for (const char *line = folded; *line;) {
+        const char *end = strchr(line, '\n');
+        if (!end) return -1;
+        const char *space = end;
+        while (space > line && *space != ' ') space--;
+        if (space == line || space[1] == '\n') return -1;
+        total += strtol(space + 1, NULL, 10);
+        line = end + 1;
+    }
+    return total;
+}
+
+void test_Folded_Stacks_Of_A_Busy_Thread(void) {
+    if (!Profiler_available()) TEST_IGNORE_MESSAGE("no backtrace() on this libc");
+    spinning = true;
+    pthread_t thread;
+    pthread_create(&thread, NULL, spin_thread, NULL);
+
+    size_t len = 0;
+    char *folded = Profiler_run(1, 200, &len);
+    spinning = false;
+    pthread_join(thread, NULL);
+
+    TEST_ASSERT_NOT_NULL(folded);
+    TEST_ASSERT_EQUAL_size_t(strlen(folded), len);
+    // About 200 samples of a second of CPU, whatever else the machine runs
+    TEST_ASSERT_GREATER_THAN(20, folded_total(folded));
+    // Not exported without -rdynamic: module+offset
+    TEST_ASSERT_NOT_NULL(strstr(folded, "test_profiler+0x"));
+    free(folded);
+}
+
+void test_One_Profile_At_A_Time(void) {
+    if (!Profiler_available()) TEST_IGNORE_MESSAGE("no backtrace() on this libc");
+    char *first = NULL;
+    pthread_t thread;
+    pthread_create(&thread, NULL, profile_thread, &first);
+    usleep(200 * 1000);
+
+    size_t len;
+    TEST_ASSERT_NULL(Profiler_run(1, 50, &len));
+    pthread_join(thread, NULL);
+    TEST_ASSERT_NOT_NULL(first);
+    free(first);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_Folded_Stacks_Of_A_Busy_Thread);
+    RUN_TEST(test_One_Profile_At_A_Time);
+    return UNITY_END();
+}
@@ -0,0 +1,98 @@
+#define _GNU_SOURCE
+#include "unity/unity.h"
+#include "../.engine/Supervisor/Supervisor.h"
+#include <sched.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static cpu_set_t sets[256];
+
+void test_Parse_Cpulist(void) {
+    cpu_set_t set;
+    TEST_ASSERT_TRUE(Supervisor_parse_cpulist("0-3,8,10-11\n", &set));
+    TEST_ASSERT_EQUAL_INT(7, CPU_COUNT(&set));
+    TEST_ASSERT_TRUE(CPU_ISSET(0, &set));
+    TEST_ASSERT_TRUE(CPU_ISSET(3, &set));
+    TEST_ASSERT_TRUE(CPU_ISSET(8, &set));
+    TEST_ASSERT_FALSE(CPU_ISSET(9, &set));
+    TEST_ASSERT_TRUE(CPU_ISSET(11, &set));
+
+    TEST_ASSERT_FALSE(Supervisor_parse_cpulist("3-1", &set));
+    TEST_ASSERT_FALSE(Supervisor_parse_cpulist("a", &set));
+    TEST_ASSERT_FALSE(Supervisor_parse_cpulist("", &set));
+}
+
+void test_One_Process_Per_Core(void) {
+    cpu_set_t allowed;
+    TEST_ASSERT_EQUAL_INT(0, sched_getaffinity(0, sizeof(allowed), &allowed));
+
+    bool pinned;
+    int n = Supervisor_plan("core", 0, sets, 256, &pinned);
+    TEST_ASSERT_EQUAL_INT(CPU_COUNT(&allowed), n);
+    TEST_ASSERT_EQUAL_INT(n > 1, pinned);
+    if (!pinned) return;
+
+    cpu_set_t seen;
+    CPU_ZERO(&seen);
+    for (int i = 0; i < n; i++) {
+        TEST_ASSERT_EQUAL_INT(1, CPU_COUNT(&sets[i]));
+        cpu_set_t both;
+        CPU_AND(&both, &seen, &sets[i]);
+        TEST_ASSERT_EQUAL_INT(0, CPU_COUNT(&both));
+        CPU_OR(&seen, &seen, &sets[i]);
+    }
+    TEST_ASSERT_TRUE(CPU_EQUAL(&seen, &allowed));
+}
+
+void test_More_Processes_Than_Cores_Share_Them(void) {
+    cpu_set_t allowed;
+    sched_getaffinity(0, sizeof(allowed), &allowed);
+    int cores = CPU_COUNT(&allowed);
+
+    bool pinned;
+    int n = Supervisor_plan("core", cores + 1, sets, 256, &pinned);
+    TEST_ASSERT_EQUAL_INT(cores + 1, n);
+    TEST_ASSERT_TRUE(pinned);
+    TEST_ASSERT_TRUE(CPU_EQUAL(&sets[0], &sets[cores]));
+}
+
+void test_No_Pinning(void) {
+    bool pinned = true;
+    TEST_ASSERT_EQUAL_INT(4, Supervisor_plan("", 4, sets, 256, &pinned));
+    TEST_ASSERT_FALSE(pinned);
+
+    pinned = true;
+    TEST_ASSERT_EQUAL_INT(1, Supervisor_plan("core", 1, sets, 256, &pinned));
+    TEST_ASSERT_FALSE(pinned);
+
+    TEST_ASSERT_EQUAL_INT(2, Supervisor_plan("core", 8, sets, 2, &pinned));
+}
+
+void test_Numa_Groups_Cover_The_Allowed_Cpus(void) {
+    cpu_set_t allowed;
+    sched_getaffinity(0, sizeof(allowed), &allowed);
+
+    bool pinned;
+    int n = Supervisor_plan("numa", 0, sets, 256, &pinned);
+    TEST_ASSERT_TRUE(n >= 1);
+    if (!pinned) return;
+
+    cpu_set_t seen;
+    CPU_ZERO(&seen);
+    for (int i = 0; i < n; i++) {
+        TEST_ASSERT_TRUE(CPU_COUNT(&sets[i]) >= 1);
+        CPU_OR(&seen, &seen, &sets[i]);
+    }
+    TEST_ASSERT_TRUE(CPU_EQUAL(&seen, &allowed));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_Parse_Cpulist);
+    RUN_TEST(test_One_Process_Per_Core);
+    RUN_TEST(test_More_Processes_Than_Cores_Share_Them);
+    RUN_TEST(test_No_Pinning);
+    RUN_TEST(test_Numa_Groups_Cover_The_Allowed_Cpus);
+    return UNITY_END();
+}
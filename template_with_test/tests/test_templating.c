@@ -0,0 +1,609 @@
+#include "unity/unity.h"
+#include "../.engine/HTMLTemplating/HTMLTemplating.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// Reads everything the server wrote on the other end of a socketpair
+static char *read_response(int fd) {
+    size_t cap = 4096, len = 0;
+    char *buf = malloc(cap);
+    ssize_t n;
+    while ((n = read(fd, buf + len, cap - len - 1)) > 0) {
+        len += n;
+        if (cap - len < 2) {
+            cap *= 2;
+            buf = realloc(buf, cap);
+        }
+    }
+    buf[len] = '\0';
+    return buf;
+}
+
+void test_Template_Is_Segmented_Once(void) {
+    const Template *tpl = template_load("label_content.html");
+    TEST_ASSERT_NOT_NULL(tpl);
+
+    // literal, {{title}}, literal, {{description}}, literal
+    TEST_ASSERT_EQUAL_INT(5, tpl->segment_count);
+    TEST_ASSERT_EQUAL_INT(SEGMENT_PARAM, tpl->segments[1].type);
+    TEST_ASSERT_EQUAL_STRING_LEN("title", tpl->segments[1].key, tpl->segments[1].key_len);
+
+    // Second load is served from the cache
+    TEST_ASSERT_EQUAL_PTR(tpl, template_load("label_content.html"));
+}
+
+void test_Template_Missing_File(void) {
+    TEST_ASSERT_NULL(template_load("does_not_exist.html"));
+
+    char *html = process_html("does_not_exist.html", NULL, 0);
+    TEST_ASSERT_EQUAL_STRING("", html);
+    free(html);
+}
+
+void test_Process_Html_Replaces_Params(void) {
+    TemplateParam params[] = {
+        {"title", "Job 1", NULL, write_string},
+        {"description", "Lorem ipsum", NULL, write_string}
+    };
+    char *html = process_html("label_content.html", params, 2);
+
+    TEST_ASSERT_NOT_NULL(strstr(html, "<h3>Job 1</h3>"));
+    TEST_ASSERT_NOT_NULL(strstr(html, "<p>Lorem ipsum</p>"));
+    TEST_ASSERT_NULL(strstr(html, "{{"));
+    free(html);
+}
+
+void test_Unknown_Params_Are_Kept(void) {
+    TemplateParam params[] = {
+        {"title", "Job 1", NULL, write_string}
+    };
+    char *html = process_html("label_content.html", params, 1);
+
+    TEST_ASSERT_NOT_NULL(strstr(html, "<p>{{description}}</p>"));
+    free(html);
+}
+
+void test_Type_Hints_Are_Parsed(void) {
+    Template tpl = {0};
+    tpl.content = "<p>{{ age : int }}</p>";
+    tpl.content_len = strlen(tpl.content);
+    TEST_ASSERT_TRUE(template_parse(&tpl));
+
+    TEST_ASSERT_EQUAL_INT(3, tpl.segment_count);
+    TEST_ASSERT_EQUAL_STRING_LEN("age", tpl.segments[1].key, tpl.segments[1].key_len);
+    TEST_ASSERT_EQUAL_STRING_LEN("int", tpl.segments[1].hint, tpl.segments[1].hint_len);
+
+    // The runtime engine ignores the hint and uses the param's writer
+    int age = 7;
+    TemplateParam params[] = { {"age", &age, NULL, write_int} };
+    TemplateOutput out;
+    template_output_init(&out);
+    TEST_ASSERT_TRUE(template_render(&tpl, params, 1, &out));
+    char *html = template_output_join(&out);
+    TEST_ASSERT_EQUAL_STRING("<p>7</p>", html);
+
+    free(html);
+    template_output_free(&out);
+    free(tpl.segments);
+}
+
+typedef struct {
+    char title[32];
+    char *owner;
+    int stars;
+} TestRepo;
+
+static char *render_string(const char *content, TemplateParam *params, int param_count) {
+    Template tpl = {0};
+    tpl.content = (char *)content;
+    tpl.content_len = strlen(content);
+    if (!template_parse(&tpl)) return NULL;
+
+    TemplateOutput out;
+    template_output_init(&out);
+    char *html = template_render(&tpl, params, param_count, &out) ? template_output_join(&out) : NULL;
+    template_output_free(&out);
+    free(tpl.segments);
+    return html;
+}
+
+void test_For_Loop_Over_Struct_Array(void) {
+    TestRepo repos[] = {
+        {"engine", "pau", 3},
+        {"docs", NULL, 0}
+    };
+    const TemplateField fields[] = {
+        TEMPLATE_FIELD_WRITER(TestRepo, title, write_string),
+        TEMPLATE_FIELD_PTR_WRITER(TestRepo, owner, write_string),
+        TEMPLATE_FIELD_WRITER(TestRepo, stars, write_int)
+    };
+    TemplateList list = TEMPLATE_LIST(repos, 2, fields);
+    TemplateParam params[] = {
+        {"repos", &list, NULL, write_list},
+        {"sep", ";", NULL, write_string}
+    };
+
+    char *html = render_string(
+        "{{repos}}:{% for r in repos %}{{ r.title }}/{{r.owner}}/{{r.stars}}"
+        "{% if r.stars %}*{% else %}-{% endif %}{{sep}}{% endfor %}",
+        params, 2);
+    TEST_ASSERT_EQUAL_STRING("2:engine/pau/3*;docs//0-;", html);
+    free(html);
+}
+
+void test_If_Else_And_Negation(void) {
+    bool on = true;
+    TemplateParam params[] = {
+        {"flag", &on, NULL, write_bool},
+        {"empty", "", NULL, write_string}
+    };
+
+    char *html = render_string(
+        "{% if flag %}a{% else %}b{% endif %}"
+        "{% if empty %}c{% else %}d{% endif %}"
+        "{% if not missing %}e{% endif %}",
+        params, 2);
+    TEST_ASSERT_EQUAL_STRING("ade", html);
+    free(html);
+}
+
+void test_Include_With_Loop_Variable(void) {
+    struct { char title[16]; char description[16]; } jobs[] = {
+        {"Job 1", "first"},
+        {"Job 2", "second"}
+    };
+    const TemplateField fields[] = {
+        { "title", offsetof(__typeof__(jobs[0]), title), NULL, false, write_string },
+        { "description", offsetof(__typeof__(jobs[0]), description), NULL, false, write_string }
+    };
+    TemplateList list = TEMPLATE_LIST(jobs, 2, fields);
+    TemplateParam params[] = {
+        {"title", "Page title", NULL, write_string},
+        {"jobs", &list, NULL, write_list}
+    };
+
+    char *html = render_string(
+        "{{title}}{% for job in jobs %}{% include \"label_content.html\" with job %}{% endfor %}",
+        params, 2);
+    TEST_ASSERT_NOT_NULL(html);
+    TEST_ASSERT_EQUAL_INT(0, strncmp(html, "Page title", 10));
+    TEST_ASSERT_NOT_NULL(strstr(html, "<h3>Job 1</h3>"));
+    TEST_ASSERT_NOT_NULL(strstr(html, "<p>second</p>"));
+    TEST_ASSERT_NULL(strstr(html, "<h3>Page title</h3>"));
+    free(html);
+}
+
+void test_Unbalanced_Blocks_Are_Rejected(void) {
+    Template tpl = {0};
+    tpl.content = "{% for a in b %}{% endif %}";
+    tpl.content_len = strlen(tpl.content);
+    TEST_ASSERT_FALSE(template_parse(&tpl));
+    free(tpl.segments);
+
+    Template open_tpl = {0};
+    open_tpl.content = "{% if a %}never closed";
+    open_tpl.content_len = strlen(open_tpl.content);
+    TEST_ASSERT_FALSE(template_parse(&open_tpl));
+    free(open_tpl.segments);
+}
+
+void test_Writers_Format_Numbers(void) {
+    int values[] = {0, 7, -42, 2147483647, -2147483647 - 1};
+    // 0.125, 0.625 and 1.125 are exact ties, which printf rounds to even
+    float prices[] = {3.14159f, -0.5f, 1234.005f, 0.0f, 0.125f, 0.625f, 1.125f, -0.375f, 2.675f};
+    const char *ints[] = {"0", "7", "-42", "2147483647", "-2147483648"};
+
+    for (int i = 0; i < 5; i++) {
+        TemplateOutput out;
+        template_output_init(&out);
+        TEST_ASSERT_TRUE(write_int(&out, &values[i]));
+        char *html = template_output_join(&out);
+        TEST_ASSERT_EQUAL_STRING(ints[i], html);
+        free(html);
+        template_output_free(&out);
+    }
+
+    for (int i = 0; i < 9; i++) {
+        char expected[64];
+        snprintf(expected, sizeof(expected), "%.2f", prices[i]);
+        TemplateOutput out;
+        template_output_init(&out);
+        TEST_ASSERT_TRUE(write_float(&out, &prices[i]));
+        char *html = template_output_join(&out);
+        TEST_ASSERT_EQUAL_STRING(expected, html);
+        free(html);
+        template_output_free(&out);
+    }
+}
+
+void test_Writers_Do_Not_Copy_Strings(void) {
+    const char *name = "pau";
+    int a = 1, b = 22;
+
+    TemplateOutput out;
+    template_output_init(&out);
+    TEST_ASSERT_TRUE(write_string(&out, name));
+    TEST_ASSERT_TRUE(write_int(&out, &a));
+    TEST_ASSERT_TRUE(write_int(&out, &b));
+
+    // The string is referenced in place, adjacent numbers share one iovec
+    TEST_ASSERT_EQUAL_INT(2, out.iov_count);
+    TEST_ASSERT_EQUAL_PTR(name, out.iov[0].iov_base);
+    TEST_ASSERT_EQUAL_INT(0, out.owned_count);
+    TEST_ASSERT_EQUAL_INT(6, out.total_len);
+    template_output_free(&out);
+}
+
+static int shout_calls = 0;
+
+static char *convert_shout(const void *value) {
+    shout_calls++;
+    char *result = strdup((const char *)value);
+    for (char *c = result; *c; c++) *c = toupper((unsigned char)*c);
+    return result;
+}
+
+void test_Legacy_Converters_Still_Work(void) {
+    int age = 30;
+    float score = 9.5f;
+    TemplateParam params[] = {
+        {"name", "pau", convert_shout, NULL},
+        {"age", &age, convert_int, NULL},
+        {"score", &score, convert_float, NULL},
+        {"empty", "", convert_string, NULL}
+    };
+
+    shout_calls = 0;
+    char *html = render_string("{{name}} {{age}} {{score}} {{name}}{% if empty %}!{% endif %}", params, 4);
+    TEST_ASSERT_EQUAL_STRING("PAU 30 9.50 PAU", html);
+    // Custom converters are still called once per param
+    TEST_ASSERT_EQUAL_INT(1, shout_calls);
+    free(html);
+
+    char *legacy = convert_float(&score);
+    TEST_ASSERT_EQUAL_STRING("9.50", legacy);
+    free(legacy);
+}
+
+void test_Values_Are_Escaped_By_Context(void) {
+    TemplateParam params[] = {
+        {"x", "a\"b<c>&'d", NULL, write_string},
+        {"frag", "<b>bold</b>", NULL, write_string}
+    };
+
+    char *html = render_string(
+        "<a title=\"{{x}}\" data-x={{x}}>{{x}}</a><!-- {{x}} -->{{ frag|raw }}", params, 2);
+    TEST_ASSERT_EQUAL_STRING(
+        "<a title=\"a&quot;b&lt;c&gt;&amp;&#39;d\" data-x=a&quot;b&lt;c&gt;&amp;&#39;d>"
+        "a\"b&lt;c&gt;&amp;'d</a><!-- a\"b&lt;c&gt;&amp;'d --><b>bold</b>", html);
+    free(html);
+
+    // Unquoted, a value cannot end the attribute and start another
+    TemplateParam unquoted[] = {{"cls", "x onmouseover=alert(1)\t`y`", NULL, write_string}};
+    html = render_string("<div class={{cls}}>{{cls}}</div>", unquoted, 1);
+    TEST_ASSERT_EQUAL_STRING(
+        "<div class=x&#32;onmouseover&#61;alert(1)&#9;&#96;y&#96;>x onmouseover=alert(1)\t`y`</div>", html);
+    free(html);
+
+    Template tpl = {0};
+    tpl.content = "{{ x|upper }}";
+    tpl.content_len = strlen(tpl.content);
+    TEST_ASSERT_FALSE(template_parse(&tpl));
+    free(tpl.segments);
+}
+
+// Compares the vector scanners against a byte at a time reference on
+// inputs long enough to cross several 16/32 byte blocks
+void test_Escape_Long_Values(void) {
+    char input[300];
+    for (int special = 0; special < 299; special += 37) {
+        for (int i = 0; i < 299; i++) input[i] = 'a' + i % 26;
+        input[299] = '\0';
+        input[special] = '<';
+        input[298 - special / 2] = '&';
+
+        char expected[600];
+        char *dst = expected;
+        for (int i = 0; i < 299; i++) {
+            if (input[i] == '<') dst += sprintf(dst, "&lt;");
+            else if (input[i] == '&') dst += sprintf(dst, "&amp;");
+            else *dst++ = input[i];
+        }
+        *dst = '\0';
+
+        TemplateOutput out;
+        template_output_init(&out);
+        TEST_ASSERT_TRUE(template_output_escape_str(&out, input, ESCAPE_TEXT));
+        char *html = template_output_join(&out);
+        TEST_ASSERT_EQUAL_STRING(expected, html);
+        free(html);
+        template_output_free(&out);
+    }
+
+    // Clean values are still referenced in place
+    const char *clean = "plain text without specials, long enough for a couple of vectors";
+    TemplateOutput out;
+    template_output_init(&out);
+    TEST_ASSERT_TRUE(template_output_escape_str(&out, clean, ESCAPE_ATTR));
+    TEST_ASSERT_EQUAL_INT(1, out.iov_count);
+    TEST_ASSERT_EQUAL_PTR(clean, out.iov[0].iov_base);
+    template_output_free(&out);
+}
+
+static int count_calls = 0;
+
+static bool write_counted(TemplateOutput *out, const void *value) {
+    count_calls++;
+    return write_string(out, value);
+}
+
+void test_Fragment_Cache_Reuses_Renders(void) {
+    template_fragment_cache_clear();
+    char title[16] = "Job 1";
+    TemplateParam params[] = {
+        {"title", title, NULL, write_counted},
+        {"description", "cached", NULL, write_string}
+    };
+
+    // Miss: the key is hashed from the value, then the template renders it
+    count_calls = 0;
+    char *first = process_html_cached("label_content.html", params, 2, 0);
+    TEST_ASSERT_EQUAL_INT(2, count_calls);
+    TEST_ASSERT_NOT_NULL(strstr(first, "<h3>Job 1</h3>"));
+
+    // Hit: only the key is computed
+    char *second = process_html_cached("label_content.html", params, 2, 0);
+    TEST_ASSERT_EQUAL_INT(3, count_calls);
+    TEST_ASSERT_EQUAL_STRING(first, second);
+    TEST_ASSERT_TRUE(first != second);
+
+    // Different values are a different entry
+    strcpy(title, "Job 2");
+    char *third = process_html_cached("label_content.html", params, 2, 0);
+    TEST_ASSERT_EQUAL_INT(5, count_calls);
+    TEST_ASSERT_NOT_NULL(strstr(third, "<h3>Job 2</h3>"));
+
+    template_fragment_cache_clear();
+    char *fourth = process_html_cached("label_content.html", params, 2, 0);
+    TEST_ASSERT_EQUAL_INT(7, count_calls);
+    TEST_ASSERT_EQUAL_STRING(third, fourth);
+
+    free(first);
+    free(second);
+    free(third);
+    free(fourth);
+}
+
+void test_Include_With_Item_Is_Cached(void) {
+    template_fragment_cache_clear();
+    struct { char title[16]; char description[16]; } jobs[] = {
+        {"Job 1", "a & b"},
+        {"Job 1", "a & b"},
+        {"Job 2", "c"}
+    };
+    const TemplateField fields[] = {
+        { "title", offsetof(__typeof__(jobs[0]), title), NULL, false, write_counted },
+        { "description", offsetof(__typeof__(jobs[0]), description), NULL, false, write_string }
+    };
+    TemplateList list = TEMPLATE_LIST(jobs, 3, fields);
+    TemplateParam params[] = {{"jobs", &list, NULL, write_list}};
+    const char *page = "{% for job in jobs %}{% include \"label_content.html\" with job cached %}{% endfor %}";
+
+    // Opt-in: a plain include renders every card, with nothing stored
+    count_calls = 0;
+    char *plain = render_string("{% for job in jobs %}{% include \"label_content.html\" with job %}{% endfor %}",
+                                params, 1);
+    TEST_ASSERT_EQUAL_INT(3, count_calls);
+
+    // The second card is a hit: its key is hashed, it is not rendered
+    count_calls = 0;
+    char *first = render_string(page, params, 1);
+    TEST_ASSERT_EQUAL_INT(5, count_calls);
+    const char *card = strstr(first, "<h3>Job 1</h3>");
+    TEST_ASSERT_NOT_NULL(card);
+    TEST_ASSERT_NOT_NULL(strstr(card + 1, "<h3>Job 1</h3>"));
+    TEST_ASSERT_NOT_NULL(strstr(first, "<p>a &amp; b</p>"));
+    TEST_ASSERT_NOT_NULL(strstr(first, "<h3>Job 2</h3>"));
+    TEST_ASSERT_EQUAL_STRING(plain, first);
+
+    // Every card is a hit the next time, with the same bytes
+    count_calls = 0;
+    char *second = render_string(page, params, 1);
+    TEST_ASSERT_EQUAL_INT(3, count_calls);
+    TEST_ASSERT_EQUAL_STRING(first, second);
+
+    // A changed field is a different entry
+    strcpy(jobs[2].title, "Job 3");
+    char *third = render_string(page, params, 1);
+    TEST_ASSERT_NOT_NULL(strstr(third, "<h3>Job 3</h3>"));
+    TEST_ASSERT_NULL(strstr(third, "<h3>Job 2</h3>"));
+
+    free(plain);
+    free(first);
+    free(second);
+    free(third);
+    template_fragment_cache_clear();
+}
+
+// Writes templates/<name> and stamps it with the given mtime
+static void write_template(const char *name, const char *content, time_t mtime) {
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s", TEMPLATE_DIR, name);
+    FILE *file = fopen(path, "w");
+    TEST_ASSERT_NOT_NULL(file);
+    fputs(content, file);
+    fclose(file);
+    struct timespec times[2] = { { mtime, 0 }, { mtime, 0 } };
+    TEST_ASSERT_EQUAL_INT(0, utimensat(AT_FDCWD, path, times, 0));
+}
+
+void test_Edited_Template_Is_Reloaded(void) {
+    TemplateParam params[] = {{"x", "!", NULL, write_string}};
+    write_template("_reload.html", "<p>one{{x}}</p>", 1000000);
+
+    const Template *first = template_load("_reload.html");
+    TEST_ASSERT_NOT_NULL(first);
+    char *html = process_html_cached("_reload.html", params, 1, 0);
+    TEST_ASSERT_EQUAL_STRING("<p>one!</p>", html);
+    free(html);
+
+    // Within TEMPLATE_RECHECK_SECONDS the file is not looked at
+    write_template("_reload.html", "<p>two{{x}}</p>", 2000000);
+    TEST_ASSERT_EQUAL_PTR(first, template_load("_reload.html"));
+
+    sleep(TEMPLATE_RECHECK_SECONDS);
+    const Template *second = template_load("_reload.html");
+    TEST_ASSERT_TRUE(second != first);
+    TEST_ASSERT_EQUAL_PTR(second, template_load("_reload.html"));
+
+    // The cached render of the old parse is not served for the new one
+    html = process_html_cached("_reload.html", params, 1, 0);
+    TEST_ASSERT_EQUAL_STRING("<p>two!</p>", html);
+    free(html);
+
+    // A render still holding the old parse keeps its bytes
+    TEST_ASSERT_EQUAL_STRING_LEN("<p>one", first->segments[0].text, first->segments[0].len);
+
+    char path[256];
+    snprintf(path, sizeof(path), "%s/_reload.html", TEMPLATE_DIR);
+    unlink(path);
+}
+
+void test_Render_Html_Streams_Response(void) {
+    int fds[2];
+    TEST_ASSERT_EQUAL_INT(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+
+    HTTPRequest request = {0};
+    request.client_socket = fds[0];
+
+    int age = 42;
+    TemplateParam params[] = {
+        {"title", "Streamed", NULL, write_string},
+        {"description", &age, NULL, write_int}
+    };
+    render_html(&request, "label_content.html", params, 2);
+
+    char *response = read_response(fds[1]);
+    close(fds[1]);
+
+    char *body = strstr(response, "\r\n\r\n");
+    TEST_ASSERT_NOT_NULL(body);
+    body += 4;
+
+    char expected_length[64];
+    snprintf(expected_length, sizeof(expected_length), "Content-Length: %zu\r\n", strlen(body));
+
+    TEST_ASSERT_EQUAL_INT(0, strncmp(response, "HTTP/1.1 200 OK\r\n", 17));
+    TEST_ASSERT_NOT_NULL(strstr(response, expected_length));
+    TEST_ASSERT_NOT_NULL(strstr(body, "<h3>Streamed</h3>"));
+    TEST_ASSERT_NOT_NULL(strstr(body, "<p>42</p>"));
+    free(response);
+}
+
+// Renders label_content.html, sending If-None-Match when etag is given
+static char *render_conditional(const char *etag) {
+    int fds[2];
+    TEST_ASSERT_EQUAL_INT(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+
+    HTTPRequest request = {0};
+    request.client_socket = fds[0];
+    if (etag) HTTPRequest_add_header(&request, "If-None-Match", etag);
+
+    TemplateParam params[] = {
+        {"title", "Tagged", NULL, write_string},
+        {"description", "Same body", NULL, write_string}
+    };
+    render_html(&request, "label_content.html", params, 2);
+    HTTPRequest_free(&request);
+
+    char *response = read_response(fds[1]);
+    close(fds[1]);
+    return response;
+}
+
+void test_Rendered_Body_Gets_Etag(void) {
+    char *first = render_conditional(NULL);
+    char *etag_header = strstr(first, "\r\nETag: \"");
+    TEST_ASSERT_NOT_NULL(etag_header);
+
+    char etag[HTTP_ETAG_SIZE];
+    memcpy(etag, etag_header + 8, HTTP_ETAG_SIZE - 1);
+    etag[HTTP_ETAG_SIZE - 1] = '\0';
+
+    // Same body, same tag
+    char *second = render_conditional(NULL);
+    TEST_ASSERT_NOT_NULL(strstr(second, etag));
+
+    char *not_modified = render_conditional(etag);
+    TEST_ASSERT_EQUAL_INT(0, strncmp(not_modified, "HTTP/1.1 304 Not Modified\r\n", 27));
+    TEST_ASSERT_NOT_NULL(strstr(not_modified, etag));
+    TEST_ASSERT_NULL(strstr(not_modified, "Content-Length"));
+    TEST_ASSERT_EQUAL_STRING("", strstr(not_modified, "\r\n\r\n") + 4);
+
+    char list[64];
+    snprintf(list, sizeof(list), "\"0000000000000000\", W/%s", etag);
+    char *weak = render_conditional(list);
+    TEST_ASSERT_EQUAL_INT(0, strncmp(weak, "HTTP/1.1 304", 12));
+
+    char *changed = render_conditional("\"0000000000000000\"");
+    TEST_ASSERT_EQUAL_INT(0, strncmp(changed, "HTTP/1.1 200 OK\r\n", 17));
+
+    free(first);
+    free(second);
+    free(not_modified);
+    free(weak);
+    free(changed);
+}
+
+void test_Static_Template_Etag_Is_Precomputed(void) {
+    const Template *dynamic = template_load("label_content.html");
+    TEST_ASSERT_NOT_NULL(dynamic);
+    TEST_ASSERT_FALSE(dynamic->is_static);
+
+    const Template *fixed = template_load("home.html");
+    TEST_ASSERT_NOT_NULL(fixed);
+    TEST_ASSERT_TRUE(fixed->is_static);
+    TEST_ASSERT_EQUAL_INT(HTTP_ETAG_SIZE - 1, strlen(fixed->etag));
+    TEST_ASSERT_EQUAL_CHAR('"', fixed->etag[0]);
+
+    // Compressed once at load, dynamic pages are compressed per response
+    TEST_ASSERT_NOT_NULL(fixed->encoded[ENCODING_GZIP].data);
+    TEST_ASSERT_NOT_NULL(fixed->encoded[ENCODING_DEFLATE].data);
+    TEST_ASSERT_TRUE(fixed->encoded[ENCODING_GZIP].len < fixed->content_len);
+    TEST_ASSERT_NULL(dynamic->encoded[ENCODING_GZIP].data);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_Template_Is_Segmented_Once);
+    RUN_TEST(test_Template_Missing_File);
+    RUN_TEST(test_Process_Html_Replaces_Params);
+    RUN_TEST(test_Unknown_Params_Are_Kept);
+    RUN_TEST(test_Type_Hints_Are_Parsed);
+    RUN_TEST(test_For_Loop_Over_Struct_Array);
+    RUN_TEST(test_If_Else_And_Negation);
+    RUN_TEST(test_Include_With_Loop_Variable);
+    RUN_TEST(test_Unbalanced_Blocks_Are_Rejected);
+    RUN_TEST(test_Writers_Format_Numbers);
+    RUN_TEST(test_Writers_Do_Not_Copy_Strings);
+    RUN_TEST(test_Legacy_Converters_Still_Work);
+    RUN_TEST(test_Values_Are_Escaped_By_Context);
+    RUN_TEST(test_Escape_Long_Values);
+    RUN_TEST(test_Fragment_Cache_Reuses_Renders);
+    RUN_TEST(test_Include_With_Item_Is_Cached);
+    RUN_TEST(test_Edited_Template_Is_Reloaded);
+    RUN_TEST(test_Render_Html_Streams_Response);
+    RUN_TEST(test_Rendered_Body_Gets_Etag);
+    RUN_TEST(test_Static_Template_Etag_Is_Precomputed);
+    return UNITY_END();
+}
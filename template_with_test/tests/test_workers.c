@@ -0,0 +1,104 @@
+#include "unity/unity.h"
+#include "../.engine/WorkerStatus/WorkerStatus.h"
+#include "../.engine/Database/Database.h"
+#include <stdlib.h>
+#include <string.h>
+
+void setUp(void) {
+    WorkerStatus_init(3);
+    WorkerStatus_attach(1);
+}
+
+void tearDown(void) {
+    WorkerStatus_end();
+}
+
+static HTTPRequest request_for(const char *path) {
+    HTTPRequest request;
+    memset(&request, 0, sizeof(request));
+    strcpy(request.method, "GET");
+    request.path = (char *)path;
+    request.received_ns = HTTPServer_now_ns();
+    return request;
+}
+
+// The snapshot line of worker id, up to its closing brace
+static char *worker_line(const char *snapshot, int id) {
+    char key[32];
+    snprintf(key, sizeof(key), "{\"id\":%d,", id);
+    const char *start = strstr(snapshot, key);
+    if (!start) return NULL;
+    const char *end = strchr(start, '\n');
+    return strndup(start, end ? (size_t)(end - start) : strlen(start));
+}
+
+void test_Worker_States_Through_A_Request(void) {
+    HTTPRequest request = request_for("/wait");
+    WorkerStatus_begin(&request);
+
+    size_t len;
+    char *snapshot = WorkerStatus_render(2, request.received_ns, &len);
+    TEST_ASSERT_NOT_NULL(snapshot);
+    TEST_ASSERT_EQUAL_size_t(strlen(snapshot), len);
+    TEST_ASSERT_NOT_NULL(strstr(snapshot, "\"workers_busy\":1,\"queue_depth\":2,"));
+    char *line = worker_line(snapshot, 1);
+    TEST_ASSERT_NOT_NULL(strstr(line, "\"state\":\"handling\""));
+    TEST_ASSERT_NOT_NULL(strstr(line, "\"path\":\"/wait\""));
+    TEST_ASSERT_NOT_NULL(strstr(line, "\"request_ms\":"));
+    free(line);
+    line = worker_line(snapshot, 0);
+    TEST_ASSERT_NOT_NULL(strstr(line, "\"state\":\"idle\""));
+    TEST_ASSERT_NULL(strstr(line, "\"path\""));
+    free(line);
+    free(snapshot);
+
+    // Statements through the Database layer, with the SQL
+    db_statement_hook("SELECT \"name\" FROM users");
+    snapshot = WorkerStatus_render(0, 0, &len);
+    line = worker_line(snapshot, 1);
+    TEST_ASSERT_NOT_NULL(strstr(line, "\"state\":\"db\""));
+    TEST_ASSERT_NOT_NULL(strstr(line, "\"sql\":\"SELECT \\\"name\\\" FROM users\""));
+    free(line);
+    free(snapshot);
+    db_statement_hook(NULL);
+
+    // Rendering, then back to the handler
+    int64_t started = HTTPRequest_begin_phase(&request, HTTP_PHASE_RENDER);
+    snapshot = WorkerStatus_render(0, 0, &len);
+    TEST_ASSERT_NOT_NULL(strstr(snapshot, "\"state\":\"rendering\""));
+    free(snapshot);
+    HTTPRequest_add_phase(&request, HTTP_PHASE_RENDER, started);
+    snapshot = WorkerStatus_render(0, 0, &len);
+    line = worker_line(snapshot, 1);
+    TEST_ASSERT_NOT_NULL(strstr(line, "\"state\":\"handling\""));
+    TEST_ASSERT_NULL(strstr(line, "\"sql\""));
+    free(line);
+    free(snapshot);
+
+    WorkerStatus_end();
+    snapshot = WorkerStatus_render(0, 0, &len);
+    TEST_ASSERT_NOT_NULL(strstr(snapshot, "\"workers_busy\":0,"));
+    free(snapshot);
+}
+
+void test_Threads_Without_A_Slot_Are_Ignored(void) {
+    WorkerStatus_attach(7);
+    HTTPRequest request = request_for("/elsewhere");
+    WorkerStatus_begin(&request);
+    db_statement_hook("SELECT 1");
+    db_statement_hook(NULL);
+
+    size_t len;
+    char *snapshot = WorkerStatus_render(0, 0, &len);
+    TEST_ASSERT_NULL(strstr(snapshot, "/elsewhere"));
+    TEST_ASSERT_NOT_NULL(strstr(snapshot, "\"workers_busy\":0,"));
+    TEST_ASSERT_NULL(strstr(snapshot, "{\"id\":3,"));
+    free(snapshot);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_Worker_States_Through_A_Request);
+    RUN_TEST(test_Threads_Without_A_Slot_Are_Ignored);
+    return UNITY_END();
+}
@@ -1,6 +1,7 @@
 #include "HTTPFramework.h"
 #include "Database.h"
 #include "GeneratedModels.h"
+#include "GeneratedTemplates.h"
 #include <unistd.h> 
 #include <stdio.h>
 #include <stdlib.h>
@@ -57,17 +58,17 @@ void create_user_view(HTTPRequest *request, Database *db) {
         db_user = u; // fallback
     }
 
-    // ---- Template parameters ----
-    TemplateParam params[] = {
-        { "result",   result,             convert_string },
-        { "name",     db_user.name,       convert_string },
-        { "DNI",      db_user.DNI,        convert_string },
-        { "age",      &db_user.age,       convert_int    },
-        { "email",    db_user.email,      convert_string },
-        { "group_id", &db_user.group_id,  convert_int    },
+    // ---- Compiled template (see GeneratedTemplates.h) ----
+    Template_create_user page = {
+        .result   = result,
+        .name     = db_user.name,
+        .DNI      = db_user.DNI,
+        .age      = db_user.age,
+        .email    = db_user.email,
+        .group_id = db_user.group_id,
     };
 
-    render_html(request, "create_user.html", params, 6);
+    render_template_create_user(request, &page);
 
     // ---- Cleanup strdup'ed DB strings ----
     if (loaded) {
@@ -105,52 +106,29 @@ void example(HTTPRequest *request, Database *db) {
         {"Job 3", "Lorem ipsum dolor sit amet, consectetur adipiscing elit."}
     };
 
-    char* convert_projects(const void* value) {
-        const struct Project* projects = (const struct Project*)value;
-        // Allocate a large buffer for the HTML
-        char* buffer = malloc(4096);  // Adjust size as needed
-        buffer[0] = '\0';
-        
-        for (int i = 0; i < 3; i++) {  // Assuming 3 projects
-            char project_html[1024];
-            snprintf(project_html, sizeof(project_html),
-                "<div class=\"project\">"
-                    "<div>"
-                        "<h3>%s</h3>"
-                        "<p>%s</p>"
-                    "</div>"
-                    "<a href=\"#\" class=\"button\">View</a>"
-                "</div>",
-                projects[i].title, projects[i].description
-            );
-            strcat(buffer, project_html);
-        }
-        
-        return buffer;
-    }
-
-    char *jobsTemplate = malloc(4096);
-    jobsTemplate[0] = '\0';
+    // Field accessors used by {% for %} in example.html
+    const TemplateField project_fields[] = {
+        TEMPLATE_FIELD_WRITER(struct Project, title, write_string),
+        TEMPLATE_FIELD_WRITER(struct Project, description, write_string)
+    };
+    const TemplateField job_fields[] = {
+        TEMPLATE_FIELD_WRITER(struct Job, title, write_string),
+        TEMPLATE_FIELD_WRITER(struct Job, description, write_string)
+    };
 
-    for (int i = 0; i < 3; i++) {
-        TemplateParam params[] = {
-            {"title", jobs[i].title, NULL},
-            {"description", jobs[i].description, NULL}
-        };
-        strcat(jobsTemplate, process_html("label_content.html", params, 2));
-    }
+    TemplateList project_list = TEMPLATE_LIST(projects, 3, project_fields);
+    TemplateList job_list = TEMPLATE_LIST(jobs, 3, job_fields);
 
     // Create the template parameters
     TemplateParam params[] = {
-        {"name", &name, NULL},
-        {"title", &title, NULL},
-        {"about", &about, NULL},
-        {"image_url", &image_url, NULL},
-        {"year", "2024", NULL},
-        {"projects", projects, convert_projects},
-        {"jobs", jobsTemplate, NULL}
+        {"name", &name, NULL, write_string},
+        {"title", &title, NULL, write_string},
+        {"about", &about, NULL, write_string},
+        {"image_url", &image_url, NULL, write_string},
+        {"year", "2024", NULL, write_string},
+        {"projects", &project_list, NULL, write_list},
+        {"jobs", &job_list, NULL, write_list}
     };
 
     render_html(request, "example.html", params, 7);
-    free(jobsTemplate);
 }
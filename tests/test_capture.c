@@ -0,0 +1,168 @@
+#include "unity/unity.h"
+#include "../.engine/Capture/Capture.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static char capture_path[64];
+static char contents[1 << 20];
+
+void setUp(void) {
+    snprintf(capture_path, sizeof(capture_path), "/tmp/test_capture.%d.jsonl", (int)getpid());
+    unlink(capture_path);
+}
+
+void tearDown(void) {
+    Capture_stop();
+    unlink(capture_path);
+}
+
+static int read_capture(void) {
+    FILE *f = fopen(capture_path, "r");
+    if (!f) return 0;
+    size_t len = fread(contents, 1, sizeof(contents) - 1, f);
+    contents[len] = '\0';
+    fclose(f);
+
+    int lines = 0;
+    for (char *p = contents; (p = strchr(p, '\n')); p++) lines++;
+    return lines;
+}
+
+static HTTPRequest make_request(const char *path) {
+    HTTPRequest request = {0};
+    strcpy(request.method, "GET");
+    request.path = (char *)path;
+    request.received_ns = HTTPServer_now_ns();
+    return request;
+}
+
+void test_Line_Matches_Loadgen_Format(void) {
+    TEST_ASSERT_TRUE(Capture_start(capture_path, 1, 4096));
+    HTTPRequest request = make_request("/login");
+    strcpy(request.method, "POST");
+    request.query = "next=/home";
+    request.body = "user=\"ana\"\npass=x";
+    request.body_len = strlen(request.body);
+    HTTPRequest_add_header(&request, "Accept", "text/html");
+    HTTPRequest_add_header(&request, "X-Trace", "not kept");
+    Capture_request(&request);
+    Capture_stop();
+
+    TEST_ASSERT_EQUAL_INT(1, read_capture());
+    TEST_ASSERT_EQUAL_STRING("{\"method\":\"POST\",\"path\":\"/login\",\"query\":\"next=/home\","
+                             "\"headers\":{\"Accept\":\"text/html\"},"
+                             "\"body\":\"user=\\\"ana\\\"\\npass=x\",\"gap_ms\":0.000}\n", contents);
+    request.path = NULL;
+    request.query = NULL;
+    request.body = NULL;
+    HTTPRequest_free(&request);
+}
+
+void test_Credentials_Are_Scrubbed(void) {
+    TEST_ASSERT_TRUE(Capture_start(capture_path, 1, 4096));
+    HTTPRequest request = make_request("/account");
+    HTTPRequest_add_header(&request, "Cookie", "session=secret");
+    HTTPRequest_add_header(&request, "Authorization", "Bearer secret");
+    Capture_request(&request);
+    Capture_stop();
+
+    // Not in CAPTURE_HEADERS, and never with their values
+    read_capture();
+    TEST_ASSERT_NULL(strstr(contents, "secret"));
+    request.path = NULL;
+    HTTPRequest_free(&request);
+}
+
+void test_Sampling_Scales_Gaps_And_Cuts_Bodies(void) {
+    TEST_ASSERT_TRUE(Capture_start(capture_path, 2, 4));
+    HTTPRequest request = make_request("/items");
+    request.body = "0123456789";
+    request.body_len = 10;
+    int64_t t0 = request.received_ns;
+    for (int i = 0; i < 4; i++) {
+        request.received_ns = t0 + i * 10000000LL;     // every 10ms
+        Capture_request(&request);
+    }
+    Capture_stop();
+
+    // Requests 2 and 4 are taken, 20ms apart: 10ms per original request
+    TEST_ASSERT_EQUAL_INT(2, read_capture());
+    TEST_ASSERT_NOT_NULL(strstr(contents, "\"body\":\"0123\",\"gap_ms\":0.000}\n"));
+    TEST_ASSERT_NOT_NULL(strstr(contents, "\"gap_ms\":10.000}\n"));
+}
+
+void test_Disabled_Without_A_File(void) {
+    TEST_ASSERT_TRUE(Capture_start("", 1, 4096));
+    HTTPRequest request = make_request("/items");
+    Capture_request(&request);
+    Capture_stop();
+    TEST_ASSERT_EQUAL_INT(0, read_capture());
+}
+
+void test_Full_Ring_Drops_Instead_Of_Blocking(void) {
+    TEST_ASSERT_TRUE(Capture_start(capture_path, 1, 0));
+    uint64_t dropped_before = Capture_dropped();
+    HTTPRequest request = make_request("/burst");
+    for (int i = 0; i < 5000; i++) Capture_request(&request);
+    Capture_stop();
+
+    int captured = read_capture();
+    TEST_ASSERT_EQUAL_INT(5000, captured + (int)(Capture_dropped() - dropped_before));
+}
+
+#define CAPTURE_THREADS 8
+#define CAPTURE_PER_THREAD 2000
+
+static void *capture_burst(void *arg) {
+    HTTPRequest request = make_request(arg);
+    for (int i = 0; i < CAPTURE_PER_THREAD; i++) {
+        Capture_request(&request);
+        if (i % 64 == 0) usleep(100);
+    }
+    return NULL;
+}
+
+void test_Captures_From_Several_Threads(void) {
+    TEST_ASSERT_TRUE(Capture_start(capture_path, 1, 0));
+    uint64_t dropped_before = Capture_dropped();
+    static char paths[CAPTURE_THREADS][16];
+    pthread_t threads[CAPTURE_THREADS];
+    for (int i = 0; i < CAPTURE_THREADS; i++) {
+        snprintf(paths[i], sizeof(paths[i]), "/thread%d", i);
+        pthread_create(&threads[i], NULL, capture_burst, paths[i]);
+    }
+    for (int i = 0; i < CAPTURE_THREADS; i++) pthread_join(threads[i], NULL);
+    Capture_stop();
+
+    // Every line written once and whole, none lost but the counted drops
+    int captured = read_capture();
+    TEST_ASSERT_GREATER_THAN(0, captured);
+    TEST_ASSERT_EQUAL_INT(CAPTURE_THREADS * CAPTURE_PER_THREAD, captured + (int)(Capture_dropped() - dropped_before));
+    for (char *line = contents; *line; line = strchr(line, '\n') + 1) {
+        const char *prefix = "{\"method\":\"GET\",\"path\":\"/thread";
+        TEST_ASSERT_EQUAL_INT(0, strncmp(line, prefix, strlen(prefix)));
+        char *end = strchr(line, '\n');
+        TEST_ASSERT_EQUAL_CHAR('}', end[-1]);
+    }
+
+    // A restart begins with an empty ring
+    TEST_ASSERT_TRUE(Capture_start(capture_path, 1, 0));
+    HTTPRequest request = make_request("/after");
+    Capture_request(&request);
+    Capture_stop();
+    TEST_ASSERT_EQUAL_INT(captured + 1, read_capture());
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_Line_Matches_Loadgen_Format);
+    RUN_TEST(test_Credentials_Are_Scrubbed);
+    RUN_TEST(test_Sampling_Scales_Gaps_And_Cuts_Bodies);
+    RUN_TEST(test_Disabled_Without_A_File);
+    RUN_TEST(test_Full_Ring_Drops_Instead_Of_Blocking);
+    RUN_TEST(test_Captures_From_Several_Threads);
+    return UNITY_END();
+}
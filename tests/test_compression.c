@@ -0,0 +1,130 @@
+#include "unity/unity.h"
+#include "../.engine/Compression/Compression.h"
+#include "../.engine/HTTPServer/HTTPServer.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <zlib.h>
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// Inflates gzip or zlib data (windowBits 15 + 32 detects the header)
+static char *inflate_all(const char *data, size_t len, size_t *out_len) {
+    size_t cap = 65536;
+    char *out = malloc(cap);
+    z_stream stream = {0};
+    TEST_ASSERT_EQUAL_INT(Z_OK, inflateInit2(&stream, 15 + 32));
+    stream.next_in = (Bytef *)data;
+    stream.avail_in = len;
+    stream.next_out = (Bytef *)out;
+    stream.avail_out = cap;
+    TEST_ASSERT_EQUAL_INT(Z_STREAM_END, inflate(&stream, Z_FINISH));
+    *out_len = cap - stream.avail_out;
+    inflateEnd(&stream);
+    return out;
+}
+
+void test_Negotiate_Accept_Encoding(void) {
+    TEST_ASSERT_EQUAL_INT(ENCODING_IDENTITY, Compression_negotiate(NULL));
+    TEST_ASSERT_EQUAL_INT(ENCODING_IDENTITY, Compression_negotiate(""));
+    TEST_ASSERT_EQUAL_INT(ENCODING_IDENTITY, Compression_negotiate("br, identity"));
+    TEST_ASSERT_EQUAL_INT(ENCODING_GZIP, Compression_negotiate("gzip, deflate, br"));
+    TEST_ASSERT_EQUAL_INT(ENCODING_GZIP, Compression_negotiate("deflate, GZIP"));
+    TEST_ASSERT_EQUAL_INT(ENCODING_DEFLATE, Compression_negotiate("gzip;q=0.5, deflate"));
+    TEST_ASSERT_EQUAL_INT(ENCODING_DEFLATE, Compression_negotiate("gzip; q=0, *"));
+    TEST_ASSERT_EQUAL_INT(ENCODING_GZIP, Compression_negotiate("*"));
+    TEST_ASSERT_EQUAL_INT(ENCODING_IDENTITY, Compression_negotiate("*;q=0"));
+    TEST_ASSERT_EQUAL_INT(ENCODING_GZIP, Compression_negotiate("x-gzip"));
+    TEST_ASSERT_EQUAL_STRING("gzip", Compression_name(ENCODING_GZIP));
+    TEST_ASSERT_NULL(Compression_name(ENCODING_IDENTITY));
+}
+
+void test_Compress_Round_Trip(void) {
+    char text[4000];
+    for (size_t i = 0; i < sizeof(text); i++) text[i] = "<li>item</li>\n"[i % 14];
+    struct iovec iov[3] = {
+        { text, 1000 },
+        { text + 1000, 0 },
+        { text + 1000, 3000 }
+    };
+
+    for (int e = ENCODING_GZIP; e < ENCODING_COUNT; e++) {
+        // Twice, the second call reuses the thread's stream
+        for (int round = 0; round < 2; round++) {
+            const char *data;
+            size_t len;
+            TEST_ASSERT_TRUE(Compression_compress(e, iov, 3, &data, &len));
+            TEST_ASSERT_TRUE(len < sizeof(text) / 10);
+            if (e == ENCODING_GZIP) TEST_ASSERT_EQUAL_HEX8(0x1f, (unsigned char)data[0]);
+
+            size_t plain_len;
+            char *plain = inflate_all(data, len, &plain_len);
+            TEST_ASSERT_EQUAL_size_t(sizeof(text), plain_len);
+            TEST_ASSERT_EQUAL_MEMORY(text, plain, plain_len);
+            free(plain);
+        }
+    }
+    TEST_ASSERT_FALSE(Compression_compress(ENCODING_IDENTITY, iov, 3, &(const char *){0}, &(size_t){0}));
+}
+
+static char *send_and_read(const char *accept_encoding, const char *body, const char *content_type) {
+    int fds[2];
+    TEST_ASSERT_EQUAL_INT(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    HTTPRequest request = {0};
+    request.client_socket = fds[0];
+    if (accept_encoding) HTTPRequest_add_header(&request, "Accept-Encoding", accept_encoding);
+
+    struct iovec iov = { (void *)body, strlen(body) };
+    HTTPServer_send_response_headers(&request, &iov, 1, content_type, 200, "", "ETag: \"0123456789abcdef\"\r\n");
+    HTTPRequest_free(&request);
+
+    size_t cap = 65536, len = 0;
+    char *buf = malloc(cap);
+    ssize_t n;
+    while ((n = read(fds[1], buf + len, cap - len - 1)) > 0) len += n;
+    buf[len] = '\0';
+    close(fds[1]);
+    return buf;
+}
+
+void test_Send_Response_Compresses_Large_Text(void) {
+    char *page = malloc(8001);
+    for (int i = 0; i < 8000; i++) page[i] = "<p>hello</p>"[i % 12];
+    page[8000] = '\0';
+
+    char *gzipped = send_and_read("gzip", page, "");
+    TEST_ASSERT_NOT_NULL(strstr(gzipped, "Content-Encoding: gzip\r\n"));
+    TEST_ASSERT_NOT_NULL(strstr(gzipped, "Vary: Accept-Encoding\r\n"));
+    TEST_ASSERT_NOT_NULL(strstr(gzipped, "ETag: W/\"0123456789abcdef\"\r\n"));
+    TEST_ASSERT_NULL(strstr(gzipped, "Content-Length: 8000"));
+
+    // Identity still says the body depends on Accept-Encoding
+    char *plain = send_and_read(NULL, page, "");
+    TEST_ASSERT_NULL(strstr(plain, "Content-Encoding"));
+    TEST_ASSERT_NOT_NULL(strstr(plain, "Vary: Accept-Encoding\r\n"));
+    TEST_ASSERT_NOT_NULL(strstr(plain, "ETag: \"0123456789abcdef\"\r\n"));
+    TEST_ASSERT_NOT_NULL(strstr(plain, "Content-Length: 8000\r\n"));
+
+    // Small bodies and binary types are left alone
+    char *small = send_and_read("gzip", "<p>short</p>", "");
+    TEST_ASSERT_NULL(strstr(small, "Content-Encoding"));
+    char *binary = send_and_read("gzip", page, "image/png");
+    TEST_ASSERT_NULL(strstr(binary, "Content-Encoding"));
+
+    free(gzipped);
+    free(plain);
+    free(small);
+    free(binary);
+    free(page);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_Negotiate_Accept_Encoding);
+    RUN_TEST(test_Compress_Round_Trip);
+    RUN_TEST(test_Send_Response_Compresses_Large_Text);
+    return UNITY_END();
+}
@@ -0,0 +1,143 @@
+#include "unity/unity.h"
+#include "../.engine/Metrics/Metrics.h"
+#include "../.engine/Database/Database.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static const char *const route_names[] = { "/", "/user/<id>", "/say \"hi\"" };
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static HTTPRequest finished(int status, int64_t queue_ns, int64_t write_ns) {
+    HTTPRequest request = {0};
+    request.status_code = status;
+    request.received_ns = HTTPServer_now_ns() - queue_ns - write_ns;
+    request.phase_ns[HTTP_PHASE_QUEUE] = queue_ns;
+    request.phase_ns[HTTP_PHASE_WRITE] = write_ns;
+    return request;
+}
+
+static char *scrape(void) {
+    size_t len;
+    char *text = Metrics_render(&len);
+    TEST_ASSERT_NOT_NULL(text);
+    TEST_ASSERT_EQUAL_size_t(strlen(text), len);
+    return text;
+}
+
+void test_Counts_By_Route_And_Status(void) {
+    for (int i = 0; i < 3; i++) {
+        HTTPRequest r = finished(200, 1000, 1000);
+        Metrics_end(&r, 1);
+    }
+    HTTPRequest missing = finished(404, 1000, 1000);
+    Metrics_end(&missing, METRICS_ROUTE_UNMATCHED);
+    HTTPRequest hit = finished(304, 0, 0);
+    Metrics_end(&hit, METRICS_ROUTE_CACHE);
+    // Parked behind a coalesced leader, no status of its own
+    HTTPRequest parked = finished(0, 0, 0);
+    Metrics_end(&parked, 1);
+
+    char *text = scrape();
+    TEST_ASSERT_NOT_NULL(strstr(text, "http_requests_total{route=\"/user/<id>\",code=\"200\"} 3\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "http_requests_total{route=\"(unmatched)\",code=\"404\"} 1\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "http_requests_total{route=\"(response cache)\",code=\"304\"} 1\n"));
+    TEST_ASSERT_NULL(strstr(text, "code=\"0\""));
+    free(text);
+}
+
+void test_Histogram_Buckets_Are_Cumulative(void) {
+    // 100 us and 3 ms of queueing
+    HTTPRequest fast = finished(200, 100000, 0);
+    HTTPRequest slow = finished(200, 3000000, 0);
+    Metrics_end(&fast, 0);
+    Metrics_end(&slow, 0);
+
+    char *text = scrape();
+    TEST_ASSERT_NOT_NULL(strstr(text, "{route=\"/\",phase=\"queue\",le=\"6.4e-05\"} 0\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "{route=\"/\",phase=\"queue\",le=\"0.000128\"} 1\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "{route=\"/\",phase=\"queue\",le=\"0.002048\"} 1\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "{route=\"/\",phase=\"queue\",le=\"0.004096\"} 2\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "{route=\"/\",phase=\"queue\",le=\"+Inf\"} 2\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "http_request_duration_seconds_sum{route=\"/\",phase=\"queue\"} 0.003100000\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "http_request_duration_seconds_count{route=\"/\",phase=\"total\"} 2\n"));
+    free(text);
+}
+
+void test_Db_Time_Goes_To_The_Current_Request(void) {
+    TEST_ASSERT_NOT_NULL(db_timing_hook);
+    HTTPRequest r = finished(200, 0, 0);
+    Metrics_begin(&r);
+    db_timing_hook(250000);
+    db_timing_hook(250000);
+    Metrics_end(&r, 2);
+    TEST_ASSERT_EQUAL_INT64(500000, r.phase_ns[HTTP_PHASE_DB]);
+
+    // Outside of a request nothing is charged
+    db_timing_hook(250000);
+    TEST_ASSERT_EQUAL_INT64(500000, r.phase_ns[HTTP_PHASE_DB]);
+
+    char *text = scrape();
+    TEST_ASSERT_NOT_NULL(strstr(text, "_sum{route=\"/say \\\"hi\\\"\",phase=\"db\"} 0.000500000\n"));
+    free(text);
+}
+
+void test_Gauges(void) {
+    Metrics_gauge_add(METRICS_QUEUE_DEPTH, 3);
+    Metrics_gauge_add(METRICS_QUEUE_DEPTH, -1);
+    Metrics_gauge_add(METRICS_ACTIVE_WORKERS, 2);
+    Metrics_db_reconnect();
+
+    char *text = scrape();
+    TEST_ASSERT_NOT_NULL(strstr(text, "\nhttp_queue_depth 2\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "\nhttp_active_workers 2\n"));
+    TEST_ASSERT_NOT_NULL(strstr(text, "\ndb_reconnects_total 1\n"));
+    free(text);
+    Metrics_gauge_add(METRICS_QUEUE_DEPTH, -2);
+    Metrics_gauge_add(METRICS_ACTIVE_WORKERS, -2);
+}
+
+static void *record_from_thread(void *arg) {
+    (void)arg;
+    for (int i = 0; i < 1000; i++) {
+        HTTPRequest r = finished(201, 0, 0);
+        Metrics_end(&r, 0);
+    }
+    return NULL;
+}
+
+void test_Other_Threads_And_Processes_Are_Merged(void) {
+    pthread_t thread;
+    pthread_create(&thread, NULL, record_from_thread, NULL);
+    pthread_join(thread, NULL);
+
+    // A second worker process records into the shared region
+    pid_t pid = fork();
+    if (pid == 0) {
+        Metrics_attach(1);
+        record_from_thread(NULL);
+        _exit(0);
+    }
+    waitpid(pid, NULL, 0);
+
+    char *text = scrape();
+    TEST_ASSERT_NOT_NULL(strstr(text, "http_requests_total{route=\"/\",code=\"201\"} 2000\n"));
+    free(text);
+}
+
+int main(void) {
+    TEST_ASSERT_TRUE(Metrics_init(2, 2, route_names, 3));
+    Metrics_attach(0);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_Counts_By_Route_And_Status);
+    RUN_TEST(test_Histogram_Buckets_Are_Cumulative);
+    RUN_TEST(test_Db_Time_Goes_To_The_Current_Request);
+    RUN_TEST(test_Gauges);
+    RUN_TEST(test_Other_Threads_And_Processes_Are_Merged);
+    return UNITY_END();
+}
@@ -0,0 +1,338 @@
+#include "unity/unity.h"
+#include "../.engine/ResponseCache/ResponseCache.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+void setUp(void) {
+    ResponseCache_clear();
+}
+
+void tearDown(void) {}
+
+static HTTPRequest make_request(const char *method, const char *path, const char *query) {
+    HTTPRequest request = {0};
+    strcpy(request.method, method);
+    request.path = strdup(path);
+    request.query = query ? strdup(query) : NULL;
+    request.client_socket = -1;
+    return request;
+}
+
+// Serves the request over a socketpair and returns what the client got, NULL on a miss
+static char *serve(HTTPRequest *request) {
+    int fds[2];
+    TEST_ASSERT_EQUAL_INT(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    request->client_socket = fds[0];
+
+    if (!ResponseCache_serve(request, true)) {
+        close(fds[0]);
+        close(fds[1]);
+        return NULL;
+    }
+
+    char *buf = calloc(1, 4096);
+    size_t len = 0;
+    ssize_t n;
+    while ((n = read(fds[1], buf + len, 4095 - len)) > 0) len += n;
+    close(fds[1]);
+    return buf;
+}
+
+static void store_for(HTTPRequest *request, const char *response, int ttl, int stale) {
+    struct iovec iov[2] = {
+        { (void *)"HTTP/1.1 200 OK\r\n\r\n", 19 },
+        { (void *)response, strlen(response) }
+    };
+    ResponseCache_store(request, ttl, stale, iov, 2);
+}
+
+static void store(HTTPRequest *request, const char *response) {
+    store_for(request, response, 5, 0);
+}
+
+void test_Hit_Serves_Stored_Bytes(void) {
+    HTTPRequest request = make_request("GET", "/example", "page=1");
+    TEST_ASSERT_NULL(serve(&request));
+
+    store(&request, "cached body");
+    char *response = serve(&request);
+    TEST_ASSERT_EQUAL_STRING("HTTP/1.1 200 OK\r\n\r\ncached body", response);
+    free(response);
+
+    // Query and vary headers are part of the key
+    HTTPRequest other_query = make_request("GET", "/example", "page=2");
+    TEST_ASSERT_NULL(serve(&other_query));
+
+    HTTPRequest other_language = make_request("GET", "/example", "page=1");
+    HTTPRequest_add_header(&other_language, "Accept-Language", "ca");
+    TEST_ASSERT_NULL(serve(&other_language));
+
+    HTTPRequest_free(&request);
+    HTTPRequest_free(&other_query);
+    HTTPRequest_free(&other_language);
+}
+
+void test_Large_Hit_Left_To_A_Thread_That_May_Block(void) {
+    HTTPRequest request = make_request("GET", "/large", NULL);
+    int fds[2];
+    TEST_ASSERT_EQUAL_INT(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    int buffer = 0;
+    socklen_t len = sizeof(buffer);
+    getsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &buffer, &len);
+
+    // More than the socket takes while its client reads nothing
+    size_t size = (size_t)buffer * 2;
+    char *body = malloc(size + 1);
+    memset(body, 'x', size);
+    body[size] = '\0';
+    store(&request, body);
+    request.client_socket = fds[0];
+    TEST_ASSERT_FALSE(ResponseCache_serve(&request, false));
+
+    // A small one is written without waiting for the client
+    HTTPRequest small = make_request("GET", "/small", NULL);
+    store(&small, "small body");
+    small.client_socket = fds[0];
+    TEST_ASSERT_TRUE(ResponseCache_serve(&small, false));
+    char buf[64] = "";
+    size_t got = 0;
+    ssize_t n;
+    while ((n = read(fds[1], buf + got, sizeof(buf) - 1 - got)) > 0) got += n;
+    TEST_ASSERT_EQUAL_STRING("HTTP/1.1 200 OK\r\n\r\nsmall body", buf);
+
+    close(fds[1]);
+    free(body);
+    HTTPRequest_free(&request);
+    HTTPRequest_free(&small);
+}
+
+void test_Matching_Etag_Gets_Not_Modified(void) {
+    HTTPRequest request = make_request("GET", "/tagged", NULL);
+    const char *headers = "HTTP/1.1 200 OK\r\nETag: \"00000000000000aa\"\r\n\r\n";
+    struct iovec iov[2] = {
+        { (void *)headers, strlen(headers) },
+        { (void *)"tagged body", 11 }
+    };
+    ResponseCache_store(&request, 5, 0, iov, 2);
+
+    HTTPRequest_add_header(&request, "If-None-Match", "\"00000000000000aa\"");
+    char *response = serve(&request);
+    TEST_ASSERT_EQUAL_STRING("HTTP/1.1 304 Not Modified\r\nETag: \"00000000000000aa\"\r\nConnection: close\r\n\r\n", response);
+    free(response);
+
+    HTTPRequest other = make_request("GET", "/tagged", NULL);
+    HTTPRequest_add_header(&other, "If-None-Match", "\"00000000000000bb\"");
+    response = serve(&other);
+    TEST_ASSERT_NOT_NULL(strstr(response, "tagged body"));
+    free(response);
+
+    HTTPRequest_free(&request);
+    HTTPRequest_free(&other);
+}
+
+void test_Only_Anonymous_Gets_Are_Cached(void) {
+    HTTPRequest post = make_request("POST", "/example", NULL);
+    HTTPRequest with_cookie = make_request("GET", "/example", NULL);
+    HTTPRequest_add_header(&with_cookie, "Cookie", "session=1");
+
+    TEST_ASSERT_FALSE(ResponseCache_cacheable(&post));
+    TEST_ASSERT_FALSE(ResponseCache_cacheable(&with_cookie));
+
+    store(&with_cookie, "private");
+    TEST_ASSERT_NULL(serve(&with_cookie));
+
+    HTTPRequest_free(&post);
+    HTTPRequest_free(&with_cookie);
+}
+
+static void capture(HTTPRequest *request, int status_code, const struct iovec *iov, int iov_count) {
+    TEST_ASSERT_EQUAL_INT(200, status_code);
+    ResponseCache_store(request, 5, 0, iov, iov_count);
+}
+
+void test_Response_Hook_Fills_Cache(void) {
+    int fds[2];
+    TEST_ASSERT_EQUAL_INT(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+
+    HTTPRequest request = make_request("GET", "/", NULL);
+    request.client_socket = fds[0];
+    request.on_response = capture;
+    HTTPServer_send_response(&request, "<h1>home</h1>", "", 200, "");
+    close(fds[1]);
+
+    request.on_response = NULL;
+    char *response = serve(&request);
+    TEST_ASSERT_NOT_NULL(response);
+    TEST_ASSERT_EQUAL_INT(0, strncmp(response, "HTTP/1.1 200 OK\r\n", 17));
+    TEST_ASSERT_NOT_NULL(strstr(response, "Content-Length: 13\r\n\r\n<h1>home</h1>"));
+    free(response);
+    HTTPRequest_free(&request);
+}
+
+static char *read_all(int fd) {
+    char *buf = calloc(1, 4096);
+    size_t len = 0;
+    ssize_t n;
+    while ((n = read(fd, buf + len, 4095 - len)) > 0) len += n;
+    close(fd);
+    return buf;
+}
+
+void test_Identical_Requests_Share_One_Response(void) {
+    int waiter_fds[2][2];
+    HTTPRequest leader = make_request("GET", "/example", NULL);
+    HTTPRequest waiters[2];
+
+    TEST_ASSERT_FALSE(ResponseCache_join(&leader));
+    for (int i = 0; i < 2; i++) {
+        TEST_ASSERT_EQUAL_INT(0, socketpair(AF_UNIX, SOCK_STREAM, 0, waiter_fds[i]));
+        waiters[i] = make_request("GET", "/example", NULL);
+        waiters[i].client_socket = waiter_fds[i][0];
+        TEST_ASSERT_TRUE(ResponseCache_join(&waiters[i]));
+    }
+
+    // A different key is not coalesced
+    HTTPRequest other = make_request("GET", "/", NULL);
+    TEST_ASSERT_FALSE(ResponseCache_join(&other));
+    ResponseCache_abandon(&other);
+
+    struct iovec iov[2] = {
+        { (void *)"HTTP/1.1 200 OK\r\n\r\n", 19 },
+        { (void *)"shared", 6 }
+    };
+    ResponseCache_complete(&leader, iov, 2);
+
+    for (int i = 0; i < 2; i++) {
+        char *response = read_all(waiter_fds[i][1]);
+        TEST_ASSERT_EQUAL_STRING("HTTP/1.1 200 OK\r\n\r\nshared", response);
+        free(response);
+        HTTPRequest_free(&waiters[i]);
+    }
+
+    // The flight is over, the next request leads again
+    TEST_ASSERT_FALSE(ResponseCache_join(&leader));
+    ResponseCache_abandon(&leader);
+    HTTPRequest_free(&leader);
+    HTTPRequest_free(&other);
+}
+
+static void complete_flight(HTTPRequest *request, int status_code, const struct iovec *iov, int iov_count) {
+    (void)status_code;
+    ResponseCache_complete(request, iov, iov_count);
+}
+
+typedef struct {
+    int fd;
+    size_t len;
+    int64_t done_ns;
+} Reader;
+
+static void *read_to_end(void *arg) {
+    Reader *r = arg;
+    char buf[65536];
+    ssize_t n;
+    while ((n = read(r->fd, buf, sizeof(buf))) > 0) r->len += n;
+    r->done_ns = HTTPServer_now_ns();
+    close(r->fd);
+    return NULL;
+}
+
+void test_Stalled_Waiter_Holds_Nobody(void) {
+    // Far more than a socket buffer, so the stalled client blocks the write
+    size_t size = 8 << 20;
+    char *body = malloc(size);
+    memset(body, 'x', size);
+
+    int leader_fds[2], stalled_fds[2], reading_fds[2];
+    TEST_ASSERT_EQUAL_INT(0, socketpair(AF_UNIX, SOCK_STREAM, 0, leader_fds));
+    TEST_ASSERT_EQUAL_INT(0, socketpair(AF_UNIX, SOCK_STREAM, 0, stalled_fds));
+    TEST_ASSERT_EQUAL_INT(0, socketpair(AF_UNIX, SOCK_STREAM, 0, reading_fds));
+    HTTPRequest leader = make_request("GET", "/example", NULL);
+    HTTPRequest stalled = make_request("GET", "/example", NULL);
+    HTTPRequest reading = make_request("GET", "/example", NULL);
+    leader.client_socket = leader_fds[0];
+    stalled.client_socket = stalled_fds[0];
+    reading.client_socket = reading_fds[0];
+    TEST_ASSERT_FALSE(ResponseCache_join(&leader));
+    TEST_ASSERT_TRUE(ResponseCache_join(&stalled));
+    TEST_ASSERT_TRUE(ResponseCache_join(&reading));
+
+    Reader readers[2] = { { leader_fds[1], 0, 0 }, { reading_fds[1], 0, 0 } };
+    pthread_t threads[2];
+    for (int i = 0; i < 2; i++) pthread_create(&threads[i], NULL, read_to_end, &readers[i]);
+
+    leader.on_response = complete_flight;
+    struct iovec iov = { body, size };
+    int64_t started = HTTPServer_now_ns();
+    HTTPServer_send_response_iov(&leader, &iov, 1, "text/plain", 200, "");
+    int64_t finished = HTTPServer_now_ns();
+    for (int i = 0; i < 2; i++) pthread_join(threads[i], NULL);
+
+    // The leader's client had it all before the stalled waiter's timeout
+    TEST_ASSERT_GREATER_THAN(size, readers[0].len);
+    TEST_ASSERT_EQUAL_size_t(readers[0].len, readers[1].len);
+    TEST_ASSERT_LESS_THAN_INT64(900000000LL, readers[0].done_ns - started);
+    // The stalled one costs its send timeout, not forever
+    TEST_ASSERT_LESS_THAN_INT64(5000000000LL, finished - started);
+
+    close(stalled_fds[1]);
+    free(body);
+    HTTPRequest_free(&leader);
+    HTTPRequest_free(&stalled);
+    HTTPRequest_free(&reading);
+}
+
+void test_Abandoned_Flight_Answers_Waiters(void) {
+    int fds[2];
+    TEST_ASSERT_EQUAL_INT(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    HTTPRequest leader = make_request("GET", "/example", NULL);
+    HTTPRequest waiter = make_request("GET", "/example", NULL);
+    waiter.client_socket = fds[0];
+
+    TEST_ASSERT_FALSE(ResponseCache_join(&leader));
+    TEST_ASSERT_TRUE(ResponseCache_join(&waiter));
+    ResponseCache_abandon(&leader);
+
+    char *response = read_all(fds[1]);
+    TEST_ASSERT_EQUAL_INT(0, strncmp(response, "HTTP/1.1 503", 12));
+    free(response);
+    HTTPRequest_free(&leader);
+    HTTPRequest_free(&waiter);
+}
+
+void test_Stale_Copy_Served_While_Refreshing(void) {
+    HTTPRequest request = make_request("GET", "/example", NULL);
+    store_for(&request, "old", 1, 30);
+    usleep(1100 * 1000);
+
+    // Expired and nobody refreshing: the request has to go to a worker
+    TEST_ASSERT_NULL(serve(&request));
+
+    HTTPRequest refresher = make_request("GET", "/example", NULL);
+    TEST_ASSERT_FALSE(ResponseCache_join(&refresher));
+    char *response = serve(&request);
+    TEST_ASSERT_EQUAL_STRING("HTTP/1.1 200 OK\r\n\r\nold", response);
+    free(response);
+
+    ResponseCache_abandon(&refresher);
+    TEST_ASSERT_NULL(serve(&request));
+    HTTPRequest_free(&request);
+    HTTPRequest_free(&refresher);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_Hit_Serves_Stored_Bytes);
+    RUN_TEST(test_Large_Hit_Left_To_A_Thread_That_May_Block);
+    RUN_TEST(test_Matching_Etag_Gets_Not_Modified);
+    RUN_TEST(test_Only_Anonymous_Gets_Are_Cached);
+    RUN_TEST(test_Response_Hook_Fills_Cache);
+    RUN_TEST(test_Identical_Requests_Share_One_Response);
+    RUN_TEST(test_Stalled_Waiter_Holds_Nobody);
+    RUN_TEST(test_Abandoned_Flight_Answers_Waiters);
+    RUN_TEST(test_Stale_Copy_Served_While_Refreshing);
+    return UNITY_END();
+}
@@ -0,0 +1,180 @@
+#include "unity/unity.h"
+#define main template_compiler_main
+#include "../.engine/HTMLTemplating/TemplateCompiler.c"
+#undef main
+#include <dlfcn.h>
+#include <unistd.h>
+
+// Compiled templates are built into a shared object at test time and
+// loaded back, their output is compared with the runtime renderer's.
+// The object resolves the engine's symbols against this binary.
+
+#define CARD_PATH "_aot_card.html"
+
+typedef struct {
+    char title[16];
+    bool remote;
+} TestJob;
+
+typedef char *(*AotRender)(const TemplateList *jobs, const char *company, bool remote);
+
+static void template_file_path(const char *name, char *path, size_t size) {
+    snprintf(path, size, "%s/%s", TEMPLATE_DIR, name);
+}
+
+void setUp(void) {}
+
+// Also after a failed assertion, which skips the rest of the test
+void tearDown(void) {
+    char path[256];
+    template_file_path(CARD_PATH, path, sizeof(path));
+    unlink(path);
+}
+
+static void write_template(const char *name, const char *content) {
+    char path[256];
+    template_file_path(name, path, sizeof(path));
+    FILE *file = fopen(path, "w");
+    TEST_ASSERT_NOT_NULL(file);
+    fputs(content, file);
+    fclose(file);
+}
+
+static char *render_string(const char *content, TemplateParam *params, int param_count) {
+    Template tpl = {0};
+    tpl.content = (char *)content;
+    tpl.content_len = strlen(content);
+    if (!template_parse(&tpl)) return NULL;
+
+    TemplateOutput out;
+    template_output_init(&out);
+    char *html = template_render(&tpl, params, param_count, &out) ? template_output_join(&out) : NULL;
+    template_output_free(&out);
+    free(tpl.segments);
+    return html;
+}
+
+// Runs both compiler passes over content the way generate_template_files
+// does, then builds it with CC and CFLAGS from the Makefile
+static void *compile_string(const char *content, const char *ident) {
+    const char *cc = getenv("CC");
+    const char *cflags = getenv("CFLAGS");
+    if (!cc || !cflags) TEST_IGNORE_MESSAGE("CC and CFLAGS come from make test");
+
+    Template tpl = {0};
+    tpl.content = (char *)content;
+    tpl.content_len = strlen(content);
+    TEST_ASSERT_TRUE(template_parse(&tpl));
+
+    CompileContext *ctx = calloc(1, sizeof(CompileContext));
+    TEST_ASSERT_NOT_NULL(ctx);
+    ctx->ident = ident;
+    ctx->path = ident;
+    ctx->ok = true;
+    compile_range(ctx, &tpl, 0, tpl.segment_count);
+    TEST_ASSERT_TRUE(ctx->ok);
+
+    char path_h[256], path_c[256], path_so[256];
+    mkdir(".cache/templates", 0755);
+    snprintf(path_h, sizeof(path_h), ".cache/templates/%s.h", ident);
+    snprintf(path_c, sizeof(path_c), ".cache/templates/%s.c", ident);
+    snprintf(path_so, sizeof(path_so), ".cache/templates/%s.so", ident);
+
+    FILE *fh = fopen(path_h, "w");
+    TEST_ASSERT_NOT_NULL(fh);
+    write_header(ctx, fh, ident);
+    fclose(fh);
+
+    FILE *fc = fopen(path_c, "w");
+    TEST_ASSERT_NOT_NULL(fc);
+    fprintf(fc, "#include \"%s.h\"\n\n", ident);
+    char *body_buf = NULL;
+    size_t body_len = 0;
+    ctx->emitting = true;
+    ctx->fc = fc;
+    ctx->body = open_memstream(&body_buf, &body_len);
+    ctx->indent = 1;
+    ctx->loop_count = 0;
+    compile_range(ctx, &tpl, 0, tpl.segment_count);
+    fclose(ctx->body);
+    fprintf(fc, "bool template_%s(const Template_%s *p, TemplateOutput *out) {\n", ident, ident);
+    fwrite(body_buf, 1, body_len, fc);
+    fprintf(fc, "    return true;\n}\n\n");
+    fprintf(fc,
+        "char *aot_render(const TemplateList *jobs, const char *company, bool remote) {\n"
+        "    Template_%s p = { .jobs = jobs, .company = company, .remote = remote };\n"
+        "    TemplateOutput out;\n"
+        "    template_output_init(&out);\n"
+        "    char *html = template_%s(&p, &out) ? template_output_join(&out) : NULL;\n"
+        "    template_output_free(&out);\n"
+        "    return html;\n"
+        "}\n",
+        ident, ident);
+    fclose(fc);
+    free(body_buf);
+    TEST_ASSERT_TRUE(ctx->ok);
+    free(ctx);
+    free(tpl.segments);
+
+    char command[4096];
+    snprintf(command, sizeof(command), "%s %s -shared -fPIC -o %s %s", cc, cflags, path_so, path_c);
+    TEST_ASSERT_EQUAL_INT(0, system(command));
+
+    void *so = dlopen(path_so, RTLD_NOW | RTLD_LOCAL);
+    if (!so) TEST_FAIL_MESSAGE(dlerror());
+    unlink(path_h);
+    unlink(path_c);
+    unlink(path_so);
+    return so;
+}
+
+// A bare key in an "include ... with" partial reads the item's field when
+// the list has one and the page's param otherwise, compiled or not
+void test_Compiled_Include_Falls_Back_To_Params(void) {
+    write_template(CARD_PATH, "{{title}}@{{company}}{% if remote:bool %}*{% endif %};");
+    const char *page = "{% for job in jobs %}{% include \"" CARD_PATH "\" with job %}{% endfor %}";
+
+    TestJob jobs[] = { {"Job 1", false}, {"Job 2", true} };
+    const TemplateField title_only[] = {
+        TEMPLATE_FIELD_WRITER(TestJob, title, write_string)
+    };
+    const TemplateField with_remote[] = {
+        TEMPLATE_FIELD_WRITER(TestJob, title, write_string),
+        TEMPLATE_FIELD_WRITER(TestJob, remote, write_bool)
+    };
+    TemplateList lists[] = {
+        TEMPLATE_LIST(jobs, 2, title_only),
+        TEMPLATE_LIST(jobs, 2, with_remote)
+    };
+    const char *expected[] = {
+        "Job 1@Acme*;Job 2@Acme*;",
+        "Job 1@Acme;Job 2@Acme*;"
+    };
+
+    void *so = compile_string(page, "_aot_fallback");
+    AotRender aot_render = (AotRender)dlsym(so, "aot_render");
+    TEST_ASSERT_NOT_NULL(aot_render);
+
+    bool remote = true;
+    for (int i = 0; i < 2; i++) {
+        TemplateParam params[] = {
+            {"jobs", &lists[i], NULL, write_list},
+            {"company", "Acme", NULL, write_string},
+            {"remote", &remote, NULL, write_bool}
+        };
+        char *runtime = render_string(page, params, 3);
+        char *compiled = aot_render(&lists[i], "Acme", remote);
+        TEST_ASSERT_EQUAL_STRING(expected[i], runtime);
+        TEST_ASSERT_EQUAL_STRING(runtime, compiled);
+        free(runtime);
+        free(compiled);
+    }
+
+    dlclose(so);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_Compiled_Include_Falls_Back_To_Params);
+    return UNITY_END();
+}
@@ -0,0 +1,222 @@
+#include "unity/unity.h"
+#include "../.engine/TLS/TLS.h"
+#include "../.engine/HTTPServer/HTTPServer.h"
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+#include <openssl/pem.h>
+
+static char cert_path[] = "/tmp/test_tls_crt.XXXXXX";
+static char key_path[] = "/tmp/test_tls_key.XXXXXX";
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// Self-signed P-256 certificate for localhost, written as PEM files
+static void write_test_certificate(void) {
+    strcpy(cert_path, "/tmp/test_tls_crt.XXXXXX");
+    strcpy(key_path, "/tmp/test_tls_key.XXXXXX");
+    EVP_PKEY *key = EVP_EC_gen("P-256");
+    X509 *cert = X509_new();
+    X509_set_version(cert, 2);
+    ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+    X509_gmtime_adj(X509_getm_notBefore(cert), 0);
+    X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+    X509_set_pubkey(cert, key);
+    X509_NAME *name = X509_get_subject_name(cert);
+    X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char *)"localhost", -1, -1, 0);
+    X509_set_issuer_name(cert, name);
+    X509_sign(cert, key, EVP_sha256());
+
+    FILE *f = fdopen(mkstemp(cert_path), "w");
+    PEM_write_X509(f, cert);
+    fclose(f);
+    f = fdopen(mkstemp(key_path), "w");
+    PEM_write_PrivateKey(f, key, NULL, NULL, 0, NULL, NULL);
+    fclose(f);
+
+    X509_free(cert);
+    EVP_PKEY_free(key);
+}
+
+// Server side of one connection: handshake, read the request, answer it
+static void *serve_one(void *arg) {
+    int fd = *(int *)arg;
+    HTTPRequest request = {0};
+    request.client_socket = fd;
+    request.tls = TLS_accept(fd);
+    if (!request.tls) {
+        close(fd);
+        return NULL;
+    }
+
+    char buf[1024];
+    ssize_t n = TLS_read(request.tls, buf, sizeof(buf) - 1);
+    if (n > 0) {
+        buf[n] = '\0';
+        HTTPServer_send_response(&request, strstr(buf, "GET /hello") ? "hello over tls" : "?", "text/plain", 200, "");
+    } else {
+        HTTPServer_close(fd, request.tls);
+    }
+    return NULL;
+}
+
+// One request from a client, returns the response and whether the session was resumed
+static char *fetch(SSL_CTX *client_ctx, SSL_SESSION **session, bool *resumed) {
+    int fds[2];
+    TEST_ASSERT_EQUAL_INT(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+    pthread_t server;
+    pthread_create(&server, NULL, serve_one, &fds[0]);
+
+    SSL *ssl = SSL_new(client_ctx);
+    SSL_set_fd(ssl, fds[1]);
+    if (*session) SSL_set_session(ssl, *session);
+    TEST_ASSERT_EQUAL_INT(1, SSL_connect(ssl));
+
+    const char *request = "GET /hello HTTP/1.1\r\nHost: localhost\r\n\r\n";
+    TEST_ASSERT_EQUAL_INT((int)strlen(request), SSL_write(ssl, request, strlen(request)));
+
+    char *response = calloc(1, 4096);
+    int len = 0, n;
+    while ((n = SSL_read(ssl, response + len, 4095 - len)) > 0) len += n;
+    *resumed = SSL_session_reused(ssl);
+
+    SSL_SESSION_free(*session);
+    *session = SSL_get1_session(ssl);
+    SSL_shutdown(ssl);  // without it SSL_free marks the session unusable
+    SSL_free(ssl);
+    close(fds[1]);
+    pthread_join(server, NULL);
+    return response;
+}
+
+void test_Tls_Disabled_Without_Certificate(void) {
+    TEST_ASSERT_FALSE(TLS_init("", ""));
+    TEST_ASSERT_FALSE(TLS_init("/nonexistent.crt", "/nonexistent.key"));
+    TEST_ASSERT_FALSE(TLS_enabled());
+    TEST_ASSERT_NULL(TLS_accept(-1));
+}
+
+void test_Response_Over_Tls_And_Resumption(void) {
+    write_test_certificate();
+    TEST_ASSERT_TRUE(TLS_init(cert_path, key_path));
+    TEST_ASSERT_TRUE(TLS_enabled());
+
+    SSL_CTX *client_ctx = SSL_CTX_new(TLS_client_method());
+    SSL_CTX_set_verify(client_ctx, SSL_VERIFY_NONE, NULL);
+    SSL_SESSION *session = NULL;
+    bool resumed;
+
+    char *first = fetch(client_ctx, &session, &resumed);
+    TEST_ASSERT_EQUAL_INT(0, strncmp(first, "HTTP/1.1 200 OK\r\n", 17));
+    TEST_ASSERT_NOT_NULL(strstr(first, "\r\n\r\nhello over tls"));
+    TEST_ASSERT_FALSE(resumed);
+
+    // The ticket from the first connection skips the full handshake
+    char *second = fetch(client_ctx, &session, &resumed);
+    TEST_ASSERT_NOT_NULL(strstr(second, "hello over tls"));
+    TEST_ASSERT_TRUE(resumed);
+
+    free(first);
+    free(second);
+    SSL_SESSION_free(session);
+    SSL_CTX_free(client_ctx);
+    TLS_cleanup();
+    unlink(cert_path);
+    unlink(key_path);
+}
+
+typedef struct {
+    int port;
+    char response[1024];
+} TcpClient;
+
+static int connect_local(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr = { .sin_family = AF_INET, .sin_port = htons(port) };
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void *tls_client(void *arg) {
+    TcpClient *c = arg;
+    int fd = connect_local(c->port);
+    if (fd < 0) return NULL;
+    SSL_CTX *ctx = SSL_CTX_new(TLS_client_method());
+    SSL_CTX_set_verify(ctx, SSL_VERIFY_NONE, NULL);
+    SSL *ssl = SSL_new(ctx);
+    SSL_set_fd(ssl, fd);
+    if (SSL_connect(ssl) == 1) {
+        const char *request = "GET /second HTTP/1.1\r\n\r\n";
+        SSL_write(ssl, request, strlen(request));
+        int len = 0, n;
+        while ((n = SSL_read(ssl, c->response + len, sizeof(c->response) - 1 - len)) > 0) len += n;
+        c->response[len] = '\0';
+    }
+    SSL_free(ssl);
+    SSL_CTX_free(ctx);
+    close(fd);
+    return NULL;
+}
+
+void test_Silent_Client_Does_Not_Block_Accept(void) {
+    write_test_certificate();
+    TEST_ASSERT_TRUE(TLS_init(cert_path, key_path));
+    int port = 20000 + (getpid() + 2) % 20000;
+    HTTPServer *server = HTTPServer_create(port, NULL);
+    if (!server) TEST_IGNORE_MESSAGE("TCP port unavailable");
+
+    // Connects and never sends a ClientHello
+    int silent = connect_local(port);
+    TEST_ASSERT_GREATER_OR_EQUAL_INT(0, silent);
+    int64_t started = HTTPServer_now_ns();
+    HTTPRequest first = HTTPServer_listen(server);
+    TEST_ASSERT_TRUE(first.unread);
+
+    TcpClient client = { port, "" };
+    pthread_t thread;
+    pthread_create(&thread, NULL, tls_client, &client);
+    HTTPRequest second = HTTPServer_listen(server);
+    // Both accepted without waiting on the silent one
+    TEST_ASSERT_LESS_THAN_INT64(1000000000, HTTPServer_now_ns() - started);
+    TEST_ASSERT_TRUE(second.unread);
+
+    // The handshakes happen where the worker threads would do them
+    TEST_ASSERT_TRUE(HTTPServer_read_request(&second));
+    TEST_ASSERT_EQUAL_STRING("/second", second.path);
+    HTTPServer_send_response(&second, "second", "text/plain", 200, "");
+    pthread_join(thread, NULL);
+    TEST_ASSERT_NOT_NULL(strstr(client.response, "\r\n\r\nsecond"));
+
+    close(silent);
+    TEST_ASSERT_FALSE(HTTPServer_read_request(&first));
+
+    HTTPRequest_free(&first);
+    HTTPRequest_free(&second);
+    HTTPServer_destroy(server);
+    TLS_cleanup();
+    unlink(cert_path);
+    unlink(key_path);
+}
+
+int main(void) {
+    // As in the server, close_notify to a peer that already hung up is not fatal
+    signal(SIGPIPE, SIG_IGN);
+    UNITY_BEGIN();
+    RUN_TEST(test_Tls_Disabled_Without_Certificate);
+    RUN_TEST(test_Response_Over_Tls_And_Resumption);
+    RUN_TEST(test_Silent_Client_Does_Not_Block_Accept);
+    return UNITY_END();
+}